@@ -8,8 +8,8 @@ OWN_VERSION = (30,0,-1,0)
 SCHEMA_VERSION = 1348
 NVSCHEMA_VERSION = 1007
 MUSICSCHEMA_VERSION = 1024
-PROTO_VERSION = '91'
-PROTO_TOKEN = 'BuzzOff'
+PROTO_VERSION = '92'
+PROTO_TOKEN = 'WhatsNew'
 BACKEND_SEP = '[]:[]'
 INSTALL_PREFIX = '/usr/local'
 
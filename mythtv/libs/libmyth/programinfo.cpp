@@ -3419,6 +3419,47 @@ void ProgramInfo::SaveCommFlagged(CommFlagStatus flag)
 }
 
 
+/** \brief Brings the parts of a recording that LoadFromRecorded() takes
+ *         from outside the recorded table up to date.
+ *
+ *  This lets a recording loaded earlier be handed out again with the
+ *  current recording status, in-use flags and commercial flagging state.
+ *  As in LoadFromRecorded(), a commercial flagging job that is no longer
+ *  running counts as not flagged. Saving that is left to the caller.
+ *
+ *  \param rectime recordings ending before this are never in progress
+ *  \return true if the flagging job this was marked with is gone
+ */
+bool ProgramInfo::UpdateRecordedStatus(
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap,
+    const QDateTime &rectime)
+{
+    QString key = MakeUniqueKey(chanid, recstartts);
+
+    recstatus = (recendts > rectime && recMap.contains(key)) ?
+        RecStatus::Recording : RecStatus::Recorded;
+
+    programflags &= ~(FL_INUSERECORDING | FL_INUSEPLAYING | FL_INUSEOTHER);
+    QMap<QString,uint32_t>::const_iterator it = inUseMap.find(key);
+    if (it != inUseMap.end())
+        programflags |= *it;
+
+    bool save_not_commflagged = false;
+    if ((programflags & FL_COMMPROCESSING) && !isJobRunning.contains(key))
+    {
+        programflags &= ~FL_COMMPROCESSING;
+        save_not_commflagged = true;
+    }
+
+    set_flag(programflags, FL_EDITING,
+             (programflags & FL_REALLYEDITING) ||
+             (programflags & COMM_FLAG_PROCESSING));
+
+    return save_not_commflagged;
+}
+
 /** \brief Set "preserve" field in "recorded" table to "preserveEpisode".
  *  \param preserveEpisode value to set preserve field to.
  */
@@ -598,6 +598,10 @@ class MPUBLIC ProgramInfo
     void SaveAutoExpire(AutoExpireType autoExpire, bool updateDelete = false);
     void SavePreserve(bool preserveEpisode);
     bool SaveBasename(const QString &basename);
+    bool UpdateRecordedStatus(const QMap<QString,uint32_t> &inUseMap,
+                              const QMap<QString,bool> &isJobRunning,
+                              const QMap<QString, ProgramInfo*> &recMap,
+                              const QDateTime &rectime);
     void SaveAspect(uint64_t frame, MarkTypes type, uint customAspect);
     void SaveResolution(uint64_t frame, uint width, uint height);
     void SaveFrameRate(uint64_t frame, uint framerate);
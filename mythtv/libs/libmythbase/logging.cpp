@@ -5,6 +5,7 @@
 #include <QList>
 #include <QQueue>
 #include <QHash>
+#include <QThreadStorage>
 #include <QCoreApplication>
 #include <QFileInfo>
 #include <QStringList>
@@ -70,7 +71,6 @@ extern "C" {
 
 static QMutex                  logQueueMutex;
 static QQueue<LoggingItem *>   logQueue;
-static QRegExp                 logRegExp = QRegExp("[%]{1,2}");
 
 static LoggerThread           *logThread = NULL;
 static QMutex                  logThreadMutex;
@@ -82,6 +82,35 @@ static QHash<uint64_t, int64_t> logThreadTidHash;
 static bool                    logThreadFinished = false;
 static bool                    debugRegistration = false;
 
+/// \brief Marks the LogRing of a thread as detached when the thread exits, so
+///        the logging thread frees it once it has handled what is left in it.
+class LogRingHolder
+{
+  public:
+    explicit LogRingHolder(LogRing *ring) : m_ring(ring) {}
+    ~LogRingHolder() { m_ring->m_detached.storeRelease(1); }
+    LogRing *m_ring;
+};
+
+static QAtomicInt                     logRingsEnabled(0);
+static QMutex                         logRingsMutex;
+static QList<LogRing *>               logRings;
+static QThreadStorage<LogRingHolder*> logRingStorage;
+
+const uint LogRing::kSize;
+
+/// \brief Check for records in the LogRings that have not been handled yet
+static bool logRingsPending(void)
+{
+    QMutexLocker locker(&logRingsMutex);
+    for (int i = 0; i < logRings.size(); ++i)
+    {
+        if (!logRings[i]->isEmpty())
+            return true;
+    }
+    return false;
+}
+
 typedef struct {
     bool    propagate;
     int     quiet;
@@ -219,35 +248,44 @@ int64_t LoggingItem::getThreadTid(void)
     return m_tid;
 }
 
-/// \brief Set the thread ID of the thread that produced the LoggingItem.  This
-///        code is actually run in the thread in question as part of the call
-///        to LOG()
-/// \note  In different platforms, the actual value returned here will vary.
-///        The intention is to get a thread ID that will map well to what is
-///        shown in gdb.
-void LoggingItem::setThreadTid(void)
+/// \brief Look up the thread ID of the calling thread, remembering it for
+///        getThreadTid()
+static int64_t logThreadTidGet(uint64_t threadId)
 {
     QMutexLocker locker(&logThreadTidMutex);
 
-    m_tid = logThreadTidHash.value(m_threadId, -1);
-    if (m_tid == -1)
+    int64_t tid = logThreadTidHash.value(threadId, -1);
+    if (tid == -1)
     {
-        m_tid = 0;
+        tid = 0;
 
 #if defined(Q_OS_ANDROID)
-        m_tid = (int64_t)gettid();
+        tid = (int64_t)gettid();
 #elif defined(linux)
-        m_tid = (int64_t)syscall(SYS_gettid);
+        tid = (int64_t)syscall(SYS_gettid);
 #elif defined(__FreeBSD__)
         long lwpid;
         int dummy = thr_self( &lwpid );
         (void)dummy;
-        m_tid = (int64_t)lwpid;
+        tid = (int64_t)lwpid;
 #elif CONFIG_DARWIN
-        m_tid = (int64_t)mach_thread_self();
+        tid = (int64_t)mach_thread_self();
 #endif
-        logThreadTidHash[m_threadId] = m_tid;
+        logThreadTidHash[threadId] = tid;
     }
+
+    return tid;
+}
+
+/// \brief Set the thread ID of the thread that produced the LoggingItem.  This
+///        code is actually run in the thread in question as part of the call
+///        to LOG()
+/// \note  In different platforms, the actual value returned here will vary.
+///        The intention is to get a thread ID that will map well to what is
+///        shown in gdb.
+void LoggingItem::setThreadTid(void)
+{
+    m_tid = logThreadTidGet(m_threadId);
 }
 
 /// \brief LoggerThread constructor.  Enables debugging of thread registration
@@ -384,9 +422,11 @@ void LoggerThread::run(void)
     #endif
     }
 
+    logRingsEnabled.storeRelease(1);
+
     QMutexLocker qLock(&logQueueMutex);
 
-    while (!m_aborted || !logQueue.isEmpty())
+    while (!m_aborted || !logQueue.isEmpty() || logRingsPending())
     {
         qLock.unlock();
         qApp->processEvents(QEventLoop::AllEvents, 10);
@@ -395,12 +435,29 @@ void LoggerThread::run(void)
         qLock.relock();
         if (logQueue.isEmpty())
         {
+            qLock.unlock();
+            bool handled = handleRings();
+            qLock.relock();
+            if (handled || !logQueue.isEmpty())
+                continue;
+
             m_waitEmpty->wakeAll();
             m_waitNotEmpty->wait(qLock.mutex(), 100);
             continue;
         }
 
-        LoggingItem *item = logQueue.dequeue();
+        // A thread whose ring was full logged to logQueue after what is
+        // still in its ring, so handle everything older than the item first
+        LoggingItem *item = logQueue.head();
+        qLock.unlock();
+        if (handleRings(256, item))
+        {
+            qLock.relock();
+            continue;
+        }
+
+        qLock.relock();
+        item = logQueue.dequeue();
         qLock.unlock();
 
         fillItem(item);
@@ -413,6 +470,12 @@ void LoggerThread::run(void)
 
     qLock.unlock();
 
+    // Anything logged from here on is handled by LogPrintLine() itself
+    logRingsEnabled.storeRelease(0);
+    while (handleRings())
+    {
+    }
+
     // This must be before the timer stop below or we deadlock when the timer
     // thread tries to deregister, and we wait for it.
     logThreadFinished = true;
@@ -705,14 +768,85 @@ bool LoggerThread::flush(int timeoutMS)
 {
     QTime t;
     t.start();
-    while (!m_aborted && !logQueue.isEmpty() && t.elapsed() < timeoutMS)
+    while (!m_aborted && (!logQueue.isEmpty() || logRingsPending()) &&
+           t.elapsed() < timeoutMS)
     {
         m_waitNotEmpty->wakeAll();
         int left = timeoutMS - t.elapsed();
         if (left > 0)
             m_waitEmpty->wait(&logQueueMutex, left);
     }
-    return logQueue.isEmpty();
+    return logQueue.isEmpty() && !logRingsPending();
+}
+
+/// \brief Wake the logging thread up to handle what is waiting for it
+void LoggerThread::wakeUp(void)
+{
+    m_waitNotEmpty->wakeAll();
+}
+
+/// \brief  Handles the records waiting in the LogRings of the threads, oldest
+///         first, and frees the rings of threads that have exited once they
+///         are empty.  The records are taken out of the rings with
+///         logRingsMutex held, so that only one thread at a time reads them,
+///         but handled without it.
+/// \param  maxRecords  Most records to handle before returning, to keep
+///                     handling events in between
+/// \param  before      only handle records logged before this item, if set
+/// \return true if any records were handled
+bool LoggerThread::handleRings(int maxRecords, const LoggingItem *before)
+{
+    QList<LoggingItem *> items;
+    {
+        QMutexLocker locker(&logRingsMutex);
+        for (int i = 0; i < logRings.size(); )
+        {
+            LogRing *ring = logRings[i];
+            if (ring->m_detached.loadAcquire() && ring->isEmpty())
+            {
+                logRings.removeAt(i);
+                delete ring;
+                continue;
+            }
+            ++i;
+        }
+
+        while (items.size() < maxRecords)
+        {
+            LogRing   *oldest = NULL;
+            LogRecord *record = NULL;
+            for (int i = 0; i < logRings.size(); ++i)
+            {
+                LogRecord *next = logRings[i]->peek();
+                if (next && (!record || next->epoch < record->epoch ||
+                             (next->epoch == record->epoch &&
+                              next->usec < record->usec)))
+                {
+                    oldest = logRings[i];
+                    record = next;
+                }
+            }
+            if (!record)
+                break;
+            if (before && (record->epoch > before->epoch() ||
+                           (record->epoch == before->epoch() &&
+                            record->usec >= before->usec())))
+                break;
+
+            items.append(LoggingItem::create(oldest, record));
+            oldest->release();
+        }
+    }
+
+    for (int i = 0; i < items.size(); ++i)
+    {
+        fillItem(items[i]);
+        handleItem(items[i]);
+        logConsole(items[i]);
+        items[i]->DecrRef();
+    }
+
+    return !items.isEmpty();
 }
 
 void LoggerThread::fillItem(LoggingItem *item)
@@ -746,6 +880,33 @@ LoggingItem *LoggingItem::create(const char *_file,
     return item;
 }
 
+/// \brief  Create a LoggingItem from a record that LOG() left in a LogRing
+/// \param  ring    the ring of the thread that logged the record
+/// \param  record  the record
+/// \return LoggingItem that was created
+LoggingItem *LoggingItem::create(const LogRing *ring, const LogRecord *record)
+{
+    LoggingItem *item = new LoggingItem;
+
+    item->m_threadId = ring->m_threadId;
+    item->m_tid      = ring->m_tid;
+    item->m_usec     = record->usec;
+    item->m_line     = record->line;
+    item->m_type     = (LoggingType)record->type;
+    item->m_level    = record->level;
+    item->m_epoch    = record->epoch;
+    item->m_file     = strdup(record->file);
+    item->m_function = strdup(record->function);
+
+    // Registrations carry the thread name rather than a message
+    if (record->type & kRegistering)
+        item->m_threadName = strdup(record->message);
+    else
+        strcpy(item->m_message, record->message);
+
+    return item;
+}
+
 LoggingItem *LoggingItem::create(QByteArray &buf)
 {
     // Deserialize buffer
@@ -758,8 +919,72 @@ LoggingItem *LoggingItem::create(QByteArray &buf)
 }
 
 
-/// \brief  Format and send a log message into the queue.  This is called from
-///         the LOG() macro.  The intention is minimal blocking of the caller.
+/// \brief  Wake the logging thread up, unless logging has been stopped
+static void logThreadWakeUp(void)
+{
+    QMutexLocker locker(&logThreadMutex);
+    if (logThread)
+        logThread->wakeUp();
+}
+
+/// \brief  Get a free record in the LogRing of the calling thread, creating
+///         the ring the first time the thread logs something.  If the ring is
+///         full the logging thread is woken up and the caller uses logQueue
+///         until it made room, rather than waiting for it.
+/// \param  ring    set to the ring of the calling thread
+/// \return the record to fill in, NULL if logQueue has to be used instead
+static LogRecord *logRingReserve(LogRing **ring)
+{
+    if (!logRingsEnabled.loadAcquire())
+        return NULL;
+
+    if (logRingStorage.hasLocalData())
+    {
+        *ring = logRingStorage.localData()->m_ring;
+    }
+    else
+    {
+        // The logging thread would only ever wait for itself
+        if (logThread && QThread::currentThread() == logThread->qthread())
+            return NULL;
+
+        *ring = new LogRing();
+        (*ring)->m_threadId = (uint64_t)(QThread::currentThreadId());
+        (*ring)->m_tid = logThreadTidGet((*ring)->m_threadId);
+        logRingStorage.setLocalData(new LogRingHolder(*ring));
+
+        QMutexLocker locker(&logRingsMutex);
+        logRings.append(*ring);
+    }
+
+    LogRecord *record = (*ring)->reserve();
+    if (!record || (*ring)->count() == LogRing::kSize / 2)
+        logThreadWakeUp();
+
+    return record;
+}
+
+/// \brief  Copy a message that came from a QString, which is not a printf
+///         format.  Like printing it with every "%" or "%%" escaped, this
+///         turns both into a single "%".
+static void logCopyMessage(char *dest, const char *message)
+{
+    char *end = dest + LOGLINE_MAX - 1;
+    while (*message && dest < end)
+    {
+        if (*message == '%' && *(message + 1) == '%')
+            message++;
+        *dest++ = *message++;
+    }
+    *dest = '\0';
+}
+
+/// \brief  Format and send a log message to the logging thread.  This is
+///         called from the LOG() macro.  The intention is minimal blocking of
+///         the caller, so once the logging thread runs the message is left in
+///         a LogRing of the calling thread without taking a lock or
+///         allocating anything.  Before that, after it stopped, and while
+///         the ring is full, the message goes through logQueue.
 /// \param  mask    Verbosity mask of the message (VB_*)
 /// \param  level   Log level of this message (LOG_* - matching syslog levels)
 /// \param  file    Filename of source code logging the message
@@ -778,26 +1003,61 @@ void LogPrintLine( uint64_t mask, LogLevel_t level, const char *file, int line,
     int type = kMessage;
     type |= (mask & VB_FLUSH) ? kFlush : 0;
     type |= (mask & VB_STDIO) ? kStandardIO : 0;
+
+    LogRing   *ring = NULL;
+    LogRecord *record = logRingReserve(&ring);
+    if (record)
+    {
+        // file and function are the static strings of the LOG() call site
+        record->file     = file;
+        record->function = function;
+        record->line     = line;
+        record->level    = level;
+        record->type     = type;
+        loggingGetTimeStamp(&record->epoch, &record->usec);
+
+        if (fromQString)
+        {
+            logCopyMessage(record->message, format);
+        }
+        else
+        {
+            va_start(arguments, format);
+            vsnprintf(record->message, LOGLINE_MAX, format, arguments);
+            va_end(arguments);
+        }
+
+#if defined( _MSC_VER ) && defined( _DEBUG )
+        OutputDebugStringA( record->message );
+        OutputDebugStringA( "\n" );
+#endif
+
+        ring->commit();
+
+        if (type & kFlush)
+        {
+            QMutexLocker qLock(&logQueueMutex);
+            if (logThread && !logThreadFinished)
+                logThread->flush();
+        }
+        return;
+    }
+
     LoggingItem *item = LoggingItem::create(file, function, line, level,
                                             (LoggingType)type);
     if (!item)
         return;
 
-    char *formatcopy = NULL;
-    if( fromQString && strchr(format, '%') )
+    if (fromQString)
     {
-        QString string(format);
-        format = strdup(string.replace(logRegExp, "%%").toLocal8Bit()
-                              .constData());
-        formatcopy = (char *)format;
+        logCopyMessage(item->m_message, format);
+    }
+    else
+    {
+        va_start(arguments, format);
+        vsnprintf(item->m_message, LOGLINE_MAX, format, arguments);
+        va_end(arguments);
     }
-
-    va_start(arguments, format);
-    vsnprintf(item->m_message, LOGLINE_MAX, format, arguments);
-    va_end(arguments);
-
-    if (formatcopy)
-        free(formatcopy);
 
     QMutexLocker qLock(&logQueueMutex);
 
@@ -819,6 +1079,11 @@ void LogPrintLine( uint64_t mask, LogLevel_t level, const char *file, int line,
             item->DecrRef();
             qLock.relock();
         }
+
+        // Anything logged to the rings while the logging thread stopped
+        while (logThread->handleRings())
+        {
+        }
     }
     else if (logThread && !logThreadFinished && (type & kFlush))
     {
@@ -957,8 +1222,20 @@ void logStop(void)
     {
         logThread->stop();
         logThread->wait();
-        delete logThread;
-        logThread = NULL;
+
+        // A thread may have reserved a record before the rings were
+        // turned off and committed it after the logging thread last
+        // looked at them
+        while (logThread->handleRings())
+        {
+        }
+
+        LoggerThread *thread = logThread;
+        {
+            QMutexLocker locker(&logThreadMutex);
+            logThread = NULL;
+        }
+        delete thread;
     }
 }
 
@@ -971,6 +1248,23 @@ void loggingRegisterThread(const QString &name)
     if (logThreadFinished)
         return;
 
+    LogRing   *ring = NULL;
+    LogRecord *record = logRingReserve(&ring);
+    if (record)
+    {
+        record->file     = __FILE__;
+        record->function = __FUNCTION__;
+        record->line     = __LINE__;
+        record->level    = (LogLevel_t)LOG_DEBUG;
+        record->type     = kRegistering;
+        loggingGetTimeStamp(&record->epoch, &record->usec);
+        strncpy(record->message, name.toLocal8Bit().constData(),
+                LOGLINE_MAX);
+        record->message[LOGLINE_MAX] = '\0';
+        ring->commit();
+        return;
+    }
+
     QMutexLocker qLock(&logQueueMutex);
 
     LoggingItem *item = LoggingItem::create(__FILE__, __FUNCTION__,
@@ -990,6 +1284,21 @@ void loggingDeregisterThread(void)
     if (logThreadFinished)
         return;
 
+    LogRing   *ring = NULL;
+    LogRecord *record = logRingReserve(&ring);
+    if (record)
+    {
+        record->file     = __FILE__;
+        record->function = __FUNCTION__;
+        record->line     = __LINE__;
+        record->level    = (LogLevel_t)LOG_DEBUG;
+        record->type     = kDeregistering;
+        loggingGetTimeStamp(&record->epoch, &record->usec);
+        record->message[0] = '\0';
+        ring->commit();
+        return;
+    }
+
     QMutexLocker qLock(&logQueueMutex);
 
     LoggingItem *item = LoggingItem::create(__FILE__, __FUNCTION__, __LINE__,
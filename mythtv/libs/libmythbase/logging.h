@@ -2,6 +2,7 @@
 #define LOGGING_H_
 
 #include <QMutexLocker>
+#include <QAtomicInt>
 #include <QMutex>
 #include <QQueue>
 #include <QTime>
@@ -67,6 +68,70 @@ typedef struct tm tmType;
                                 arg = strdup(val.toLocal8Bit().constData()); \
                             }
 
+/// \brief A log message as LOG() leaves it for the logging thread.  The file
+///        and function point to the static strings of the LOG() call site.
+typedef struct {
+    const char *file;
+    const char *function;
+    int         line;
+    LogLevel_t  level;
+    int         type;           ///< LoggingType
+    qlonglong   epoch;
+    uint        usec;
+    char        message[LOGLINE_MAX+1];
+} LogRecord;
+
+/// \brief Preallocated LogRecords of a single thread.  Only that thread
+///        writes records and only the logging thread reads them, so neither
+///        side needs a lock or an allocation.  When the ring is full the
+///        thread logs through logQueue instead.
+class LogRing
+{
+  public:
+    LogRing() : m_threadId(0), m_tid(0), m_detached(0), m_head(0), m_tail(0)
+    {
+    }
+
+    /// \brief Get the record to write next, NULL if the ring is full
+    LogRecord *reserve(void)
+    {
+        uint head = m_head.load();
+        if (head - (uint)m_tail.loadAcquire() >= kSize)
+            return NULL;
+        return &m_records[head % kSize];
+    }
+    /// \brief Hand the record from reserve() to the logging thread
+    void commit(void)               { m_head.storeRelease(m_head.load() + 1); }
+
+    /// \brief Get the oldest record, NULL if the ring is empty
+    LogRecord *peek(void)
+    {
+        uint tail = m_tail.load();
+        if ((uint)m_head.loadAcquire() == tail)
+            return NULL;
+        return &m_records[tail % kSize];
+    }
+    /// \brief Give the record from peek() back to the writing thread
+    void release(void)              { m_tail.storeRelease(m_tail.load() + 1); }
+
+    uint count(void) const
+    {
+        return (uint)m_head.loadAcquire() - (uint)m_tail.loadAcquire();
+    }
+    bool isEmpty(void) const        { return count() == 0; }
+
+    static const uint kSize = 128;  ///< must be a power of two
+
+    qulonglong  m_threadId;         ///< QThread::currentThreadId() of the writer
+    qlonglong   m_tid;              ///< System thread id of the writer
+    QAtomicInt  m_detached;         ///< The writing thread has exited
+
+  private:
+    QAtomicInt  m_head;             ///< Records written, only the writer stores
+    QAtomicInt  m_tail;             ///< Records read, only the reader stores
+    LogRecord   m_records[kSize];
+};
+
 /// \brief The logging items that are generated by LOG() and are sent to the
 ///        console and to mythlogserver via ZeroMQ
 class LoggingItem: public QObject, public ReferenceCounter
@@ -101,6 +166,7 @@ class LoggingItem: public QObject, public ReferenceCounter
     static LoggingItem *create(const char *, const char *, int, LogLevel_t,
                                LoggingType);
     static LoggingItem *create(QByteArray &buf);
+    static LoggingItem *create(const LogRing *ring, const LogRecord *record);
     QByteArray toByteArray(void);
 
     int                 pid() const         { return m_pid; };
@@ -191,6 +257,9 @@ class LoggerThread : public QObject, public MThread
     bool flush(int timeoutMS = 200000);
     void handleItem(LoggingItem *item);
     void fillItem(LoggingItem *item);
+    bool handleRings(int maxRecords = 256,
+                     const LoggingItem *before = NULL);
+    void wakeUp(void);
   private:
     QWaitCondition *m_waitNotEmpty; ///< Condition variable for waiting
                                     ///  for the queue to not be empty
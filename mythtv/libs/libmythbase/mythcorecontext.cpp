@@ -1634,9 +1634,10 @@ bool MythCoreContext::CheckProtoVersion(MythSocket *socket, uint timeout_ms,
     if (!socket)
         return false;
 
-    QStringList strlist(QString("MYTH_PROTO_VERSION %1 %2")
+    QStringList strlist(QString("MYTH_PROTO_VERSION %1 %2 %3")
                         .arg(MYTH_PROTO_VERSION)
-                        .arg(QString::fromUtf8(MYTH_PROTO_TOKEN)));
+                        .arg(QString::fromUtf8(MYTH_PROTO_TOKEN))
+                        .arg(MythSocket::kBinaryFramingToken));
     socket->WriteStringList(strlist);
 
     if (!socket->ReadStringList(strlist, timeout_ms) || strlist.empty())
@@ -1667,6 +1668,10 @@ bool MythCoreContext::CheckProtoVersion(MythSocket *socket, uint timeout_ms,
     }
     else if (strlist[0] == "ACCEPT")
     {
+        // Backends that do not know the binary framing leave it out
+        socket->SetBinaryFraming((strlist.size() >= 3) &&
+            (strlist[2] == MythSocket::kBinaryFramingToken));
+
         if (!d->m_announcedProtocol)
         {
             d->m_announcedProtocol = true;
@@ -31,6 +31,8 @@
 #endif
 
 static const uint kPurgeTimeout = 60 * 60;
+/// Number of prepared statements kept per connection
+static const int kStatementCacheSize = 64;
 
 bool TestDatabase(QString dbHostName,
                   QString dbUserName,
@@ -71,7 +73,8 @@ bool TestDatabase(QString dbHostName,
     return ret;
 }
 
-MSqlDatabase::MSqlDatabase(const QString &name)
+MSqlDatabase::MSqlDatabase(const QString &name) :
+    m_stmtHits(0), m_stmtMisses(0)
 {
     m_name = name;
     m_name.detach();
@@ -98,6 +101,14 @@ MSqlDatabase::MSqlDatabase(const QString &name)
 
 MSqlDatabase::~MSqlDatabase()
 {
+    if (m_stmtHits || m_stmtMisses)
+    {
+        LOG(VB_DATABASE, LOG_INFO,
+            QString("Prepared statement cache for %1: %2 hits, %3 misses")
+            .arg(m_name).arg(m_stmtHits).arg(m_stmtMisses));
+    }
+    ClearStatementCache();
+
     if (m_db.isOpen())
     {
         m_db.close();
@@ -251,13 +262,17 @@ bool MSqlDatabase::KickDatabase(void)
     m_lastDBKick = MythDate::current().addSecs(-60);
 
     if (!m_db.isOpen())
+    {
+        ClearStatementCache();
         m_db.open();
+    }
 
     return m_db.isOpen();
 }
 
 bool MSqlDatabase::Reconnect()
 {
+    ClearStatementCache();
     m_db.close();
     m_db.open();
 
@@ -271,6 +286,50 @@ bool MSqlDatabase::Reconnect()
     return open;
 }
 
+/** \brief Hands out the cached prepared statement for query, if any.
+ *
+ *  The statement is removed from the cache while it is in use, so
+ *  nested MSqlQuery objects on a reused connection never share one.
+ */
+bool MSqlDatabase::TakeStatement(const QString &query, QSqlQuery &stmt)
+{
+    QHash<QString, QSqlQuery>::iterator it = m_stmtCache.find(query);
+    if (it == m_stmtCache.end())
+    {
+        m_stmtMisses++;
+        return false;
+    }
+
+    stmt = *it;
+    m_stmtCache.erase(it);
+    m_stmtOrder.removeOne(query);
+    m_stmtHits++;
+    return true;
+}
+
+/// \brief Puts a prepared statement back, dropping the least recently
+///        used one if the cache is full.
+void MSqlDatabase::ReturnStatement(const QString &query, const QSqlQuery &stmt)
+{
+    if (!m_db.isOpen())
+        return;
+
+    if (m_stmtCache.contains(query))
+        m_stmtOrder.removeOne(query);
+    else if (m_stmtCache.size() >= kStatementCacheSize)
+        m_stmtCache.remove(m_stmtOrder.takeFirst());
+
+    m_stmtCache[query] = stmt;
+    m_stmtOrder.append(query);
+}
+
+/// \brief Drops all prepared statements, they do not survive a reconnect.
+void MSqlDatabase::ClearStatementCache(void)
+{
+    m_stmtCache.clear();
+    m_stmtOrder.clear();
+}
+
 void MSqlDatabase::InitSessionVars()
 {
     // Make sure NOW() returns time in UTC...
@@ -541,6 +600,8 @@ MSqlQuery::MSqlQuery(const MSqlQueryInfo &qi)
 
 MSqlQuery::~MSqlQuery()
 {
+    ReturnStatement();
+
     if (m_returnConnection)
     {
         MDBManager *dbmanager = GetMythDB()->GetDBManager();
@@ -740,6 +801,9 @@ bool MSqlQuery::exec(const QString &query)
         return false;
     }
 
+    // Don't run unprepared SQL on a cached statement's result
+    ReturnStatement();
+
     // Database connection down.  Try to restart it, give up if it's still
     // down
     if (!m_db->isOpen() && !Reconnect())
@@ -832,6 +896,21 @@ bool MSqlQuery::seek(int where, bool relative)
     return seekDebug("seek", QSqlQuery::seek(where, relative), where, relative);
 }
 
+/// \brief Gives the prepared statement this query holds back to the
+///        connection's statement cache.
+void MSqlQuery::ReturnStatement(void)
+{
+    if (m_cached_query.isEmpty())
+        return;
+
+    if (m_db)
+    {
+        QSqlQuery::finish();
+        m_db->ReturnStatement(m_cached_query, *this);
+    }
+    m_cached_query.clear();
+}
+
 bool MSqlQuery::prepare(const QString& query)
 {
     if (!m_db)
@@ -840,6 +919,8 @@ bool MSqlQuery::prepare(const QString& query)
         return false;
     }
 
+    ReturnStatement();
+
     m_last_prepared_query = query;
 
 #ifdef DEBUG_QT4_PORT
@@ -875,6 +956,18 @@ bool MSqlQuery::prepare(const QString& query)
     // iterate forward over the result set.
     setForwardOnly(true);
 
+    // Reuse the statement if this connection prepared the same query
+    // before. The cached QSqlQuery shares its result with us, so only
+    // the bindings need resetting.
+    if (m_db->TakeStatement(query, *this))
+    {
+        int bound = QSqlQuery::boundValues().size();
+        for (int i = 0; i < bound; ++i)
+            QSqlQuery::bindValue(i, QVariant(), QSql::In);
+        m_cached_query = query;
+        return true;
+    }
+
     bool ok = QSqlQuery::prepare(query);
 
     // if the prepare failed with "MySQL server has gone away"
@@ -889,6 +982,9 @@ bool MSqlQuery::prepare(const QString& query)
         && Reconnect())
         ok = true;
 
+    if (ok)
+        m_cached_query = query;
+
     if (!ok && !(GetMythDB()->SuppressDBMessages()))
     {
         LOG(VB_GENERAL, LOG_ERR,
@@ -10,6 +10,7 @@
 #include <QDateTime>
 #include <QMutex>
 #include <QList>
+#include <QHash>
 
 #include "mythbaseexp.h"
 #include "mythdbparams.h"
@@ -42,11 +43,22 @@ class MSqlDatabase
     bool Reconnect(void);
     void InitSessionVars(void);
 
+    bool TakeStatement(const QString &query, QSqlQuery &stmt);
+    void ReturnStatement(const QString &query, const QSqlQuery &stmt);
+    void ClearStatementCache(void);
+
   private:
     QString m_name;
     QSqlDatabase m_db;
     QDateTime m_lastDBKick;
     DatabaseParams m_dbparms;
+
+    /// Prepared statements that are not in use by an MSqlQuery, keyed by
+    /// query text. m_stmtOrder holds the keys, least recently used first.
+    QHash<QString, QSqlQuery> m_stmtCache;
+    QList<QString> m_stmtOrder;
+    uint m_stmtHits;
+    uint m_stmtMisses;
 };
 
 /// \brief DB connection pool, used by MSqlQuery. Do not use directly.
@@ -218,11 +230,13 @@ class MBASE_PUBLIC MSqlQuery : private QSqlQuery
 
     bool seekDebug(const char *type, bool result,
                    int where, bool relative) const;
+    void ReturnStatement(void);
 
     MSqlDatabase *m_db;
     bool m_isConnected;
     bool m_returnConnection;
     QString m_last_prepared_query; // holds a copy of the last prepared query
+    QString m_cached_query; // query text of a statement to give back to m_db
 #ifdef DEBUG_QT4_PORT
     QRegExp m_testbindings;
 #endif
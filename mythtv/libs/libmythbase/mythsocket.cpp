@@ -8,6 +8,7 @@
 #include <QHostInfo>
 #include <QThread>
 #include <QMetaType>
+#include <QtEndian>
 
 // setsockopt -- has to be after Qt includes for Q_OS_WIN definition
 #if defined(Q_OS_WIN)
@@ -16,6 +17,10 @@
 #include <stdio.h>
 #else
 #include <sys/socket.h>
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
 #endif
 #include <unistd.h> // for usleep (and socket code on Q_OS_WIN)
 #include <algorithm> // for min/max
@@ -43,6 +48,8 @@ const uint MythSocket::kLongTimeout  = kMythSocketLongTimeout;
 
 const int MythSocket::kSocketReceiveBufferSize = 128 * 1024;
 
+const char *MythSocket::kBinaryFramingToken = "BINARY";
+
 QMutex MythSocket::s_loopbackCacheLock;
 QHash<QString, QHostAddress::SpecialAddress> MythSocket::s_loopbackCache;
 
@@ -92,7 +99,8 @@ MythSocket::MythSocket(
     m_connected(false),
     m_dataAvailable(0),
     m_isValidated(false),
-    m_isAnnounced(false)
+    m_isAnnounced(false),
+    m_binaryFraming(false)
 {
     LOG(VB_SOCKET, LOG_INFO, LOC + QString("MythSocket(%1, 0x%2) ctor")
         .arg(socket).arg((intptr_t)(cb),0,16));
@@ -425,9 +433,10 @@ bool MythSocket::Validate(uint timeout_ms, bool error_dialog_desired)
     if (m_isValidated)
         return true;
 
-    QStringList strlist(QString("MYTH_PROTO_VERSION %1 %2")
+    QStringList strlist(QString("MYTH_PROTO_VERSION %1 %2 %3")
                         .arg(MYTH_PROTO_VERSION)
-                        .arg(QString::fromUtf8(MYTH_PROTO_TOKEN)));
+                        .arg(QString::fromUtf8(MYTH_PROTO_TOKEN))
+                        .arg(kBinaryFramingToken));
 
     WriteStringList(strlist);
 
@@ -462,6 +471,9 @@ bool MythSocket::Validate(uint timeout_ms, bool error_dialog_desired)
         LOG(VB_GENERAL, LOG_NOTICE, QString("Using protocol version %1 %2")
             .arg(MYTH_PROTO_VERSION).arg(QString::fromUtf8(MYTH_PROTO_TOKEN)));
         m_isValidated = true;
+        // Backends that do not know the binary framing leave it out
+        m_binaryFraming = (strlist.size() >= 3) &&
+            (strlist[2] == kBinaryFramingToken);
     }
     else
     {
@@ -558,6 +570,29 @@ int MythSocket::Read(char *data, int size, int max_wait_ms)
     return ret;
 }
 
+/** \brief Sends size bytes starting at offset of the open file fd,
+ *         letting the kernel copy them straight from the page cache
+ *         to the socket.
+ *
+ *  \return number of bytes sent, which is less than size at the end of
+ *          the file, or -1 if nothing could be sent. -1 is also returned
+ *          where sendfile() isn't available; callers are expected to
+ *          fall back to Write().
+ */
+int MythSocket::SendFile(int fd, long long offset, int size)
+{
+    int ret = -1;
+    QMetaObject::invokeMethod(
+        this, "SendFileReal",
+        (QThread::currentThread() != m_thread->qthread()) ?
+        Qt::BlockingQueuedConnection : Qt::DirectConnection,
+        Q_ARG(int, fd),
+        Q_ARG(qlonglong, offset),
+        Q_ARG(int, size),
+        Q_ARG(int*, &ret));
+    return ret;
+}
+
 void MythSocket::Reset(void)
 {
     QMetaObject::invokeMethod(
@@ -706,6 +741,112 @@ void MythSocket::DisconnectFromHostReal(void)
     m_tcpSocket->disconnectFromHost();
 }
 
+// Parses str if it is an integer that QString::number() would print the
+// same way, so that it can be sent as a native integer.
+static bool canonical_integer(const QString &str, qint64 &value)
+{
+    const QChar *c = str.unicode();
+    int len = str.length();
+    int i = (len && c[0] == '-') ? 1 : 0;
+
+    // at most 18 digits, so that the value cannot overflow
+    if (len == i || len - i > 18)
+        return false;
+    if (c[i] == '0' && (len > 1))  // leading zero or "-0"
+        return false;
+
+    value = 0;
+    for (int j = i; j < len; j++)
+    {
+        ushort d = c[j].unicode() - '0';
+        if (d > 9)
+            return false;
+        value = value * 10 + d;
+    }
+    if (i)
+        value = -value;
+
+    return true;
+}
+
+/** \brief Encodes list in the binary framing.
+ *
+ *  Each field starts with a tag byte. Integers that print back the same
+ *  way are tagged 'I' and sent as 8 byte big-endian numbers, everything
+ *  else is tagged 'S' and sent as a 4 byte big-endian length followed by
+ *  the UTF-8 bytes. Numeric fields, like most of a ProgramInfo, are then
+ *  neither searched for separators nor decoded from UTF-8 on the way.
+ */
+QByteArray MythSocket::EncodeStringList(const QStringList &list)
+{
+    QByteArray data;
+    data.reserve(list.size() * 16);
+
+    QStringList::const_iterator it = list.begin();
+    for (; it != list.end(); ++it)
+    {
+        qint64 value;
+        if (canonical_integer(*it, value))
+        {
+            char field[9];
+            field[0] = 'I';
+            qToBigEndian(value, (uchar*)field + 1);
+            data.append(field, sizeof(field));
+        }
+        else
+        {
+            QByteArray utf8 = it->toUtf8();
+            char field[5];
+            field[0] = 'S';
+            qToBigEndian((quint32)utf8.size(), (uchar*)field + 1);
+            data.append(field, sizeof(field));
+            data.append(utf8);
+        }
+    }
+
+    return data;
+}
+
+/** \brief Decodes a string list from the binary framing.
+ *  \return false if data is not a complete binary string list
+ */
+bool MythSocket::DecodeStringList(const char *data, int size,
+                                  QStringList &list)
+{
+    list.clear();
+
+    const uchar *p   = (const uchar*)data;
+    const uchar *end = p + size;
+    while (p < end)
+    {
+        uchar tag = *p++;
+        if (tag == 'I')
+        {
+            if (end - p < 8)
+                return false;
+            list.push_back(QString::number(qFromBigEndian<qint64>(p)));
+            p += 8;
+        }
+        else if (tag == 'S')
+        {
+            if (end - p < 4)
+                return false;
+            quint32 len = qFromBigEndian<quint32>(p);
+            p += 4;
+            if ((quint32)(end - p) < len)
+                return false;
+            list.push_back(QString::fromUtf8((const char*)p, len));
+            p += len;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return !list.empty();
+}
+
 void MythSocket::WriteStringListReal(const QStringList *list, bool *ret)
 {
     if (list->empty())
@@ -724,31 +865,51 @@ void MythSocket::WriteStringListReal(const QStringList *list, bool *ret)
         return;
     }
 
-    QString str = list->join("[]:[]");
-    if (str.isEmpty())
+    QByteArray payload;
+    if (m_binaryFraming)
     {
-        LOG(VB_GENERAL, LOG_ERR, LOC +
-            "WriteStringList: Error, joined null string.");
-        *ret = false;
-        return;
+        QByteArray data = EncodeStringList(*list);
+        if (data.size() > 0xfffffff)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                "WriteStringList: Error, string list too long.");
+            *ret = false;
+            return;
+        }
+
+        // '#' and the size in hex tell the reader this is binary
+        payload = "#" + QByteArray::number(data.size(), 16)
+            .rightJustified(7, '0');
+        payload += data;
     }
+    else
+    {
+        QString str = list->join("[]:[]");
+        if (str.isEmpty())
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                "WriteStringList: Error, joined null string.");
+            *ret = false;
+            return;
+        }
 
-    QByteArray utf8 = str.toUtf8();
-    int size = utf8.length();
+        QByteArray utf8 = str.toUtf8();
+        payload = payload.setNum(utf8.length());
+        payload += "        ";
+        payload.truncate(8);
+        payload += utf8;
+    }
+    int size = payload.length();
     int written = 0;
     int written_since_timer_restart = 0;
 
-    QByteArray payload;
-    payload = payload.setNum(size);
-    payload += "        ";
-    payload.truncate(8);
-    payload += utf8;
-    size = payload.length();
-
     if (VERBOSE_LEVEL_CHECK(VB_NETWORK, LOG_INFO))
     {
         QString msg = QString("write -> %1 %2")
-            .arg(m_tcpSocket->socketDescriptor(), 2).arg(payload.data());
+            .arg(m_tcpSocket->socketDescriptor(), 2)
+            .arg(QString::fromUtf8(m_binaryFraming ?
+                 payload.left(8) + list->join("[]:[]").toUtf8() :
+                 payload));
 
         if (logLevel < LOG_DEBUG && msg.length() > 88)
         {
@@ -851,8 +1012,22 @@ void MythSocket::ReadStringListReal(
         return;
     }
 
-    QString sizes = sizestr;
-    qint64 btr = sizes.trimmed().toInt();
+    // Binary frames are only sent to peers that asked for them in
+    // Validate(), but are recognized whatever was negotiated.
+    bool binary = (sizestr[0] == '#');
+    qint64 btr = 0;
+    if (binary)
+    {
+        bool ok = false;
+        btr = sizestr.mid(1, 7).toInt(&ok, 16);
+        if (!ok)
+            btr = 0;
+    }
+    else
+    {
+        QString sizes = sizestr;
+        btr = sizes.trimmed().toInt();
+    }
 
     if (btr < 1)
     {
@@ -937,16 +1112,33 @@ void MythSocket::ReadStringListReal(
         }
     }
 
-    QString str = QString::fromUtf8(utf8.data());
-
-    QByteArray payload;
-    payload = payload.setNum(str.length());
-    payload += "        ";
-    payload.truncate(8);
-    payload += str;
+    QString str;
+    if (binary)
+    {
+        if (!DecodeStringList(utf8.constData(), readoffset, *list))
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                "Protocol error: malformed binary string list.");
+            list->clear();
+            ResetReal();
+            return;
+        }
+        if (VERBOSE_LEVEL_CHECK(VB_NETWORK, LOG_INFO))
+            str = list->join("[]:[]");
+    }
+    else
+    {
+        str = QString::fromUtf8(utf8.data());
+    }
 
     if (VERBOSE_LEVEL_CHECK(VB_NETWORK, LOG_INFO))
     {
+        QByteArray payload;
+        payload = payload.setNum(str.length());
+        payload += "        ";
+        payload.truncate(8);
+        payload += str;
+
         QString msg = QString("read  <- %1 %2")
             .arg(m_tcpSocket->socketDescriptor(), 2)
             .arg(payload.data());
@@ -959,7 +1151,8 @@ void MythSocket::ReadStringListReal(
         LOG(VB_NETWORK, LOG_INFO, LOC + msg);
     }
 
-    *list = str.split("[]:[]");
+    if (!binary)
+        *list = str.split("[]:[]");
 
     m_dataAvailable.fetchAndStoreOrdered(
         (m_tcpSocket->bytesAvailable() > 0) ? 1 : 0);
@@ -995,6 +1188,63 @@ void MythSocket::ReadReal(char *data, int size, int max_wait_ms, int *ret)
         (m_tcpSocket->bytesAvailable() > 0) ? 1 : 0);
 }
 
+void MythSocket::SendFileReal(int fd, qlonglong offset, int size, int *ret)
+{
+    *ret = -1;
+
+#ifdef __linux__
+    // Anything Write() queued must go out before the file data
+    while (m_tcpSocket->bytesToWrite() > 0)
+    {
+        if (!m_tcpSocket->waitForBytesWritten(kShortTimeout))
+            return;
+    }
+
+    int sd = m_tcpSocket->socketDescriptor();
+    off_t off = offset;
+    int tot = 0;
+    bool failed = false;
+
+    while (tot < size)
+    {
+        ssize_t sent = sendfile(sd, fd, &off, size - tot);
+        if (sent > 0)
+        {
+            tot += sent;
+            continue;
+        }
+        if (sent == 0)
+            break; // end of file
+
+        if (EINTR == errno)
+            continue;
+
+        if (EAGAIN == errno || EWOULDBLOCK == errno)
+        {
+            // QTcpSocket uses non-blocking sockets
+            struct pollfd pfd;
+            pfd.fd = sd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, kShortTimeout) > 0 && !(pfd.revents & POLLERR))
+                continue;
+        }
+
+        LOG(VB_NETWORK, LOG_WARNING, LOC +
+            QString("SendFile(%1, %2, %3) failed after %4 bytes")
+            .arg(fd).arg(offset).arg(size).arg(tot) + ENO);
+        failed = true;
+        break;
+    }
+
+    *ret = (failed && !tot) ? -1 : tot;
+#else
+    (void) fd;
+    (void) offset;
+    (void) size;
+#endif
+}
+
 void MythSocket::ResetReal(void)
 {
     vector<char> trash;
@@ -46,6 +46,15 @@ class MBASE_PUBLIC MythSocket : public QObject, public ReferenceCounter
     void SetAnnounce(const QStringList &strlist);
     bool IsAnnounced(void) const { return m_isAnnounced; }
 
+    /// Writes string lists in the binary framing, see EncodeStringList().
+    /// Only enable this once the peer has agreed to it during Validate().
+    void SetBinaryFraming(bool enabled) { m_binaryFraming = enabled; }
+    bool IsBinaryFraming(void) const { return m_binaryFraming; }
+
+    static QByteArray EncodeStringList(const QStringList &list);
+    static bool DecodeStringList(const char *data, int size,
+                                 QStringList &list);
+
     void SetReadyReadCallbackEnabled(bool enabled)
         { m_disableReadyReadCallback.fetchAndStoreOrdered((enabled) ? 0 : 1); }
 
@@ -66,11 +75,16 @@ class MBASE_PUBLIC MythSocket : public QObject, public ReferenceCounter
     // RemoteFile stuff
     int Write(const char*, int size);
     int Read(char*, int size, int max_wait_ms);
+    int SendFile(int fd, long long offset, int size);
     void Reset(void);
 
     static const uint kShortTimeout;
     static const uint kLongTimeout;
 
+    /// Added to MYTH_PROTO_VERSION and its ACCEPT by peers that read
+    /// the binary framing
+    static const char *kBinaryFramingToken;
+
   signals:
     void CallReadyRead(void);
 
@@ -89,6 +103,7 @@ class MBASE_PUBLIC MythSocket : public QObject, public ReferenceCounter
 
     void WriteReal(const char*, int size, int *ret);
     void ReadReal(char*, int size, int max_wait_ms, int *ret);
+    void SendFileReal(int fd, qlonglong offset, int size, int *ret);
     void ResetReal(void);
 
     void IsDataAvailableReal(bool *ret) const;
@@ -112,6 +127,7 @@ class MBASE_PUBLIC MythSocket : public QObject, public ReferenceCounter
     bool            m_isValidated; // only set in thread using MythSocket
     bool            m_isAnnounced; // only set in thread using MythSocket
     QStringList     m_announce; // only set in thread using MythSocket
+    bool            m_binaryFraming; // only set in thread using MythSocket
 
     static const int kSocketReceiveBufferSize;
 
@@ -0,0 +1,185 @@
+/*
+ *  Class TestLogging
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+#include <QThread>
+#include <QList>
+
+#include "mythlogging.h"
+#include "logging.h"
+
+// Writes numbered records into a ring as fast as the reader allows
+class RingWriterThread : public QThread
+{
+  public:
+    RingWriterThread(LogRing *ring, int count) :
+        m_ring(ring), m_count(count) {}
+
+    void run(void)
+    {
+        for (int i = 0; i < m_count; i++)
+        {
+            LogRecord *record;
+            while (!(record = m_ring->reserve()))
+                yieldCurrentThread();
+            record->line = i;
+            snprintf(record->message, LOGLINE_MAX, "message %d", i);
+            m_ring->commit();
+        }
+    }
+
+  private:
+    LogRing *m_ring;
+    int      m_count;
+};
+
+// Logs like a recorder that has -v record,channel turned on
+class LogThread : public QThread
+{
+  public:
+    explicit LogThread(int count) : m_count(count) {}
+
+    void run(void)
+    {
+        for (int i = 0; i < m_count; i++)
+        {
+            LOG(VB_GENERAL, LOG_INFO,
+                QString("RecBase[%1](/dev/dvb/adapter0/frontend0): "
+                        "Buffered %2 of %3 bytes")
+                .arg(i % 8).arg(i * 188).arg(188 * 1024));
+        }
+    }
+
+  private:
+    int m_count;
+};
+
+class TestLogging: public QObject
+{
+    Q_OBJECT
+
+    static void log_from_threads(int threads, int count)
+    {
+        QList<LogThread *> list;
+        for (int i = 0; i < threads; i++)
+            list.append(new LogThread(count));
+        for (int i = 0; i < threads; i++)
+            list[i]->start();
+        for (int i = 0; i < threads; i++)
+        {
+            list[i]->wait();
+            delete list[i];
+        }
+    }
+
+  private slots:
+    void initTestCase(void)
+    {
+        // quiet and without mythlogserver, so only LOG() itself is measured
+        logStart("", 0, 1, -1, LOG_INFO, false, false, true);
+    }
+
+    void cleanupTestCase(void)
+    {
+        logStop();
+    }
+
+    void ring_order(void)
+    {
+        LogRing *ring = new LogRing();
+        QVERIFY(ring->isEmpty());
+        QVERIFY(ring->peek() == NULL);
+
+        int next = 0;
+        for (int round = 0; round < 3; round++)
+        {
+            for (uint i = 0; i < LogRing::kSize; i++)
+            {
+                LogRecord *record = ring->reserve();
+                QVERIFY(record != NULL);
+                record->line = next + i;
+                ring->commit();
+            }
+            QVERIFY(ring->reserve() == NULL);
+            QCOMPARE(ring->count(), (uint)LogRing::kSize);
+
+            for (uint i = 0; i < LogRing::kSize; i++)
+            {
+                LogRecord *record = ring->peek();
+                QVERIFY(record != NULL);
+                QCOMPARE(record->line, (int)(next + i));
+                ring->release();
+            }
+            QVERIFY(ring->isEmpty());
+            next += LogRing::kSize;
+        }
+
+        delete ring;
+    }
+
+    void ring_threads(void)
+    {
+        const int count = 100000;
+        LogRing *ring = new LogRing();
+        RingWriterThread writer(ring, count);
+        writer.start();
+
+        int i = 0;
+        while (i < count)
+        {
+            LogRecord *record = ring->peek();
+            if (!record)
+            {
+                QThread::yieldCurrentThread();
+                continue;
+            }
+            QCOMPARE(record->line, i);
+            QCOMPARE(QString(record->message), QString("message %1").arg(i));
+            ring->release();
+            i++;
+        }
+
+        writer.wait();
+        QVERIFY(ring->isEmpty());
+        delete ring;
+    }
+
+    void benchmark_log_1thread(void)
+    {
+        QBENCHMARK
+        {
+            log_from_threads(1, 20000);
+        }
+    }
+
+    void benchmark_log_4threads(void)
+    {
+        QBENCHMARK
+        {
+            log_from_threads(4, 5000);
+        }
+    }
+
+    void benchmark_log_16threads(void)
+    {
+        QBENCHMARK
+        {
+            log_from_threads(16, 1250);
+        }
+    }
+};
@@ -0,0 +1,3 @@
+#include "test_mythsocket.h"
+
+QTEST_APPLESS_MAIN(TestMythSocket)
@@ -0,0 +1,133 @@
+/*
+ *  Class TestMythSocket
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "mythsocket.h"
+
+class TestMythSocket: public QObject
+{
+    Q_OBJECT
+
+    // Roughly what QUERY_RECORDINGS sends for a few recordings
+    static QStringList recording_list(int count)
+    {
+        QStringList list;
+        list << QString::number(count);
+        for (int i = 0; i < count; i++)
+        {
+            list << "Some Title" << "Some Subtitle"
+                 << "A description that is a bit longer than the rest."
+                 << "0" << "1" << "0" << "Drama" << QString::number(1000 + i)
+                 << "101" << "CALL" << "Channel Name"
+                 << "myth://Default@host/1001_20140101000000.ts"
+                 << "1234567890" << "1388534400" << "1388538000"
+                 << "0" << "host" << "0" << "0" << "0" << "-1" << "0"
+                 << "0" << "1388534400" << "1388538000" << "1207959556"
+                 << "Default" << "1" << "0" << "Default" << "EP000000000000"
+                 << "EP000000000000" << "" << "1388538000" << "0.000000"
+                 << "2014-01-01" << "0" << "0" << "Default" << "0" << "0"
+                 << "Default" << "0" << "32" << "0" << "0" << "0" << "0"
+                 << "0" << "0" << "0" << "0";
+        }
+        return list;
+    }
+
+    static QStringList roundtrip(const QStringList &list)
+    {
+        QByteArray data = MythSocket::EncodeStringList(list);
+        QStringList out;
+        if (!MythSocket::DecodeStringList(data.constData(), data.size(), out))
+            out << "decode failed";
+        return out;
+    }
+
+  private slots:
+    void roundtrip_fields(void)
+    {
+        QStringList list;
+        list << "QUERY_RECORDINGS Play" << "" << "0" << "-1" << "42"
+             << "123456789012345678" << "-123456789012345678"
+             << "007" << "-0" << "+5" << "1.5" << " 1" << "-"
+             << "1234567890123456789" << "99999999999999999999"
+             << "[]:[]" << QString::fromUtf8("Sch\xc3\xb6ne Gr\xc3\xbc\xc3\x9f" "e")
+             << QString(QChar(0));
+
+        QCOMPARE(roundtrip(list), list);
+    }
+
+    void native_integers(void)
+    {
+        // tag and 8 bytes for each integer
+        QByteArray data = MythSocket::EncodeStringList(
+            QStringList() << "0" << "-1" << "123456789012345678");
+        QCOMPARE(data.size(), 27);
+        QCOMPARE(data[0], 'I');
+
+        // tag, 4 byte length and the UTF-8 bytes for anything else
+        data = MythSocket::EncodeStringList(QStringList() << "007" << "");
+        QCOMPARE(data.size(), 13);
+        QCOMPARE(data[0], 'S');
+    }
+
+    void decode_malformed(void)
+    {
+        QStringList list;
+        QByteArray data = MythSocket::EncodeStringList(
+            QStringList() << "title" << "1234");
+
+        QVERIFY(!MythSocket::DecodeStringList(data.constData(), 0, list));
+        for (int size = 1; size < data.size(); size++)
+        {
+            if (size == 10)  // ends after "title"
+                continue;
+            QVERIFY(!MythSocket::DecodeStringList(
+                         data.constData(), size, list));
+        }
+        QVERIFY(MythSocket::DecodeStringList(data.constData(), 10, list));
+        QCOMPARE(list, QStringList() << "title");
+
+        data[10] = 'X';
+        QVERIFY(!MythSocket::DecodeStringList(
+                     data.constData(), data.size(), list));
+    }
+
+    void benchmark_text(void)
+    {
+        QStringList list = recording_list(1000);
+        QStringList out;
+        QBENCHMARK
+        {
+            QByteArray utf8 = list.join("[]:[]").toUtf8();
+            out = QString::fromUtf8(utf8.constData()).split("[]:[]");
+        }
+        QCOMPARE(out, list);
+    }
+
+    void benchmark_binary(void)
+    {
+        QStringList list = recording_list(1000);
+        QStringList out;
+        QBENCHMARK
+        {
+            QByteArray data = MythSocket::EncodeStringList(list);
+            MythSocket::DecodeStringList(data.constData(), data.size(), out);
+        }
+        QCOMPARE(out, list);
+    }
+};
@@ -3,6 +3,9 @@
 #include <cstdlib>
 #include <cerrno>
 
+// C++ headers
+#include <algorithm>
+
 // Unix C headers
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -44,6 +47,8 @@ void TFWSyncThread::run(void)
 const uint ThreadedFileWriter::kMaxBufferSize   = 8 * 1024 * 1024;
 const uint ThreadedFileWriter::kMinWriteSize    = 64 * 1024;
 const uint ThreadedFileWriter::kMaxBlockSize    = 1 * 1024 * 1024;
+const uint ThreadedFileWriter::kDirectBufferSize = 2 * 1024 * 1024;
+const uint ThreadedFileWriter::kDirectAlignment = 4096;
 
 /** \class ThreadedFileWriter
  *  \brief This class supports the writing of recordings to disk.
@@ -54,6 +59,11 @@ const uint ThreadedFileWriter::kMaxBlockSize    = 1 * 1024 * 1024;
  *   using another thread. The goal here so to block as little as
  *   possible when the classes using this class want to add data
  *   to the stream.
+ *
+ *   Optionally (see SetDirectIO()) the file is written with O_DIRECT,
+ *   bypassing the page cache, so many simultaneous recordings don't
+ *   push data other processes are reading out of memory. If the file
+ *   system refuses O_DIRECT we fall back to ordinary writes.
  */
 
 /** \fn ThreadedFileWriter::ThreadedFileWriter(const QString&,int,mode_t)
@@ -71,7 +81,9 @@ ThreadedFileWriter::ThreadedFileWriter(const QString &fname,
     // threads
     writeThread(NULL),                   syncThread(NULL),
     m_warned(false),                     m_blocking(false),
-    m_registered(false)
+    m_registered(false),
+    m_directIO(false),                   m_directBuf(NULL),
+    m_directUsed(0),                     m_directTailDirty(false)
 {
     filename.detach();
 }
@@ -99,6 +111,12 @@ bool ThreadedFileWriter::ReOpen(QString newFilename)
         gCoreContext->UnregisterFileForWrite(filename);
     }
 
+    if (m_directBuf)
+    {
+        free(m_directBuf);
+        m_directBuf = NULL;
+    }
+
     if (!newFilename.isEmpty())
         filename = newFilename;
 
@@ -138,6 +156,12 @@ bool ThreadedFileWriter::Open(void)
 #ifdef _WIN32
     _setmode(fd, _O_BINARY);
 #endif
+
+    m_directUsed = 0;
+    m_directTailDirty = false;
+    if (m_directIO && filename != "-")
+        EnableDirectIO();
+
     if (!writeThread)
     {
         writeThread = new TFWWriteThread(this);
@@ -199,6 +223,12 @@ ThreadedFileWriter::~ThreadedFileWriter()
         fd = -1;
     }
 
+    if (m_directBuf)
+    {
+        free(m_directBuf);
+        m_directBuf = NULL;
+    }
+
     gCoreContext->UnregisterFileForWrite(filename);
     m_registered = false;
 }
@@ -320,7 +350,7 @@ long long ThreadedFileWriter::Seek(long long pos, int whence)
 {
     QMutexLocker locker(&buflock);
     flush = true;
-    while (!writeBuffers.empty())
+    while (!writeBuffers.empty() || m_directTailDirty)
     {
         bufferHasData.wakeAll();
         if (!bufferEmpty.wait(locker.mutex(), 2000))
@@ -331,6 +361,18 @@ long long ThreadedFileWriter::Seek(long long pos, int whence)
         }
     }
     flush = false;
+
+    if (m_directBuf)
+    {
+        // The unaligned tail was written without moving the file
+        // offset, account for it before seeking. Writes resume at an
+        // arbitrary offset, so O_DIRECT can't be used for them.
+        if (m_directUsed)
+            lseek(fd, m_directUsed, SEEK_CUR);
+        m_directUsed = 0;
+        DisableDirectIO();
+    }
+
     return lseek(fd, pos, whence);
 }
 
@@ -341,7 +383,7 @@ void ThreadedFileWriter::Flush(void)
 {
     QMutexLocker locker(&buflock);
     flush = true;
-    while (!writeBuffers.empty())
+    while (!writeBuffers.empty() || m_directTailDirty)
     {
         bufferHasData.wakeAll();
         if (!bufferEmpty.wait(locker.mutex(), 2000))
@@ -460,6 +502,7 @@ void ThreadedFileWriter::DiskLoop(void)
                 delete emptyBuffers.front();
                 emptyBuffers.pop_front();
             }
+            m_directTailDirty = false;
             bufferEmpty.wakeAll();
             bufferHasData.wait(locker.mutex());
             continue;
@@ -467,6 +510,15 @@ void ThreadedFileWriter::DiskLoop(void)
 
         if (writeBuffers.empty())
         {
+            // FlushDirectTail() logs its own errors. Like a failed
+            // write() the tail is not retried, or Flush() would wait
+            // on a full or broken disk forever. It is still in the
+            // staging buffer and goes out with the next aligned write.
+            if (flush && m_directTailDirty)
+            {
+                FlushDirectTail();
+                m_directTailDirty = false;
+            }
             bufferEmpty.wakeAll();
             bufferHasData.wait(locker.mutex(), 1000);
             TrimEmptyBuffers();
@@ -514,7 +566,9 @@ void ThreadedFileWriter::DiskLoop(void)
         {
             locker.unlock();
 
-            int ret = write(fd, (char *)data + tot, sz - tot);
+            int ret = (m_directBuf) ?
+                DirectWrite((char *)data + tot, sz - tot) :
+                write(fd, (char *)data + tot, sz - tot);
 
             if (ret < 0)
             {
@@ -562,6 +616,7 @@ void ThreadedFileWriter::DiskLoop(void)
 
         buf->lastUsed = MythDate::current();
         emptyBuffers.push_back(buf);
+        m_directTailDirty = m_directBuf && m_directUsed;
 
         if (writeTimer.elapsed() > 1000)
         {
@@ -637,3 +692,158 @@ bool ThreadedFileWriter::SetBlocking(bool block)
     m_blocking = block;
     return old;
 }
+
+/**
+ *  \brief Request writing the file with O_DIRECT, must be called before
+ *         Open(). Writes go through an aligned staging buffer and never
+ *         enter the page cache; unsupported file systems fall back to
+ *         normal writes.
+ *  \return old mode value
+ *  \param direct True to bypass the page cache
+ */
+bool ThreadedFileWriter::SetDirectIO(bool direct)
+{
+    bool old = m_directIO;
+    m_directIO = direct;
+    return old;
+}
+
+/** \fn ThreadedFileWriter::EnableDirectIO(void)
+ *  \brief Sets O_DIRECT on the file and allocates the staging buffer.
+ */
+bool ThreadedFileWriter::EnableDirectIO(void)
+{
+#ifdef O_DIRECT
+    if (lseek(fd, 0, SEEK_CUR) % kDirectAlignment)
+        return false;
+
+    void *mem = NULL;
+    if (!m_directBuf &&
+        posix_memalign(&mem, kDirectAlignment, kDirectBufferSize) != 0)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            "Unable to allocate O_DIRECT buffer, using buffered writes");
+        return false;
+    }
+
+    int fl = fcntl(fd, F_GETFL);
+    if (fl < 0 || fcntl(fd, F_SETFL, fl | O_DIRECT) < 0)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            "O_DIRECT not supported, using buffered writes" + ENO);
+        free(mem);
+        return false;
+    }
+
+    if (mem)
+        m_directBuf = (char*) mem;
+    m_directUsed = 0;
+
+    LOG(VB_FILE, LOG_INFO, LOC + "Writing with O_DIRECT");
+    return true;
+#else
+    return false;
+#endif
+}
+
+/** \fn ThreadedFileWriter::DisableDirectIO(void)
+ *  \brief Clears O_DIRECT, writing out anything still staged.
+ */
+void ThreadedFileWriter::DisableDirectIO(void)
+{
+    if (!m_directBuf)
+        return;
+
+#ifdef O_DIRECT
+    int fl = fcntl(fd, F_GETFL);
+    if (fl >= 0)
+        fcntl(fd, F_SETFL, fl & ~O_DIRECT);
+#endif
+
+    uint tot = 0;
+    while (tot < m_directUsed)
+    {
+        ssize_t ret = write(fd, m_directBuf + tot, m_directUsed - tot);
+        if (ret <= 0 && errno != EAGAIN && errno != EINTR)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                "Lost data while leaving O_DIRECT mode" + ENO);
+            break;
+        }
+        tot += (ret > 0) ? ret : 0;
+    }
+
+    free(m_directBuf);
+    m_directBuf = NULL;
+    m_directUsed = 0;
+}
+
+/** \fn ThreadedFileWriter::DirectWrite(const char*, uint)
+ *  \brief Adds data to the O_DIRECT staging buffer and writes all
+ *         complete kDirectAlignment sized blocks in it.
+ *  \return number of bytes of data consumed, or -1 on error.
+ */
+int ThreadedFileWriter::DirectWrite(const char *data, uint count)
+{
+    uint len = std::min(count, kDirectBufferSize - m_directUsed);
+    memcpy(m_directBuf + m_directUsed, data, len);
+    m_directUsed += len;
+
+    uint aligned = m_directUsed - (m_directUsed % kDirectAlignment);
+    if (!aligned)
+        return len;
+
+    ssize_t ret = write(fd, m_directBuf, aligned);
+    if (ret < 0)
+    {
+        int err = errno;
+        m_directUsed -= len;
+        if (EINVAL == err)
+        {
+            // The file system doesn't support O_DIRECT after all
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                "O_DIRECT write refused, using buffered writes");
+            DisableDirectIO();
+            return 0;
+        }
+        errno = err;
+        return -1;
+    }
+
+    memmove(m_directBuf, m_directBuf + ret, m_directUsed - ret);
+    m_directUsed -= ret;
+
+    // a short write leaves the file offset unaligned
+    if (ret % kDirectAlignment)
+        DisableDirectIO();
+
+    return len;
+}
+
+/** \fn ThreadedFileWriter::FlushDirectTail(void)
+ *  \brief Makes the unaligned remainder of the staging buffer visible in
+ *         the file without moving the file offset, so the next aligned
+ *         O_DIRECT write simply rewrites that block.
+ */
+bool ThreadedFileWriter::FlushDirectTail(void)
+{
+#ifdef O_DIRECT
+    if (!m_directBuf || !m_directUsed)
+        return true;
+
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    int fl = fcntl(fd, F_GETFL);
+    if (pos < 0 || fl < 0 || fcntl(fd, F_SETFL, fl & ~O_DIRECT) < 0)
+        return false;
+
+    bool ok = pwrite(fd, m_directBuf, m_directUsed, pos) ==
+        (ssize_t) m_directUsed;
+    if (!ok)
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Flushing O_DIRECT tail" + ENO);
+
+    fcntl(fd, F_SETFL, fl);
+    return ok;
+#else
+    return true;
+#endif
+}
@@ -57,6 +57,7 @@ class MBASE_PUBLIC ThreadedFileWriter
     void Sync(void);
     void Flush(void);
     bool SetBlocking(bool block = true);
+    bool SetDirectIO(bool direct = true);
     bool WritesFailing(void) const { return ignore_writes; }
 
   protected:
@@ -64,6 +65,12 @@ class MBASE_PUBLIC ThreadedFileWriter
     void SyncLoop(void);
     void TrimEmptyBuffers(void);
 
+    // O_DIRECT support, only used by the write thread
+    bool EnableDirectIO(void);
+    void DisableDirectIO(void);
+    int  DirectWrite(const char *data, uint count);
+    bool FlushDirectTail(void);
+
   private:
     // file info
     QString         filename;
@@ -105,10 +112,21 @@ class MBASE_PUBLIC ThreadedFileWriter
     static const uint kMinWriteSize;
     /// Maximum block size to write at a time
     static const uint kMaxBlockSize;
+    /// Size of the staging buffer used for O_DIRECT writes
+    static const uint kDirectBufferSize;
+    /// File offset, length and memory alignment needed for O_DIRECT
+    static const uint kDirectAlignment;
 
     bool m_warned;
     bool m_blocking;
     bool m_registered;
+
+    // O_DIRECT staging buffer, data is written out in kDirectAlignment
+    // sized pieces and the remainder kept until more data arrives.
+    bool  m_directIO;         // requested by SetDirectIO()
+    char *m_directBuf;        // non-NULL while O_DIRECT is in use
+    uint  m_directUsed;
+    bool  m_directTailDirty;  // protected by buflock
 };
 
 #endif
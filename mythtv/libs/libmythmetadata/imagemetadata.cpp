@@ -12,8 +12,10 @@
 // file.  Using image.hpp instead seems to work.
 #ifdef _MSC_VER
 #include <exiv2/src/image.hpp>
+#include <exiv2/src/preview.hpp>
 #else
 #include <exiv2/image.hpp>
+#include <exiv2/preview.hpp>
 #endif
 
 // To read FFMPEG Metadata
@@ -269,6 +271,7 @@ public:
     virtual int         GetOrientation(bool *exists = NULL);
     virtual QDateTime   GetOriginalDateTime(bool *exists = NULL);
     virtual QString     GetComment(bool *exists = NULL);
+    virtual QImage      GetThumbnail(const QSize &size);
 
 protected:
     static QString DecodeComment(std::string rawValue);
@@ -460,6 +463,64 @@ QString PictureMetaData::GetComment(bool *exists)
 }
 
 
+/*!
+   \brief Read the smallest embedded preview that fills a thumbnail
+   \details Previews that would have to be enlarged, or whose shape differs
+   from the image (ie. are letterboxed), are ignored. Previews carry no
+   orientation, so Qt never rotates them when loading.
+   \param size Thumbnail size
+   \return Preview image, or a null image if there is no suitable preview
+ */
+QImage PictureMetaData::GetThumbnail(const QSize &size)
+{
+    if (!IsValid())
+        return QImage();
+
+    try
+    {
+        QSize imageSize(m_image->pixelWidth(), m_image->pixelHeight());
+        if (imageSize.isEmpty())
+            return QImage();
+
+        Exiv2::PreviewManager manager(*m_image);
+        Exiv2::PreviewPropertiesList list = manager.getPreviewProperties();
+
+        // Previews are listed smallest first
+        Exiv2::PreviewPropertiesList::const_iterator it;
+        for (it = list.begin(); it != list.end(); ++it)
+        {
+            QSize previewSize(it->width_, it->height_);
+            QSize fitted = previewSize.scaled(size, Qt::KeepAspectRatio);
+            if (previewSize.width() < fitted.width()
+                    || previewSize.height() < fitted.height())
+                continue;
+
+            // Aspect ratios have to agree within 2%, which allows for
+            // rounding of the preview size but not for letterboxing
+            qint64 previewAspect = (qint64)previewSize.width() * imageSize.height();
+            qint64 imageAspect   = (qint64)previewSize.height() * imageSize.width();
+            if (qAbs(previewAspect - imageAspect) > previewAspect / 50)
+                continue;
+
+            Exiv2::PreviewImage preview = manager.getPreviewImage(*it);
+            QImage image;
+            if (image.loadFromData(preview.pData(), preview.size()))
+            {
+                LOG(VB_FILE, LOG_DEBUG, LOC + QString("Using %1x%2 preview of %3")
+                    .arg(previewSize.width()).arg(previewSize.height())
+                    .arg(m_filePath));
+                return image;
+            }
+        }
+    }
+    catch (Exiv2::Error &e)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("Exiv2 exception %1").arg(e.what()));
+    }
+    return QImage();
+}
+
+
 /*!
    \brief Decodes charset of UserComment
    \param rawValue Metadata value with optional "[charset=...]" prefix
@@ -491,6 +552,7 @@ public:
     virtual int         GetOrientation(bool *exists = NULL);
     virtual QDateTime   GetOriginalDateTime(bool *exists = NULL);
     virtual QString     GetComment(bool *exists = NULL);
+    virtual QImage      GetThumbnail(const QSize &size);
 
 protected:
     QString GetTag(const QString &key, bool *exists = NULL);
@@ -694,6 +756,18 @@ QString VideoMetaData::GetComment(bool *exists)
 }
 
 
+/*!
+   \brief Read embedded preview
+   \details Videos have none
+   \param size Thumbnail size
+   \return Null image
+ */
+QImage VideoMetaData::GetThumbnail(const QSize &)
+{
+    return QImage();
+}
+
+
 /*!
    \brief Factory to retrieve metadata from pictures
    \param filePath Image path
@@ -13,6 +13,7 @@
 #include <QStringBuilder>
 #include <QStringList>
 #include <QDateTime>
+#include <QImage>
 
 #include "mythmetaexp.h"
 
@@ -120,6 +121,7 @@ public:
     virtual int         GetOrientation(bool *exists = NULL)      = 0;
     virtual QDateTime   GetOriginalDateTime(bool *exists = NULL) = 0;
     virtual QString     GetComment(bool *exists = NULL)          = 0;
+    virtual QImage      GetThumbnail(const QSize &size)          = 0;
 
 protected:
     explicit ImageMetaData(const QString &filePath) : m_filePath(filePath) {}
@@ -1,6 +1,8 @@
 #include "imagethumbs.h"
 
 #include <QDir>
+#include <QImageReader>
+#include <QScopedPointer>
 #include <QStringList>
 
 #include "mythlogging.h"
@@ -12,16 +14,39 @@
 
 #include "imagemetadata.h"
 
+/*!
+ \brief Handles thumbnail requests until its generator has none left
+*/
+template <class DBFS>
+void ThumbWorker<DBFS>::run()
+{
+    RunProlog();
+
+    setPriority(QThread::LowestPriority);
+
+    m_parent->Process(this);
+
+    RunEpilog();
+}
+
+
 /*!
  \brief Constructor
  \param name Thread name
  \param dbfs Filesystem/Database adapter
+ \param workers Number of worker threads
 */
 template <class DBFS>
-ThumbThread<DBFS>::ThumbThread(const QString &name, DBFS *const dbfs)
-    : MThread(name), m_dbfs(*dbfs),
+ThumbThread<DBFS>::ThumbThread(const QString &name, DBFS *const dbfs,
+                               int workers)
+    : m_dbfs(*dbfs),
       m_requestQ(), m_backgroundQ(), m_doBackground(true)
-{}
+{
+    for (int i = 0; i < qMax(workers, 1); ++i)
+        m_workers.append(new ThumbWorker<DBFS>(
+                             workers > 1 ? QString("%1%2").arg(name).arg(i)
+                                         : name, this));
+}
 
 
 /*!
@@ -31,12 +56,15 @@ template <class DBFS>
 ThumbThread<DBFS>::~ThumbThread()
 {
     cancel();
-    wait();
+
+    // Waits for the workers to finish their current tasks
+    qDeleteAll(m_workers);
+    m_workers.clear();
 }
 
 
 /*!
- \brief Clears all queues so that the thread will terminate.
+ \brief Clears all queues so that the workers will terminate.
 */
 template <class DBFS>
 void ThumbThread<DBFS>::cancel()
@@ -65,9 +93,35 @@ void ThumbThread<DBFS>::Enqueue(const TaskPtr &task)
         else
             m_requestQ.insert(task->m_priority, task);
 
-        // restart if not already running
-        if ((m_doBackground || !background) && !this->isRunning())
-            this->start();
+        // restart workers if not already running
+        if (m_doBackground || !background)
+            StartWorkers();
+    }
+}
+
+
+/*!
+ \brief Starts idle workers for the queued tasks
+ \details Must be called with the queues locked
+*/
+template <class DBFS>
+void ThumbThread<DBFS>::StartWorkers()
+{
+    int pending = m_requestQ.size() + (m_doBackground ? m_backgroundQ.size() : 0);
+
+    foreach (ThumbWorker<DBFS> *worker, m_workers)
+    {
+        if (pending <= 0)
+            break;
+
+        if (worker->m_active)
+            continue;
+
+        // A worker that has run out of tasks may not have exited yet
+        worker->wait();
+        worker->m_active = true;
+        worker->start();
+        --pending;
     }
 }
 
@@ -81,12 +135,14 @@ void ThumbThread<DBFS>::AbortDevice(int devId, const QString &action)
 {
     if (action == "DEVICE CLOSE ALL" || action == "DEVICE CLEAR ALL")
     {
-        if (isRunning())
+        QMutexLocker locker(&m_mutex);
+        if (!m_busy.isEmpty())
             LOG(VB_FILE, LOG_INFO,
                 QString("Aborting all thumbnails %1").arg(action));
 
         // Abort thumbnail generation for all devices
-        cancel();
+        m_requestQ.clear();
+        m_backgroundQ.clear();
         return;
     }
 
@@ -97,9 +153,10 @@ void ThumbThread<DBFS>::AbortDevice(int devId, const QString &action)
     QMutexLocker locker(&m_mutex);
     RemoveTasks(m_requestQ, devId);
     RemoveTasks(m_backgroundQ, devId);
-    if (isRunning())
-        // Wait until current task is complete - it may be using the device
-        m_taskDone.wait(&m_mutex, 3000);
+
+    // Wait until current tasks are complete - they may be using the device
+    while (IsBusy(devId) && m_taskDone.wait(&m_mutex, 3000))
+        ;
 }
 
 
@@ -122,40 +179,96 @@ void ThumbThread<DBFS>::RemoveTasks(ThumbQueue &queue, int devId)
 }
 
 
+/*!
+ \brief Determines whether a worker is processing a task for a device
+ \details Must be called with the queues locked
+*/
+template <class DBFS>
+bool ThumbThread<DBFS>::IsBusy(int devId) const
+{
+    foreach (const TaskPtr &task, m_busy)
+        // All thumbs in a task come from same device
+        if (!task->m_images.isEmpty() && task->m_images.at(0)->m_device == devId)
+            return true;
+    return false;
+}
+
+
+/*!
+ \brief Removes the highest priority task that can be processed now
+ \details Tasks for images that another worker is processing are left queued
+ so that a thumbnail is never moved or deleted whilst it is being created.
+ Must be called with the queues locked
+ \param queue Task queue
+ \return Task, or NULL if no queued task can be processed
+*/
+template <class DBFS>
+TaskPtr ThumbThread<DBFS>::TakeTask(ThumbQueue &queue)
+{
+    typename ThumbQueue::iterator it;
+    for (it = queue.begin(); it != queue.end(); ++it)
+    {
+        TaskPtr task = it.value();
+        bool busy = false;
+        foreach (const ImagePtrK &im, task->m_images)
+            if ((busy = m_busyImages.contains(im->m_id)))
+                break;
+
+        if (!busy)
+        {
+            queue.erase(it);
+            return task;
+        }
+    }
+    return TaskPtr();
+}
+
+
 /*!
  \brief  Handles thumbnail requests by priority
  \details Repeatedly processes next request from highest priority queue until all
   queues are empty, then quits. For Create requests an event is broadcast once the
   thumbnail exists. Dirs are only deleted if empty
+ \param worker The worker thread
 */
 template <class DBFS>
-void ThumbThread<DBFS>::run()
+void ThumbThread<DBFS>::Process(ThumbWorker<DBFS> *worker)
 {
-    RunProlog();
-
-    setPriority(QThread::LowestPriority);
-
+    TaskPtr task;
     while (true)
     {
-        // Signal previous task is complete (its files have been closed)
-        m_taskDone.wakeAll();
-
-        // Do all we can to run in background
-        QThread::yieldCurrentThread();
-
-        // process next highest-priority task
-        TaskPtr task;
         {
             QMutexLocker locker(&m_mutex);
-            if (!m_requestQ.isEmpty())
-                task = m_requestQ.take(m_requestQ.constBegin().key());
-            else if (m_doBackground && !m_backgroundQ.isEmpty())
-                task = m_backgroundQ.take(m_backgroundQ.constBegin().key());
-            else
+
+            if (task)
+            {
+                // Signal previous task is complete (its files have been closed)
+                m_busy.removeOne(task);
+                foreach (const ImagePtrK &im, task->m_images)
+                    m_busyImages.remove(im->m_id);
+                m_taskDone.wakeAll();
+            }
+
+            // process next highest-priority task
+            task = TakeTask(m_requestQ);
+            if (!task && m_doBackground)
+                task = TakeTask(m_backgroundQ);
+
+            if (!task)
+            {
                 // quit when both queues exhausted
+                worker->m_active = false;
                 break;
+            }
+
+            m_busy.append(task);
+            foreach (const ImagePtrK &im, task->m_images)
+                m_busyImages.insert(im->m_id);
         }
 
+        // Do all we can to run in background
+        QThread::yieldCurrentThread();
+
         // Shouldn't receive empty requests
         if (task->m_images.isEmpty())
             continue;
@@ -192,10 +305,7 @@ void ThumbThread<DBFS>::run()
                     QString("Deleted thumbnail %1").arg(thumbnail));
 
                 // Clean up empty dirs
-                QString path = QFileInfo(thumbnail).path();
-                if (QDir::root().rmpath(path))
-                    LOG(VB_FILE, LOG_DEBUG,
-                        QString("Cleaned up path %1").arg(path));
+                RemoveEmptyDir(QFileInfo(thumbnail).path());
             }
         }
         else if (task->m_action == "MOVE")
@@ -207,9 +317,15 @@ void ThumbThread<DBFS>::run()
                         m_dbfs.GetAbsThumbPath(m_dbfs.ThumbDir(im->m_device),
                                                m_dbfs.ThumbPath(*im.data()));
 
-                // Ensure path exists
-                if (QDir::root().mkpath(QFileInfo(newThumbPath).path())
-                        && QFile::rename(im->m_thumbPath, newThumbPath))
+                // Ensure path exists. Dirs are only made and removed with
+                // the queues locked, so no other worker can remove it first
+                bool moved;
+                {
+                    QMutexLocker locker(&m_mutex);
+                    moved = QDir::root().mkpath(QFileInfo(newThumbPath).path())
+                            && QFile::rename(im->m_thumbPath, newThumbPath);
+                }
+                if (moved)
                 {
                     LOG(VB_FILE, LOG_DEBUG, QString("Moved thumbnail %1 -> %2")
                         .arg(im->m_thumbPath, newThumbPath));
@@ -223,18 +339,41 @@ void ThumbThread<DBFS>::run()
                 }
 
                 // Clean up empty dirs
-                QString path = QFileInfo(im->m_thumbPath).path();
-                if (QDir::root().rmpath(path))
-                    LOG(VB_FILE, LOG_DEBUG,
-                        QString("Cleaned up path %1").arg(path));
+                RemoveEmptyDir(QFileInfo(im->m_thumbPath).path());
             }
         }
         else
             LOG(VB_GENERAL, LOG_ERR,
                 QString("Unknown task %1").arg(task->m_action));
     }
+}
 
-    RunEpilog();
+
+/*!
+ \brief Removes a thumbnail dir and its parents, if they are empty
+ \details Dirs that a busy task is creating a thumbnail in are kept, even
+ whilst they are still empty. Dirs are only made and removed with the queues
+ locked, so a worker can't lose its dir between making it and saving into it
+ \param path Thumbnail dir
+*/
+template <class DBFS>
+void ThumbThread<DBFS>::RemoveEmptyDir(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+
+    foreach (const TaskPtr &task, m_busy)
+    {
+        if (task->m_action != "CREATE" || task->m_images.isEmpty())
+            continue;
+
+        // rmpath removes the dir itself and then its empty parents
+        QString dir = QFileInfo(task->m_images.at(0)->m_thumbPath).path();
+        if (path == dir || path.startsWith(dir + '/'))
+            return;
+    }
+
+    if (QDir::root().rmpath(path))
+        LOG(VB_FILE, LOG_DEBUG, QString("Cleaned up path %1").arg(path));
 }
 
 
@@ -260,17 +399,24 @@ QString ThumbThread<DBFS>::CreateThumbnail(ImagePtrK im, int thumbPriority)
     if (imagePath.isEmpty())
         return QString("Empty image path: %1").arg(im->m_filePath);
 
-    // Ensure path exists
-    QDir::root().mkpath(QFileInfo(im->m_thumbPath).path());
+    // Ensure path exists. It is kept until this task is done
+    {
+        QMutexLocker locker(&m_mutex);
+        QDir::root().mkpath(QFileInfo(im->m_thumbPath).path());
+    }
 
     QImage image;
+    bool fromPreview = false;
     if (im->m_type == kImageFile)
     {
-        if (!image.load(imagePath))
+        // Resize to optimise load/display time by FE's
+        QSize size(240, 180);
+
+        image = LoadPicture(imagePath, size, &fromPreview);
+        if (image.isNull())
             return QString("Failed to open image %1").arg(imagePath);
 
-        // Resize to optimise load/display time by FE's
-        image = image.scaled(QSize(240,180), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
     }
     else if (im->m_type == kVideoFile)
     {
@@ -307,7 +453,7 @@ QString ThumbThread<DBFS>::CreateThumbnail(ImagePtrK im, int thumbPriority)
 
     // Compensate for any Qt auto-orientation
     int orientBy = Orientation(im->m_orientation)
-            .GetCurrent(im->m_type == kImageFile);
+            .GetCurrent(im->m_type == kImageFile && !fromPreview);
 
     // Orientate now to optimise load/display time - no orientation
     // is required when displaying thumbnails
@@ -323,6 +469,44 @@ QString ThumbThread<DBFS>::CreateThumbnail(ImagePtrK im, int thumbPriority)
 }
 
 
+/*!
+ \brief Loads a picture no smaller than a thumbnail, as cheaply as possible
+ \details Uses an embedded Exif preview when there is one that is big enough.
+ Otherwise the picture is decoded at a reduced size, which JPEGs do whilst
+ decoding (by skipping DCT coefficients) rather than after loading the
+ full image.
+ \param imagePath Absolute image path
+ \param size Thumbnail size
+ \param [out] fromPreview True if the image is an embedded preview
+ \return Image, or a null image if the picture could not be read
+ */
+template <class DBFS>
+QImage ThumbThread<DBFS>::LoadPicture(const QString &imagePath,
+                                      const QSize &size, bool *fromPreview)
+{
+    QScopedPointer<ImageMetaData> metadata(ImageMetaData::FromPicture(imagePath));
+    QImage image = metadata->GetThumbnail(size);
+    *fromPreview = !image.isNull();
+    if (*fromPreview)
+        return image;
+
+    QImageReader reader(imagePath);
+    QSize fullSize = reader.size();
+
+    // Decode at twice the thumbnail size, leaving the final smooth scaling
+    // to produce a thumbnail as good as one scaled from the full image
+    QSize decodeSize = fullSize.scaled(size * 2, Qt::KeepAspectRatio);
+    if (fullSize.isValid() && decodeSize.width() < fullSize.width())
+        reader.setScaledSize(decodeSize);
+
+    if (!reader.read(&image))
+        LOG(VB_FILE, LOG_DEBUG, QString("Failed to read %1: %2")
+            .arg(imagePath, reader.errorString()));
+
+    return image;
+}
+
+
 /*!
   \brief Pauses or restarts processing of background tasks (scanner requests)
  */
@@ -332,9 +516,9 @@ void ThumbThread<DBFS>::PauseBackground(bool pause)
     QMutexLocker locker(&m_mutex);
     m_doBackground = !pause;
 
-    // restart if not already running
-    if (m_doBackground && !this->isRunning())
-        this->start();
+    // restart workers if not already running
+    if (m_doBackground)
+        StartWorkers();
 }
 
 
@@ -344,7 +528,8 @@ void ThumbThread<DBFS>::PauseBackground(bool pause)
 template <class DBFS>
 ImageThumb<DBFS>::ImageThumb(DBFS *const dbfs)
     : m_dbfs(*dbfs),
-      m_imageThread(new ThumbThread<DBFS>("ImageThumbs", dbfs)),
+      m_imageThread(new ThumbThread<DBFS>("ImageThumbs", dbfs,
+                                          QThread::idealThreadCount())),
       m_videoThread(new ThumbThread<DBFS>("VideoThumbs", dbfs))
 {}
 
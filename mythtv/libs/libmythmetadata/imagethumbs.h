@@ -1,12 +1,15 @@
 //! \file
 //! \brief Creates and manages thumbnails
-//! \details Uses two worker threads to process thumbnail requests that are queued
+//! \details Uses two generators to process thumbnail requests that are queued
 //! from the scanner and UI.
-//! One thread generates picture thumbs; the other video thumbs, which are delegated
-//! to previewgenerator and time-consuming.
-//! Both background threads are low-priority to avoid recording issues.
+//! One generates picture thumbs using a worker thread per core; the other video
+//! thumbs, which are delegated to previewgenerator and time-consuming, using a
+//! single worker thread.
+//! All background threads are low-priority to avoid recording issues.
 //! Requests are handled by client-assigned priority so that UI display requests
-//! are serviced before background scanner requests.
+//! are serviced before background scanner requests. The workers of a generator
+//! share its queues, so they always take the highest priority request that is
+//! not waiting for another worker to finish with the same image.
 //! When images are removed, their thumbnails are also deleted (thumbnail cache is
 //! synchronised to database). Obsolete images are broadcast to enable clients to
 //! also cleanup/synchronise their caches.
@@ -14,7 +17,9 @@
 #ifndef IMAGETHUMBS_H
 #define IMAGETHUMBS_H
 
+#include <QImage>
 #include <QMap>
+#include <QSet>
 #include <QMutex>
 #include <QWaitCondition>
 
@@ -78,12 +83,36 @@ public:
 typedef QSharedPointer<ThumbTask> TaskPtr;
 
 
+template <class DBFS> class ThumbThread;
+
+
 //! A generator worker thread
 template <class DBFS>
-class ThumbThread : public MThread
+class ThumbWorker : public MThread
 {
 public:
-    ThumbThread(const QString &name, DBFS *const dbfs);
+    ThumbWorker(const QString &name, ThumbThread<DBFS> *parent)
+        : MThread(name), m_parent(parent), m_active(false) {}
+    ~ThumbWorker() { wait(); }
+
+protected:
+    void run();
+
+private:
+    Q_DISABLE_COPY(ThumbWorker)
+    friend class ThumbThread<DBFS>;
+
+    ThumbThread<DBFS> *m_parent; //!< Generator owning the queues
+    bool m_active;   //!< Set until it runs out of tasks. Protected by parent mutex
+};
+
+
+//! A generator of thumbnails, using a pool of worker threads
+template <class DBFS>
+class ThumbThread
+{
+public:
+    ThumbThread(const QString &name, DBFS *const dbfs, int workers = 1);
     ~ThumbThread();
 
     void cancel();
@@ -91,16 +120,21 @@ public:
     void AbortDevice(int devId, const QString &action);
     void PauseBackground(bool pause);
 
-protected:
-    void run();
-
 private:
     Q_DISABLE_COPY(ThumbThread)
+    friend class ThumbWorker<DBFS>;
 
     //! A priority queue where 0 is highest priority
     typedef QMultiMap<int, TaskPtr> ThumbQueue;
 
+    void    Process(ThumbWorker<DBFS> *worker);
+    TaskPtr TakeTask(ThumbQueue &queue);
+    bool    IsBusy(int devId) const;
+    void    RemoveEmptyDir(const QString &path);
+    void    StartWorkers();
     QString CreateThumbnail(ImagePtrK im, int thumbPriority);
+    static QImage LoadPicture(const QString &imagePath, const QSize &size,
+                              bool *fromPreview);
     static void RemoveTasks(ThumbQueue &queue, int devId);
 
     DBFS &m_dbfs;               //!< Database/filesystem adapter
@@ -109,6 +143,9 @@ private:
     ThumbQueue m_requestQ;   //!< Priority queue of requests
     ThumbQueue m_backgroundQ;   //!< Priority queue of background tasks
     bool m_doBackground;       //!< Whether to process background tasks
+    QList<TaskPtr> m_busy;     //!< Tasks being processed by workers
+    QSet<int> m_busyImages;    //!< Images of the tasks being processed
+    QList<ThumbWorker<DBFS> *> m_workers; //!< Worker threads
     QMutex m_mutex;            //!< Queue protection
 };
 
@@ -140,7 +177,7 @@ private:
 
     //! Db/filesystem adapter
     DBFS              &m_dbfs;
-    //! Thread generating picture thumbnails
+    //! Threads generating picture thumbnails
     ThumbThread<DBFS> *m_imageThread;
     //! Thread generating video previews
     ThumbThread<DBFS> *m_videoThread;
@@ -373,8 +373,15 @@ void MythSocketManager::HandleVersion(MythSocket *socket,
     }
 
     LOG(VB_SOCKET, LOG_DEBUG, LOC + "Client validated");
+    // Clients that can read the binary framing ask for it after the token
+    bool binary = (slist.size() >= 4) &&
+        (slist[3] == MythSocket::kBinaryFramingToken);
+
     retlist << "ACCEPT" << MYTH_PROTO_VERSION;
+    if (binary)
+        retlist << MythSocket::kBinaryFramingToken;
     socket->WriteStringList(retlist);
+    socket->SetBinaryFraming(binary);
     socket->m_isValidated = true;
 }
 
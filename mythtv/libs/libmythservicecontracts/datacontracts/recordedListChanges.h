@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: recordedListChanges.h
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef RECORDEDLISTCHANGES_H_
+#define RECORDEDLISTCHANGES_H_
+
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+#include "serviceexp.h"
+#include "datacontracthelper.h"
+
+#include "programAndChannel.h"
+
+namespace DTC
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Recordings changed since a generation of the recorded list. With Full
+// set, Programs holds every recording and replaces the list.
+/////////////////////////////////////////////////////////////////////////////
+
+class SERVICE_PUBLIC RecordedListChanges : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO( "version", "1.0" );
+
+    // Q_CLASSINFO Used to augment Metadata for properties.
+    // See datacontracthelper.h for details
+
+    Q_CLASSINFO( "Programs", "type=DTC::Program");
+    Q_CLASSINFO( "AsOf"    , "transient=true"   );
+
+    Q_PROPERTY( uint         Generation     READ Generation      WRITE setGeneration     )
+    Q_PROPERTY( bool         Full           READ Full            WRITE setFull           )
+    Q_PROPERTY( QStringList  Deleted        READ Deleted         WRITE setDeleted        )
+    Q_PROPERTY( QDateTime    AsOf           READ AsOf            WRITE setAsOf           )
+    Q_PROPERTY( QString      Version        READ Version         WRITE setVersion        )
+    Q_PROPERTY( QString      ProtoVer       READ ProtoVer        WRITE setProtoVer       )
+
+    Q_PROPERTY( QVariantList Programs     READ Programs DESIGNABLE true )
+
+    PROPERTYIMP       ( uint        , Generation      )
+    PROPERTYIMP       ( bool        , Full            )
+    PROPERTYIMP       ( QStringList , Deleted         )
+    PROPERTYIMP       ( QDateTime   , AsOf            )
+    PROPERTYIMP       ( QString     , Version         )
+    PROPERTYIMP       ( QString     , ProtoVer        )
+
+    PROPERTYIMP_RO_REF( QVariantList, Programs      );
+
+    public:
+
+        static inline void InitializeCustomTypes();
+
+        Q_INVOKABLE RecordedListChanges(QObject *parent = 0)
+            : QObject         ( parent ),
+              m_Generation    ( 0      ),
+              m_Full          ( false  )
+        {
+        }
+
+        void Copy( const RecordedListChanges *src )
+        {
+            m_Generation    = src->m_Generation     ;
+            m_Full          = src->m_Full           ;
+            m_Deleted       = src->m_Deleted        ;
+            m_AsOf          = src->m_AsOf           ;
+            m_Version       = src->m_Version        ;
+            m_ProtoVer      = src->m_ProtoVer       ;
+
+            CopyListContents< Program >( this, m_Programs, src->m_Programs );
+        }
+
+        Program *AddNewProgram()
+        {
+            // We must make sure the object added to the QVariantList has
+            // a parent of 'this'
+
+            Program *pObject = new Program( this );
+            m_Programs.append( QVariant::fromValue<QObject *>( pObject ));
+
+            return pObject;
+        }
+
+    private:
+        Q_DISABLE_COPY(RecordedListChanges);
+};
+
+inline void RecordedListChanges::InitializeCustomTypes()
+{
+    qRegisterMetaType< RecordedListChanges* >();
+
+    Program::InitializeCustomTypes();
+}
+
+} // namespace DTC
+
+#endif
@@ -62,6 +62,7 @@ HEADERS += datacontracts/backendInfo.h           datacontracts/envInfo.h
 HEADERS += datacontracts/buildInfo.h             datacontracts/logInfo.h
 HEADERS += datacontracts/genre.h                 datacontracts/genreList.h
 HEADERS += datacontracts/musicMetadataInfo.h     datacontracts/musicMetadataInfoList.h
+HEADERS += datacontracts/recordedListChanges.h
 
 HEADERS += enums/recStatus.h
 
@@ -125,6 +126,7 @@ incDatacontracts.files += datacontracts/enum.h                datacontracts/enum
 incDatacontracts.files += datacontracts/cutting.h             datacontracts/cutList.h
 incDatacontracts.files += datacontracts/backendInfo.h         datacontracts/envInfo.h
 incDatacontracts.files += datacontracts/buildInfo.h           datacontracts/logInfo.h
+incDatacontracts.files += datacontracts/recordedListChanges.h
 
 INSTALLS += inc incServices incDatacontracts incEnums
 
@@ -25,6 +25,7 @@
 #include "datacontracts/input.h"
 #include "datacontracts/inputList.h"
 #include "datacontracts/cutList.h"
+#include "datacontracts/recordedListChanges.h"
 
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -45,7 +46,7 @@
 class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
 {
     Q_OBJECT
-    Q_CLASSINFO( "version"    , "6.5" )
+    Q_CLASSINFO( "version"    , "6.6" )
     Q_CLASSINFO( "RemoveRecorded_Method",                       "POST" )
     Q_CLASSINFO( "DeleteRecording_Method",                      "POST" )
     Q_CLASSINFO( "UnDeleteRecording",                           "POST" )
@@ -73,6 +74,7 @@ class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
             DTC::TitleInfoList::InitializeCustomTypes();
             DTC::RecRuleFilterList::InitializeCustomTypes();
             DTC::CutList::InitializeCustomTypes();
+            DTC::RecordedListChanges::InitializeCustomTypes();
         }
 
     public slots:
@@ -89,6 +91,8 @@ class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
                                                            const QString   &Category,
                                                            const QString   &Sort) = 0;
 
+        virtual DTC::RecordedListChanges* GetRecordedListChanges( uint Generation ) = 0;
+
         virtual DTC::ProgramList* GetOldRecordedList     ( bool             Descending,
                                                            int              StartIndex,
                                                            int              Count,
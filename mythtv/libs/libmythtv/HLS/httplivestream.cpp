@@ -23,6 +23,7 @@
 #include <unistd.h> // for usleep
 
 // C headers
+#include <cmath>
 #include <cstdio>
 
 #include <QDir>
@@ -42,6 +43,8 @@
 #include "mythlogging.h"
 #include "storagegroup.h"
 #include "httplivestream.h"
+#include "httplivestreamtranscoder.h"
+#include "httplivestreamremuxer.h"
 
 #define LOC QString("HLS(%1): ").arg(m_sourceFile)
 #define LOC_ERR QString("HLS(%1) Error: ").arg(m_sourceFile)
@@ -89,6 +92,46 @@ class HTTPLiveStreamThread : public QRunnable
     int m_streamID;
 };
 
+/** \class HTTPLiveStreamTranscodeThread
+ *  \brief QRunnable class for transcoding HTTP Live Streams in process
+ *
+ *  The HTTPLiveStreamTranscodeThread class runs an HTTPLiveStreamTranscoder
+ *  in the HTTPLiveStreamTranscoders pool, so that the number of streams
+ *  being transcoded at the same time is limited per backend.
+ */
+class HTTPLiveStreamTranscodeThread : public QRunnable
+{
+  public:
+    explicit HTTPLiveStreamTranscodeThread(int streamid)
+      : m_streamID(streamid) {}
+
+    void run(void)
+    {
+        HTTPLiveStreamTranscoder transcoder(m_streamID);
+
+        if (!transcoder.Run())
+            LOG(VB_GENERAL, LOG_WARNING, SLOC +
+                QString("Transcoding stream %1 failed").arg(m_streamID));
+    }
+
+  private:
+    int m_streamID;
+};
+
+/** \class HTTPLiveStreamTranscoderPool
+ *  \brief The HTTPLiveStreamTranscoders pool, sized once when it is first
+ *         used.
+ */
+class HTTPLiveStreamTranscoderPool : public MThreadPool
+{
+  public:
+    explicit HTTPLiveStreamTranscoderPool(int maxThreads)
+      : MThreadPool("HTTPLiveStreamTranscoders")
+    {
+        setMaxThreadCount(maxThreads);
+    }
+};
+
 
 HTTPLiveStream::HTTPLiveStream(QString srcFile, uint16_t width, uint16_t height,
                                uint32_t bitrate, uint32_t abitrate,
@@ -161,7 +204,8 @@ HTTPLiveStream::~HTTPLiveStream()
 {
     if (m_writing)
     {
-        WritePlaylist(false, true);
+        for (int r = 0; r < GetRenditionCount(); ++r)
+            WritePlaylist(false, true, r);
         if (m_audioOnlyBitrate)
             WritePlaylist(true, true);
     }
@@ -182,7 +226,8 @@ bool HTTPLiveStream::InitForWrite(void)
 }
 
 QString HTTPLiveStream::GetFilename(uint16_t segmentNumber, bool fileOnly,
-                                    bool audioOnly, bool encoded) const
+                                    bool audioOnly, bool encoded,
+                                    int rendition) const
 {
     QString filename;
 
@@ -191,6 +236,10 @@ QString HTTPLiveStream::GetFilename(uint16_t segmentNumber, bool fileOnly,
     else
         filename = audioOnly ? m_audioOutFile : m_outFile;
 
+    if (!audioOnly && rendition > 0)
+        filename = (encoded ? m_outBaseEncoded : m_outBase) +
+            QString(".r%1.av").arg(rendition);
+
     filename += ".%1.ts";
 
     if (!fileOnly)
@@ -322,18 +371,29 @@ bool HTTPLiveStream::AddSegment(void)
     if ((m_maxSegments) &&
         (m_segmentCount > (uint16_t)(m_maxSegments + 1)))
     {
-        QString thisFile = GetFilename(m_startSegment);
+        QStringList oldFiles;
+        for (int r = 0; r < GetRenditionCount(); ++r)
+            oldFiles << GetFilename(m_startSegment, true, false, false, r);
+        if (m_audioOnlyBitrate)
+            oldFiles << GetFilename(m_startSegment, true, true);
 
-        if (!QFile::remove(thisFile))
-            LOG(VB_GENERAL, LOG_ERR, LOC +
-                QString("Unable to delete %1.").arg(thisFile));
+        foreach (const QString &oldFile, oldFiles)
+        {
+            HTTPLiveStreamSegmentCache::Remove(oldFile);
+
+            QString thisFile = m_outDir + "/" + oldFile;
+            if (QFile::exists(thisFile) && !QFile::remove(thisFile))
+                LOG(VB_GENERAL, LOG_ERR, LOC +
+                    QString("Unable to delete %1.").arg(thisFile));
+        }
 
         ++m_startSegment;
         --m_segmentCount;
     }
 
     SaveSegmentInfo();
-    WritePlaylist(false);
+    for (int r = 0; r < GetRenditionCount(); ++r)
+        WritePlaylist(false, false, r);
 
     if (m_audioOnlyBitrate)
         WritePlaylist(true);
@@ -417,6 +477,17 @@ bool HTTPLiveStream::WriteMetaPlaylist(void)
         ).arg((int)((m_bitrate + m_audioBitrate) * 1.1))
          .arg(m_outFileEncoded).toLatin1());
 
+    for (int r = 1; r < GetRenditionCount(); ++r)
+    {
+        const HTTPLiveStreamRendition &rendition = m_renditions[r - 1];
+        file.write(QString(
+            "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1,RESOLUTION=%2x%3\n"
+            "%4.m3u8\n"
+            ).arg((int)((rendition.bitrate + m_audioBitrate) * 1.1))
+             .arg(rendition.width).arg(rendition.height)
+             .arg(m_outBaseEncoded + QString(".r%1.av").arg(r)).toLatin1());
+    }
+
     if (m_audioOnlyBitrate)
     {
         file.write(QString(
@@ -432,7 +503,7 @@ bool HTTPLiveStream::WriteMetaPlaylist(void)
     return true;
 }
 
-QString HTTPLiveStream::GetPlaylistName(bool audioOnly) const
+QString HTTPLiveStream::GetPlaylistName(bool audioOnly, int rendition) const
 {
     if (m_streamid == -1)
         return QString();
@@ -441,16 +512,19 @@ QString HTTPLiveStream::GetPlaylistName(bool audioOnly) const
         return QString();
 
     QString base = audioOnly ? m_audioOutFile : m_outFile;
+    if (!audioOnly && rendition > 0)
+        base = m_outBase + QString(".r%1.av").arg(rendition);
     QString outFile = m_outDir + "/" + base + ".m3u8";
     return outFile;
 }
 
-bool HTTPLiveStream::WritePlaylist(bool audioOnly, bool writeEndTag)
+bool HTTPLiveStream::WritePlaylist(bool audioOnly, bool writeEndTag,
+                                   int rendition)
 {
     if (m_streamid == -1)
         return false;
 
-    QString outFile = GetPlaylistName(audioOnly);
+    QString outFile = GetPlaylistName(audioOnly, rendition);
     QString tmpFile = outFile + ".tmp";
 
     QFile file(tmpFile);
@@ -485,7 +559,8 @@ bool HTTPLiveStream::WritePlaylist(bool audioOnly, bool writeEndTag)
             "#EXTINF:%1,\n"
             "%2\n"
             ).arg(m_segmentSize)
-             .arg(GetFilename(segmentid + i, true, audioOnly, true)).toLatin1());
+             .arg(GetFilename(segmentid + i, true, audioOnly, true,
+                              rendition)).toLatin1());
 
         ++i;
     }
@@ -503,6 +578,82 @@ bool HTTPLiveStream::WritePlaylist(bool audioOnly, bool writeEndTag)
     return true;
 }
 
+/** \brief Writes the playlists of a stream that is remuxed instead of
+ *         transcoded, which has all of its segments from the start.
+ *  \param durations of the segments, in ms
+ *  \param bitrate of the recording
+ */
+bool HTTPLiveStream::WriteRemuxPlaylists(const QList<uint32_t> &durations,
+                                         uint32_t bitrate)
+{
+    if (m_streamid == -1 || !WriteHTML())
+        return false;
+
+    QString outFile = GetMetaPlaylistName();
+    QFile file(outFile);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        LOG(VB_RECORD, LOG_ERR, QString("Error opening %1").arg(outFile));
+        return false;
+    }
+
+    file.write(QString(
+        "#EXTM3U\n"
+        "#EXT-X-VERSION:3\n"
+        "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1,RESOLUTION=%2x%3\n"
+        "%4.m3u8\n"
+        ).arg((int)(bitrate * 1.1))
+         .arg(m_sourceWidth).arg(m_sourceHeight)
+         .arg(m_outFileEncoded).toLatin1());
+
+    file.close();
+
+    outFile = GetPlaylistName();
+    QString tmpFile = outFile + ".tmp";
+    file.setFileName(tmpFile);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        LOG(VB_RECORD, LOG_ERR, QString("Error opening %1").arg(tmpFile));
+        return false;
+    }
+
+    uint32_t longest = 0;
+    for (int i = 0; i < durations.size(); ++i)
+        longest = qMax(longest, durations[i]);
+
+    file.write(QString(
+        "#EXTM3U\n"
+        "#EXT-X-VERSION:3\n"
+        "#EXT-X-PLAYLIST-TYPE:VOD\n"
+        "#EXT-X-TARGETDURATION:%1\n"
+        "#EXT-X-MEDIA-SEQUENCE:1\n"
+        ).arg((int)ceil(longest / 1000.0)).toLatin1());
+
+    for (int i = 0; i < durations.size(); ++i)
+    {
+        file.write(QString(
+            "#EXTINF:%1,\n"
+            "%2\n"
+            ).arg(durations[i] / 1000.0, 0, 'f', 3)
+             .arg(GetFilename(i + 1, true, false, true)).toLatin1());
+    }
+
+    file.write("#EXT-X-ENDLIST\n");
+    file.close();
+
+    if(rename(tmpFile.toLatin1().constData(),
+              outFile.toLatin1().constData()) == -1)
+    {
+        LOG(VB_RECORD, LOG_ERR, LOC +
+            QString("Error renaming %1 to %2").arg(tmpFile).arg(outFile) + ENO);
+        return false;
+    }
+
+    return true;
+}
+
 bool HTTPLiveStream::SaveSegmentInfo(void)
 {
     if (m_streamid == -1)
@@ -579,6 +730,64 @@ bool HTTPLiveStream::UpdateSizeInfo(uint16_t width, uint16_t height,
     return true;
 }
 
+/** \brief Switches the stream over to being remuxed, with all its
+ *         segments there from the start.
+ *
+ *  The requested size and bitrates are kept, so the same request
+ *  finds this stream again.
+ */
+bool HTTPLiveStream::UpdateRemuxInfo(uint16_t srcwidth, uint16_t srcheight,
+                                     uint16_t segmentCount)
+{
+    if (m_streamid == -1)
+        return false;
+
+    QFileInfo finfo(m_sourceFile);
+    QString newOutBase = finfo.fileName() +
+        QString(".%1.remux").arg(m_streamid);
+    QString newFullURL = m_httpPrefix + newOutBase + ".m3u8";
+    QString newRelativeURL = m_httpPrefixRel + newOutBase + ".m3u8";
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare(
+        "UPDATE livestream "
+        "SET sourcewidth = :SRCWIDTH, sourceheight = :SRCHEIGHT, "
+        "    fullurl = :FULLURL, relativeurl = :RELATIVEURL, "
+        "    outbase = :OUTBASE, "
+        "    startsegment = 1, currentsegment = :CURRENT, "
+        "    segmentcount = :COUNT "
+        "WHERE id = :STREAMID; ");
+    query.bindValue(":SRCWIDTH", srcwidth);
+    query.bindValue(":SRCHEIGHT", srcheight);
+    query.bindValue(":FULLURL", newFullURL);
+    query.bindValue(":RELATIVEURL", newRelativeURL);
+    query.bindValue(":OUTBASE", newOutBase);
+    query.bindValue(":CURRENT", segmentCount);
+    query.bindValue(":COUNT", segmentCount);
+    query.bindValue(":STREAMID", m_streamid);
+
+    if (!query.exec())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to update remux info for streamid %1")
+                    .arg(m_streamid));
+        return false;
+    }
+
+    m_sourceWidth = srcwidth;
+    m_sourceHeight = srcheight;
+    m_outBase = newOutBase;
+    m_fullURL = newFullURL;
+    m_relativeURL = newRelativeURL;
+    m_startSegment = 1;
+    m_curSegment = segmentCount;
+    m_segmentCount = segmentCount;
+
+    SetOutputVars();
+
+    return true;
+}
+
 bool HTTPLiveStream::UpdateStatus(HTTPLiveStreamStatus status)
 {
     if (m_streamid == -1)
@@ -773,6 +982,25 @@ void HTTPLiveStream::SetOutputVars(void)
         m_httpPrefixRel = "";
 }
 
+HTTPLiveStreamRendition HTTPLiveStream::GetRendition(int rendition) const
+{
+    if (rendition > 0 && rendition <= m_renditions.size())
+        return m_renditions[rendition - 1];
+
+    HTTPLiveStreamRendition main = { m_width, m_height, m_bitrate };
+    return main;
+}
+
+/** \brief Sets the renditions encoded next to the one the stream was
+ *         created with, best quality first. They are only known to the
+ *         process doing the transcoding, which writes their playlists.
+ */
+void HTTPLiveStream::SetRenditions(
+    const QList<HTTPLiveStreamRendition> &renditions)
+{
+    m_renditions = renditions;
+}
+
 HTTPLiveStreamStatus HTTPLiveStream::GetDBStatus(void) const
 {
     if (m_streamid == -1)
@@ -825,10 +1053,33 @@ DTC::LiveStreamInfo *HTTPLiveStream::StartStream(void)
     if (GetDBStatus() != kHLSStatusQueued)
         return GetLiveStreamInfo();
 
-    HTTPLiveStreamThread *streamThread =
-        new HTTPLiveStreamThread(GetStreamID());
-    MThreadPool::globalInstance()->startReserved(streamThread,
-                                                 "HTTPLiveStream");
+    // Recordings players can already decode only need cutting up
+    if (gCoreContext->GetNumSetting("HTTPLiveStreamRemux", 1) &&
+        HTTPLiveStreamRemuxer::StartStream(this))
+    {
+        UpdateStatus(kHLSStatusCompleted);
+        UpdateStatusMessage("Remuxing on demand");
+        UpdatePercentComplete(100);
+        return GetLiveStreamInfo();
+    }
+
+    // Streams are transcoded by mythtranscode, unless they are turned to
+    // be done in this process, queueing up behind the ones already running.
+    int transcoders =
+        gCoreContext->GetNumSetting("HTTPLiveStreamTranscoders", 0);
+    if (transcoders > 0)
+    {
+        static HTTPLiveStreamTranscoderPool s_pool(transcoders);
+        s_pool.start(new HTTPLiveStreamTranscodeThread(GetStreamID()),
+                     "HTTPLiveStream");
+    }
+    else
+    {
+        HTTPLiveStreamThread *streamThread =
+            new HTTPLiveStreamThread(GetStreamID());
+        MThreadPool::globalInstance()->startReserved(streamThread,
+                                                     "HTTPLiveStream");
+    }
     MythTimer statusTimer;
     int       delay = 250000;
     statusTimer.start();
@@ -871,17 +1122,20 @@ bool HTTPLiveStream::RemoveStream(int id)
     int startSegment = query.value(0).toInt();
     int segmentCount = query.value(1).toInt();
 
+    // Remuxed streams only have the segments that were asked for
     for (int x = 0; x < segmentCount; ++x)
     {
         thisFile = hls->GetFilename(startSegment + x);
 
-        if (!thisFile.isEmpty() && !QFile::remove(thisFile))
+        if (!thisFile.isEmpty() && QFile::exists(thisFile) &&
+            !QFile::remove(thisFile))
             LOG(VB_GENERAL, LOG_ERR, SLOC +
                 QString("Unable to delete %1.").arg(thisFile));
 
         thisFile = hls->GetFilename(startSegment + x, false, true);
 
-        if (!thisFile.isEmpty() && !QFile::remove(thisFile))
+        if (!thisFile.isEmpty() && QFile::exists(thisFile) &&
+            !QFile::remove(thisFile))
             LOG(VB_GENERAL, LOG_ERR, SLOC +
                 QString("Unable to delete %1.").arg(thisFile));
     }
@@ -897,7 +1151,8 @@ bool HTTPLiveStream::RemoveStream(int id)
             QString("Unable to delete %1.").arg(thisFile));
 
     thisFile = hls->GetPlaylistName(true);
-    if (!thisFile.isEmpty() && !QFile::remove(thisFile))
+    if (!thisFile.isEmpty() && QFile::exists(thisFile) &&
+        !QFile::remove(thisFile))
         LOG(VB_GENERAL, LOG_ERR, SLOC +
             QString("Unable to delete %1.").arg(thisFile));
 
@@ -906,6 +1161,28 @@ bool HTTPLiveStream::RemoveStream(int id)
         LOG(VB_GENERAL, LOG_ERR, SLOC +
             QString("Unable to delete %1.").arg(thisFile));
 
+    // The renditions are not in the database, so remove whatever else
+    // was written for this stream.
+    QString outBase = hls->m_outBase;
+    if (!outBase.isEmpty())
+    {
+        HTTPLiveStreamSegmentCache::Remove(outBase + ".");
+        HTTPLiveStreamRemuxer::RemoveStream(outBase);
+
+        QDir outDir(hls->m_outDir);
+        QStringList files = outDir.entryList(QDir::Files);
+        foreach (const QString &file, files)
+        {
+            if (!file.startsWith(outBase + ".r"))
+                continue;
+
+            thisFile = outDir.filePath(file);
+            if (!QFile::remove(thisFile))
+                LOG(VB_GENERAL, LOG_ERR, SLOC +
+                    QString("Unable to delete %1.").arg(thisFile));
+        }
+    }
+
     query.prepare(
         "DELETE FROM livestream "
         "WHERE id = :STREAMID; ");
@@ -2,6 +2,7 @@
 #define HTTPLIVESTREAM_H
 
 #include <QString>
+#include <QList>
 
 #include "datacontracts/liveStreamInfoList.h"
 
@@ -18,6 +19,12 @@ typedef enum {
     kHLSStatusStopped      = 6
 } HTTPLiveStreamStatus;
 
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint32_t bitrate;
+} HTTPLiveStreamRendition;
+
 
 class MTV_PUBLIC HTTPLiveStream
 {
@@ -40,17 +47,23 @@ class MTV_PUBLIC HTTPLiveStream
     uint32_t GetAudioOnlyBitrate(void) const { return m_audioOnlyBitrate; }
     uint16_t GetMaxSegments(void) const { return m_maxSegments; }
     QString  GetSourceFile(void) const { return m_sourceFile; }
+    QString  GetOutBase(void) const { return m_outBase; }
     QString  GetHTMLPageName(void) const;
     QString  GetMetaPlaylistName(void) const;
-    QString  GetPlaylistName(bool audioOnly = false) const;
+    QString  GetPlaylistName(bool audioOnly = false, int rendition = 0) const;
     uint16_t GetSegmentSize(void) const { return m_segmentSize; }
     QString  GetFilename(uint16_t segmentNumber = 0, bool fileOnly = false,
-                         bool audioOnly = false, bool encoded = false) const;
+                         bool audioOnly = false, bool encoded = false,
+                         int rendition = 0) const;
     QString  GetCurrentFilename(
         bool audioOnly = false, bool encoded = false) const;
 
     void SetOutputVars(void);
 
+    int  GetRenditionCount(void) const { return m_renditions.size() + 1; }
+    HTTPLiveStreamRendition GetRendition(int rendition) const;
+    void SetRenditions(const QList<HTTPLiveStreamRendition> &renditions);
+
     HTTPLiveStreamStatus GetDBStatus(void) const;
 
     int      AddStream(void);
@@ -58,12 +71,18 @@ class MTV_PUBLIC HTTPLiveStream
 
     bool WriteHTML(void);
     bool WriteMetaPlaylist(void);
-    bool WritePlaylist(bool audioOnly = false, bool writeEndTag = false);
+    bool WritePlaylist(bool audioOnly = false, bool writeEndTag = false,
+                       int rendition = 0);
+
+    bool WriteRemuxPlaylists(const QList<uint32_t> &durations,
+                             uint32_t bitrate);
 
     bool SaveSegmentInfo(void);
 
     bool UpdateSizeInfo(uint16_t width, uint16_t height,
                         uint16_t srcwidth, uint16_t srcheight);
+    bool UpdateRemuxInfo(uint16_t srcwidth, uint16_t srcheight,
+                         uint16_t segmentCount);
     bool UpdateStatus(HTTPLiveStreamStatus status);
     bool UpdateStatusMessage(QString message);
     bool UpdatePercentComplete(int percent);
@@ -106,6 +125,8 @@ class MTV_PUBLIC HTTPLiveStream
     uint32_t    m_audioBitrate;
     uint32_t    m_audioOnlyBitrate;
     int32_t     m_sampleRate;
+    /// Renditions after the first, which is m_width x m_height @ m_bitrate
+    QList<HTTPLiveStreamRendition> m_renditions;
 
     QDateTime   m_created;
     QDateTime   m_lastModified;
@@ -0,0 +1,647 @@
+/*  -*- Mode: c++ -*-
+ *
+ *   Class HTTPLiveStreamRemuxer
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QRegExp>
+
+#include "mythcorecontext.h"
+#include "mythdate.h"
+#include "mythlogging.h"
+#include "mythdb.h"
+#include "programinfo.h"
+#include "ringbuffer.h"
+#include "httplivestream.h"
+#include "httplivestreamremuxer.h"
+#include "httplivestreamtranscoder.h"
+
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+#define LOC QString("HLSRemuxer(%1): ").arg(m_sourceFile)
+
+QMutex                                                HTTPLiveStreamRemuxer::s_lock;
+QHash<QString, QSharedPointer<HTTPLiveStreamRemuxer> > HTTPLiveStreamRemuxer::s_streams;
+QList<QString>                                        HTTPLiveStreamRemuxer::s_order;
+
+const int HTTPLiveStreamRemuxer::kMaxStreams = 16;
+const int HTTPLiveStreamRemuxer::kPreroll    = 512 * 1024;
+
+static const int kTSPacketSize = 188;
+
+static int read_packet(void *opaque, uint8_t *buf, int buf_size)
+{
+    int ret = ((RingBuffer *)opaque)->Read(buf, buf_size);
+    return (ret > 0) ? ret : AVERROR_EOF;
+}
+
+static int64_t seek_packet(void *opaque, int64_t offset, int whence)
+{
+    RingBuffer *rbuffer = (RingBuffer *)opaque;
+
+    if (whence == AVSEEK_SIZE)
+        return rbuffer->GetRealFileSize();
+
+    return rbuffer->Seek(offset, whence & ~AVSEEK_FORCE);
+}
+
+/** \brief Opens the recording for demuxing from byte offset start on.
+ *
+ *  Packet positions are those in the recording. With probe set the
+ *  format is detected and the streams are looked into, otherwise the
+ *  recording is read as an MPEG-TS from start without that delay.
+ */
+static AVFormatContext *open_input(RingBuffer *rbuffer, int64_t start,
+                                   bool probe)
+{
+    int buf_size = rbuffer->BestBufferSize();
+    unsigned char *buffer = (unsigned char *)av_malloc(buf_size);
+    AVIOContext *pb = avio_alloc_context(buffer, buf_size, 0, rbuffer,
+                                         read_packet, NULL, seek_packet);
+    if (!pb)
+    {
+        av_free(buffer);
+        return NULL;
+    }
+    pb->seekable = !rbuffer->IsStreamed();
+
+    AVFormatContext *ic = avformat_alloc_context();
+    ic->pb = pb;
+    if (!probe)
+        ic->flags |= AVFMT_FLAG_NOPARSE;
+
+    AVDictionary *opts = NULL;
+    if (!probe)
+        av_dict_set(&opts, "probesize", "1048576", 0);
+
+    bool opened = false;
+    bool ok = (start == 0) || (avio_seek(pb, start, SEEK_SET) == start);
+    if (ok)
+    {
+        QMutexLocker locker(avcodeclock);
+        QByteArray fname = rbuffer->GetFilename().toLocal8Bit();
+        // frees ic when it fails
+        opened = avformat_open_input(&ic, fname.constData(),
+                                     probe ? NULL :
+                                     av_find_input_format("mpegts"),
+                                     &opts) >= 0;
+        ok = opened && (!probe || avformat_find_stream_info(ic, NULL) >= 0);
+    }
+    av_dict_free(&opts);
+
+    if (!ok)
+    {
+        if (opened)
+        {
+            QMutexLocker locker(avcodeclock);
+            avformat_close_input(&ic);
+        }
+        else
+        {
+            avformat_free_context(ic);
+        }
+        av_freep(&pb->buffer);
+        avio_context_free(&pb);
+        return NULL;
+    }
+
+    return ic;
+}
+
+static void close_input(AVFormatContext **ic)
+{
+    if (!*ic)
+        return;
+
+    AVIOContext *pb = (*ic)->pb;
+    {
+        QMutexLocker locker(avcodeclock);
+        avformat_close_input(ic);
+    }
+    av_freep(&pb->buffer);
+    avio_context_free(&pb);
+}
+
+HTTPLiveStreamRemuxer::HTTPLiveStreamRemuxer() :
+    m_videoPid(-1), m_audioPid(-1),
+    m_videoPar(avcodec_parameters_alloc()),
+    m_audioPar(avcodec_parameters_alloc()),
+    m_width(0), m_height(0), m_bitrate(0)
+{
+}
+
+HTTPLiveStreamRemuxer::~HTTPLiveStreamRemuxer()
+{
+    avcodec_parameters_free(&m_videoPar);
+    avcodec_parameters_free(&m_audioPar);
+}
+
+/** \brief Prepares the stream to be remuxed, if the recording allows.
+ *
+ *  Only finished recordings with a seek table and codecs that players
+ *  can decode are remuxed. The playlists are written for every segment
+ *  at once.
+ *
+ *  \return false if the stream has to be transcoded instead
+ */
+bool HTTPLiveStreamRemuxer::StartStream(HTTPLiveStream *hls)
+{
+    ProgramInfo pginfo(hls->GetSourceFile());
+    if (!pginfo.GetChanID())
+        return false;
+
+    // The seek table is not complete until the recording is
+    if (pginfo.GetRecordingEndTime() > MythDate::current())
+        return false;
+
+    QSharedPointer<HTTPLiveStreamRemuxer> remuxer = Create(hls, pginfo);
+    if (!remuxer)
+        return false;
+
+    // Only serve the recording as it is to those who asked for at least
+    // its size and bitrate, the others get what they asked for
+    if ((hls->GetWidth() && hls->GetWidth() < remuxer->m_width) ||
+        (hls->GetHeight() && hls->GetHeight() < remuxer->m_height) ||
+        (uint64_t)hls->GetBitrate() + hls->GetAudioBitrate() <
+        remuxer->m_bitrate)
+    {
+        LOG(VB_GENERAL, LOG_INFO, QString("HLSRemuxer(%1): %2x%3 at %4 kb/s "
+                                          "was asked for, transcoding")
+            .arg(hls->GetSourceFile()).arg(hls->GetWidth())
+            .arg(hls->GetHeight())
+            .arg((hls->GetBitrate() + hls->GetAudioBitrate()) / 1000));
+        return false;
+    }
+
+    QList<uint32_t> durations;
+    for (int i = 0; i < remuxer->m_segments.size(); ++i)
+        durations << remuxer->m_segments[i].duration;
+
+    if (!hls->UpdateRemuxInfo(remuxer->m_width, remuxer->m_height,
+                              durations.size()) ||
+        !hls->WriteRemuxPlaylists(durations, remuxer->m_bitrate))
+    {
+        return false;
+    }
+
+    Add(hls->GetOutBase(), remuxer);
+
+    LOG(VB_GENERAL, LOG_INFO, QString("HLSRemuxer(%1): Streaming %2 "
+                                      "segments without transcoding")
+        .arg(hls->GetSourceFile()).arg(durations.size()));
+
+    return true;
+}
+
+/** \brief Remuxes the segment named filename, unless it is not one of
+ *         a remuxed stream.
+ */
+bool HTTPLiveStreamRemuxer::GetSegment(const QString &filename,
+                                       QByteArray &data)
+{
+    QRegExp re("^(.*\\.remux)\\.av\\.(\\d{6})\\.ts$");
+    if (!re.exactMatch(filename))
+        return false;
+
+    QString outBase = re.cap(1);
+    int segment = re.cap(2).toInt() - 1;
+
+    QSharedPointer<HTTPLiveStreamRemuxer> remuxer = Find(outBase);
+    if (!remuxer)
+    {
+        // Started before the backend was, the playlists are still there
+        MSqlQuery query(MSqlQuery::InitCon());
+        query.prepare("SELECT id FROM livestream WHERE outbase = :OUTBASE");
+        query.bindValue(":OUTBASE", outBase);
+
+        if (!query.exec())
+        {
+            MythDB::DBError("HTTPLiveStreamRemuxer::GetSegment", query);
+            return false;
+        }
+        if (!query.next())
+            return false;
+
+        HTTPLiveStream hls(query.value(0).toInt());
+        ProgramInfo pginfo(hls.GetSourceFile());
+        if (!pginfo.GetChanID())
+            return false;
+
+        remuxer = Create(&hls, pginfo);
+        if (!remuxer)
+            return false;
+        Add(outBase, remuxer);
+    }
+
+    if (segment < 0 || segment >= remuxer->m_segments.size() ||
+        !remuxer->Remux(segment, data))
+    {
+        return false;
+    }
+
+    HTTPLiveStreamSegmentCache::Insert(filename, data);
+
+    return true;
+}
+
+void HTTPLiveStreamRemuxer::RemoveStream(const QString &outBase)
+{
+    QMutexLocker locker(&s_lock);
+
+    s_streams.remove(outBase);
+    s_order.removeOne(outBase);
+}
+
+QSharedPointer<HTTPLiveStreamRemuxer> HTTPLiveStreamRemuxer::Create(
+    HTTPLiveStream *hls, const ProgramInfo &pginfo)
+{
+    QSharedPointer<HTTPLiveStreamRemuxer> remuxer(new HTTPLiveStreamRemuxer());
+    remuxer->m_sourceFile = hls->GetSourceFile();
+
+    if (!remuxer->Probe() ||
+        !remuxer->LoadSegments(pginfo, hls->GetSegmentSize()))
+    {
+        return QSharedPointer<HTTPLiveStreamRemuxer>();
+    }
+
+    return remuxer;
+}
+
+QSharedPointer<HTTPLiveStreamRemuxer> HTTPLiveStreamRemuxer::Find(
+    const QString &outBase)
+{
+    QMutexLocker locker(&s_lock);
+
+    return s_streams.value(outBase);
+}
+
+void HTTPLiveStreamRemuxer::Add(const QString &outBase,
+                                QSharedPointer<HTTPLiveStreamRemuxer> remuxer)
+{
+    QMutexLocker locker(&s_lock);
+
+    if (!s_streams.contains(outBase))
+        s_order.append(outBase);
+    s_streams[outBase] = remuxer;
+
+    // Forgotten streams are looked up again when next requested
+    while (s_order.size() > kMaxStreams)
+        s_streams.remove(s_order.takeFirst());
+}
+
+/** \brief Checks that players can decode the recording as it is.
+ *
+ *  HLS players only have to decode progressive H.264 of the Baseline,
+ *  Main and High profiles up to level 4.1, so interlaced broadcasts
+ *  and anything beyond that are transcoded.
+ */
+bool HTTPLiveStreamRemuxer::Probe(void)
+{
+    RingBuffer *rbuffer = RingBuffer::Create(m_sourceFile, false, true);
+    if (!rbuffer || !rbuffer->IsOpen())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to open the recording");
+        delete rbuffer;
+        return false;
+    }
+    rbuffer->Start();
+
+    AVFormatContext *ic = open_input(rbuffer, 0, true);
+    if (!ic)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to demux the recording");
+        delete rbuffer;
+        return false;
+    }
+
+    bool ok = !strcmp(ic->iformat->name, "mpegts");
+
+    int videoIndex = av_find_best_stream(ic, AVMEDIA_TYPE_VIDEO,
+                                         -1, -1, NULL, 0);
+    int audioIndex = av_find_best_stream(ic, AVMEDIA_TYPE_AUDIO,
+                                         -1, videoIndex, NULL, 0);
+    if (ok && videoIndex >= 0 && audioIndex >= 0)
+    {
+        AVStream *video = ic->streams[videoIndex];
+        AVStream *audio = ic->streams[audioIndex];
+
+        // AAC has to be in ADTS, which AV_CODEC_ID_AAC_LATM is not
+        ok = video->codecpar->codec_id == AV_CODEC_ID_H264 &&
+            (audio->codecpar->codec_id == AV_CODEC_ID_AAC ||
+             audio->codecpar->codec_id == AV_CODEC_ID_MP3 ||
+             audio->codecpar->codec_id == AV_CODEC_ID_AC3 ||
+             audio->codecpar->codec_id == AV_CODEC_ID_EAC3) &&
+            video->codecpar->width && video->codecpar->height &&
+            ic->bit_rate > 0;
+
+        int profile = video->codecpar->profile & ~FF_PROFILE_H264_CONSTRAINED;
+        ok = ok &&
+            video->codecpar->field_order == AV_FIELD_PROGRESSIVE &&
+            (profile == FF_PROFILE_H264_BASELINE ||
+             profile == FF_PROFILE_H264_MAIN ||
+             profile == FF_PROFILE_H264_HIGH) &&
+            video->codecpar->level > 0 && video->codecpar->level <= 41;
+
+        if (ok)
+        {
+            m_videoPid = video->id;
+            m_audioPid = audio->id;
+            avcodec_parameters_copy(m_videoPar, video->codecpar);
+            avcodec_parameters_copy(m_audioPar, audio->codecpar);
+            m_width   = video->codecpar->width;
+            m_height  = video->codecpar->height;
+            m_bitrate = ic->bit_rate;
+        }
+    }
+    else
+    {
+        ok = false;
+    }
+
+    if (!ok)
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            "Not an MPEG-TS with progressive H.264 video players can "
+            "decode and AAC, MP3 or AC-3 audio, it has to be transcoded");
+
+    close_input(&ic);
+    delete rbuffer;
+
+    return ok;
+}
+
+/** \brief Splits the recording into segments of at least segmentSize
+ *         seconds, each starting with a key frame from the seek table.
+ */
+bool HTTPLiveStreamRemuxer::LoadSegments(const ProgramInfo &pginfo,
+                                         int segmentSize)
+{
+    frm_pos_map_t posMap;
+    frm_pos_map_t durMap;
+
+    pginfo.QueryPositionMap(posMap, MARK_GOP_BYFRAME);
+    if (posMap.empty())
+        pginfo.QueryPositionMap(posMap, MARK_GOP_START);
+    pginfo.QueryPositionMap(durMap, MARK_DURATION_MS);
+
+    if (posMap.empty() || durMap.empty())
+    {
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            "No seek table, the recording has to be transcoded");
+        return false;
+    }
+
+    if (segmentSize <= 0)
+        segmentSize = 4;
+
+    // The first segment holds whatever is before the first key frame
+    Segment first = { 0, 0 };
+    m_segments.append(first);
+    int64_t startMs = 0;
+
+    frm_pos_map_t::const_iterator it = posMap.begin();
+    for (; it != posMap.end(); ++it)
+    {
+        frm_pos_map_t::const_iterator dit = durMap.find(it.key());
+        if (dit == durMap.end())
+            continue;
+
+        if (*dit - startMs < segmentSize * 1000)
+            continue;
+
+        m_segments.last().duration = *dit - startMs;
+
+        Segment segment = { *it, 0 };
+        m_segments.append(segment);
+        startMs = *dit;
+    }
+
+    int64_t totalMs = pginfo.QueryTotalDuration();
+    m_segments.last().duration = (totalMs > startMs) ?
+        totalMs - startMs : segmentSize * 1000;
+
+    return true;
+}
+
+/** \brief Copies segment out of the recording into an MPEG-TS of its own.
+ *
+ *  The seek table holds the position of the TS packet starting the PES
+ *  packet of each key frame, which is where the demuxer places those
+ *  frames, so the video is cut on the positions alone. The audio goes
+ *  with the segment whose video it is presented with, so the recording
+ *  is read from a little before the segment, and on past its end until
+ *  the audio has caught up.
+ */
+bool HTTPLiveStreamRemuxer::Remux(int segment, QByteArray &data) const
+{
+    int64_t start = m_segments[segment].offset;
+    int64_t end   = (segment + 1 < m_segments.size()) ?
+        m_segments[segment + 1].offset : -1;
+    int64_t base  = 0;
+    if (segment > 0 && start > kPreroll)
+        base = (start - kPreroll) / kTSPacketSize * kTSPacketSize;
+
+    RingBuffer *rbuffer = RingBuffer::Create(m_sourceFile, false, true);
+    if (!rbuffer || !rbuffer->IsOpen())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to open the recording");
+        delete rbuffer;
+        return false;
+    }
+    rbuffer->Start();
+
+    AVFormatContext *ic = open_input(rbuffer, base, false);
+    if (!ic)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to demux segment %1").arg(segment + 1));
+        delete rbuffer;
+        return false;
+    }
+
+    AVFormatContext *oc = NULL;
+    avformat_alloc_output_context2(&oc, NULL, "mpegts", NULL);
+
+    AVStream *videoOut = oc ? avformat_new_stream(oc, NULL) : NULL;
+    AVStream *audioOut = oc ? avformat_new_stream(oc, NULL) : NULL;
+    bool ok = videoOut && audioOut &&
+        avcodec_parameters_copy(videoOut->codecpar, m_videoPar) >= 0 &&
+        avcodec_parameters_copy(audioOut->codecpar, m_audioPar) >= 0;
+    if (ok)
+    {
+        videoOut->id = m_videoPid;
+        audioOut->id = m_audioPid;
+        videoOut->codecpar->codec_tag = 0;
+        audioOut->codecpar->codec_tag = 0;
+        videoOut->time_base.num = audioOut->time_base.num = 1;
+        videoOut->time_base.den = audioOut->time_base.den = 90000;
+
+        // Keep the timestamps, so the segments play on from each other
+        AVDictionary *opts = NULL;
+        av_dict_set(&opts, "mpegts_copyts", "1", 0);
+        ok = avio_open_dyn_buf(&oc->pb) >= 0 &&
+            avformat_write_header(oc, &opts) >= 0;
+        av_dict_free(&opts);
+    }
+
+    AVRational videoTb = { 1, 90000 };
+    int64_t startPts = AV_NOPTS_VALUE;
+    int64_t endPts   = AV_NOPTS_VALUE;
+    bool videoDone   = false;
+    QList<AVPacket *> held;         // audio read before the video starts
+
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    while (ok && av_read_frame(ic, &pkt) >= 0)
+    {
+        AVStream *st = ic->streams[pkt.stream_index];
+        int64_t pts = (pkt.pts != (int64_t)AV_NOPTS_VALUE) ? pkt.pts : pkt.dts;
+        AVPacket *out = NULL;
+        AVStream *ost = NULL;
+
+        if (st->id == m_videoPid)
+        {
+            if (pkt.pos >= 0 && pkt.pos < start)
+            {
+                // before the segment
+            }
+            else if (!videoDone && (end < 0 || pkt.pos < end))
+            {
+                if (startPts == (int64_t)AV_NOPTS_VALUE)
+                {
+                    startPts = pts;
+                    videoTb  = st->time_base;
+
+                    // Only the first segment keeps audio from before it
+                    while (ok && !held.isEmpty())
+                    {
+                        AVPacket *apkt = held.takeFirst();
+                        if (segment == 0 ||
+                            apkt->pts == (int64_t)AV_NOPTS_VALUE ||
+                            av_compare_ts(apkt->pts, audioOut->time_base,
+                                          startPts, videoTb) >= 0)
+                        {
+                            apkt->stream_index = audioOut->index;
+                            ok = av_interleaved_write_frame(oc, apkt) >= 0;
+                        }
+                        av_packet_free(&apkt);
+                    }
+                }
+                out = &pkt;
+                ost = videoOut;
+            }
+            else if (!videoDone)
+            {
+                videoDone = true;
+                endPts    = pts;
+            }
+            else if (endPts != (int64_t)AV_NOPTS_VALUE &&
+                     pts != (int64_t)AV_NOPTS_VALUE &&
+                     (pts - endPts) * av_q2d(videoTb) > 2.0)
+            {
+                // The audio is not coming
+                av_packet_unref(&pkt);
+                break;
+            }
+        }
+        else if (st->id == m_audioPid)
+        {
+            if (startPts == (int64_t)AV_NOPTS_VALUE)
+            {
+                AVPacket *apkt = av_packet_clone(&pkt);
+                if (apkt)
+                {
+                    av_packet_rescale_ts(apkt, st->time_base,
+                                         audioOut->time_base);
+                    held.append(apkt);
+                }
+            }
+            else if (pts == (int64_t)AV_NOPTS_VALUE)
+            {
+                if (!videoDone)
+                {
+                    out = &pkt;
+                    ost = audioOut;
+                }
+            }
+            else if (segment > 0 &&
+                     av_compare_ts(pts, st->time_base, startPts, videoTb) < 0)
+            {
+                // belongs to the segment before
+            }
+            else if (videoDone &&
+                     (endPts == (int64_t)AV_NOPTS_VALUE ||
+                      av_compare_ts(pts, st->time_base, endPts, videoTb) >= 0))
+            {
+                av_packet_unref(&pkt);
+                break;
+            }
+            else
+            {
+                out = &pkt;
+                ost = audioOut;
+            }
+        }
+
+        if (out)
+        {
+            av_packet_rescale_ts(out, st->time_base, ost->time_base);
+            out->stream_index = ost->index;
+            out->pos = -1;
+            ok = av_interleaved_write_frame(oc, out) >= 0;
+        }
+
+        av_packet_unref(&pkt);
+    }
+
+    while (!held.isEmpty())
+    {
+        AVPacket *apkt = held.takeFirst();
+        av_packet_free(&apkt);
+    }
+
+    if (startPts == (int64_t)AV_NOPTS_VALUE)
+        ok = false;
+
+    if (oc && oc->pb)
+    {
+        if (ok)
+            ok = av_write_trailer(oc) >= 0;
+
+        uint8_t *buf = NULL;
+        int size = avio_close_dyn_buf(oc->pb, &buf);
+        oc->pb = NULL;
+        if (ok)
+            data = QByteArray((const char *)buf, size);
+        av_free(buf);
+    }
+    avformat_free_context(oc);
+
+    close_input(&ic);
+    delete rbuffer;
+
+    if (!ok)
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to remux segment %1").arg(segment + 1));
+
+    return ok;
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,80 @@
+#ifndef HTTPLIVESTREAMREMUXER_H
+#define HTTPLIVESTREAMREMUXER_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+
+#include "mythtvexp.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+}
+
+class HTTPLiveStream;
+class ProgramInfo;
+
+/** \class HTTPLiveStreamRemuxer
+ *  \brief Serves an HTTP Live Stream of a recording that players can
+ *         already decode, without transcoding it.
+ *
+ *  Recordings with H.264 video and AAC, MP3 or AC-3 audio are cut into
+ *  segments at the key frames in their seek table, so the playlist can
+ *  be written as soon as the stream is started. A segment is only read
+ *  from the recording and remuxed when it is first requested, and is
+ *  then kept in HTTPLiveStreamSegmentCache.
+ */
+class MTV_PUBLIC HTTPLiveStreamRemuxer
+{
+  public:
+   ~HTTPLiveStreamRemuxer();
+
+    static bool StartStream(HTTPLiveStream *hls);
+    static bool GetSegment(const QString &filename, QByteArray &data);
+    static void RemoveStream(const QString &outBase);
+
+  private:
+    typedef struct {
+        int64_t  offset;     ///< of the first key frame, in bytes
+        uint32_t duration;   ///< in ms
+    } Segment;
+
+    HTTPLiveStreamRemuxer();
+
+    static QSharedPointer<HTTPLiveStreamRemuxer> Create(
+        HTTPLiveStream *hls, const ProgramInfo &pginfo);
+    static QSharedPointer<HTTPLiveStreamRemuxer> Find(const QString &outBase);
+    static void Add(const QString &outBase,
+                    QSharedPointer<HTTPLiveStreamRemuxer> remuxer);
+
+    bool Probe(void);
+    bool LoadSegments(const ProgramInfo &pginfo, int segmentSize);
+    bool Remux(int segment, QByteArray &data) const;
+
+    QString            m_sourceFile;
+    int                m_videoPid;
+    int                m_audioPid;
+    AVCodecParameters *m_videoPar;
+    AVCodecParameters *m_audioPar;
+    uint16_t           m_width;
+    uint16_t           m_height;
+    uint32_t           m_bitrate;     ///< of the whole recording
+    QVector<Segment>   m_segments;
+
+    static QMutex                                               s_lock;
+    static QHash<QString, QSharedPointer<HTTPLiveStreamRemuxer> > s_streams;
+    static QList<QString>                                       s_order;
+
+    /// Most streams whose seek table is kept in memory
+    static const int   kMaxStreams;
+    /// Read before a segment, for audio muxed ahead of its video
+    static const int   kPreroll;
+};
+
+#endif
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,1050 @@
+/*  -*- Mode: c++ -*-
+ *
+ *   Class HTTPLiveStreamTranscoder
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+// C headers
+#include <cstring>
+
+#include <QFile>
+#include <QIODevice>
+
+#include "mythcorecontext.h"
+#include "mythtimer.h"
+#include "mythlogging.h"
+#include "ringbuffer.h"
+#include "httplivestream.h"
+#include "httplivestreamtranscoder.h"
+
+extern "C" {
+#include "libavutil/opt.h"
+#include "libavutil/audio_fifo.h"
+#include "libavutil/channel_layout.h"
+#include "libswscale/swscale.h"
+#include "libswresample/swresample.h"
+}
+
+#define LOC QString("HLSTranscoder(%1): ").arg(m_hls->GetStreamID())
+
+QMutex                     HTTPLiveStreamSegmentCache::s_lock;
+QHash<QString, QByteArray> HTTPLiveStreamSegmentCache::s_segments;
+QList<QString>             HTTPLiveStreamSegmentCache::s_order;
+qint64                     HTTPLiveStreamSegmentCache::s_size = 0;
+
+const qint64 HTTPLiveStreamSegmentCache::kMaxSize = 256 * 1024 * 1024;
+
+void HTTPLiveStreamSegmentCache::Insert(const QString &filename,
+                                        const QByteArray &data)
+{
+    QMutexLocker locker(&s_lock);
+
+    QHash<QString, QByteArray>::iterator it = s_segments.find(filename);
+    if (it != s_segments.end())
+    {
+        s_size -= it->size();
+        s_order.removeOne(filename);
+        s_segments.erase(it);
+    }
+
+    s_segments[filename] = data;
+    s_order.append(filename);
+    s_size += data.size();
+
+    while (s_size > kMaxSize && s_order.size() > 1)
+    {
+        QString oldest = s_order.takeFirst();
+        s_size -= s_segments.take(oldest).size();
+    }
+}
+
+bool HTTPLiveStreamSegmentCache::Find(const QString &filename,
+                                      QByteArray &data)
+{
+    QMutexLocker locker(&s_lock);
+
+    QHash<QString, QByteArray>::const_iterator it = s_segments.find(filename);
+    if (it == s_segments.end())
+        return false;
+
+    data = *it;
+    return true;
+}
+
+/// Drops every segment whose file name starts with prefix.
+void HTTPLiveStreamSegmentCache::Remove(const QString &prefix)
+{
+    QMutexLocker locker(&s_lock);
+
+    QList<QString>::iterator it = s_order.begin();
+    while (it != s_order.end())
+    {
+        if (!it->startsWith(prefix))
+        {
+            ++it;
+            continue;
+        }
+
+        s_size -= s_segments.take(*it).size();
+        it = s_order.erase(it);
+    }
+}
+
+static AVCodecContext *open_decoder(AVStream *st)
+{
+    AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+    if (!codec)
+        return NULL;
+
+    AVCodecContext *avctx = avcodec_alloc_context3(codec);
+    if (!avctx)
+        return NULL;
+
+    if (avcodec_parameters_to_context(avctx, st->codecpar) < 0)
+    {
+        avcodec_free_context(&avctx);
+        return NULL;
+    }
+    avctx->pkt_timebase = st->time_base;
+
+    QMutexLocker locker(avcodeclock);
+    if (avcodec_open2(avctx, codec, NULL) < 0)
+        avcodec_free_context(&avctx);
+
+    return avctx;
+}
+
+static void close_codec(AVCodecContext **avctx)
+{
+    if (!*avctx)
+        return;
+
+    QMutexLocker locker(avcodeclock);
+    avcodec_free_context(avctx);
+}
+
+HTTPLiveStreamTranscoder::HTTPLiveStreamTranscoder(int streamid) :
+    m_hls(new HTTPLiveStream(streamid)),
+    m_ringBuffer(NULL), m_avfRingBuffer(NULL),
+    m_ioContext(NULL), m_ic(NULL),
+    m_videoIndex(-1), m_audioIndex(-1),
+    m_videoDecoder(NULL), m_audioDecoder(NULL),
+    m_frame(av_frame_alloc()), m_startTime(0),
+    m_halfFramerate(false), m_framesDecoded(0),
+    m_lastVideoPts(AV_NOPTS_VALUE), m_lastVideoTime(0.0), m_nextCut(0.0),
+    m_audioEncoder(NULL), m_audioOnlyEncoder(NULL),
+    m_resampler(NULL), m_audioFifo(NULL),
+    m_audioSamples(0), m_audioStarted(false),
+    m_segment(0), m_segmentSize(m_hls->GetSegmentSize())
+{
+    memset(&m_readContext, 0, sizeof(m_readContext));
+}
+
+HTTPLiveStreamTranscoder::~HTTPLiveStreamTranscoder()
+{
+    while (!m_outputs.isEmpty())
+        CloseOutput(m_outputs.takeFirst());
+
+    close_codec(&m_audioEncoder);
+    close_codec(&m_audioOnlyEncoder);
+    close_codec(&m_videoDecoder);
+    close_codec(&m_audioDecoder);
+
+    if (m_resampler)
+        swr_free(&m_resampler);
+    if (m_audioFifo)
+        av_audio_fifo_free(m_audioFifo);
+    av_frame_free(&m_frame);
+
+    if (m_ic)
+    {
+        QMutexLocker locker(avcodeclock);
+        avformat_close_input(&m_ic);
+    }
+    if (m_ioContext)
+    {
+        av_freep(&m_ioContext->buffer);
+        avio_context_free(&m_ioContext);
+    }
+    delete m_avfRingBuffer;
+    delete m_ringBuffer;
+
+    // Writes the final playlists
+    delete m_hls;
+}
+
+/** \brief Transcodes the whole stream, updating its status as it goes.
+ *  \return false if the stream could not be transcoded
+ */
+bool HTTPLiveStreamTranscoder::Run(void)
+{
+    if (m_hls->GetStreamID() == -1 || m_hls->GetDBStatus() != kHLSStatusQueued)
+        return false;
+
+    m_hls->UpdateStatus(kHLSStatusStarting);
+    m_hls->UpdateStatusMessage("Transcoding Starting");
+
+    if (!OpenInput() || !OpenOutputs())
+    {
+        m_hls->UpdateStatus(kHLSStatusErrored);
+        m_hls->UpdateStatusMessage("Transcoding Errored");
+        return false;
+    }
+
+    m_hls->UpdateStatus(kHLSStatusRunning);
+    m_hls->UpdateStatusMessage("Transcoding");
+
+    MythTimer statusTimer;
+    statusTimer.start();
+    bool stopped = false;
+    bool ok = true;
+
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    while (ok && av_read_frame(m_ic, &pkt) >= 0)
+    {
+        if (pkt.stream_index == m_videoIndex)
+            ok = DecodeVideo(&pkt);
+        else if (pkt.stream_index == m_audioIndex)
+            ok = DecodeAudio(&pkt);
+        av_packet_unref(&pkt);
+
+        if (statusTimer.elapsed() > 5000)
+        {
+            if (m_hls->CheckStop())
+            {
+                m_hls->UpdateStatus(kHLSStatusStopping);
+                stopped = true;
+                break;
+            }
+
+            UpdateProgress();
+            statusTimer.restart();
+        }
+    }
+
+    if (ok)
+    {
+        // Drain the decoders, the resampler and then the encoders
+        ok = DecodeVideo(NULL) && DecodeAudio(NULL);
+
+        if (ok && m_resampler && m_audioStarted)
+        {
+            AVFrame *out = av_frame_alloc();
+            out->format         = m_audioEncoder->sample_fmt;
+            out->channel_layout = m_audioEncoder->channel_layout;
+            out->sample_rate    = m_audioEncoder->sample_rate;
+            if (swr_convert_frame(m_resampler, out, NULL) >= 0 &&
+                out->nb_samples > 0)
+            {
+                av_audio_fifo_write(m_audioFifo, (void **)out->data,
+                                    out->nb_samples);
+            }
+            av_frame_free(&out);
+        }
+
+        if (ok && m_audioEncoder)
+        {
+            ok = EncodeAudioFifo(true) &&
+                EncodeAudio(m_audioEncoder, NULL, false);
+            if (ok && m_audioOnlyEncoder)
+                ok = EncodeAudio(m_audioOnlyEncoder, NULL, true);
+        }
+
+        for (int i = 0; ok && i < m_outputs.size(); ++i)
+        {
+            if (m_outputs[i]->m_videoCodec)
+                ok = EncodeVideo(m_outputs[i], NULL);
+        }
+    }
+
+    for (int i = 0; i < m_outputs.size(); ++i)
+        FinishSegment(m_outputs[i], true);
+
+    if (!ok)
+    {
+        m_hls->UpdateStatus(kHLSStatusErrored);
+        m_hls->UpdateStatusMessage("Transcoding Errored");
+        return false;
+    }
+
+    if (stopped)
+    {
+        m_hls->UpdateStatus(kHLSStatusStopped);
+        m_hls->UpdateStatusMessage("Transcoding Stopped");
+    }
+    else
+    {
+        m_hls->UpdateStatus(kHLSStatusCompleted);
+        m_hls->UpdateStatusMessage("Transcoding Completed");
+        m_hls->UpdatePercentComplete(100);
+    }
+
+    return true;
+}
+
+/// Opens the source through a RingBuffer, so myth:// URLs work as well.
+bool HTTPLiveStreamTranscoder::OpenInput(void)
+{
+    QString filename = m_hls->GetSourceFile();
+
+    m_ringBuffer = RingBuffer::Create(filename, false, true);
+    if (!m_ringBuffer || !m_ringBuffer->IsOpen())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to open %1").arg(filename));
+        return false;
+    }
+    m_ringBuffer->Start();
+
+    m_avfRingBuffer = new AVFRingBuffer(m_ringBuffer);
+
+    int buf_size                  = m_ringBuffer->BestBufferSize();
+    m_readContext.prot            = AVFRingBuffer::GetRingBufferURLProtocol();
+    m_readContext.flags           = AVIO_FLAG_READ;
+    m_readContext.is_streamed     = m_ringBuffer->IsStreamed();
+    m_readContext.max_packet_size = 0;
+    m_readContext.priv_data       = m_avfRingBuffer;
+    unsigned char *buffer         = (unsigned char *)av_malloc(buf_size);
+    m_ioContext = avio_alloc_context(buffer, buf_size, 0, &m_readContext,
+                                     AVFRingBuffer::AVF_Read_Packet,
+                                     AVFRingBuffer::AVF_Write_Packet,
+                                     AVFRingBuffer::AVF_Seek_Packet);
+    m_ioContext->seekable = !m_ringBuffer->IsStreamed();
+
+    m_ic = avformat_alloc_context();
+    m_ic->pb = m_ioContext;
+
+    {
+        QMutexLocker locker(avcodeclock);
+        QByteArray fname = filename.toLocal8Bit();
+        if (avformat_open_input(&m_ic, fname.constData(), NULL, NULL) < 0)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                QString("Unable to demux %1").arg(filename));
+            return false;
+        }
+
+        if (avformat_find_stream_info(m_ic, NULL) < 0)
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                "Unable to find all stream info");
+    }
+
+    m_videoIndex = av_find_best_stream(m_ic, AVMEDIA_TYPE_VIDEO,
+                                       -1, -1, NULL, 0);
+    m_audioIndex = av_find_best_stream(m_ic, AVMEDIA_TYPE_AUDIO,
+                                       -1, m_videoIndex, NULL, 0);
+    if (m_videoIndex < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("No video stream in %1").arg(filename));
+        return false;
+    }
+
+    m_videoDecoder = open_decoder(m_ic->streams[m_videoIndex]);
+    if (!m_videoDecoder)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to open the video decoder");
+        return false;
+    }
+
+    if (m_audioIndex >= 0)
+    {
+        m_audioDecoder = open_decoder(m_ic->streams[m_audioIndex]);
+        if (!m_audioDecoder)
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                "Unable to open the audio decoder, "
+                "the stream will have no audio");
+            m_audioIndex = -1;
+        }
+    }
+
+    if (m_ic->start_time != (int64_t)AV_NOPTS_VALUE)
+        m_startTime = m_ic->start_time;
+
+    return true;
+}
+
+bool HTTPLiveStreamTranscoder::OpenAudioEncoder(AVCodecContext **avctx,
+                                                uint32_t bitrate)
+{
+    AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    if (!codec)
+        return false;
+
+    AVCodecContext *c = avcodec_alloc_context3(codec);
+    if (!c)
+        return false;
+
+    c->bit_rate              = bitrate;
+    c->sample_rate           = m_audioDecoder->sample_rate ?
+                               m_audioDecoder->sample_rate : 48000;
+    c->channel_layout        = AV_CH_LAYOUT_STEREO;
+    c->channels              = 2;
+    c->sample_fmt            = codec->sample_fmts ?
+                               codec->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
+    c->time_base.num         = 1;
+    c->time_base.den         = c->sample_rate;
+    c->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
+
+    *avctx = c;
+
+    QMutexLocker locker(avcodeclock);
+    if (avcodec_open2(c, codec, NULL) < 0)
+    {
+        avcodec_free_context(avctx);
+        return false;
+    }
+
+    return true;
+}
+
+/** \brief Sizes the renditions and opens an encoder and muxer for each.
+ *
+ *  The first rendition is sized the way mythtranscode sizes a stream.
+ *  Each further one has about 2/3 of the lines and half the bitrate of
+ *  the one before, down to HTTPLiveStreamRenditions renditions in all.
+ */
+bool HTTPLiveStreamTranscoder::OpenOutputs(void)
+{
+    AVStream *st = m_ic->streams[m_videoIndex];
+    int srcWidth  = m_videoDecoder->width;
+    int srcHeight = m_videoDecoder->height;
+    if (!srcWidth || !srcHeight)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unknown video size");
+        return false;
+    }
+
+    AVRational sar = av_guess_sample_aspect_ratio(m_ic, st, NULL);
+    double aspect = (double)srcWidth / srcHeight;
+    if (sar.num && sar.den)
+        aspect *= av_q2d(sar);
+
+    int newWidth  = m_hls->GetWidth();
+    int newHeight = m_hls->GetHeight();
+
+    // There is no point in scaling beyond the original resolution
+    if (newHeight > srcHeight)
+    {
+        newHeight = srcHeight;
+        newWidth = 0;
+    }
+
+    if (newHeight == 0 && newWidth > 0)
+        newHeight = (int)(1.0 * newWidth / aspect);
+    else if (newWidth == 0 && newHeight > 0)
+        newWidth = (int)(1.0 * newHeight * aspect);
+    else if (newWidth == 0 && newHeight == 0)
+    {
+        newHeight = 480;
+        newWidth = (int)(1.0 * 480 * aspect);
+        if (newWidth > 640)
+        {
+            newWidth = 640;
+            newHeight = (int)(1.0 * 640 / aspect);
+        }
+    }
+
+    // make sure dimensions are valid for MPEG codecs
+    newHeight = (newHeight + 15) & ~0xF;
+    newWidth  = (newWidth  + 15) & ~0xF;
+
+    m_hls->UpdateSizeInfo(newWidth, newHeight, srcWidth, srcHeight);
+
+    QList<HTTPLiveStreamRendition> renditions;
+    HTTPLiveStreamRendition rendition = m_hls->GetRendition(0);
+    int count = gCoreContext->GetNumSetting("HTTPLiveStreamRenditions", 3);
+    for (int i = 1; i < count; ++i)
+    {
+        int height = ((rendition.height * 2 / 3) + 15) & ~0xF;
+        uint32_t bitrate = rendition.bitrate / 2;
+        if (height < 144 || bitrate < 100000)
+            break;
+
+        rendition.width   = ((int)(height * aspect) + 15) & ~0xF;
+        rendition.height  = height;
+        rendition.bitrate = bitrate;
+        renditions << rendition;
+    }
+    m_hls->SetRenditions(renditions);
+
+    // Like mythtranscode, only every other frame of 50/60 fps video is kept
+    if (av_q2d(st->avg_frame_rate) > 30)
+        m_halfFramerate = true;
+
+    if (m_audioDecoder)
+    {
+        if (!OpenAudioEncoder(&m_audioEncoder, m_hls->GetAudioBitrate()) ||
+            (m_hls->GetAudioOnlyBitrate() &&
+             !OpenAudioEncoder(&m_audioOnlyEncoder,
+                               m_hls->GetAudioOnlyBitrate())))
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to open the audio encoder");
+            return false;
+        }
+
+        m_resampler = swr_alloc();
+        m_audioFifo = av_audio_fifo_alloc(m_audioEncoder->sample_fmt,
+                                          m_audioEncoder->channels,
+                                          m_audioEncoder->frame_size * 4);
+    }
+
+    LOG(VB_GENERAL, LOG_INFO, LOC +
+        QString("Transcoding %1 %2x%3 into %4 renditions")
+        .arg(m_hls->GetSourceFile()).arg(srcWidth).arg(srcHeight)
+        .arg(m_hls->GetRenditionCount()));
+
+    for (int r = 0; r < m_hls->GetRenditionCount(); ++r)
+    {
+        rendition = m_hls->GetRendition(r);
+        Output *out = OpenOutput(r, false, rendition.width, rendition.height,
+                                 rendition.bitrate);
+        if (!out)
+            return false;
+        m_outputs << out;
+    }
+
+    if (m_audioOnlyEncoder)
+    {
+        Output *out = OpenOutput(0, true, 0, 0, 0);
+        if (!out)
+            return false;
+        m_outputs << out;
+    }
+
+    if (!m_hls->InitForWrite())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "InitForWrite() failed");
+        return false;
+    }
+
+    m_hls->AddSegment();
+    m_segment = 1;
+    m_nextCut = m_segmentSize;
+
+    return true;
+}
+
+HTTPLiveStreamTranscoder::Output *HTTPLiveStreamTranscoder::OpenOutput(
+    int rendition, bool audioOnly,
+    uint16_t width, uint16_t height, uint32_t bitrate)
+{
+    Output *out = new Output();
+    out->m_rendition = rendition;
+    out->m_audioOnly = audioOnly;
+
+    if (avformat_alloc_output_context2(&out->m_ctx, NULL, "mpegts", NULL) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to create the mpegts muxer");
+        CloseOutput(out);
+        return NULL;
+    }
+
+    if (!audioOnly)
+    {
+        AVCodec *codec = avcodec_find_encoder_by_name("libx264");
+        AVCodecContext *c = codec ? avcodec_alloc_context3(codec) : NULL;
+        if (!c)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + "libx264 is not available");
+            CloseOutput(out);
+            return NULL;
+        }
+        out->m_videoCodec = c;
+
+        AVStream *src = m_ic->streams[m_videoIndex];
+        AVRational sar = av_guess_sample_aspect_ratio(m_ic, src, NULL);
+        double aspect = (double)m_videoDecoder->width / m_videoDecoder->height;
+        if (sar.num && sar.den)
+            aspect *= av_q2d(sar);
+
+        c->bit_rate            = bitrate;
+        c->width               = width;
+        c->height              = height;
+        c->sample_aspect_ratio = av_d2q(aspect * height / width, 255);
+        c->time_base           = src->time_base;
+        c->pix_fmt             = AV_PIX_FMT_YUV420P;
+        c->max_b_frames        = 0;
+        c->thread_count        =
+            gCoreContext->GetNumSetting("HTTPLiveStreamThreads", 2);
+        c->thread_type         = FF_THREAD_SLICE;
+
+        // Key frames are forced at the segment boundaries
+        double fps = av_q2d(src->avg_frame_rate);
+        if (fps <= 0.0 || fps > 120.0)
+            fps = 29.97;
+        if (m_halfFramerate)
+            fps /= 2;
+        c->framerate           = av_d2q(fps, 1001000);
+        c->gop_size            = (int)(fps * m_segmentSize);
+
+        // Try to provide the widest device support by using the
+        // Baseline profile where the resolution and bitrate permit
+        if ((c->height > 720) || (c->bit_rate > 1000000))
+        {
+            c->level = 40;
+            av_opt_set(c->priv_data, "profile", "main", 0);
+        }
+        else if (c->height > 576)
+        {
+            c->level = 31;
+            av_opt_set(c->priv_data, "profile", "baseline", 0);
+        }
+        else
+        {
+            c->level = 30;
+            av_opt_set(c->priv_data, "profile", "baseline", 0);
+        }
+
+        QString preset =
+            gCoreContext->GetSetting("HTTPLiveStreamPreset", "veryfast");
+        QString tune = gCoreContext->GetSetting("HTTPLiveStreamTune", "film");
+        av_opt_set(c->priv_data, "preset", preset.toLatin1().constData(), 0);
+        av_opt_set(c->priv_data, "tune", tune.toLatin1().constData(), 0);
+        av_opt_set_int(c->priv_data, "rc-lookahead", 0, 0);
+        av_opt_set_int(c->priv_data, "forced-idr", 1, 0);
+
+        {
+            QMutexLocker locker(avcodeclock);
+            if (avcodec_open2(c, codec, NULL) < 0)
+            {
+                LOG(VB_GENERAL, LOG_ERR, LOC +
+                    QString("Unable to open the %1x%2 video encoder")
+                    .arg(width).arg(height));
+                locker.unlock();
+                CloseOutput(out);
+                return NULL;
+            }
+        }
+
+        out->m_videoStream = avformat_new_stream(out->m_ctx, NULL);
+        if (!out->m_videoStream)
+        {
+            CloseOutput(out);
+            return NULL;
+        }
+        avcodec_parameters_from_context(out->m_videoStream->codecpar, c);
+        out->m_videoStream->time_base = c->time_base;
+        out->m_videoStream->sample_aspect_ratio = c->sample_aspect_ratio;
+
+        out->m_picture = av_frame_alloc();
+        out->m_picture->format = c->pix_fmt;
+        out->m_picture->width  = width;
+        out->m_picture->height = height;
+        if (av_frame_get_buffer(out->m_picture, 32) < 0)
+        {
+            CloseOutput(out);
+            return NULL;
+        }
+    }
+
+    AVCodecContext *actx = audioOnly ? m_audioOnlyEncoder : m_audioEncoder;
+    if (actx)
+    {
+        out->m_audioStream = avformat_new_stream(out->m_ctx, NULL);
+        if (!out->m_audioStream)
+        {
+            CloseOutput(out);
+            return NULL;
+        }
+        avcodec_parameters_from_context(out->m_audioStream->codecpar, actx);
+        out->m_audioStream->time_base = actx->time_base;
+    }
+
+    if (avio_open_dyn_buf(&out->m_ctx->pb) < 0 ||
+        avformat_write_header(out->m_ctx, NULL) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to start the mpegts muxer");
+        CloseOutput(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+void HTTPLiveStreamTranscoder::CloseOutput(Output *out)
+{
+    if (out->m_ctx)
+    {
+        if (out->m_ctx->pb)
+        {
+            uint8_t *data = NULL;
+            avio_close_dyn_buf(out->m_ctx->pb, &data);
+            av_free(data);
+            out->m_ctx->pb = NULL;
+        }
+        avformat_free_context(out->m_ctx);
+    }
+
+    close_codec(&out->m_videoCodec);
+    sws_freeContext(out->m_scaler);
+    av_frame_free(&out->m_picture);
+
+    delete out;
+}
+
+/// Decodes a video packet, or drains the decoder if pkt is NULL.
+bool HTTPLiveStreamTranscoder::DecodeVideo(AVPacket *pkt)
+{
+    int ret = avcodec_send_packet(m_videoDecoder, pkt);
+    if (ret < 0 && ret != AVERROR_EOF)
+    {
+        // Damaged packets are common in recordings, skip them
+        LOG(VB_GENERAL, LOG_DEBUG, LOC + "Skipping a bad video packet");
+        return true;
+    }
+
+    AVStream *st = m_ic->streams[m_videoIndex];
+    int64_t start = av_rescale_q(m_startTime, AV_TIME_BASE_Q, st->time_base);
+
+    while ((ret = avcodec_receive_frame(m_videoDecoder, m_frame)) >= 0)
+    {
+        int64_t pts = m_frame->best_effort_timestamp;
+        bool skip = (pts == (int64_t)AV_NOPTS_VALUE) ||
+            (m_halfFramerate && (m_framesDecoded & 1));
+        ++m_framesDecoded;
+
+        if (!skip)
+        {
+            pts -= start;
+            skip = (pts < 0) || ((m_lastVideoPts != (int64_t)AV_NOPTS_VALUE) &&
+                                 (pts <= m_lastVideoPts));
+        }
+
+        if (skip)
+        {
+            av_frame_unref(m_frame);
+            continue;
+        }
+
+        m_lastVideoPts = pts;
+        m_lastVideoTime = pts * av_q2d(st->time_base);
+
+        // Every rendition starts a new segment on this frame
+        AVPictureType pict_type = AV_PICTURE_TYPE_NONE;
+        if (m_lastVideoTime >= m_nextCut)
+        {
+            pict_type = AV_PICTURE_TYPE_I;
+            while (m_nextCut <= m_lastVideoTime)
+                m_nextCut += m_segmentSize;
+        }
+
+        for (int i = 0; i < m_outputs.size(); ++i)
+        {
+            Output *out = m_outputs[i];
+            if (!out->m_videoCodec)
+                continue;
+
+            out->m_scaler = sws_getCachedContext(
+                out->m_scaler, m_frame->width, m_frame->height,
+                (AVPixelFormat)m_frame->format,
+                out->m_picture->width, out->m_picture->height,
+                AV_PIX_FMT_YUV420P, SWS_FAST_BILINEAR, NULL, NULL, NULL);
+            if (!out->m_scaler ||
+                av_frame_make_writable(out->m_picture) < 0)
+            {
+                av_frame_unref(m_frame);
+                return false;
+            }
+
+            sws_scale(out->m_scaler, m_frame->data, m_frame->linesize,
+                      0, m_frame->height,
+                      out->m_picture->data, out->m_picture->linesize);
+            out->m_picture->pts = pts;
+            out->m_picture->pict_type = pict_type;
+
+            if (!EncodeVideo(out, out->m_picture))
+            {
+                av_frame_unref(m_frame);
+                return false;
+            }
+        }
+
+        av_frame_unref(m_frame);
+    }
+
+    return (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF);
+}
+
+/// Decodes an audio packet into the FIFO the encoders read from.
+bool HTTPLiveStreamTranscoder::DecodeAudio(AVPacket *pkt)
+{
+    if (!m_audioDecoder || !m_audioEncoder)
+        return true;
+
+    int ret = avcodec_send_packet(m_audioDecoder, pkt);
+    if (ret < 0 && ret != AVERROR_EOF)
+    {
+        LOG(VB_GENERAL, LOG_DEBUG, LOC + "Skipping a bad audio packet");
+        return true;
+    }
+
+    AVStream *st = m_ic->streams[m_audioIndex];
+
+    while ((ret = avcodec_receive_frame(m_audioDecoder, m_frame)) >= 0)
+    {
+        if (!m_audioStarted)
+        {
+            // Keep the audio where it was relative to the video
+            int64_t pts = m_frame->best_effort_timestamp;
+            if (pts != (int64_t)AV_NOPTS_VALUE)
+            {
+                pts -= av_rescale_q(m_startTime, AV_TIME_BASE_Q,
+                                    st->time_base);
+                if (pts > 0)
+                    m_audioSamples = av_rescale_q(
+                        pts, st->time_base, m_audioEncoder->time_base);
+            }
+            m_audioStarted = true;
+        }
+
+        if (!m_frame->channel_layout)
+            m_frame->channel_layout =
+                av_get_default_channel_layout(m_frame->channels);
+
+        AVFrame *out = av_frame_alloc();
+        out->format         = m_audioEncoder->sample_fmt;
+        out->channel_layout = m_audioEncoder->channel_layout;
+        out->sample_rate    = m_audioEncoder->sample_rate;
+
+        if (swr_convert_frame(m_resampler, out, m_frame) < 0)
+        {
+            // The input format changed, start over with the new one
+            swr_close(m_resampler);
+            av_frame_unref(out);
+            out->format         = m_audioEncoder->sample_fmt;
+            out->channel_layout = m_audioEncoder->channel_layout;
+            out->sample_rate    = m_audioEncoder->sample_rate;
+            swr_convert_frame(m_resampler, out, m_frame);
+        }
+
+        if (out->nb_samples > 0)
+            av_audio_fifo_write(m_audioFifo, (void **)out->data,
+                                out->nb_samples);
+
+        av_frame_free(&out);
+        av_frame_unref(m_frame);
+
+        if (!EncodeAudioFifo(false))
+            return false;
+    }
+
+    return (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF);
+}
+
+/// Encodes a frame for one rendition, or drains it if frame is NULL.
+bool HTTPLiveStreamTranscoder::EncodeVideo(Output *out, AVFrame *frame)
+{
+    int ret = avcodec_send_frame(out->m_videoCodec, frame);
+    if (ret < 0 && ret != AVERROR_EOF)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Video encoding failed");
+        return false;
+    }
+
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    while ((ret = avcodec_receive_packet(out->m_videoCodec, &pkt)) >= 0)
+    {
+        WritePacket(out, out->m_videoStream, out->m_videoCodec, &pkt);
+        av_packet_unref(&pkt);
+    }
+
+    return (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF);
+}
+
+/** \brief Encodes audio and muxes it into every rendition, or into the
+ *         audio only stream. Drains the encoder if frame is NULL.
+ */
+bool HTTPLiveStreamTranscoder::EncodeAudio(AVCodecContext *avctx,
+                                           AVFrame *frame, bool audioOnly)
+{
+    int ret = avcodec_send_frame(avctx, frame);
+    if (ret < 0 && ret != AVERROR_EOF)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Audio encoding failed");
+        return false;
+    }
+
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    while ((ret = avcodec_receive_packet(avctx, &pkt)) >= 0)
+    {
+        for (int i = 0; i < m_outputs.size(); ++i)
+        {
+            Output *out = m_outputs[i];
+            if (out->m_audioOnly == audioOnly && out->m_audioStream)
+                WritePacket(out, out->m_audioStream, avctx, &pkt);
+        }
+        av_packet_unref(&pkt);
+    }
+
+    return (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF);
+}
+
+/// Encodes what is in the FIFO in whole frames, or all of it if flushing.
+bool HTTPLiveStreamTranscoder::EncodeAudioFifo(bool flush)
+{
+    int frameSize = m_audioEncoder->frame_size;
+    if (frameSize <= 0)
+        frameSize = 1024;
+
+    while (av_audio_fifo_size(m_audioFifo) >= frameSize ||
+           (flush && av_audio_fifo_size(m_audioFifo) > 0))
+    {
+        int samples = FFMIN(av_audio_fifo_size(m_audioFifo), frameSize);
+
+        AVFrame *frame = av_frame_alloc();
+        frame->nb_samples     = samples;
+        frame->format         = m_audioEncoder->sample_fmt;
+        frame->channel_layout = m_audioEncoder->channel_layout;
+        frame->sample_rate    = m_audioEncoder->sample_rate;
+        if (av_frame_get_buffer(frame, 0) < 0)
+        {
+            av_frame_free(&frame);
+            return false;
+        }
+
+        av_audio_fifo_read(m_audioFifo, (void **)frame->data, samples);
+        frame->pts = m_audioSamples;
+        m_audioSamples += samples;
+
+        bool ok = EncodeAudio(m_audioEncoder, frame, false) &&
+            (!m_audioOnlyEncoder ||
+             EncodeAudio(m_audioOnlyEncoder, frame, true));
+        av_frame_free(&frame);
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+/** \brief Muxes a packet, first starting the next segment if this is the
+ *         key frame (or for the audio only stream, the audio) at its start.
+ */
+void HTTPLiveStreamTranscoder::WritePacket(Output *out, AVStream *st,
+                                           AVCodecContext *avctx,
+                                           AVPacket *pkt)
+{
+    bool boundary = out->m_audioOnly ? true : ((st == out->m_videoStream) &&
+                                               (pkt->flags & AV_PKT_FLAG_KEY));
+    double secs = pkt->pts * av_q2d(avctx->time_base);
+
+    if (boundary && secs >= (double)out->m_segment * m_segmentSize - 0.001)
+    {
+        FinishSegment(out);
+
+        // Publish the segment once every rendition has finished it
+        uint16_t done = out->m_segment;
+        for (int i = 0; i < m_outputs.size(); ++i)
+            done = qMin(done, m_outputs[i]->m_segment);
+        while (m_segment < done)
+        {
+            m_hls->AddSegment();
+            ++m_segment;
+        }
+    }
+
+    AVPacket copy;
+    if (av_packet_ref(&copy, pkt) < 0)
+        return;
+    av_packet_rescale_ts(&copy, avctx->time_base, st->time_base);
+    copy.stream_index = st->index;
+
+    if (av_write_frame(out->m_ctx, &copy) < 0)
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to mux a packet");
+
+    av_packet_unref(&copy);
+}
+
+/** \brief Takes the segment out of the muxer, caches it and writes it to
+ *         disk, then starts the next one unless this was the last.
+ */
+void HTTPLiveStreamTranscoder::FinishSegment(Output *out, bool last)
+{
+    if (!out->m_ctx->pb)
+        return;
+
+    if (last)
+        av_write_trailer(out->m_ctx);
+    else
+        av_write_frame(out->m_ctx, NULL);
+
+    uint8_t *data = NULL;
+    int size = avio_close_dyn_buf(out->m_ctx->pb, &data);
+    out->m_ctx->pb = NULL;
+
+    QByteArray segment((const char *)data, size);
+    av_free(data);
+
+    HTTPLiveStreamSegmentCache::Insert(
+        m_hls->GetFilename(out->m_segment, true, out->m_audioOnly, false,
+                           out->m_rendition), segment);
+
+    QString filename = m_hls->GetFilename(out->m_segment, false,
+                                          out->m_audioOnly, false,
+                                          out->m_rendition);
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(segment) != segment.size())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to write %1").arg(filename));
+    }
+    file.close();
+
+    ++out->m_segment;
+
+    if (last)
+        return;
+
+    if (avio_open_dyn_buf(&out->m_ctx->pb) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to start a new segment");
+        return;
+    }
+
+    // Each segment has to be playable on its own
+    av_opt_set(out->m_ctx->priv_data, "mpegts_flags", "resend_headers", 0);
+}
+
+void HTTPLiveStreamTranscoder::UpdateProgress(void)
+{
+    int percent = 0;
+
+    if (m_ic->duration > 0)
+        percent = (int)(m_lastVideoTime * 100 * AV_TIME_BASE /
+                        m_ic->duration);
+    else if (m_ringBuffer->GetRealFileSize() > 0)
+        percent = (int)(m_ringBuffer->GetReadPosition() * 100 /
+                        m_ringBuffer->GetRealFileSize());
+
+    m_hls->UpdatePercentComplete(qBound(0, percent, 99));
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,136 @@
+#ifndef HTTPLIVESTREAMTRANSCODER_H
+#define HTTPLIVESTREAMTRANSCODER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+
+#include "avfringbuffer.h"
+#include "mythtvexp.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+}
+
+struct SwsContext;
+struct SwrContext;
+struct AVAudioFifo;
+class HTTPLiveStream;
+class RingBuffer;
+
+/** \class HTTPLiveStreamSegmentCache
+ *  \brief Keeps the most recent HTTP Live Stream segments in memory, so
+ *         that they can be served without going back to the disk.
+ *
+ *  Segments are looked up by their file name, and the oldest ones are
+ *  dropped once the cache holds more than kMaxSize bytes.
+ */
+class MTV_PUBLIC HTTPLiveStreamSegmentCache
+{
+  public:
+    static void Insert(const QString &filename, const QByteArray &data);
+    static bool Find(const QString &filename, QByteArray &data);
+    static void Remove(const QString &prefix);
+
+  private:
+    static QMutex                     s_lock;
+    static QHash<QString, QByteArray> s_segments;
+    static QList<QString>             s_order;   ///< oldest first
+    static qint64                     s_size;
+
+    static const qint64               kMaxSize;
+};
+
+/** \class HTTPLiveStreamTranscoder
+ *  \brief Transcodes an HTTP Live Stream inside the calling process.
+ *
+ *  The source is demuxed and decoded once. Every video frame is scaled
+ *  and encoded for each rendition of the stream, and the audio is
+ *  encoded once and muxed into all of them, plus into the audio only
+ *  stream. Key frames are forced at the segment boundaries, so all
+ *  renditions are cut at the same points in time. Segments are muxed
+ *  into memory, handed to HTTPLiveStreamSegmentCache and written out
+ *  to the Streaming storage group.
+ */
+class MTV_PUBLIC HTTPLiveStreamTranscoder
+{
+  public:
+    explicit HTTPLiveStreamTranscoder(int streamid);
+   ~HTTPLiveStreamTranscoder();
+
+    bool Run(void);
+
+  private:
+    class Output
+    {
+      public:
+        Output() :
+            m_ctx(NULL), m_videoStream(NULL), m_audioStream(NULL),
+            m_videoCodec(NULL), m_scaler(NULL), m_picture(NULL),
+            m_rendition(0), m_audioOnly(false), m_segment(1) {}
+
+        AVFormatContext *m_ctx;
+        AVStream        *m_videoStream;
+        AVStream        *m_audioStream;
+        AVCodecContext  *m_videoCodec;   ///< NULL for the audio only stream
+        SwsContext      *m_scaler;
+        AVFrame         *m_picture;
+        int              m_rendition;
+        bool             m_audioOnly;
+        uint16_t         m_segment;      ///< segment being muxed
+    };
+
+    bool OpenInput(void);
+    bool OpenAudioEncoder(AVCodecContext **avctx, uint32_t bitrate);
+    bool OpenOutputs(void);
+    Output *OpenOutput(int rendition, bool audioOnly,
+                       uint16_t width, uint16_t height, uint32_t bitrate);
+    void CloseOutput(Output *out);
+
+    bool DecodeVideo(AVPacket *pkt);
+    bool DecodeAudio(AVPacket *pkt);
+    bool EncodeVideo(Output *out, AVFrame *frame);
+    bool EncodeAudio(AVCodecContext *avctx, AVFrame *frame, bool audioOnly);
+    bool EncodeAudioFifo(bool flush);
+    void WritePacket(Output *out, AVStream *st, AVCodecContext *avctx,
+                     AVPacket *pkt);
+    void FinishSegment(Output *out, bool last = false);
+    void UpdateProgress(void);
+
+    HTTPLiveStream   *m_hls;
+    RingBuffer       *m_ringBuffer;
+    AVFRingBuffer    *m_avfRingBuffer;
+    URLContext        m_readContext;
+    AVIOContext      *m_ioContext;
+    AVFormatContext  *m_ic;
+
+    int               m_videoIndex;
+    int               m_audioIndex;
+    AVCodecContext   *m_videoDecoder;
+    AVCodecContext   *m_audioDecoder;
+    AVFrame          *m_frame;
+    int64_t           m_startTime;       ///< in AV_TIME_BASE
+    bool              m_halfFramerate;
+    uint64_t          m_framesDecoded;
+    int64_t           m_lastVideoPts;    ///< last pts sent to the encoders
+    double            m_lastVideoTime;   ///< seconds into the source
+    double            m_nextCut;         ///< seconds, next forced key frame
+
+    AVCodecContext   *m_audioEncoder;
+    AVCodecContext   *m_audioOnlyEncoder;
+    SwrContext       *m_resampler;
+    AVAudioFifo      *m_audioFifo;
+    int64_t           m_audioSamples;    ///< next audio pts, in samples
+    bool              m_audioStarted;
+
+    QList<Output*>    m_outputs;
+    uint16_t          m_segment;         ///< segment m_hls is writing
+    int               m_segmentSize;     ///< seconds
+};
+
+#endif
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -1214,6 +1214,13 @@ void DecoderBase::SaveTotalDuration(void)
     m_playbackinfo->SaveTotalDuration(1000000 * av_q2d(totalDuration));
 }
 
+/// Adds the duration another decoder read of a different part of the
+/// same file, for files decoded in segments.
+void DecoderBase::AddTotalDuration(const DecoderBase *other)
+{
+    totalDuration = av_add_q(totalDuration, other->totalDuration);
+}
+
 void DecoderBase::SaveTotalFrames(void)
 {
     if (!m_playbackinfo || !framesRead)
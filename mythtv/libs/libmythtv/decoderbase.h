@@ -266,6 +266,7 @@ class DecoderBase
 
     void SaveTotalDuration(void);
     void ResetTotalDuration(void) { totalDuration = AVRationalInit(0); }
+    void AddTotalDuration(const DecoderBase *other);
     void SaveTotalFrames(void);
     bool GetVideoInverted(void) const { return video_inverted; }
     void TrackTotalDuration(bool track) { trackTotalDuration = track; }
@@ -5,22 +5,131 @@
  * License: GPL v2
  */
 
+#include <algorithm>
+#include <cstring>
+
 #include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
 
 #include "eitcache.h"
 #include "mythcontext.h"
 #include "mythdb.h"
+#include "mythdirs.h"
 #include "mythlogging.h"
 #include "mythdate.h"
 
 #define LOC QString("EITCache: ")
 
+const uint EITCacheMap::kMinCapacity = 1024;
+
+static inline uint hash_event(uint chanid, uint eventid)
+{
+    // finalizer of MurmurHash3
+    uint64_t key = ((uint64_t) chanid << 32) | eventid;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (uint) key;
+}
+
+uint64_t *EITCacheMap::Find(uint chanid, uint eventid)
+{
+    if (m_slots.empty())
+        return NULL;
+
+    uint mask = m_slots.size() - 1;
+    for (uint i = hash_event(chanid, eventid) & mask;; i = (i + 1) & mask)
+    {
+        Entry &entry = m_slots[i];
+        if (!entry.chanid)
+            return NULL;
+        if (entry.chanid == chanid && entry.eventid == eventid)
+            return &entry.sig;
+    }
+}
+
+void EITCacheMap::Insert(uint chanid, uint eventid, uint64_t sig)
+{
+    if (!chanid)
+        return;
+
+    if ((m_count + 1) * 2 > (uint) m_slots.size())
+        Resize(std::max(kMinCapacity, (uint) m_slots.size() * 2));
+
+    uint mask = m_slots.size() - 1;
+    for (uint i = hash_event(chanid, eventid) & mask;; i = (i + 1) & mask)
+    {
+        Entry &entry = m_slots[i];
+        if (!entry.chanid)
+        {
+            entry.chanid  = chanid;
+            entry.eventid = eventid;
+            entry.sig     = sig;
+            m_count++;
+            return;
+        }
+        if (entry.chanid == chanid && entry.eventid == eventid)
+        {
+            entry.sig = sig;
+            return;
+        }
+    }
+}
+
+void EITCacheMap::Compact(void)
+{
+    uint count = 0;
+    for (int i = 0; i < m_slots.size(); i++)
+        count += m_slots[i].chanid ? 1 : 0;
+
+    if (!count)
+    {
+        Clear();
+        return;
+    }
+
+    uint capacity = kMinCapacity;
+    while (capacity < count * 4)
+        capacity *= 2;
+
+    // Re-inserting closes the holes left in the probe sequences
+    Resize(std::min(capacity, std::max(kMinCapacity, (uint) m_slots.size())));
+}
+
+void EITCacheMap::Clear(void)
+{
+    m_slots.clear();
+    m_slots.squeeze();
+    m_count = 0;
+}
+
+void EITCacheMap::Resize(uint capacity)
+{
+    QVector<Entry> old;
+    old.swap(m_slots);
+
+    Entry empty = { 0, 0, 0 };
+    m_slots.fill(empty, capacity);
+    m_count = 0;
+
+    for (int i = 0; i < old.size(); i++)
+    {
+        if (old[i].chanid)
+            Insert(old[i].chanid, old[i].eventid, old[i].sig);
+    }
+}
+
 // Highest version number. version is 5bits
 const uint EITCache::kVersionMax = 31;
 
 EITCache::EITCache()
-    : accessCnt(0), hitCnt(0), tblChgCnt(0), verChgCnt(0), endChgCnt(0),
-      entryCnt(0), pruneCnt(0), prunedHitCnt(0), futureHitCnt(0), wrongChannelHitCnt(0)
+    : snapshotOpened(false), snapshotFile(NULL), snapshotData(NULL),
+      accessCnt(0), hitCnt(0), tblChgCnt(0), verChgCnt(0), endChgCnt(0),
+      entryCnt(0), pruneCnt(0), prunedHitCnt(0), futureHitCnt(0), wrongChannelHitCnt(0),
+      snapshotChanCnt(0), dbChanCnt(0)
 {
     // 24 hours ago
 #if QT_VERSION < QT_VERSION_CHECK(5,8,0)
@@ -33,6 +142,7 @@ EITCache::EITCache()
 EITCache::~EITCache()
 {
     WriteToDB();
+    CloseSnapshot();
 }
 
 void EITCache::ResetStatistics(void)
@@ -47,6 +157,8 @@ void EITCache::ResetStatistics(void)
     prunedHitCnt = 0;
     futureHitCnt = 0;
     wrongChannelHitCnt = 0;
+    snapshotChanCnt = 0;
+    dbChanCnt = 0;
 }
 
 QString EITCache::GetStatistics(void) const
@@ -56,11 +168,16 @@ QString EITCache::GetStatistics(void) const
         "EITCache::statistics: Accesses: %1, Hits: %2, "
         "Table Upgrades %3, New Versions: %4, New Endtimes: %5, Entries: %6, "
         "Pruned Entries: %7, Pruned Hits: %8, Future Hits: %9, Wrong Channel Hits %10, "
-        "Hit Ratio %11.")
+        "Hit Ratio %11, Cached Entries %12, Memory %13 kB, Load Factor %14, "
+        "Channels Loaded from Snapshot %15, from Database %16.")
         .arg(accessCnt).arg(hitCnt).arg(tblChgCnt).arg(verChgCnt).arg(endChgCnt)
         .arg(entryCnt).arg(pruneCnt).arg(prunedHitCnt).arg(futureHitCnt)
         .arg(wrongChannelHitCnt)
-        .arg((hitCnt+prunedHitCnt+futureHitCnt+wrongChannelHitCnt)/(double)accessCnt);
+        .arg((hitCnt+prunedHitCnt+futureHitCnt+wrongChannelHitCnt)/(double)accessCnt)
+        .arg(eventMap.Size()).arg(eventMap.MemoryUsage() / 1024)
+        .arg(eventMap.Capacity() ?
+             eventMap.Size() / (double)eventMap.Capacity() : 0.0, 0, 'f', 2)
+        .arg(snapshotChanCnt).arg(dbChanCnt);
 }
 
 /*
@@ -184,7 +301,8 @@ static bool lock_channel(uint chanid, uint endtime)
     return true;
 }
 
-static void unlock_channel(uint chanid, uint updated)
+// Returns the time stamp of the statistics row written for the channel.
+static uint unlock_channel(uint chanid, uint updated)
 {
     MSqlQuery query(MSqlQuery::InitCon());
 
@@ -218,13 +336,18 @@ static void unlock_channel(uint chanid, uint updated)
 
     if (!query.exec())
         MythDB::DBError("Error inserting eit statistics", query);
+
+    return now;
 }
 
 
-event_map_t * EITCache::LoadChannel(uint chanid)
+bool EITCache::LoadChannel(uint chanid)
 {
     if (!lock_channel(chanid, lastPruneTime))
-        return NULL;
+        return false;
+
+    if (LoadChannelFromSnapshot(chanid))
+        return true;
 
     MSqlQuery query(MSqlQuery::InitCon());
 
@@ -243,11 +366,10 @@ event_map_t * EITCache::LoadChannel(uint chanid)
     if (!query.exec() || !query.isActive())
     {
         MythDB::DBError("Error loading eitcache", query);
-        return NULL;
+        return false;
     }
 
-    event_map_t * eventMap = new event_map_t();
-
+    uint count = 0;
     while (query.next())
     {
         uint eventid = query.value(0).toUInt();
@@ -255,89 +377,333 @@ event_map_t * EITCache::LoadChannel(uint chanid)
         uint version = query.value(2).toUInt();
         uint endtime = query.value(3).toUInt();
 
-        (*eventMap)[eventid] = construct_sig(tableid, version, endtime, false);
+        eventMap.Insert(chanid, eventid,
+                        construct_sig(tableid, version, endtime, false));
+        count++;
     }
 
-    if (eventMap->size())
+    if (count)
         LOG(VB_EIT, LOG_INFO, LOC + QString("Loaded %1 entries for channel %2")
-                .arg(eventMap->size()).arg(chanid));
+                .arg(count).arg(chanid));
 
-    entryCnt += eventMap->size();
-    return eventMap;
+    entryCnt += count;
+    dbChanCnt++;
+    return true;
 }
 
-bool EITCache::WriteChannelToDB(QStringList &value_clauses, uint chanid)
+void EITCache::WriteToDB(void)
 {
-    event_map_t * eventMap = channelMap[chanid];
-
-    if (!eventMap)
-        return false;
+    QMutexLocker locker(&eventMapLock);
 
-    uint size    = eventMap->size();
-    uint updated = 0;
-    uint removed = 0;
+    QStringList value_clauses;
+    QMap<uint, uint> sizes;
+    QMap<uint, uint> updated;
+    QMap<uint, uint> removed;
 
-    event_map_t::iterator it = eventMap->begin();
-    while (it != eventMap->end())
+    QVector<EITCacheMap::Entry> &table = eventMap.Slots();
+    for (int i = 0; i < table.size(); i++)
     {
-        if (extract_endtime(*it) > lastPruneTime)
+        EITCacheMap::Entry &entry = table[i];
+        if (!entry.chanid)
+            continue;
+
+        sizes[entry.chanid]++;
+        if (extract_endtime(entry.sig) > lastPruneTime)
         {
-            if (modified(*it))
+            if (modified(entry.sig))
             {
-                replace_in_db(value_clauses, chanid, it.key(), *it);
-                updated++;
-                *it &= ~(uint64_t)0 >> 1; // mark as synced
+                replace_in_db(value_clauses, entry.chanid,
+                              entry.eventid, entry.sig);
+                updated[entry.chanid]++;
+                entry.sig &= ~(uint64_t)0 >> 1; // mark as synced
             }
-            ++it;
         }
         else
         {
             // Event is too old; remove from eit cache in memory
-            it = eventMap->erase(it);
-            removed++;
+            removed[entry.chanid]++;
+            entry.chanid = 0;
         }
     }
-    unlock_channel(chanid, updated);
 
-    if (updated)
-        LOG(VB_EIT, LOG_INFO, LOC + QString("Writing %1 modified entries of %2 "
-                                      "for channel %3 to database.")
-                .arg(updated).arg(size).arg(chanid));
-    if (removed)
-        LOG(VB_EIT, LOG_INFO, LOC + QString("Removed %1 old entries of %2 "
-                                      "for channel %3 from cache.")
-                .arg(removed).arg(size).arg(chanid));
-    pruneCnt += removed;
+    if (!removed.empty())
+        eventMap.Compact();
 
-    return true;
+    QMap<uint, bool>::iterator it = channelMap.begin();
+    while (it != channelMap.end())
+    {
+        if (!*it)
+        {
+            it = channelMap.erase(it);
+            continue;
+        }
+
+        uint chanid = it.key();
+        syncTimes[chanid] = unlock_channel(chanid, updated.value(chanid));
+
+        if (updated.value(chanid))
+            LOG(VB_EIT, LOG_INFO, LOC + QString("Writing %1 modified entries of %2 "
+                                          "for channel %3 to database.")
+                    .arg(updated.value(chanid)).arg(sizes.value(chanid))
+                    .arg(chanid));
+        if (removed.value(chanid))
+            LOG(VB_EIT, LOG_INFO, LOC + QString("Removed %1 old entries of %2 "
+                                          "for channel %3 from cache.")
+                    .arg(removed.value(chanid)).arg(sizes.value(chanid))
+                    .arg(chanid));
+        pruneCnt += removed.value(chanid);
+        ++it;
+    }
+
+    if (!value_clauses.isEmpty())
+    {
+        MSqlQuery query(MSqlQuery::InitCon());
+        query.prepare(QString("REPLACE INTO eit_cache "
+                              "(chanid, eventid, tableid, version, endtime) "
+                              "VALUES %1").arg(value_clauses.join(",")));
+        if (!query.exec())
+        {
+            MythDB::DBError("Error updating eitcache", query);
+        }
+    }
+
+    WriteSnapshot();
 }
 
-void EITCache::WriteToDB(void)
+/*
+ * The snapshot file holds the cache as it was last written to the
+ * database, so a restarted backend can map it instead of reading the
+ * eit_cache rows of each channel back from MySQL. It consists of a
+ * snapshot_header, the SnapshotChannel table sorted by chanid and the
+ * entries of all channels, in host byte order.
+ */
+#define SNAPSHOT_MAGIC   0x43544945 // "EITC"
+#define SNAPSHOT_VERSION 1
+
+struct snapshot_header
 {
-    QMutexLocker locker(&eventMapLock);
+    uint32_t magic;
+    uint32_t version;
+    uint32_t channels;
+    uint32_t entries;
+};
 
-    QStringList value_clauses;
-    key_map_t::iterator it = channelMap.begin();
-    while (it != channelMap.end())
+static QString snapshot_path(void)
+{
+    return GetConfDir() + "/eitcache.snapshot";
+}
+
+void EITCache::OpenSnapshot(void)
+{
+    snapshotOpened = true;
+
+    QFile *file = new QFile(snapshot_path());
+    if (!file->open(QIODevice::ReadOnly))
     {
-        if (!WriteChannelToDB(value_clauses, it.key()))
-            it = channelMap.erase(it);
-        else
-            ++it;
+        delete file;
+        return;
     }
 
-    if(value_clauses.isEmpty())
+    snapshot_header header;
+    qint64 size = file->size();
+    const uchar *data = NULL;
+    if (size >= (qint64)sizeof(header))
+        data = file->map(0, size);
+    if (data)
+        memcpy(&header, data, sizeof(header));
+
+    if (!data || header.magic != SNAPSHOT_MAGIC ||
+        header.version != SNAPSHOT_VERSION ||
+        size != (qint64)(sizeof(header) +
+                         header.channels * sizeof(SnapshotChannel) +
+                         header.entries * sizeof(EITCacheMap::Entry)))
     {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("Ignoring invalid snapshot %1").arg(file->fileName()));
+        delete file;
         return;
     }
 
+    const uchar *channels = data + sizeof(header);
+    for (uint i = 0; i < header.channels; i++)
+    {
+        SnapshotChannel channel;
+        memcpy(&channel, channels + i * sizeof(channel), sizeof(channel));
+        if ((uint64_t)channel.first + channel.count > header.entries)
+            continue;
+        snapshotIndex[channel.chanid] = channel;
+    }
+
+    snapshotFile = file;
+    snapshotData = channels + header.channels * sizeof(SnapshotChannel);
+
+    LOG(VB_EIT, LOG_INFO, LOC +
+        QString("Opened snapshot with %1 entries for %2 channels")
+            .arg(header.entries).arg(snapshotIndex.size()));
+}
+
+void EITCache::CloseSnapshot(void)
+{
+    // Deleting the file unmaps it
+    delete snapshotFile;
+    snapshotFile = NULL;
+    snapshotData = NULL;
+    snapshotIndex.clear();
+}
+
+bool EITCache::LoadChannelFromSnapshot(uint chanid)
+{
+    if (!snapshotOpened)
+        OpenSnapshot();
+
+    QMap<uint, SnapshotChannel>::iterator it = snapshotIndex.find(chanid);
+    if (it == snapshotIndex.end())
+        return false;
+
+    SnapshotChannel channel = *it;
+    snapshotIndex.erase(it);
+
+    // The snapshot is only good as long as nobody else wrote
+    // the channel to the database after it was taken.
     MSqlQuery query(MSqlQuery::InitCon());
-    query.prepare(QString("REPLACE INTO eit_cache "
-                          "(chanid, eventid, tableid, version, endtime) "
-                          "VALUES %1").arg(value_clauses.join(",")));
+    query.prepare(
+        "SELECT MAX(endtime) "
+        "FROM eit_cache "
+        "WHERE chanid = :CHANID AND "
+        "      status = :STATUS");
+    query.bindValue(":CHANID", chanid);
+    query.bindValue(":STATUS", STATISTIC);
+
+    bool valid = false;
     if (!query.exec())
+        MythDB::DBError("Error checking eitcache snapshot", query);
+    else if (query.next())
+        valid = (query.value(0).toUInt() == channel.synctime);
+
+    uint count = 0;
+    for (uint i = 0; valid && (i < channel.count); i++)
+    {
+        EITCacheMap::Entry entry;
+        memcpy(&entry,
+               snapshotData + (channel.first + i) * sizeof(entry),
+               sizeof(entry));
+        if (extract_endtime(entry.sig) > lastPruneTime)
+        {
+            eventMap.Insert(chanid, entry.eventid,
+                            entry.sig & (~(uint64_t)0 >> 1));
+            count++;
+        }
+    }
+
+    if (snapshotIndex.empty())
+        CloseSnapshot();
+
+    if (!valid)
+    {
+        LOG(VB_EIT, LOG_INFO, LOC +
+            QString("Snapshot of channel %1 is out of date").arg(chanid));
+        return false;
+    }
+
+    if (count)
+        LOG(VB_EIT, LOG_INFO, LOC +
+            QString("Loaded %1 entries for channel %2 from snapshot")
+                .arg(count).arg(chanid));
+
+    entryCnt += count;
+    snapshotChanCnt++;
+    return true;
+}
+
+void EITCache::WriteSnapshot(void)
+{
+    if (!snapshotOpened)
+        OpenSnapshot();
+
+    QMap<uint, QVector<EITCacheMap::Entry> > channels;
+    QMap<uint, uint> synctimes;
+
+    QMap<uint, bool>::const_iterator cit = channelMap.begin();
+    for (; cit != channelMap.end(); ++cit)
+    {
+        if (*cit && syncTimes.contains(cit.key()))
+        {
+            channels.insert(cit.key(), QVector<EITCacheMap::Entry>());
+            synctimes[cit.key()] = syncTimes[cit.key()];
+        }
+    }
+
+    const QVector<EITCacheMap::Entry> &table = eventMap.Slots();
+    for (int i = 0; i < table.size(); i++)
+    {
+        if (channels.contains(table[i].chanid))
+            channels[table[i].chanid].push_back(table[i]);
+    }
+
+    // Carry over the channels of the previous snapshot not used yet
+    QMap<uint, SnapshotChannel>::const_iterator sit = snapshotIndex.begin();
+    for (; sit != snapshotIndex.end(); ++sit)
+    {
+        if (channels.contains(sit.key()))
+            continue;
+
+        QVector<EITCacheMap::Entry> &entries = channels[sit.key()];
+        synctimes[sit.key()] = (*sit).synctime;
+        for (uint i = 0; i < (*sit).count; i++)
+        {
+            EITCacheMap::Entry entry;
+            memcpy(&entry,
+                   snapshotData + ((*sit).first + i) * sizeof(entry),
+                   sizeof(entry));
+            if (extract_endtime(entry.sig) > lastPruneTime)
+                entries.push_back(entry);
+        }
+    }
+
+    // Windows can not replace a file that is still mapped. The new
+    // snapshot is opened again when the next channel is loaded.
+    CloseSnapshot();
+    snapshotOpened = false;
+
+    snapshot_header header;
+    header.magic    = SNAPSHOT_MAGIC;
+    header.version  = SNAPSHOT_VERSION;
+    header.channels = channels.size();
+    header.entries  = 0;
+
+    QByteArray index;
+    QMap<uint, QVector<EITCacheMap::Entry> >::const_iterator it;
+    for (it = channels.begin(); it != channels.end(); ++it)
+    {
+        SnapshotChannel channel;
+        channel.chanid   = it.key();
+        channel.synctime = synctimes[it.key()];
+        channel.first    = header.entries;
+        channel.count    = (*it).size();
+        index.append((const char*)&channel, sizeof(channel));
+        header.entries  += channel.count;
+    }
+
+    QSaveFile file(snapshot_path());
+    if (!file.open(QIODevice::WriteOnly))
     {
-        MythDB::DBError("Error updating eitcache", query);
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to write snapshot %1").arg(file.fileName()));
+        return;
+    }
+
+    file.write((const char*)&header, sizeof(header));
+    file.write(index);
+    for (it = channels.begin(); it != channels.end(); ++it)
+    {
+        file.write((const char*)(*it).constData(),
+                   (*it).size() * sizeof(EITCacheMap::Entry));
+    }
+
+    if (!file.commit())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to write snapshot %1").arg(file.fileName()));
     }
 }
 
@@ -378,24 +744,23 @@ bool EITCache::IsNewEIT(uint chanid,  uint tableid,   uint version,
         return false;
     }
 
-    event_map_t * eventMap = channelMap[chanid];
-    event_map_t::iterator it = eventMap->find(eventid);
-    if (it != eventMap->end())
+    uint64_t *sig = eventMap.Find(chanid, eventid);
+    if (sig)
     {
-        if (extract_table_id(*it) > tableid)
+        if (extract_table_id(*sig) > tableid)
         {
             // EIT from lower (ie. better) table number
             tblChgCnt++;
         }
-        else if ((extract_table_id(*it) == tableid) &&
-                 ((extract_version(*it) < version) ||
-                  ((extract_version(*it) == kVersionMax) &&
+        else if ((extract_table_id(*sig) == tableid) &&
+                 ((extract_version(*sig) < version) ||
+                  ((extract_version(*sig) == kVersionMax) &&
                    version < kVersionMax)))
         {
             // EIT updated version on current table
             verChgCnt++;
         }
-        else if (extract_endtime(*it) != endtime)
+        else if (extract_endtime(*sig) != endtime)
         {
             // Endtime (starttime + duration) changed
             endChgCnt++;
@@ -406,9 +771,14 @@ bool EITCache::IsNewEIT(uint chanid,  uint tableid,   uint version,
             hitCnt++;
             return false;
         }
-    }
 
-    eventMap->insert(eventid, construct_sig(tableid, version, endtime, true));
+        *sig = construct_sig(tableid, version, endtime, true);
+    }
+    else
+    {
+        eventMap.Insert(chanid, eventid,
+                        construct_sig(tableid, version, endtime, true));
+    }
     entryCnt++;
 
     return true;
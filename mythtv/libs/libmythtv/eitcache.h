@@ -12,12 +12,55 @@
 #include <QString>
 #include <QMutex>
 #include <QMap>
+#include <QVector>
 
 // MythTV headers
 #include "mythtvexp.h"
 
-typedef QMap<uint, uint64_t> event_map_t;
-typedef QMap<uint, event_map_t*> key_map_t;
+class QFile;
+
+/** \class EITCacheMap
+ *  \brief Open addressing hash table from (chanid, eventid) to the
+ *         signature of the event.
+ *
+ *  Uses linear probing and is kept at most half full. Slots with a
+ *  chanid of 0 are empty, so chanid 0 can not be stored.
+ */
+class MTV_PUBLIC EITCacheMap
+{
+  public:
+    struct Entry
+    {
+        uint32_t chanid;
+        uint32_t eventid;
+        uint64_t sig;
+    };
+
+    EITCacheMap() : m_count(0) {}
+
+    uint64_t *Find(uint chanid, uint eventid);
+    void      Insert(uint chanid, uint eventid, uint64_t sig);
+
+    /// Slots of the table, to walk all entries. An entry is removed by
+    /// setting its chanid to 0, followed by a call to Compact() before
+    /// the table is used again.
+    QVector<Entry> &Slots(void) { return m_slots; }
+    void Compact(void);
+    void Clear(void);
+
+    uint   Size(void) const { return m_count; }
+    uint   Capacity(void) const { return m_slots.size(); }
+    size_t MemoryUsage(void) const
+        { return m_slots.capacity() * sizeof(Entry); }
+
+  private:
+    void Resize(uint capacity);
+
+    QVector<Entry> m_slots;
+    uint           m_count;
+
+    static const uint kMinCapacity;
+};
 
 class EITCache
 {
@@ -35,15 +78,33 @@ class EITCache
     QString GetStatistics(void) const;
 
   private:
-    event_map_t * LoadChannel(uint chanid);
-    bool WriteChannelToDB(QStringList &value_clauses, uint chanid);
+    bool LoadChannel(uint chanid);
+    bool LoadChannelFromSnapshot(uint chanid);
+    void OpenSnapshot(void);
+    void CloseSnapshot(void);
+    void WriteSnapshot(void);
 
     // event key cache
-    key_map_t   channelMap;
+    EITCacheMap      eventMap;
+    QMap<uint, bool> channelMap;  ///< false if locked by another backend
+    QMap<uint, uint> syncTimes;   ///< when each channel was last written
 
     mutable QMutex eventMapLock;
     uint            lastPruneTime;
 
+    // snapshot of the cache from the last run
+    struct SnapshotChannel
+    {
+        uint32_t chanid;
+        uint32_t synctime;
+        uint32_t first;
+        uint32_t count;
+    };
+    bool                         snapshotOpened;
+    QFile                       *snapshotFile;
+    const uchar                 *snapshotData;
+    QMap<uint, SnapshotChannel>  snapshotIndex;
+
     // statistics
     uint        accessCnt;
     uint        hitCnt;
@@ -55,6 +116,8 @@ class EITCache
     uint        prunedHitCnt;
     uint        futureHitCnt;
     uint        wrongChannelHitCnt;
+    uint        snapshotChanCnt;
+    uint        dbChanCnt;
 
     static const uint kVersionMax;
 
@@ -45,6 +45,183 @@ const QString shortContext =
         QString("(?:^|\\.)(\\s*\\(*\\s*%1[\\s)]*(?:[).:]|$))").arg(shortEp);
 
 
+// Returns the index just past the character class starting at pos,
+// or -1 if it is not closed.
+static int skip_class(const QString &pattern, int pos)
+{
+    pos++;
+    if (pos < pattern.size() && pattern[pos] == '^')
+        pos++;
+    // a leading ']' is taken literally
+    if (pos < pattern.size() && pattern[pos] == ']')
+        pos++;
+    while (pos < pattern.size())
+    {
+        if (pattern[pos] == '\\')
+            pos += 2;
+        else if (pattern[pos] == ']')
+            return pos + 1;
+        else
+            pos++;
+    }
+    return -1;
+}
+
+// Returns the index just past the group starting at pos,
+// or -1 if it is not closed.
+static int skip_group(const QString &pattern, int pos)
+{
+    int depth = 0;
+    while (pos < pattern.size())
+    {
+        QChar c = pattern[pos];
+        if (c == '\\')
+        {
+            pos += 2;
+            continue;
+        }
+        if (c == '[')
+        {
+            pos = skip_class(pattern, pos);
+            if (pos < 0)
+                return -1;
+            continue;
+        }
+        if (c == '(')
+            depth++;
+        else if (c == ')' && --depth == 0)
+            return pos + 1;
+        pos++;
+    }
+    return -1;
+}
+
+static bool is_quantifier(QChar c)
+{
+    return c == '?' || c == '*' || c == '+' || c == '{';
+}
+
+EITRegExp::EITRegExp(const QString &pattern, Qt::CaseSensitivity cs)
+    : QRegExp(pattern, cs), m_literal(RequiredLiteral(pattern, cs))
+{
+}
+
+/** \fn EITRegExp::RequiredLiteral(const QString&, Qt::CaseSensitivity)
+ *  \brief Finds the longest literal string that every match of pattern
+ *         contains.
+ *
+ *  Only the top level of the pattern is looked at, groups and character
+ *  classes just end the current literal. Patterns with a top level
+ *  alternative have no required literal. When in doubt this returns a
+ *  shorter literal or none at all, never one a match could lack.
+ */
+QString EITRegExp::RequiredLiteral(const QString &pattern,
+                                   Qt::CaseSensitivity cs)
+{
+    QString best;
+    QString run;
+    int pos = 0;
+
+    while (pos < pattern.size())
+    {
+        QChar c = pattern[pos];
+        QChar literal;
+        int next = pos + 1;
+
+        if (c == '\\')
+        {
+            if (next >= pattern.size())
+                return QString();
+            QChar escaped = pattern[next++];
+            // escaped letters and digits are classes, assertions, back
+            // references or character codes
+            if (!escaped.isLetterOrNumber())
+                literal = escaped;
+        }
+        else if (c == '(')
+        {
+            next = skip_group(pattern, pos);
+            if (next < 0)
+                return QString();
+        }
+        else if (c == '[')
+        {
+            next = skip_class(pattern, pos);
+            if (next < 0)
+                return QString();
+        }
+        else if (c == '|' || c == ')' || is_quantifier(c))
+        {
+            return QString();
+        }
+        else if (c != '.' && c != '^' && c != '$')
+        {
+            literal = c;
+        }
+
+        // QRegExp compares lower case characters while QString::contains()
+        // folds case, they disagree on U+0130 which lowers to 'i'. Stick to
+        // the ASCII letters they agree on.
+        if (cs == Qt::CaseInsensitive &&
+            (literal.unicode() > 127 || literal.toLower() == 'i'))
+            literal = QChar();
+
+        bool optional = false;
+        bool repeated = false;
+        while (next < pattern.size() && is_quantifier(pattern[next]))
+        {
+            if (pattern[next] == '+' && !optional && !repeated)
+                repeated = true;
+            else
+                optional = true;
+            if (pattern[next] == '{')
+            {
+                next = pattern.indexOf('}', next);
+                if (next < 0)
+                    return QString();
+            }
+            next++;
+        }
+
+        if (!literal.isNull() && !optional)
+            run += literal;
+        if (literal.isNull() || optional || repeated)
+        {
+            if (run.size() > best.size())
+                best = run;
+            run.clear();
+        }
+        pos = next;
+    }
+
+    return run.size() > best.size() ? run : best;
+}
+
+// The QString operations the fixups use, skipping the regular expression
+// when the string lacks its literal.
+static inline int index_of(const QString &str, const EITRegExp &rx,
+                           int from = 0)
+{
+    return rx.CanMatch(str) ? str.indexOf(rx, from) : -1;
+}
+
+static inline bool contains_match(const QString &str, const EITRegExp &rx)
+{
+    return rx.CanMatch(str) && str.contains(rx);
+}
+
+static inline QString &remove_matches(QString &str, const EITRegExp &rx)
+{
+    return rx.CanMatch(str) ? str.remove(rx) : str;
+}
+
+static inline QString &replace_matches(QString &str, const EITRegExp &rx,
+                                       const QString &after)
+{
+    return rx.CanMatch(str) ? str.replace(rx, after) : str;
+}
+
+
 EITFixUp::EITFixUp()
     : m_bellYear("[\\(]{1}[0-9]{4}[\\)]{1}"),
       m_bellActors("\\set\\s|,"),
@@ -501,7 +678,7 @@ void EITFixUp::FixBellExpressVu(DBEventEIT &event) const
     }
 
     // See if a year is present as (xxxx)
-    position = event.description.indexOf(m_bellYear);
+    position = index_of(event.description, m_bellYear);
     if (position != -1 && !event.category.isEmpty())
     {
         tmp = "";
@@ -540,33 +717,33 @@ void EITFixUp::FixBellExpressVu(DBEventEIT &event) const
     }
 
     // Check for (Stereo) in the decription and set the <audio> tags
-    position = event.description.indexOf(m_Stereo);
+    position = index_of(event.description, m_Stereo);
     if (position != -1)
     {
         event.audioProps |= AUD_STEREO;
-        event.description = event.description.replace(m_Stereo, "");
+        event.description = replace_matches(event.description, m_Stereo, "");
     }
 
     // Check for "title (All Day, HD)" in the title
-    position = event.title.indexOf(m_bellPPVTitleAllDayHD);
+    position = index_of(event.title, m_bellPPVTitleAllDayHD);
     if (position != -1)
     {
-        event.title = event.title.replace(m_bellPPVTitleAllDayHD, "");
+        event.title = replace_matches(event.title, m_bellPPVTitleAllDayHD, "");
         event.videoProps |= VID_HDTV;
      }
 
     // Check for "title (All Day)" in the title
-    position = event.title.indexOf(m_bellPPVTitleAllDay);
+    position = index_of(event.title, m_bellPPVTitleAllDay);
     if (position != -1)
     {
-        event.title = event.title.replace(m_bellPPVTitleAllDay, "");
+        event.title = replace_matches(event.title, m_bellPPVTitleAllDay, "");
     }
 
     // Check for "HD - title" in the title
-    position = event.title.indexOf(m_bellPPVTitleHD);
+    position = index_of(event.title, m_bellPPVTitleHD);
     if (position != -1)
     {
-        event.title = event.title.replace(m_bellPPVTitleHD, "");
+        event.title = replace_matches(event.title, m_bellPPVTitleHD, "");
         event.videoProps |= VID_HDTV;
     }
 
@@ -587,10 +764,10 @@ void EITFixUp::FixBellExpressVu(DBEventEIT &event) const
     }
 
     // Check for HD at the end of the title
-    position = event.title.indexOf(m_dishPPVTitleHD);
+    position = index_of(event.title, m_dishPPVTitleHD);
     if (position != -1)
     {
-        event.title = event.title.replace(m_dishPPVTitleHD, "");
+        event.title = replace_matches(event.title, m_dishPPVTitleHD, "");
         event.videoProps |= VID_HDTV;
     }
 
@@ -612,50 +789,50 @@ void EITFixUp::FixBellExpressVu(DBEventEIT &event) const
     }
 
     // Remove any trailing colon in title
-    position = event.title.indexOf(m_dishPPVTitleColon);
+    position = index_of(event.title, m_dishPPVTitleColon);
     if (position != -1)
     {
-        event.title = event.title.replace(m_dishPPVTitleColon, "");
+        event.title = replace_matches(event.title, m_dishPPVTitleColon, "");
     }
 
     // Remove New at the end of the description
-    position = event.description.indexOf(m_dishDescriptionNew);
+    position = index_of(event.description, m_dishDescriptionNew);
     if (position != -1)
     {
         event.previouslyshown = false;
-        event.description = event.description.replace(m_dishDescriptionNew, "");
+        event.description = replace_matches(event.description, m_dishDescriptionNew, "");
     }
 
     // Remove Series Finale at the end of the desciption
-    position = event.description.indexOf(m_dishDescriptionFinale);
+    position = index_of(event.description, m_dishDescriptionFinale);
     if (position != -1)
     {
         event.previouslyshown = false;
-        event.description = event.description.replace(m_dishDescriptionFinale, "");
+        event.description = replace_matches(event.description, m_dishDescriptionFinale, "");
     }
 
     // Remove Series Finale at the end of the desciption
-    position = event.description.indexOf(m_dishDescriptionFinale2);
+    position = index_of(event.description, m_dishDescriptionFinale2);
     if (position != -1)
     {
         event.previouslyshown = false;
-        event.description = event.description.replace(m_dishDescriptionFinale2, "");
+        event.description = replace_matches(event.description, m_dishDescriptionFinale2, "");
     }
 
     // Remove Series Premiere at the end of the description
-    position = event.description.indexOf(m_dishDescriptionPremiere);
+    position = index_of(event.description, m_dishDescriptionPremiere);
     if (position != -1)
     {
         event.previouslyshown = false;
-        event.description = event.description.replace(m_dishDescriptionPremiere, "");
+        event.description = replace_matches(event.description, m_dishDescriptionPremiere, "");
     }
 
     // Remove Series Premiere at the end of the description
-    position = event.description.indexOf(m_dishDescriptionPremiere2);
+    position = index_of(event.description, m_dishDescriptionPremiere2);
     if (position != -1)
     {
         event.previouslyshown = false;
-        event.description = event.description.replace(m_dishDescriptionPremiere2, "");
+        event.description = replace_matches(event.description, m_dishDescriptionPremiere2, "");
     }
 
     // Remove Dish's PPV code at the end of the description
@@ -668,38 +845,38 @@ void EITFixUp::FixBellExpressVu(DBEventEIT &event) const
     }
 
     // Remove trailing garbage
-    position = event.description.indexOf(m_dishPPVSpacePerenEnd);
+    position = index_of(event.description, m_dishPPVSpacePerenEnd);
     if (position != -1)
     {
-        event.description = event.description.replace(m_dishPPVSpacePerenEnd, "");
+        event.description = replace_matches(event.description, m_dishPPVSpacePerenEnd, "");
     }
 
     // Check for subtitle "All Day (... Eastern)" in the subtitle
-    position = event.subtitle.indexOf(m_bellPPVSubtitleAllDay);
+    position = index_of(event.subtitle, m_bellPPVSubtitleAllDay);
     if (position != -1)
     {
-        event.subtitle = event.subtitle.replace(m_bellPPVSubtitleAllDay, "");
+        event.subtitle = replace_matches(event.subtitle, m_bellPPVSubtitleAllDay, "");
     }
 
     // Check for description "(... Eastern)" in the description
-    position = event.description.indexOf(m_bellPPVDescriptionAllDay);
+    position = index_of(event.description, m_bellPPVDescriptionAllDay);
     if (position != -1)
     {
-        event.description = event.description.replace(m_bellPPVDescriptionAllDay, "");
+        event.description = replace_matches(event.description, m_bellPPVDescriptionAllDay, "");
     }
 
     // Check for description "(... ET)" in the description
-    position = event.description.indexOf(m_bellPPVDescriptionAllDay2);
+    position = index_of(event.description, m_bellPPVDescriptionAllDay2);
     if (position != -1)
     {
-        event.description = event.description.replace(m_bellPPVDescriptionAllDay2, "");
+        event.description = replace_matches(event.description, m_bellPPVDescriptionAllDay2, "");
     }
 
     // Check for description "(nnnnn)" in the description
-    position = event.description.indexOf(m_bellPPVDescriptionEventId);
+    position = index_of(event.description, m_bellPPVDescriptionEventId);
     if (position != -1)
     {
-        event.description = event.description.replace(m_bellPPVDescriptionEventId, "");
+        event.description = replace_matches(event.description, m_bellPPVDescriptionEventId, "");
     }
 
 }
@@ -774,11 +951,11 @@ void EITFixUp::SetUKSubtitle(DBEventEIT &event) const
              fColon = true;
          }
     }
-    QRegExp tmpQuotedSubtitle = m_ukQuotedSubtitle;
-    if (tmpQuotedSubtitle.indexIn(event.description) != -1)
+    EITRegExp tmpQuotedSubtitle = m_ukQuotedSubtitle;
+    if (tmpQuotedSubtitle.IndexIn(event.description) != -1)
     {
         event.subtitle = tmpQuotedSubtitle.cap(1);
-        event.description.remove(m_ukQuotedSubtitle);
+        remove_matches(event.description, m_ukQuotedSubtitle);
         fQuotedSubtitle = true;
     }
     QStringList strListPeriod;
@@ -824,10 +1001,10 @@ void EITFixUp::SetUKSubtitle(DBEventEIT &event) const
         if (strListSpace.filter(m_ukExclusionFromSubtitle).empty())
         {
              event.subtitle = strListEnd[0]+strEnd;
-             event.subtitle.remove(m_ukSpaceColonStart);
+             remove_matches(event.subtitle, m_ukSpaceColonStart);
              event.description=
                           event.description.mid(strListEnd[0].length()+1);
-             event.description.remove(m_ukSpaceColonStart);
+             remove_matches(event.description, m_ukSpaceColonStart);
         }
     }
 }
@@ -845,31 +1022,31 @@ void EITFixUp::FixUK(DBEventEIT &event) const
     bool isMovie = event.category.startsWith("Movie",Qt::CaseInsensitive) ||
                    event.category.startsWith("Film",Qt::CaseInsensitive);
     // BBC three case (could add another record here ?)
-    event.description = event.description.remove(m_ukThen);
-    event.description = event.description.remove(m_ukNew);
-    event.title = event.title.remove(m_ukNewTitle);
+    event.description = remove_matches(event.description, m_ukThen);
+    event.description = remove_matches(event.description, m_ukNew);
+    event.title = remove_matches(event.title, m_ukNewTitle);
 
     // Removal of Class TV, CBBC and CBeebies etc..
-    event.title = event.title.remove(m_ukTitleRemove);
-    event.description = event.description.remove(m_ukDescriptionRemove);
+    event.title = remove_matches(event.title, m_ukTitleRemove);
+    event.description = remove_matches(event.description, m_ukDescriptionRemove);
 
     // Removal of BBC FOUR and BBC THREE
-    event.description = event.description.remove(m_ukBBC34);
+    event.description = remove_matches(event.description, m_ukBBC34);
 
     // BBC 7 [Rpt of ...] case.
-    event.description = event.description.remove(m_ukBBC7rpt);
+    event.description = remove_matches(event.description, m_ukBBC7rpt);
 
     // "All New To 4Music!
-    event.description = event.description.remove(m_ukAllNew);
+    event.description = remove_matches(event.description, m_ukAllNew);
 
     // Removal of 'Also in HD' text
- 	event.description = event.description.remove(m_ukAlsoInHD);
+ 	event.description = remove_matches(event.description, m_ukAlsoInHD);
 
     // Remove [AD,S] etc.
     bool    ccMatched = false;
-    QRegExp tmpCC = m_ukCC;
+    EITRegExp tmpCC = m_ukCC;
     position1 = 0;
-    while ((position1 = tmpCC.indexIn(event.description, position1)) != -1)
+    while ((position1 = tmpCC.IndexIn(event.description, position1)) != -1)
     {
         ccMatched = true;
         position1 += tmpCC.matchedLength();
@@ -888,7 +1065,7 @@ void EITFixUp::FixUK(DBEventEIT &event) const
     }
 
     if(ccMatched)
-        event.description = event.description.remove(m_ukCC);
+        event.description = remove_matches(event.description, m_ukCC);
 
     event.title       = event.title.trimmed();
     event.description = event.description.trimmed();
@@ -896,9 +1073,9 @@ void EITFixUp::FixUK(DBEventEIT &event) const
     // Work out the season and episode numbers (if any)
     // Matching pattern "Season 2 Episode|Ep 3 of 14|3/14" etc
     bool    series  = false;
-    QRegExp tmpSeries = m_ukSeries;
-    if ((position1 = tmpSeries.indexIn(event.title)) != -1
-            || (position2 = tmpSeries.indexIn(event.description)) != -1)
+    EITRegExp tmpSeries = m_ukSeries;
+    if ((position1 = tmpSeries.IndexIn(event.title)) != -1
+            || (position2 = tmpSeries.IndexIn(event.description)) != -1)
     {
         if (!tmpSeries.cap(1).isEmpty())
         {
@@ -959,8 +1136,8 @@ void EITFixUp::FixUK(DBEventEIT &event) const
 
     // Multi-part episodes, or films (e.g. ITV film split by news)
     // Matches Part 1, Pt 1/2, Part 1 of 2 etc.
-    QRegExp tmpPart = m_ukPart;
-    if ((position1 = tmpPart.indexIn(event.title)) != -1)
+    EITRegExp tmpPart = m_ukPart;
+    if ((position1 = tmpPart.IndexIn(event.title)) != -1)
     {
         event.partnumber = tmpPart.cap(1).toUInt();
         event.parttotal  = tmpPart.cap(2).toUInt();
@@ -971,7 +1148,7 @@ void EITFixUp::FixUK(DBEventEIT &event) const
         // Remove from the title
         event.title = event.title.remove(tmpPart.cap(0));
     }
-    else if ((position1 = tmpPart.indexIn(event.description)) != -1)
+    else if ((position1 = tmpPart.IndexIn(event.description)) != -1)
     {
         event.partnumber = tmpPart.cap(1).toUInt();
         event.parttotal  = tmpPart.cap(2).toUInt();
@@ -990,8 +1167,8 @@ void EITFixUp::FixUK(DBEventEIT &event) const
         }
     }
 
-    QRegExp tmpStarring = m_ukStarring;
-    if (tmpStarring.indexIn(event.description) != -1)
+    EITRegExp tmpStarring = m_ukStarring;
+    if (tmpStarring.IndexIn(event.description) != -1)
     {
         // if we match this we've captured 2 actors and an (optional) airdate
         event.AddPerson(DBPerson::kActor, tmpStarring.cap(1));
@@ -1008,37 +1185,37 @@ void EITFixUp::FixUK(DBEventEIT &event) const
         }
     }
 
-    QRegExp tmp24ep = m_uk24ep;
+    EITRegExp tmp24ep = m_uk24ep;
     if (!event.title.startsWith("CSI:") && !event.title.startsWith("CD:") &&
-        !event.title.contains(m_ukLaONoSplit) &&
+        !contains_match(event.title, m_ukLaONoSplit) &&
         !event.title.startsWith("Mission: Impossible"))
     {
-        if (((position1=event.title.indexOf(m_ukDoubleDotEnd)) != -1) &&
-            ((position2=event.description.indexOf(m_ukDoubleDotStart)) != -1))
+        if (((position1=index_of(event.title, m_ukDoubleDotEnd)) != -1) &&
+            ((position2=index_of(event.description, m_ukDoubleDotStart)) != -1))
         {
-            QString strPart=event.title.remove(m_ukDoubleDotEnd)+" ";
-            strFull = strPart + event.description.remove(m_ukDoubleDotStart);
+            QString strPart=remove_matches(event.title, m_ukDoubleDotEnd)+" ";
+            strFull = strPart + remove_matches(event.description, m_ukDoubleDotStart);
             if (isMovie &&
-                ((position1 = strFull.indexOf(m_ukCEPQ,strPart.length())) != -1))
+                ((position1 = index_of(strFull, m_ukCEPQ, strPart.length())) != -1))
             {
                  if (strFull[position1] == '!' || strFull[position1] == '?'
                   || (position1>2 && strFull[position1] == '.' && strFull[position1-2] == '.'))
                      position1++;
                  event.title = strFull.left(position1);
                  event.description = strFull.mid(position1 + 1);
-                 event.description.remove(m_ukSpaceStart);
+                 remove_matches(event.description, m_ukSpaceStart);
             }
-            else if ((position1 = strFull.indexOf(m_ukCEPQ)) != -1)
+            else if ((position1 = index_of(strFull, m_ukCEPQ)) != -1)
             {
                  if (strFull[position1] == '!' || strFull[position1] == '?'
                   || (position1>2 && strFull[position1] == '.' && strFull[position1-2] == '.'))
                      position1++;
                  event.title = strFull.left(position1);
                  event.description = strFull.mid(position1 + 1);
-                 event.description.remove(m_ukSpaceStart);
+                 remove_matches(event.description, m_ukSpaceStart);
                  SetUKSubtitle(event);
             }
-            if ((position1 = strFull.indexOf(m_ukYear)) != -1)
+            if ((position1 = index_of(strFull, m_ukYear)) != -1)
             {
                 // Looks like they are using the airdate as a delimiter
                 if ((uint)position1 < SUBTITLE_MAX_LEN)
@@ -1048,7 +1225,7 @@ void EITFixUp::FixUK(DBEventEIT &event) const
                 }
             }
         }
-        else if ((position1 = tmp24ep.indexIn(event.description)) != -1)
+        else if ((position1 = tmp24ep.IndexIn(event.description)) != -1)
         {
             // Special case for episodes of 24.
             // -2 from the length cause we don't want ": " on the end
@@ -1056,14 +1233,14 @@ void EITFixUp::FixUK(DBEventEIT &event) const
                                 tmp24ep.cap(0).length() - 2);
             event.description = event.description.remove(tmp24ep.cap(0));
         }
-        else if ((position1 = event.description.indexOf(m_ukTime)) == -1)
+        else if ((position1 = index_of(event.description, m_ukTime)) == -1)
         {
-            if (!isMovie && (event.title.indexOf(m_ukYearColon) < 0))
+            if (!isMovie && (index_of(event.title, m_ukYearColon) < 0))
             {
                 if (((position1 = event.title.indexOf(":")) != -1) &&
                     (event.description.indexOf(":") < 0 ))
                 {
-                    if (event.title.mid(position1+1).indexOf(m_ukCompleteDots)==0)
+                    if (index_of(event.title.mid(position1+1), m_ukCompleteDots)==0)
                     {
                         SetUKSubtitle(event);
                         QString strTmp = event.title.mid(position1+1);
@@ -1085,9 +1262,9 @@ void EITFixUp::FixUK(DBEventEIT &event) const
     if (!isMovie && event.subtitle.isEmpty() &&
         !event.title.startsWith("The X-Files"))
     {
-        if ((position1=event.description.indexOf(m_ukTime)) != -1)
+        if ((position1=index_of(event.description, m_ukTime)) != -1)
         {
-            position2 = event.description.indexOf(m_ukColonPeriod);
+            position2 = index_of(event.description, m_ukColonPeriod);
             if ((position2>=0) && (position2 < (position1-2)))
                 SetUKSubtitle(event);
         }
@@ -1096,7 +1273,7 @@ void EITFixUp::FixUK(DBEventEIT &event) const
             if ((uint)position1 < SUBTITLE_MAX_LEN)
             {
                 event.subtitle = event.title.mid(position1 + 1);
-                event.subtitle.remove(m_ukSpaceColonStart);
+                remove_matches(event.subtitle, m_ukSpaceColonStart);
                 event.title = event.title.left(position1);
             }
         }
@@ -1105,8 +1282,8 @@ void EITFixUp::FixUK(DBEventEIT &event) const
     }
 
     // Work out the year (if any)
-    QRegExp tmpUKYear = m_ukYear;
-    if ((position1 = tmpUKYear.indexIn(event.description)) != -1)
+    EITRegExp tmpUKYear = m_ukYear;
+    if ((position1 = tmpUKYear.IndexIn(event.description)) != -1)
     {
         QString stmp = event.description;
         int     itmp = position1 + tmpUKYear.cap(0).length();
@@ -1121,9 +1298,9 @@ void EITFixUp::FixUK(DBEventEIT &event) const
     }
 
     // Trim leading/trailing '.'
-    event.subtitle.remove(m_ukDotSpaceStart);
+    remove_matches(event.subtitle, m_ukDotSpaceStart);
     if (event.subtitle.lastIndexOf("..") != (((int)event.subtitle.length())-2))
-        event.subtitle.remove(m_ukDotEnd);
+        remove_matches(event.subtitle, m_ukDotEnd);
 
     // Reverse the subtitle and empty description
     if (event.description.isEmpty() && !event.subtitle.isEmpty())
@@ -1166,15 +1343,15 @@ void EITFixUp::FixComHem(DBEventEIT &event, bool process_subtitle) const
     bool isSeries = false;
     // Try to find episode numbers
     int pos;
-    QRegExp tmpSeries1 = m_comHemSeries1;
-    QRegExp tmpSeries2 = m_comHemSeries2;
-    if ((pos = tmpSeries2.indexIn(event.title)) != -1)
+    EITRegExp tmpSeries1 = m_comHemSeries1;
+    EITRegExp tmpSeries2 = m_comHemSeries2;
+    if ((pos = tmpSeries2.IndexIn(event.title)) != -1)
     {
         QStringList list = tmpSeries2.capturedTexts();
         event.partnumber = list[2].toUInt();
         event.title = event.title.replace(list[0],"");
     }
-    else if ((pos = tmpSeries1.indexIn(event.description)) != -1)
+    else if ((pos = tmpSeries1.IndexIn(event.description)) != -1)
     {
         QStringList list = tmpSeries1.capturedTexts();
         if (!list[1].isEmpty())
@@ -1205,8 +1382,8 @@ void EITFixUp::FixComHem(DBEventEIT &event, bool process_subtitle) const
     }
 
     // Move subtitle info from title to subtitle
-    QRegExp tmpTSub = m_comHemTSub;
-    if (tmpTSub.indexIn(event.title) != -1)
+    EITRegExp tmpTSub = m_comHemTSub;
+    if (tmpTSub.IndexIn(event.title) != -1)
     {
         event.subtitle = tmpTSub.cap(1);
         event.title = event.title.replace(tmpTSub.cap(0),"");
@@ -1218,8 +1395,8 @@ void EITFixUp::FixComHem(DBEventEIT &event, bool process_subtitle) const
 
     // Try to find country category, year and possibly other information
     // from the begining of the description
-    QRegExp tmpCountry = m_comHemCountry;
-    pos = tmpCountry.indexIn(event.description);
+    EITRegExp tmpCountry = m_comHemCountry;
+    pos = tmpCountry.IndexIn(event.description);
     if (pos != -1)
     {
         QStringList list = tmpCountry.capturedTexts();
@@ -1284,24 +1461,24 @@ void EITFixUp::FixComHem(DBEventEIT &event, bool process_subtitle) const
         event.categoryType = ProgramInfo::kCategorySeries;
 
     // Look for additional persons in the description
-    QRegExp tmpPersons = m_comHemPersons;
-    while(pos = tmpPersons.indexIn(event.description),pos!=-1)
+    EITRegExp tmpPersons = m_comHemPersons;
+    while(pos = tmpPersons.IndexIn(event.description),pos!=-1)
     {
         DBPerson::Role role;
         QStringList list = tmpPersons.capturedTexts();
 
-        QRegExp tmpDirector = m_comHemDirector;
-        QRegExp tmpActor = m_comHemActor;
-        QRegExp tmpHost = m_comHemHost;
-        if (tmpDirector.indexIn(list[1])!=-1)
+        EITRegExp tmpDirector = m_comHemDirector;
+        EITRegExp tmpActor = m_comHemActor;
+        EITRegExp tmpHost = m_comHemHost;
+        if (tmpDirector.IndexIn(list[1])!=-1)
         {
             role = DBPerson::kDirector;
         }
-        else if(tmpActor.indexIn(list[1])!=-1)
+        else if(tmpActor.IndexIn(list[1])!=-1)
         {
             role = DBPerson::kActor;
         }
-        else if(tmpHost.indexIn(list[1])!=-1)
+        else if(tmpHost.IndexIn(list[1])!=-1)
         {
             role = DBPerson::kHost;
         }
@@ -1327,7 +1504,7 @@ void EITFixUp::FixComHem(DBEventEIT &event, bool process_subtitle) const
     // shorter than 55 characters or we risk picking up the wrong thing.
     if (process_subtitle)
     {
-        int pos = event.description.indexOf(m_comHemSub);
+        int pos = index_of(event.description, m_comHemSub);
         bool pvalid = pos != -1 && pos <= 55;
         if (pvalid && (event.description.length() - (pos + 2)) > 0)
         {
@@ -1338,15 +1515,15 @@ void EITFixUp::FixComHem(DBEventEIT &event, bool process_subtitle) const
     }
 
     // Teletext subtitles?
-    int position = event.description.indexOf(m_comHemTT);
+    int position = index_of(event.description, m_comHemTT);
     if (position != -1)
     {
         event.subtitleType |= SUB_NORMAL;
     }
 
     // Try to findout if this is a rerun and if so the date.
-    QRegExp tmpRerun1 = m_comHemRerun1;
-    if (tmpRerun1.indexIn(event.description) == -1)
+    EITRegExp tmpRerun1 = m_comHemRerun1;
+    if (tmpRerun1.IndexIn(event.description) == -1)
         return;
 
     // Rerun from today
@@ -1365,8 +1542,8 @@ void EITFixUp::FixComHem(DBEventEIT &event, bool process_subtitle) const
     }
 
     // Rerun with day, month and possibly year specified
-    QRegExp tmpRerun2 = m_comHemRerun2;
-    if (tmpRerun2.indexIn(list[1]) != -1)
+    EITRegExp tmpRerun2 = m_comHemRerun2;
+    if (tmpRerun2.IndexIn(list[1]) != -1)
     {
         QStringList datelist = tmpRerun2.capturedTexts();
         int day   = datelist[1].toInt();
@@ -1603,23 +1780,23 @@ void EITFixUp::FixMCA(DBEventEIT &event) const
     }
 
     // Close captioned?
-    position = event.description.indexOf(m_mcaCC);
+    position = index_of(event.description, m_mcaCC);
     if (position > 0)
     {
         event.subtitleType |= SUB_HARDHEAR;
-        event.description.replace(m_mcaCC, "");
+        replace_matches(event.description, m_mcaCC, "");
     }
 
     // Dolby Digital 5.1?
-    position = event.description.indexOf(m_mcaDD);
+    position = index_of(event.description, m_mcaDD);
     if ((position > 0) && (position > (int) (event.description.length() - 7)))
     {
         event.audioProps |= AUD_DOLBY;
-        event.description.replace(m_mcaDD, "");
+        replace_matches(event.description, m_mcaDD, "");
     }
 
     // Remove bouquet tags
-    event.description.replace(m_mcaAvail, "");
+    replace_matches(event.description, m_mcaAvail, "");
 
     // Try to find year and director from the end of the description
     bool isMovie = false;
@@ -1681,27 +1858,27 @@ void EITFixUp::FixRTL(DBEventEIT &event) const
         return;
 
     // Repeat
-    QRegExp tmpExpRepeat = m_RTLrepeat;
-    if ((pos = tmpExpRepeat.indexIn(event.description)) != -1)
+    EITRegExp tmpExpRepeat = m_RTLrepeat;
+    if ((pos = tmpExpRepeat.IndexIn(event.description)) != -1)
     {
         // remove '.' if it matches at the beginning of the description
         int length = tmpExpRepeat.cap(0).length() + (pos ? 0 : 1);
         event.description = event.description.remove(pos, length).trimmed();
     }
 
-    QRegExp tmpExp1 = m_RTLSubtitle;
-    QRegExp tmpExpSubtitle1 = m_RTLSubtitle1;
+    EITRegExp tmpExp1 = m_RTLSubtitle;
+    EITRegExp tmpExpSubtitle1 = m_RTLSubtitle1;
     tmpExpSubtitle1.setMinimal(true);
-    QRegExp tmpExpSubtitle2 = m_RTLSubtitle2;
-    QRegExp tmpExpSubtitle3 = m_RTLSubtitle3;
-    QRegExp tmpExpSubtitle4 = m_RTLSubtitle4;
-    QRegExp tmpExpSubtitle5 = m_RTLSubtitle5;
+    EITRegExp tmpExpSubtitle2 = m_RTLSubtitle2;
+    EITRegExp tmpExpSubtitle3 = m_RTLSubtitle3;
+    EITRegExp tmpExpSubtitle4 = m_RTLSubtitle4;
+    EITRegExp tmpExpSubtitle5 = m_RTLSubtitle5;
     tmpExpSubtitle5.setMinimal(true);
-    QRegExp tmpExpEpisodeNo1 = m_RTLEpisodeNo1;
-    QRegExp tmpExpEpisodeNo2 = m_RTLEpisodeNo2;
+    EITRegExp tmpExpEpisodeNo1 = m_RTLEpisodeNo1;
+    EITRegExp tmpExpEpisodeNo2 = m_RTLEpisodeNo2;
 
     // subtitle with episode number: "Folge *: 'subtitle'. description
-    if (tmpExpSubtitle1.indexIn(event.description) != -1)
+    if (tmpExpSubtitle1.IndexIn(event.description) != -1)
     {
         event.syndicatedepisodenumber = tmpExpSubtitle1.cap(1);
         event.subtitle    = tmpExpSubtitle1.cap(2);
@@ -1709,7 +1886,7 @@ void EITFixUp::FixRTL(DBEventEIT &event) const
             event.description.remove(0, tmpExpSubtitle1.matchedLength());
     }
     // episode number subtitle
-    else if (tmpExpSubtitle2.indexIn(event.description) != -1)
+    else if (tmpExpSubtitle2.IndexIn(event.description) != -1)
     {
         event.syndicatedepisodenumber = tmpExpSubtitle2.cap(1);
         event.subtitle    = tmpExpSubtitle2.cap(2);
@@ -1717,7 +1894,7 @@ void EITFixUp::FixRTL(DBEventEIT &event) const
             event.description.remove(0, tmpExpSubtitle2.matchedLength());
     }
     // episode number subtitle
-    else if (tmpExpSubtitle3.indexIn(event.description) != -1)
+    else if (tmpExpSubtitle3.IndexIn(event.description) != -1)
     {
         event.syndicatedepisodenumber = tmpExpSubtitle3.cap(1);
         event.subtitle    = tmpExpSubtitle3.cap(2);
@@ -1725,21 +1902,21 @@ void EITFixUp::FixRTL(DBEventEIT &event) const
             event.description.remove(0, tmpExpSubtitle3.matchedLength());
     }
     // "Thema..."
-    else if (tmpExpSubtitle4.indexIn(event.description) != -1)
+    else if (tmpExpSubtitle4.IndexIn(event.description) != -1)
     {
         event.subtitle    = tmpExpSubtitle4.cap(1);
         event.description =
             event.description.remove(0, tmpExpSubtitle4.matchedLength());
     }
     // "'...'"
-    else if (tmpExpSubtitle5.indexIn(event.description) != -1)
+    else if (tmpExpSubtitle5.IndexIn(event.description) != -1)
     {
         event.subtitle    = tmpExpSubtitle5.cap(1);
         event.description =
             event.description.remove(0, tmpExpSubtitle5.matchedLength());
     }
     // episode number
-    else if (tmpExpEpisodeNo1.indexIn(event.description) != -1)
+    else if (tmpExpEpisodeNo1.IndexIn(event.description) != -1)
     {
         event.syndicatedepisodenumber = tmpExpEpisodeNo1.cap(2);
         event.subtitle    = tmpExpEpisodeNo1.cap(1);
@@ -1747,7 +1924,7 @@ void EITFixUp::FixRTL(DBEventEIT &event) const
             event.description.remove(0, tmpExpEpisodeNo1.matchedLength());
     }
     // episode number
-    else if (tmpExpEpisodeNo2.indexIn(event.description) != -1)
+    else if (tmpExpEpisodeNo2.IndexIn(event.description) != -1)
     {
         event.syndicatedepisodenumber = tmpExpEpisodeNo2.cap(2);
         event.subtitle    = tmpExpEpisodeNo2.cap(1);
@@ -1767,7 +1944,7 @@ void EITFixUp::FixRTL(DBEventEIT &event) const
         const uint SUBTITLE_PCT = 35; // % of description to allow subtitle up to
         const uint SUBTITLE_MAX_LEN = 50; // max length of subtitle field in db
 
-        if (tmpExp1.indexIn(event.description) != -1)
+        if (tmpExp1.IndexIn(event.description) != -1)
         {
             uint tmpExp1Len = tmpExp1.cap(1).length();
             uint evDescLen = max(event.description.length(), 1);
@@ -1894,7 +2071,7 @@ void EITFixUp::FixDisneyChannel(DBEventEIT &event) const
 **/
 void EITFixUp::FixATV(DBEventEIT &event) const
 {
-    event.subtitle.replace(m_ATVSubtitle, "");
+    replace_matches(event.subtitle, m_ATVSubtitle, "");
 }
 
 
@@ -1903,26 +2080,26 @@ void EITFixUp::FixATV(DBEventEIT &event) const
  */
 void EITFixUp::FixFI(DBEventEIT &event) const
 {
-    int position = event.description.indexOf(m_fiRerun);
+    int position = index_of(event.description, m_fiRerun);
     if (position != -1)
     {
         event.previouslyshown = true;
-        event.description = event.description.replace(m_fiRerun, "");
+        event.description = replace_matches(event.description, m_fiRerun, "");
     }
 
-    position = event.description.indexOf(m_fiRerun2);
+    position = index_of(event.description, m_fiRerun2);
     if (position != -1)
     {
         event.previouslyshown = true;
-        event.description = event.description.replace(m_fiRerun2, "");
+        event.description = replace_matches(event.description, m_fiRerun2, "");
     }
 
     // Check for (Stereo) in the decription and set the <audio> tags
-    position = event.description.indexOf(m_Stereo);
+    position = index_of(event.description, m_Stereo);
     if (position != -1)
     {
         event.audioProps |= AUD_STEREO;
-        event.description = event.description.replace(m_Stereo, "");
+        event.description = replace_matches(event.description, m_Stereo, "");
     }
 }
 
@@ -1965,8 +2142,8 @@ void EITFixUp::FixPremiere(DBEventEIT &event) const
     event.description = event.description.replace("\u000A", " ");
 
     // move the original titel from the title to subtitle
-    QRegExp tmpOTitle = m_dePremiereOTitle;
-    if (tmpOTitle.indexIn(event.title) != -1)
+    EITRegExp tmpOTitle = m_dePremiereOTitle;
+    if (tmpOTitle.IndexIn(event.title) != -1)
     {
         event.subtitle = QString("%1, %2").arg(tmpOTitle.cap(1)).arg(country);
         event.title = event.title.replace(tmpOTitle, "");
@@ -2083,42 +2260,42 @@ void EITFixUp::FixNL(DBEventEIT &event) const
     }
 
     // Get stereo info
-    if (fullinfo.indexOf(m_Stereo) != -1)
+    if (index_of(fullinfo, m_Stereo) != -1)
     {
         event.audioProps |= AUD_STEREO;
-        fullinfo = fullinfo.replace(m_Stereo, ".");
+        fullinfo = replace_matches(fullinfo, m_Stereo, ".");
     }
 
     //Get widescreen info
-    if (fullinfo.indexOf(m_nlWide) != -1)
+    if (index_of(fullinfo, m_nlWide) != -1)
     {
         fullinfo = fullinfo.replace("breedbeeld", ".");
     }
 
     // Get repeat info
-    if (fullinfo.indexOf(m_nlRepeat) != -1)
+    if (index_of(fullinfo, m_nlRepeat) != -1)
     {
         fullinfo = fullinfo.replace("herh.", ".");
     }
 
     // Get teletext subtitle info
-    if (fullinfo.indexOf(m_nlTxt) != -1)
+    if (index_of(fullinfo, m_nlTxt) != -1)
     {
         event.subtitleType |= SUB_NORMAL;
         fullinfo = fullinfo.replace("txt", ".");
     }
 
     // Get HDTV information
-    if (event.title.indexOf(m_nlHD) != -1)
+    if (index_of(event.title, m_nlHD) != -1)
     {
         event.videoProps |= VID_HDTV;
-        event.title = event.title.replace(m_nlHD, "");
+        event.title = replace_matches(event.title, m_nlHD, "");
     }
 
     // Try to make subtitle from Afl.:
-    QRegExp tmpSub = m_nlSub;
+    EITRegExp tmpSub = m_nlSub;
     QString tmpSubString;
-    if (tmpSub.indexIn(fullinfo) != -1)
+    if (tmpSub.IndexIn(fullinfo) != -1)
     {
         tmpSubString = tmpSub.cap(0);
         tmpSubString = tmpSubString.right(tmpSubString.length() - 7);
@@ -2127,9 +2304,9 @@ void EITFixUp::FixNL(DBEventEIT &event) const
     }
 
     // Try to make subtitle from " "
-    QRegExp tmpSub2 = m_nlSub2;
+    EITRegExp tmpSub2 = m_nlSub2;
     //QString tmpSubString2;
-    if (tmpSub2.indexIn(fullinfo) != -1)
+    if (tmpSub2.IndexIn(fullinfo) != -1)
     {
         tmpSubString = tmpSub2.cap(0);
         tmpSubString = tmpSubString.right(tmpSubString.length() - 2);
@@ -2151,8 +2328,8 @@ void EITFixUp::FixNL(DBEventEIT &event) const
 
 
     // Get the actors
-    QRegExp tmpActors = m_nlActors;
-    if (tmpActors.indexIn(fullinfo) != -1)
+    EITRegExp tmpActors = m_nlActors;
+    if (tmpActors.IndexIn(fullinfo) != -1)
     {
         QString tmpActorsString = tmpActors.cap(0);
         tmpActorsString = tmpActorsString.right(tmpActorsString.length() - 6);
@@ -2166,8 +2343,8 @@ void EITFixUp::FixNL(DBEventEIT &event) const
     }
 
     // Try to find presenter
-    QRegExp tmpPres = m_nlPres;
-    if (tmpPres.indexIn(fullinfo) != -1)
+    EITRegExp tmpPres = m_nlPres;
+    if (tmpPres.IndexIn(fullinfo) != -1)
     {
         QString tmpPresString = tmpPres.cap(0);
         tmpPresString = tmpPresString.right(tmpPresString.length() - 14);
@@ -2181,9 +2358,9 @@ void EITFixUp::FixNL(DBEventEIT &event) const
     }
 
     // Try to find year
-    QRegExp tmpYear1 = m_nlYear1;
-    QRegExp tmpYear2 = m_nlYear2;
-    if (tmpYear1.indexIn(fullinfo) != -1)
+    EITRegExp tmpYear1 = m_nlYear1;
+    EITRegExp tmpYear2 = m_nlYear2;
+    if (tmpYear1.IndexIn(fullinfo) != -1)
     {
         bool ok;
         uint y = tmpYear1.cap(0).toUInt(&ok);
@@ -2191,7 +2368,7 @@ void EITFixUp::FixNL(DBEventEIT &event) const
             event.originalairdate = QDate(y, 1, 1);
     }
 
-    if (tmpYear2.indexIn(fullinfo) != -1)
+    if (tmpYear2.IndexIn(fullinfo) != -1)
     {
         bool ok;
         uint y = tmpYear2.cap(2).toUInt(&ok);
@@ -2200,30 +2377,30 @@ void EITFixUp::FixNL(DBEventEIT &event) const
     }
 
     // Try to find director
-    QRegExp tmpDirector = m_nlDirector;
+    EITRegExp tmpDirector = m_nlDirector;
     QString tmpDirectorString;
-    if (fullinfo.indexOf(m_nlDirector) != -1)
+    if (index_of(fullinfo, m_nlDirector) != -1)
     {
         tmpDirectorString = tmpDirector.cap(0);
         event.AddPerson(DBPerson::kDirector, tmpDirectorString);
     }
 
     // Strip leftovers
-    if (fullinfo.indexOf(m_nlRub) != -1)
+    if (index_of(fullinfo, m_nlRub) != -1)
     {
-        fullinfo = fullinfo.replace(m_nlRub, "");
+        fullinfo = replace_matches(fullinfo, m_nlRub, "");
     }
 
     // Strip category info from description
-    if (fullinfo.indexOf(m_nlCat) != -1)
+    if (index_of(fullinfo, m_nlCat) != -1)
     {
-        fullinfo = fullinfo.replace(m_nlCat, "");
+        fullinfo = replace_matches(fullinfo, m_nlCat, "");
     }
 
     // Remove omroep from title
-    if (event.title.indexOf(m_nlOmroep) != -1)
+    if (index_of(event.title, m_nlOmroep) != -1)
     {
-        event.title = event.title.replace(m_nlOmroep, "");
+        event.title = replace_matches(event.title, m_nlOmroep, "");
     }
 
     // Put information back in description
@@ -2252,25 +2429,25 @@ void EITFixUp::FixCategory(DBEventEIT &event) const
 void EITFixUp::FixNO(DBEventEIT &event) const
 {
     // Check for "title (R)" in the title
-    int position = event.title.indexOf(m_noRerun);
+    int position = index_of(event.title, m_noRerun);
     if (position != -1)
     {
       event.previouslyshown = true;
-      event.title = event.title.replace(m_noRerun, "");
+      event.title = replace_matches(event.title, m_noRerun, "");
     }
     // Check for "subtitle (HD)" in the subtitle
-    position = event.subtitle.indexOf(m_noHD);
+    position = index_of(event.subtitle, m_noHD);
     if (position != -1)
     {
       event.videoProps |= VID_HDTV;
-      event.subtitle = event.subtitle.replace(m_noHD, "");
+      event.subtitle = replace_matches(event.subtitle, m_noHD, "");
     }
    // Check for "description (HD)" in the description
-    position = event.description.indexOf(m_noHD);
+    position = index_of(event.description, m_noHD);
     if (position != -1)
     {
       event.videoProps |= VID_HDTV;
-      event.description = event.description.replace(m_noHD, "");
+      event.description = replace_matches(event.description, m_noHD, "");
     }
 }
 
@@ -2281,13 +2458,13 @@ void EITFixUp::FixNRK_DVBT(DBEventEIT &event) const
 {
     QRegExp    tmpExp1;
     // Check for "title (R)" in the title
-    if (event.title.indexOf(m_noRerun) != -1)
+    if (index_of(event.title, m_noRerun) != -1)
     {
       event.previouslyshown = true;
-      event.title = event.title.replace(m_noRerun, "");
+      event.title = replace_matches(event.title, m_noRerun, "");
     }
     // Check for "(R)" in the description
-    if (event.description.indexOf(m_noRerun) != -1)
+    if (index_of(event.description, m_noRerun) != -1)
     {
       event.previouslyshown = true;
     }
@@ -2304,7 +2481,7 @@ void EITFixUp::FixNRK_DVBT(DBEventEIT &event) const
     tmpExp1 = m_noPremiere;
     if (tmpExp1.indexIn(event.title) >= 3)
     {
-        event.title.remove(m_noPremiere);
+        remove_matches(event.title, m_noPremiere);
     }
     // Try to find colon-delimited subtitle in title, only tested for NRK channels
     tmpExp1 = m_noColonSubtitle;
@@ -2409,25 +2586,25 @@ void EITFixUp::FixDK(DBEventEIT &event) const
         QString features = tmpRegEx.cap(1);
         event.description = event.description.replace(tmpRegEx, "");
         // 16:9
-        if (features.indexOf(m_dkWidescreen) !=  -1)
+        if (index_of(features, m_dkWidescreen) !=  -1)
             event.videoProps |= VID_WIDESCREEN;
         // HDTV
-        if (features.indexOf(m_dkHD) !=  -1)
+        if (index_of(features, m_dkHD) !=  -1)
             event.videoProps |= VID_HDTV;
         // Dolby Digital surround
-        if (features.indexOf(m_dkDolby) !=  -1)
+        if (index_of(features, m_dkDolby) !=  -1)
             event.audioProps |= AUD_DOLBY;
         // surround
-        if (features.indexOf(m_dkSurround) !=  -1)
+        if (index_of(features, m_dkSurround) !=  -1)
             event.audioProps |= AUD_SURROUND;
         // stereo
-        if (features.indexOf(m_dkStereo) !=  -1)
+        if (index_of(features, m_dkStereo) !=  -1)
             event.audioProps |= AUD_STEREO;
         // (G)
-        if (features.indexOf(m_dkReplay) !=  -1)
+        if (index_of(features, m_dkReplay) !=  -1)
             event.previouslyshown = true;
         // TTV
-        if (features.indexOf(m_dkTxt) !=  -1)
+        if (index_of(features, m_dkTxt) !=  -1)
             event.subtitleType |= SUB_NORMAL;
     }
 
@@ -2495,7 +2672,7 @@ void EITFixUp::FixDK(DBEventEIT &event) const
     {
         QString tmpActorsString = tmpRegEx.cap(1);
         if (directorPresent)
-            tmpActorsString = tmpActorsString.replace(m_dkDirector,"");
+            tmpActorsString = replace_matches(tmpActorsString, m_dkDirector, "");
         const QStringList actors =
             tmpActorsString.split(m_dkPersonsSeparator, QString::SkipEmptyParts);
         QStringList::const_iterator it = actors.begin();
@@ -2529,7 +2706,7 @@ void EITFixUp::FixDK(DBEventEIT &event) const
 void EITFixUp::FixStripHTML(DBEventEIT &event) const
 {
     LOG(VB_EIT, LOG_INFO, QString("Applying html strip to %1").arg(event.title));
-    event.title.remove(m_HTML);
+    remove_matches(event.title, m_HTML);
 }
 
 // Moves the subtitle field into the description since it's just used
@@ -2564,7 +2741,7 @@ void EITFixUp::FixGreekEIT(DBEventEIT &event) const
     }
 
     // Greek not previously Shown
-    position = event.title.indexOf(m_grNotPreviouslyShown);
+    position = index_of(event.title, m_grNotPreviouslyShown);
     if (position != -1)
     {
         event.previouslyshown = false;
@@ -2722,11 +2899,11 @@ void EITFixUp::FixGreekEIT(DBEventEIT &event) const
     // Work out the season and episode numbers (if any)
     // Matching pattern "Επεισ[όο]διο:?|Επ 3 από 14|3/14" etc
     bool    series  = false;
-    QRegExp tmpSeries = m_grSeason;
+    EITRegExp tmpSeries = m_grSeason;
     // cap(2) is the season for ΑΒΓΔ
     // cap(3) is the season for 1234
-    int position1 = tmpSeries.indexIn(event.title);
-    int position2 = tmpSeries.indexIn(event.description);
+    int position1 = tmpSeries.IndexIn(event.title);
+    int position2 = tmpSeries.IndexIn(event.description);
     if ((position1 != -1) || (position2 != -1))
     {
         if (!tmpSeries.cap(2).isEmpty()) // we found a letter representing a number
@@ -2758,11 +2935,11 @@ void EITFixUp::FixGreekEIT(DBEventEIT &event) const
             event.description.replace(tmpSeries.cap(0),"");
     }
 
-    QRegExp tmpEpisode = m_grlongEp;
+    EITRegExp tmpEpisode = m_grlongEp;
     //tmpEpisode.setMinimal(true);
     // cap(1) is the Episode No.
-    if ((position1 = tmpEpisode.indexIn(event.title)) != -1
-            || (position2 = tmpEpisode.indexIn(event.description)) != -1)
+    if ((position1 = tmpEpisode.IndexIn(event.title)) != -1
+            || (position2 = tmpEpisode.IndexIn(event.description)) != -1)
     {
         if (!tmpEpisode.cap(1).isEmpty())
         {
@@ -2839,99 +3016,99 @@ void EITFixUp::FixGreekEIT(DBEventEIT &event) const
 
 void EITFixUp::FixGreekCategories(DBEventEIT &event) const
 {
-    if (event.description.indexOf(m_grCategComedy) != -1)
+    if (index_of(event.description, m_grCategComedy) != -1)
     {
         event.category = "Κωμωδία";
     }
-    else if (event.description.indexOf(m_grCategTeleMag) != -1)
+    else if (index_of(event.description, m_grCategTeleMag) != -1)
     {
         event.category = "Τηλεπεριοδικό";
     }
-    else if (event.description.indexOf(m_grCategNature) != -1)
+    else if (index_of(event.description, m_grCategNature) != -1)
     {
         event.category = "Επιστήμη/Φύση";
     }
-    else if (event.description.indexOf(m_grCategHealth) != -1)
+    else if (index_of(event.description, m_grCategHealth) != -1)
     {
         event.category = "Υγεία";
     }
-    else if (event.description.indexOf(m_grCategReality) != -1)
+    else if (index_of(event.description, m_grCategReality) != -1)
     {
         event.category = "Ριάλιτι";
     }
-    else if (event.description.indexOf(m_grCategDrama) != -1)
+    else if (index_of(event.description, m_grCategDrama) != -1)
     {
         event.category = "Κοινωνικό";
     }
-    else if (event.description.indexOf(m_grCategChildren) != -1)
+    else if (index_of(event.description, m_grCategChildren) != -1)
     {
         event.category = "Παιδικό";
     }
-    else if (event.description.indexOf(m_grCategSciFi) != -1)
+    else if (index_of(event.description, m_grCategSciFi) != -1)
     {
         event.category = "Επιστ.Φαντασίας";
     }
-    else if ((event.description.indexOf(m_grCategFantasy) != -1)
-             && (event.description.indexOf(m_grCategMystery) != -1))
+    else if ((index_of(event.description, m_grCategFantasy) != -1)
+             && (index_of(event.description, m_grCategMystery) != -1))
     {
         event.category = "Φαντασίας/Μυστηρίου";
     }
-    else if (event.description.indexOf(m_grCategMystery) != -1)
+    else if (index_of(event.description, m_grCategMystery) != -1)
     {
         event.category = "Μυστηρίου";
     }
-    else if (event.description.indexOf(m_grCategFantasy) != -1)
+    else if (index_of(event.description, m_grCategFantasy) != -1)
     {
         event.category = "Φαντασίας";
     }
-    else if (event.description.indexOf(m_grCategHistory) != -1)
+    else if (index_of(event.description, m_grCategHistory) != -1)
     {
         event.category = "Ιστορικό";
     }
-    else if (event.description.indexOf(m_grCategTeleShop) != -1
-            || event.title.indexOf(m_grCategTeleShop) != -1)
+    else if (index_of(event.description, m_grCategTeleShop) != -1
+            || index_of(event.title, m_grCategTeleShop) != -1)
     {
         event.category = "Τηλεπωλήσεις";
     }
-    else if (event.description.indexOf(m_grCategFood) != -1)
+    else if (index_of(event.description, m_grCategFood) != -1)
     {
         event.category = "Γαστρονομία";
     }
-    else if (event.description.indexOf(m_grCategGameShow) != -1
-             || event.title.indexOf(m_grCategGameShow) != -1)
+    else if (index_of(event.description, m_grCategGameShow) != -1
+             || index_of(event.title, m_grCategGameShow) != -1)
     {
         event.category = "Τηλεπαιχνίδι";
     }
-    else if (event.description.indexOf(m_grCategBiography) != -1)
+    else if (index_of(event.description, m_grCategBiography) != -1)
     {
         event.category = "Βιογραφία";
     }
-    else if (event.title.indexOf(m_grCategNews) != -1)
+    else if (index_of(event.title, m_grCategNews) != -1)
     {
         event.category = "Ειδήσεις";
     }
-    else if (event.description.indexOf(m_grCategSports) != -1)
+    else if (index_of(event.description, m_grCategSports) != -1)
     {
         event.category = "Αθλητικά";
     }
-    else if (event.description.indexOf(m_grCategMusic) != -1
-            || event.title.indexOf(m_grCategMusic) != -1)
+    else if (index_of(event.description, m_grCategMusic) != -1
+            || index_of(event.title, m_grCategMusic) != -1)
     {
         event.category = "Μουσική";
     }
-    else if (event.description.indexOf(m_grCategDocumentary) != -1)
+    else if (index_of(event.description, m_grCategDocumentary) != -1)
     {
         event.category = "Ντοκιμαντέρ";
     }
-    else if (event.description.indexOf(m_grCategReligion) != -1)
+    else if (index_of(event.description, m_grCategReligion) != -1)
     {
         event.category = "Θρησκεία";
     }
-    else if (event.description.indexOf(m_grCategCulture) != -1)
+    else if (index_of(event.description, m_grCategCulture) != -1)
     {
         event.category = "Τέχνες/Πολιτισμός";
     }
-    else if (event.description.indexOf(m_grCategSpecial) != -1)
+    else if (index_of(event.description, m_grCategSpecial) != -1)
     {
         event.category = "Αφιέρωμα";
     }
@@ -2996,7 +3173,7 @@ void EITFixUp::FixUnitymedia(DBEventEIT &event) const
     }
 
     // handle star rating in the description
-    QRegExp tmp = m_unitymediaImdbrating;
+    EITRegExp tmp = m_unitymediaImdbrating;
     if (event.description.indexOf (tmp) != -1)
     {
         float stars = tmp.cap(1).toFloat();
@@ -9,6 +9,44 @@
 
 #include "programdata.h"
 
+/** \brief Regular expression that knows a literal string every match
+ *         must contain.
+ *
+ *  Most fixup expressions can only match text containing some fixed word,
+ *  e.g. "Wiederholung" or "Stereo". The literal is found once when the
+ *  expression is built, so the fixups can skip running the expression on
+ *  the many descriptions that cannot match with a plain substring search.
+ */
+class EITRegExp : public QRegExp
+{
+  public:
+    explicit EITRegExp(const QString &pattern,
+                       Qt::CaseSensitivity cs = Qt::CaseSensitive);
+
+    /// False when str can not contain a match of this expression.
+    bool CanMatch(const QString &str) const
+    {
+        return m_literal.isEmpty() ||
+            str.contains(m_literal, caseSensitivity());
+    }
+
+    /// As QRegExp::indexIn(), skipped when str can not contain a match.
+    int IndexIn(const QString &str, int offset = 0)
+    {
+        if (CanMatch(str))
+            return indexIn(str, offset);
+        indexIn(QString());
+        return -1;
+    }
+
+    /// Longest literal every match of pattern contains, may be empty.
+    static QString RequiredLiteral(const QString &pattern,
+                                   Qt::CaseSensitivity cs);
+
+  private:
+    QString m_literal;
+};
+
 /// EIT Fix Up Functions
 class EITFixUp
 {
@@ -121,186 +159,186 @@ class EITFixUp
 
     static QString AddDVBEITAuthority(uint chanid, const QString &id);
 
-    const QRegExp m_bellYear;
-    const QRegExp m_bellActors;
-    const QRegExp m_bellPPVTitleAllDayHD;
-    const QRegExp m_bellPPVTitleAllDay;
-    const QRegExp m_bellPPVTitleHD;
-    const QRegExp m_bellPPVSubtitleAllDay;
-    const QRegExp m_bellPPVDescriptionAllDay;
-    const QRegExp m_bellPPVDescriptionAllDay2;
-    const QRegExp m_bellPPVDescriptionEventId;
-    const QRegExp m_dishPPVTitleHD;
-    const QRegExp m_dishPPVTitleColon;
-    const QRegExp m_dishPPVSpacePerenEnd;
-    const QRegExp m_dishDescriptionNew;
-    const QRegExp m_dishDescriptionFinale;
-    const QRegExp m_dishDescriptionFinale2;
-    const QRegExp m_dishDescriptionPremiere;
-    const QRegExp m_dishDescriptionPremiere2;
-    const QRegExp m_dishPPVCode;
-    const QRegExp m_ukThen;
-    const QRegExp m_ukNew;
-    const QRegExp m_ukNewTitle;
-    const QRegExp m_ukAlsoInHD;
-    const QRegExp m_ukCEPQ;
-    const QRegExp m_ukColonPeriod;
-    const QRegExp m_ukDotSpaceStart;
-    const QRegExp m_ukDotEnd;
-    const QRegExp m_ukSpaceColonStart;
-    const QRegExp m_ukSpaceStart;
-    const QRegExp m_ukPart;
-    const QRegExp m_ukSeries;
-    const QRegExp m_ukCC;
-    const QRegExp m_ukYear;
-    const QRegExp m_uk24ep;
-    const QRegExp m_ukStarring;
-    const QRegExp m_ukBBC7rpt;
-    const QRegExp m_ukDescriptionRemove;
-    const QRegExp m_ukTitleRemove;
-    const QRegExp m_ukDoubleDotEnd;
-    const QRegExp m_ukDoubleDotStart;
-    const QRegExp m_ukTime;
-    const QRegExp m_ukBBC34;
-    const QRegExp m_ukYearColon;
-    const QRegExp m_ukExclusionFromSubtitle;
-    const QRegExp m_ukCompleteDots;
-    const QRegExp m_ukQuotedSubtitle;
-    const QRegExp m_ukAllNew;
-    const QRegExp m_ukLaONoSplit;
-    const QRegExp m_comHemCountry;
-    const QRegExp m_comHemDirector;
-    const QRegExp m_comHemActor;
-    const QRegExp m_comHemHost;
-    const QRegExp m_comHemSub;
-    const QRegExp m_comHemRerun1;
-    const QRegExp m_comHemRerun2;
-    const QRegExp m_comHemTT;
-    const QRegExp m_comHemPersSeparator;
-    const QRegExp m_comHemPersons;
-    const QRegExp m_comHemSubEnd;
-    const QRegExp m_comHemSeries1;
-    const QRegExp m_comHemSeries2;
-    const QRegExp m_comHemTSub;
-    const QRegExp m_mcaIncompleteTitle;
-    const QRegExp m_mcaCompleteTitlea;
-    const QRegExp m_mcaCompleteTitleb;
-    const QRegExp m_mcaSubtitle;
-    const QRegExp m_mcaSeries;
-    const QRegExp m_mcaCredits;
-    const QRegExp m_mcaAvail;
-    const QRegExp m_mcaActors;
-    const QRegExp m_mcaActorsSeparator;
-    const QRegExp m_mcaYear;
-    const QRegExp m_mcaCC;
-    const QRegExp m_mcaDD;
-    const QRegExp m_RTLrepeat;
-    const QRegExp m_RTLSubtitle;
-    const QRegExp m_RTLSubtitle1;
-    const QRegExp m_RTLSubtitle2;
-    const QRegExp m_RTLSubtitle3;
-    const QRegExp m_RTLSubtitle4;
-    const QRegExp m_RTLSubtitle5;
-    const QRegExp m_PRO7Subtitle;
-    const QRegExp m_PRO7Crew;
-    const QRegExp m_PRO7CrewOne;
-    const QRegExp m_PRO7Cast;
-    const QRegExp m_PRO7CastOne;
-    const QRegExp m_ATVSubtitle;
-    const QRegExp m_DisneyChannelSubtitle;
-    const QRegExp m_RTLEpisodeNo1;
-    const QRegExp m_RTLEpisodeNo2;
-    const QRegExp m_fiRerun;
-    const QRegExp m_fiRerun2;
-    const QRegExp m_dePremiereLength;
-    const QRegExp m_dePremiereAirdate;
-    const QRegExp m_dePremiereCredits;
-    const QRegExp m_dePremiereOTitle;
-    const QRegExp m_deSkyDescriptionSeasonEpisode;
-    const QRegExp m_nlTxt;
-    const QRegExp m_nlWide;
-    const QRegExp m_nlRepeat;
-    const QRegExp m_nlHD;
-    const QRegExp m_nlSub;
-    const QRegExp m_nlSub2;
-    const QRegExp m_nlActors;
-    const QRegExp m_nlPres;
-    const QRegExp m_nlPersSeparator;
-    const QRegExp m_nlRub;
-    const QRegExp m_nlYear1;
-    const QRegExp m_nlYear2;
-    const QRegExp m_nlDirector;
-    const QRegExp m_nlCat;
-    const QRegExp m_nlOmroep;
-    const QRegExp m_noRerun;
-    const QRegExp m_noHD;
-    const QRegExp m_noColonSubtitle;
-    const QRegExp m_noNRKCategories;
-    const QRegExp m_noPremiere;
-    const QRegExp m_Stereo;
-    const QRegExp m_dkEpisode;
-    const QRegExp m_dkPart;
-    const QRegExp m_dkSubtitle1;
-    const QRegExp m_dkSubtitle2;
-    const QRegExp m_dkSeason1;
-    const QRegExp m_dkSeason2;
-    const QRegExp m_dkFeatures;
-    const QRegExp m_dkWidescreen;
-    const QRegExp m_dkDolby;
-    const QRegExp m_dkSurround;
-    const QRegExp m_dkStereo;
-    const QRegExp m_dkReplay;
-    const QRegExp m_dkTxt;
-    const QRegExp m_dkHD;
-    const QRegExp m_dkActors;
-    const QRegExp m_dkPersonsSeparator;
-    const QRegExp m_dkDirector;
-    const QRegExp m_dkYear;
-    const QRegExp m_AUFreeviewSY;//subtitle, year
-    const QRegExp m_AUFreeviewY;//year
-    const QRegExp m_AUFreeviewYC;//year, cast
-    const QRegExp m_AUFreeviewSYC;//subtitle, year, cast
-    const QRegExp m_HTML;
-    const QRegExp m_grReplay; //Greek rerun
-    const QRegExp m_grDescriptionFinale; //Greek last m_grEpisode
-    const QRegExp m_grActors; //Greek actors
-    const QRegExp m_grFixnofullstopActors; //bad punctuation makes the "Παίζουν:" and the actors' names part of the directors...
-    const QRegExp m_grFixnofullstopDirectors; //bad punctuation makes the "Σκηνοθ...:" and the previous sentence.
-    const QRegExp m_grPeopleSeparator; // The comma that separates the actors.
-    const QRegExp m_grDirector;
-    const QRegExp m_grPres; // Greek Presenters for shows
-    const QRegExp m_grYear; // Greek release year.
-    const QRegExp m_grCountry; // Greek event country of origin.
-    const QRegExp m_grlongEp; // Greek Episode
-    const QRegExp m_grSeason; // Greek Season
-    const QRegExp m_grSeries;
-    const QRegExp m_grRealTitleinDescription; // The original title is often in the descr in parenthesis.
-    const QRegExp m_grRealTitleinTitle; // The original title is often in the title in parenthesis.
-    const QRegExp m_grNotPreviouslyShown; // Not previously shown on TV
-    const QRegExp m_grEpisodeAsSubtitle; // Description field: "^Episode: Lion in the cage. (Description follows)"
-    const QRegExp m_grCategFood; // Greek category food
-    const QRegExp m_grCategDrama; // Greek category social/drama
-    const QRegExp m_grCategComedy; // Greek category comedy
-    const QRegExp m_grCategChildren; // Greek category for children / cartoons
-    const QRegExp m_grCategMystery; // Greek category for mystery
-    const QRegExp m_grCategFantasy; // Greek category for fantasy
-    const QRegExp m_grCategHistory; //Greek category for historical movie/series
-    const QRegExp m_grCategTeleMag; //Greek category for Telemagazine show
-    const QRegExp m_grCategTeleShop; //Greek category for teleshopping
-    const QRegExp m_grCategGameShow; //Greek category for game show
-    const QRegExp m_grCategDocumentary; // Greek category for Documentaries
-    const QRegExp m_grCategBiography; // Greek category for biography
-    const QRegExp m_grCategNews; // Greek category for News
-    const QRegExp m_grCategSports; // Greek category for Sports
-    const QRegExp m_grCategMusic; // Greek category for Music
-    const QRegExp m_grCategReality; // Greek category for reality shows
-    const QRegExp m_grCategReligion; //Greek category for religion
-    const QRegExp m_grCategCulture; //Greek category for Arts/Culture
-    const QRegExp m_grCategNature; //Greek category for Nature/Science
-    const QRegExp m_grCategSciFi;  // Greek category for Science Fiction
-    const QRegExp m_grCategHealth; //Greek category for Health
-    const QRegExp m_grCategSpecial; //Greek category for specials.
-    const QRegExp m_unitymediaImdbrating; ///< IMDb Rating
+    const EITRegExp m_bellYear;
+    const EITRegExp m_bellActors;
+    const EITRegExp m_bellPPVTitleAllDayHD;
+    const EITRegExp m_bellPPVTitleAllDay;
+    const EITRegExp m_bellPPVTitleHD;
+    const EITRegExp m_bellPPVSubtitleAllDay;
+    const EITRegExp m_bellPPVDescriptionAllDay;
+    const EITRegExp m_bellPPVDescriptionAllDay2;
+    const EITRegExp m_bellPPVDescriptionEventId;
+    const EITRegExp m_dishPPVTitleHD;
+    const EITRegExp m_dishPPVTitleColon;
+    const EITRegExp m_dishPPVSpacePerenEnd;
+    const EITRegExp m_dishDescriptionNew;
+    const EITRegExp m_dishDescriptionFinale;
+    const EITRegExp m_dishDescriptionFinale2;
+    const EITRegExp m_dishDescriptionPremiere;
+    const EITRegExp m_dishDescriptionPremiere2;
+    const EITRegExp m_dishPPVCode;
+    const EITRegExp m_ukThen;
+    const EITRegExp m_ukNew;
+    const EITRegExp m_ukNewTitle;
+    const EITRegExp m_ukAlsoInHD;
+    const EITRegExp m_ukCEPQ;
+    const EITRegExp m_ukColonPeriod;
+    const EITRegExp m_ukDotSpaceStart;
+    const EITRegExp m_ukDotEnd;
+    const EITRegExp m_ukSpaceColonStart;
+    const EITRegExp m_ukSpaceStart;
+    const EITRegExp m_ukPart;
+    const EITRegExp m_ukSeries;
+    const EITRegExp m_ukCC;
+    const EITRegExp m_ukYear;
+    const EITRegExp m_uk24ep;
+    const EITRegExp m_ukStarring;
+    const EITRegExp m_ukBBC7rpt;
+    const EITRegExp m_ukDescriptionRemove;
+    const EITRegExp m_ukTitleRemove;
+    const EITRegExp m_ukDoubleDotEnd;
+    const EITRegExp m_ukDoubleDotStart;
+    const EITRegExp m_ukTime;
+    const EITRegExp m_ukBBC34;
+    const EITRegExp m_ukYearColon;
+    const EITRegExp m_ukExclusionFromSubtitle;
+    const EITRegExp m_ukCompleteDots;
+    const EITRegExp m_ukQuotedSubtitle;
+    const EITRegExp m_ukAllNew;
+    const EITRegExp m_ukLaONoSplit;
+    const EITRegExp m_comHemCountry;
+    const EITRegExp m_comHemDirector;
+    const EITRegExp m_comHemActor;
+    const EITRegExp m_comHemHost;
+    const EITRegExp m_comHemSub;
+    const EITRegExp m_comHemRerun1;
+    const EITRegExp m_comHemRerun2;
+    const EITRegExp m_comHemTT;
+    const EITRegExp m_comHemPersSeparator;
+    const EITRegExp m_comHemPersons;
+    const EITRegExp m_comHemSubEnd;
+    const EITRegExp m_comHemSeries1;
+    const EITRegExp m_comHemSeries2;
+    const EITRegExp m_comHemTSub;
+    const EITRegExp m_mcaIncompleteTitle;
+    const EITRegExp m_mcaCompleteTitlea;
+    const EITRegExp m_mcaCompleteTitleb;
+    const EITRegExp m_mcaSubtitle;
+    const EITRegExp m_mcaSeries;
+    const EITRegExp m_mcaCredits;
+    const EITRegExp m_mcaAvail;
+    const EITRegExp m_mcaActors;
+    const EITRegExp m_mcaActorsSeparator;
+    const EITRegExp m_mcaYear;
+    const EITRegExp m_mcaCC;
+    const EITRegExp m_mcaDD;
+    const EITRegExp m_RTLrepeat;
+    const EITRegExp m_RTLSubtitle;
+    const EITRegExp m_RTLSubtitle1;
+    const EITRegExp m_RTLSubtitle2;
+    const EITRegExp m_RTLSubtitle3;
+    const EITRegExp m_RTLSubtitle4;
+    const EITRegExp m_RTLSubtitle5;
+    const EITRegExp m_PRO7Subtitle;
+    const EITRegExp m_PRO7Crew;
+    const EITRegExp m_PRO7CrewOne;
+    const EITRegExp m_PRO7Cast;
+    const EITRegExp m_PRO7CastOne;
+    const EITRegExp m_ATVSubtitle;
+    const EITRegExp m_DisneyChannelSubtitle;
+    const EITRegExp m_RTLEpisodeNo1;
+    const EITRegExp m_RTLEpisodeNo2;
+    const EITRegExp m_fiRerun;
+    const EITRegExp m_fiRerun2;
+    const EITRegExp m_dePremiereLength;
+    const EITRegExp m_dePremiereAirdate;
+    const EITRegExp m_dePremiereCredits;
+    const EITRegExp m_dePremiereOTitle;
+    const EITRegExp m_deSkyDescriptionSeasonEpisode;
+    const EITRegExp m_nlTxt;
+    const EITRegExp m_nlWide;
+    const EITRegExp m_nlRepeat;
+    const EITRegExp m_nlHD;
+    const EITRegExp m_nlSub;
+    const EITRegExp m_nlSub2;
+    const EITRegExp m_nlActors;
+    const EITRegExp m_nlPres;
+    const EITRegExp m_nlPersSeparator;
+    const EITRegExp m_nlRub;
+    const EITRegExp m_nlYear1;
+    const EITRegExp m_nlYear2;
+    const EITRegExp m_nlDirector;
+    const EITRegExp m_nlCat;
+    const EITRegExp m_nlOmroep;
+    const EITRegExp m_noRerun;
+    const EITRegExp m_noHD;
+    const EITRegExp m_noColonSubtitle;
+    const EITRegExp m_noNRKCategories;
+    const EITRegExp m_noPremiere;
+    const EITRegExp m_Stereo;
+    const EITRegExp m_dkEpisode;
+    const EITRegExp m_dkPart;
+    const EITRegExp m_dkSubtitle1;
+    const EITRegExp m_dkSubtitle2;
+    const EITRegExp m_dkSeason1;
+    const EITRegExp m_dkSeason2;
+    const EITRegExp m_dkFeatures;
+    const EITRegExp m_dkWidescreen;
+    const EITRegExp m_dkDolby;
+    const EITRegExp m_dkSurround;
+    const EITRegExp m_dkStereo;
+    const EITRegExp m_dkReplay;
+    const EITRegExp m_dkTxt;
+    const EITRegExp m_dkHD;
+    const EITRegExp m_dkActors;
+    const EITRegExp m_dkPersonsSeparator;
+    const EITRegExp m_dkDirector;
+    const EITRegExp m_dkYear;
+    const EITRegExp m_AUFreeviewSY;//subtitle, year
+    const EITRegExp m_AUFreeviewY;//year
+    const EITRegExp m_AUFreeviewYC;//year, cast
+    const EITRegExp m_AUFreeviewSYC;//subtitle, year, cast
+    const EITRegExp m_HTML;
+    const EITRegExp m_grReplay; //Greek rerun
+    const EITRegExp m_grDescriptionFinale; //Greek last m_grEpisode
+    const EITRegExp m_grActors; //Greek actors
+    const EITRegExp m_grFixnofullstopActors; //bad punctuation makes the "Παίζουν:" and the actors' names part of the directors...
+    const EITRegExp m_grFixnofullstopDirectors; //bad punctuation makes the "Σκηνοθ...:" and the previous sentence.
+    const EITRegExp m_grPeopleSeparator; // The comma that separates the actors.
+    const EITRegExp m_grDirector;
+    const EITRegExp m_grPres; // Greek Presenters for shows
+    const EITRegExp m_grYear; // Greek release year.
+    const EITRegExp m_grCountry; // Greek event country of origin.
+    const EITRegExp m_grlongEp; // Greek Episode
+    const EITRegExp m_grSeason; // Greek Season
+    const EITRegExp m_grSeries;
+    const EITRegExp m_grRealTitleinDescription; // The original title is often in the descr in parenthesis.
+    const EITRegExp m_grRealTitleinTitle; // The original title is often in the title in parenthesis.
+    const EITRegExp m_grNotPreviouslyShown; // Not previously shown on TV
+    const EITRegExp m_grEpisodeAsSubtitle; // Description field: "^Episode: Lion in the cage. (Description follows)"
+    const EITRegExp m_grCategFood; // Greek category food
+    const EITRegExp m_grCategDrama; // Greek category social/drama
+    const EITRegExp m_grCategComedy; // Greek category comedy
+    const EITRegExp m_grCategChildren; // Greek category for children / cartoons
+    const EITRegExp m_grCategMystery; // Greek category for mystery
+    const EITRegExp m_grCategFantasy; // Greek category for fantasy
+    const EITRegExp m_grCategHistory; //Greek category for historical movie/series
+    const EITRegExp m_grCategTeleMag; //Greek category for Telemagazine show
+    const EITRegExp m_grCategTeleShop; //Greek category for teleshopping
+    const EITRegExp m_grCategGameShow; //Greek category for game show
+    const EITRegExp m_grCategDocumentary; // Greek category for Documentaries
+    const EITRegExp m_grCategBiography; // Greek category for biography
+    const EITRegExp m_grCategNews; // Greek category for News
+    const EITRegExp m_grCategSports; // Greek category for Sports
+    const EITRegExp m_grCategMusic; // Greek category for Music
+    const EITRegExp m_grCategReality; // Greek category for reality shows
+    const EITRegExp m_grCategReligion; //Greek category for religion
+    const EITRegExp m_grCategCulture; //Greek category for Arts/Culture
+    const EITRegExp m_grCategNature; //Greek category for Nature/Science
+    const EITRegExp m_grCategSciFi;  // Greek category for Science Fiction
+    const EITRegExp m_grCategHealth; //Greek category for Health
+    const EITRegExp m_grCategSpecial; //Greek category for specials.
+    const EITRegExp m_unitymediaImdbrating; ///< IMDb Rating
 };
 
 #endif // EITFIXUP_H
@@ -21,7 +21,7 @@ using namespace std;
 #include "scheduledrecording.h" // for ScheduledRecording
 #include "compat.h" // for gmtime_r on windows.
 
-const uint EITHelper::kChunkSize = 20;
+const uint EITHelper::kChunkSize = 200;
 EITCache *EITHelper::eitcache = new EITCache();
 
 static uint get_chan_id_from_db_atsc(uint sourceid,
@@ -36,6 +36,7 @@ static void init_fixup(FixupMap &fix);
 
 EITHelper::EITHelper() :
     eitfixup(new EITFixUp()),
+    eitwriter(new EITBatchWriter()),
     gps_offset(-1 * GPS_LEAP_SECONDS),
     sourceid(0), channelid(0),
     maxStarttime(QDateTime()), seenEITother(false)
@@ -50,6 +51,7 @@ EITHelper::~EITHelper()
         delete db_events.dequeue();
 
     delete eitfixup;
+    delete eitwriter;
 }
 
 uint EITHelper::GetListSize(void) const
@@ -71,20 +73,24 @@ uint EITHelper::ProcessEvents(void)
     if (db_events.empty())
         return 0;
 
-    MSqlQuery query(MSqlQuery::InitCon());
+    QList<DBEventEIT*> events;
     for (uint i = 0; (i < kChunkSize) && (db_events.size() > 0); i++)
-    {
-        DBEventEIT *event = db_events.dequeue();
-        eitList_lock.unlock();
+        events.push_back(db_events.dequeue());
+    eitList_lock.unlock();
 
-        eitfixup->Fix(*event);
+    QList<DBEventEIT*>::iterator it = events.begin();
+    for (; it != events.end(); ++it)
+    {
+        eitfixup->Fix(**it);
+        maxStarttime = max (maxStarttime, (*it)->starttime);
+    }
 
-        insertCount += event->UpdateDB(query, 1000);
-        maxStarttime = max (maxStarttime, event->starttime);
+    insertCount = eitwriter->Write(events, 1000);
+    LOG(VB_EIT, LOG_DEBUG, LOC + eitwriter->GetStatistics());
 
-        delete event;
-        eitList_lock.lock();
-    }
+    for (it = events.begin(); it != events.end(); ++it)
+        delete *it;
+    eitList_lock.lock();
 
     if (!insertCount)
         return 0;
@@ -80,6 +80,7 @@ typedef QMap<FixupKey, FixupValue>         FixupMap;
 
 class DBEventEIT;
 class EITFixUp;
+class EITBatchWriter;
 class EITCache;
 
 class EventInformationTable;
@@ -141,6 +142,7 @@ class EITHelper
     mutable ServiceToChanID srv_to_chanid;
 
     EITFixUp               *eitfixup;
+    EITBatchWriter         *eitwriter;
     static EITCache        *eitcache;
 
     int                     gps_offset;
@@ -159,7 +161,7 @@ class EITHelper
 
     QMap<uint,uint>         languagePreferences;
 
-    /// Maximum number of DB inserts per ProcessEvents call.
+    /// Maximum number of events written per ProcessEvents call.
     static const uint kChunkSize;
 };
 
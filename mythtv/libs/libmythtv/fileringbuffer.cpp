@@ -70,6 +70,8 @@ FileRingBuffer::FileRingBuffer(const QString &lfilename,
         {
             tfw = new ThreadedFileWriter(
                 filename, O_WRONLY|O_TRUNC|O_CREAT|O_LARGEFILE, 0644);
+            tfw->SetDirectIO(
+                gCoreContext->GetBoolSetting("RecordingDirectIO", false));
 
             if (!tfw->Open())
             {
@@ -203,7 +203,7 @@ HEADERS += mpeg/atsc_huffman.h
 HEADERS += mpeg/freesat_huffman.h   mpeg/freesat_tables.h
 HEADERS += mpeg/iso6937tables.h
 HEADERS += mpeg/tsstats.h           mpeg/streamlisteners.h
-HEADERS += mpeg/H264Parser.h
+HEADERS += mpeg/H264Parser.h        mpeg/startcode.h
 HEADERS += mpeg/tablestatus.h
 
 SOURCES += mpeg/tspacket.cpp        mpeg/pespacket.cpp
@@ -219,7 +219,7 @@ SOURCES += mpeg/dishdescriptors.cpp mpeg/premieredescriptors.cpp
 SOURCES += mpeg/atsc_huffman.cpp
 SOURCES += mpeg/freesat_huffman.cpp
 SOURCES += mpeg/iso6937tables.cpp
-SOURCES += mpeg/H264Parser.cpp
+SOURCES += mpeg/H264Parser.cpp      mpeg/startcode.cpp
 SOURCES += mpeg/tablestatus.cpp
 
 # Channels, and the multiplexes that transmit them
@@ -307,6 +307,10 @@ HEADERS += HLS/httplivestream.h
 SOURCES += HLS/httplivestream.cpp
 HEADERS += HLS/httplivestreambuffer.h
 SOURCES += HLS/httplivestreambuffer.cpp
+HEADERS += HLS/httplivestreamtranscoder.h
+SOURCES += HLS/httplivestreamtranscoder.cpp
+HEADERS += HLS/httplivestreamremuxer.h
+SOURCES += HLS/httplivestreamremuxer.cpp
 HEADERS += HLS/m3u.h
 SOURCES += HLS/m3u.cpp
 using_libcrypto:DEFINES += USING_LIBCRYPTO
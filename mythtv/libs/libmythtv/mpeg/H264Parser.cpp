@@ -3,6 +3,7 @@
 #include <iostream>
 #include "mythlogging.h"
 #include "recorders/dtvrecorder.h" // for FrameRate
+#include "startcode.h"
 
 extern "C" {
 #include "libavcodec/avcodec.h"
@@ -413,7 +414,7 @@ uint32_t H264Parser::addBytes(const uint8_t  *bytes,
 
     while (startP < bytes + byte_count && !on_frame)
     {
-        endP = avpriv_find_start_code(startP,
+        endP = myth_find_start_code(startP,
                                   bytes + byte_count, &sync_accumulator);
 
         found_start_code = ((sync_accumulator & 0xffffff00) == 0x00000100);
@@ -46,7 +46,7 @@ MPEGStreamData::MPEGStreamData(int desiredProgram, int cardnum,
       _si_time_offset_cnt(0),
       _si_time_offset_indx(0),
       _eit_helper(NULL), _eit_rate(0.0f),
-      _listening_disabled(false),
+      _listening_disabled(false), _pid_class_dirty(true),
       _encryption_lock(QMutex::Recursive), _listener_lock(QMutex::Recursive),
       _cache_tables(cacheTables), _cache_lock(QMutex::Recursive),
       // Single program stuff
@@ -62,6 +62,7 @@ MPEGStreamData::MPEGStreamData(int desiredProgram, int cardnum,
       _invalid_pat_seen(false), _invalid_pat_warning(false)
 {
     memset(_si_time_offsets, 0, sizeof(_si_time_offsets));
+    memset(_pid_class, 0, sizeof(_pid_class));
 
     AddListeningPID(MPEG_PAT_PID);
     AddListeningPID(MPEG_CAT_PID);
@@ -170,6 +171,7 @@ void MPEGStreamData::Reset(int desiredProgram)
     _pids_audio.clear();
 
     _pid_video_single_program = _pid_pmt_single_program = 0xffffffff;
+    _pid_class_dirty = true;
 
     _pat_status.clear();
 
@@ -623,6 +625,7 @@ bool MPEGStreamData::CreatePMTSingleProgram(const ProgramMapTable &pmt)
 
     _pids_writing.clear();
     _pid_video_single_program = !videoPIDs.empty() ? videoPIDs[0] : 0xffffffff;
+    _pid_class_dirty = true;
     for (uint i = 1; i < videoPIDs.size(); i++)
         AddWritingPID(videoPIDs[i]);
 
@@ -1000,6 +1003,26 @@ int MPEGStreamData::ProcessData(const unsigned char *buffer, int len)
         }
 
         const TSPacket *pkt = reinterpret_cast<const TSPacket*>(&buffer[pos]);
+
+        // Hand runs of packets bound for the same listener callback
+        // over in one call, so recorders can write them in one go.
+        if (_pid_class_dirty)
+            UpdatePIDClassTable();
+        uint pid_class = BatchablePIDClass(*pkt);
+        if (pid_class)
+        {
+            uint cnt = CountBatchablePackets(
+                &buffer[pos + TSPacket::kSize],
+                len - pos - TSPacket::kSize, pid_class) + 1;
+            if (cnt > 1)
+            {
+                ProcessTSPackets(pkt, cnt, pid_class);
+                pos += cnt * TSPacket::kSize;
+                resync = false;
+                continue;
+            }
+        }
+
         pos += TSPacket::kSize; // Advance to next TS packet
         resync = false;
         if (!ProcessTSPacket(*pkt))
@@ -1024,7 +1047,13 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
 {
     bool ok = !tspacket.TransportError();
 
-    if (IsEncryptionTestPID(tspacket.PID()))
+    if (_pid_class_dirty)
+        UpdatePIDClassTable();
+
+    // PID() is 13 bits wide, so this can never index past the table
+    uint pid_class = _pid_class[tspacket.PID()];
+
+    if (pid_class & kPIDClassEncryptionTest)
     {
         ProcessEncryptedPacket(tspacket);
     }
@@ -1035,7 +1064,7 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
     if (tspacket.Scrambled())
         return true;
 
-    if (IsVideoPID(tspacket.PID()))
+    if (pid_class & kPIDClassVideo)
     {
         for (uint j = 0; j < _ts_av_listeners.size(); j++)
             _ts_av_listeners[j]->ProcessVideoTSPacket(tspacket);
@@ -1043,7 +1072,7 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
         return true;
     }
 
-    if (IsAudioPID(tspacket.PID()))
+    if (pid_class & kPIDClassAudio)
     {
         for (uint j = 0; j < _ts_av_listeners.size(); j++)
             _ts_av_listeners[j]->ProcessAudioTSPacket(tspacket);
@@ -1051,13 +1080,13 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
         return true;
     }
 
-    if (IsWritingPID(tspacket.PID()))
+    if (pid_class & kPIDClassWriting)
     {
         for (uint j = 0; j < _ts_writing_listeners.size(); j++)
             _ts_writing_listeners[j]->ProcessTSPacket(tspacket);
     }
 
-    if (IsListeningPID(tspacket.PID()) && tspacket.HasPayload())
+    if ((pid_class & kPIDClassListening) && tspacket.HasPayload())
     {
         HandleTSTables(&tspacket);
     }
@@ -1065,6 +1094,121 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
     return true;
 }
 
+/** \fn MPEGStreamData::UpdatePIDClassTable(void)
+ *  \brief Rebuilds the flat PID classification table used by
+ *         ProcessTSPacket() from the listening, writing, audio,
+ *         video and encryption test PID sets.
+ *
+ *   The PID sets are only changed when tables are (re)parsed, while
+ *   ProcessTSPacket() runs for every packet, so we trade a full
+ *   rebuild on change for one array lookup per packet.
+ */
+void MPEGStreamData::UpdatePIDClassTable(void)
+{
+    _pid_class_dirty = false;
+
+    memset(_pid_class, 0, sizeof(_pid_class));
+
+    pid_map_t::const_iterator it = _pids_audio.begin();
+    for (; it != _pids_audio.end(); ++it)
+        if (it.key() < 0x2000)
+            _pid_class[it.key()] |= kPIDClassAudio;
+
+    for (it = _pids_writing.begin(); it != _pids_writing.end(); ++it)
+        if (it.key() < 0x2000)
+            _pid_class[it.key()] |= kPIDClassWriting;
+
+    if (!_listening_disabled)
+    {
+        for (it = _pids_listening.begin(); it != _pids_listening.end(); ++it)
+            if (it.key() < 0x2000)
+                _pid_class[it.key()] |= kPIDClassListening;
+    }
+
+    for (it = _pids_notlistening.begin();
+         it != _pids_notlistening.end(); ++it)
+    {
+        if (it.key() < 0x2000)
+            _pid_class[it.key()] &= ~kPIDClassListening;
+    }
+
+    if (_pid_video_single_program < 0x2000)
+        _pid_class[_pid_video_single_program] |= kPIDClassVideo;
+
+    QMutexLocker locker(&_encryption_lock);
+    QMap<uint, CryptInfo>::const_iterator eit =
+        _encryption_pid_to_info.begin();
+    for (; eit != _encryption_pid_to_info.end(); ++eit)
+        if (eit.key() < 0x2000)
+            _pid_class[eit.key()] |= kPIDClassEncryptionTest;
+}
+
+/** \fn MPEGStreamData::BatchablePIDClass(const TSPacket&) const
+ *  \brief Returns the listener callback class (video, audio or writing)
+ *         this packet would be dispatched to by ProcessTSPacket(), or
+ *         zero if the packet needs any other handling.
+ */
+uint MPEGStreamData::BatchablePIDClass(const TSPacket &tspacket) const
+{
+    if (tspacket.TransportError() || tspacket.Scrambled())
+        return 0;
+
+    uint pid_class = _pid_class[tspacket.PID()];
+    if (pid_class & kPIDClassEncryptionTest)
+        return 0;
+    if (pid_class & kPIDClassVideo)
+        return kPIDClassVideo;
+    if (pid_class & kPIDClassAudio)
+        return kPIDClassAudio;
+    if ((pid_class & kPIDClassWriting) && !(pid_class & kPIDClassListening))
+        return kPIDClassWriting;
+    return 0;
+}
+
+/** \fn MPEGStreamData::CountBatchablePackets(const unsigned char*,int,uint) const
+ *  \brief Returns the number of in sync packets at the start of \p buffer
+ *         that belong to \p pid_class.
+ */
+uint MPEGStreamData::CountBatchablePackets(
+    const unsigned char *buffer, int len, uint pid_class) const
+{
+    uint cnt = 0;
+    for (int pos = 0; pos + int(TSPacket::kSize) <= len;
+         pos += TSPacket::kSize, cnt++)
+    {
+        if (buffer[pos] != SYNC_BYTE)
+            break;
+        const TSPacket *pkt = reinterpret_cast<const TSPacket*>(&buffer[pos]);
+        if (BatchablePIDClass(*pkt) != pid_class)
+            break;
+    }
+    return cnt;
+}
+
+/** \fn MPEGStreamData::ProcessTSPackets(const TSPacket*,uint,uint)
+ *  \brief Batch equivalent of ProcessTSPacket() for \p count packets
+ *         that all belong to the same \p pid_class.
+ */
+void MPEGStreamData::ProcessTSPackets(
+    const TSPacket *tspackets, uint count, uint pid_class)
+{
+    if (pid_class == kPIDClassVideo)
+    {
+        for (uint j = 0; j < _ts_av_listeners.size(); j++)
+            _ts_av_listeners[j]->ProcessVideoTSPackets(tspackets, count);
+    }
+    else if (pid_class == kPIDClassAudio)
+    {
+        for (uint j = 0; j < _ts_av_listeners.size(); j++)
+            _ts_av_listeners[j]->ProcessAudioTSPackets(tspackets, count);
+    }
+    else if (pid_class == kPIDClassWriting)
+    {
+        for (uint j = 0; j < _ts_writing_listeners.size(); j++)
+            _ts_writing_listeners[j]->ProcessTSPackets(tspackets, count);
+    }
+}
+
 int MPEGStreamData::ResyncStream(const unsigned char *buffer, int curr_pos,
                                  int len)
 {
@@ -1759,6 +1903,7 @@ void MPEGStreamData::AddEncryptionTestPID(uint pnum, uint pid, bool isvideo)
     _encryption_pid_to_pnums[pid].push_back(pnum);
     _encryption_pnum_to_pids[pnum].push_back(pid);
     _encryption_pnum_to_status[pnum] = kEncUnknown;
+    _pid_class_dirty = true;
 }
 
 void MPEGStreamData::RemoveEncryptionTestPIDs(uint pnum)
@@ -1803,6 +1948,7 @@ void MPEGStreamData::RemoveEncryptionTestPIDs(uint pnum)
     }
 
     _encryption_pnum_to_pids.remove(pnum);
+    _pid_class_dirty = true;
 }
 
 bool MPEGStreamData::IsEncryptionTestPID(uint pid) const
@@ -1848,6 +1994,7 @@ void MPEGStreamData::ResetDecryptionMonitoringState(void)
     _encryption_pid_to_info.clear();
     _encryption_pid_to_pnums.clear();
     _encryption_pnum_to_pids.clear();
+    _pid_class_dirty = true;
 }
 
 bool MPEGStreamData::IsProgramDecrypted(uint pnum) const
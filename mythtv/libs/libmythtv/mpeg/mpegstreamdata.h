@@ -89,6 +89,16 @@ typedef enum
 } PIDPriority;
 typedef QMap<uint, PIDPriority> pid_map_t;
 
+/// Per PID flags cached in MPEGStreamData::_pid_class for ProcessTSPacket()
+enum
+{
+    kPIDClassEncryptionTest = 0x01,
+    kPIDClassVideo          = 0x02,
+    kPIDClassAudio          = 0x04,
+    kPIDClassWriting        = 0x08,
+    kPIDClassListening      = 0x10,
+};
+
 class MTV_PUBLIC MPEGStreamData : public EITSource
 {
   public:
@@ -96,7 +106,8 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     virtual ~MPEGStreamData();
 
     void SetCaching(bool cacheTables) { _cache_tables = cacheTables; }
-    void SetListeningDisabled(bool lt) { _listening_disabled = lt; }
+    void SetListeningDisabled(bool lt)
+        { _listening_disabled = lt; _pid_class_dirty = true; }
 
     virtual void Reset(void) { Reset(-1); }
     virtual void Reset(int desiredProgram);
@@ -126,21 +137,25 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     // Listening
     virtual void AddListeningPID(
         uint pid, PIDPriority priority = kPIDPriorityNormal)
-        { _pids_listening[pid] = priority; }
+        { _pids_listening[pid] = priority; _pid_class_dirty = true; }
     virtual void AddNotListeningPID(uint pid)
-        { _pids_notlistening[pid] = kPIDPriorityNormal; }
+        { _pids_notlistening[pid] = kPIDPriorityNormal;
+          _pid_class_dirty = true; }
     virtual void AddWritingPID(
         uint pid, PIDPriority priority = kPIDPriorityHigh)
-        { _pids_writing[pid] = priority; }
+        { _pids_writing[pid] = priority; _pid_class_dirty = true; }
     virtual void AddAudioPID(
         uint pid, PIDPriority priority = kPIDPriorityHigh)
-        { _pids_audio[pid] = priority; }
+        { _pids_audio[pid] = priority; _pid_class_dirty = true; }
 
-    virtual void RemoveListeningPID(uint pid) { _pids_listening.remove(pid);  }
+    virtual void RemoveListeningPID(uint pid)
+        { _pids_listening.remove(pid);    _pid_class_dirty = true; }
     virtual void RemoveNotListeningPID(uint pid)
-        { _pids_notlistening.remove(pid); }
-    virtual void RemoveWritingPID(uint pid) { _pids_writing.remove(pid);    }
-    virtual void RemoveAudioPID(uint pid)   { _pids_audio.remove(pid);      }
+        { _pids_notlistening.remove(pid); _pid_class_dirty = true; }
+    virtual void RemoveWritingPID(uint pid)
+        { _pids_writing.remove(pid);      _pid_class_dirty = true; }
+    virtual void RemoveAudioPID(uint pid)
+        { _pids_audio.remove(pid);        _pid_class_dirty = true; }
 
     virtual bool IsListeningPID(uint pid) const;
     virtual bool IsNotListeningPID(uint pid) const;
@@ -300,6 +315,12 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     void ProcessCAT(const ConditionalAccessTable *cat);
     void ProcessPMT(const ProgramMapTable *pmt);
     void ProcessEncryptedPacket(const TSPacket&);
+    void UpdatePIDClassTable(void);
+    uint BatchablePIDClass(const TSPacket &tspacket) const;
+    uint CountBatchablePackets(const unsigned char *buffer, int len,
+                               uint pid_class) const;
+    void ProcessTSPackets(const TSPacket *tspackets, uint count,
+                          uint pid_class);
 
     static int ResyncStream(const unsigned char *buffer, int curr_pos, int len);
 
@@ -334,6 +355,11 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     pid_map_t                 _pids_audio;
     bool                      _listening_disabled;
 
+    /// Flattened copy of the PID sets above, indexed by 13 bit PID.
+    /// Rebuilt by UpdatePIDClassTable() whenever _pid_class_dirty is set.
+    unsigned char             _pid_class[0x2000];
+    bool                      _pid_class_dirty;
+
     // Encryption monitoring
     mutable QMutex            _encryption_lock;
     QMap<uint, CryptInfo>     _encryption_pid_to_info;
@@ -12,7 +12,10 @@ ScanStreamData::ScanStreamData(bool no_default_pid) :
     m_no_default_pid(no_default_pid)
 {
     if (m_no_default_pid)
+    {
         _pids_listening.clear();
+        _pid_class_dirty = true;
+    }
 }
 
 ScanStreamData::~ScanStreamData() { ; }
@@ -50,6 +53,7 @@ void ScanStreamData::Reset(void)
     if (m_no_default_pid)
     {
         _pids_listening.clear();
+        _pid_class_dirty = true;
         return;
     }
 
@@ -0,0 +1,130 @@
+// -*- Mode: c++ -*-
+
+#include "mythconfig.h"
+#include "startcode.h"
+
+#if ARCH_X86 && defined(__GNUC__)
+#define USE_X86_STARTCODE 1
+#include <immintrin.h>
+extern "C" {
+#include "libavutil/cpu.h"
+}
+#endif
+
+static inline uint32_t read_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] <<  8) |  (uint32_t)p[3];
+}
+
+/// Returns the first q in [p, end) with q[0..2] == 00 00 01, or end.
+static const uint8_t *scan_c(const uint8_t *p, const uint8_t *end)
+{
+    // q points at the byte that would be the 01 of a start code,
+    // the same skipping avpriv_find_start_code() does.
+    const uint8_t *q = p + 2;
+    while (q < end)
+    {
+        if (*q > 1)
+            q += 3;
+        else if (q[-1])
+            q += 2;
+        else if (q[-2] | (*q - 1))
+            q++;
+        else
+            return q - 2;
+    }
+    return end;
+}
+
+#ifdef USE_X86_STARTCODE
+__attribute__((target("sse2")))
+static const uint8_t *scan_sse2(const uint8_t *p, const uint8_t *end)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi8(1);
+
+    // compare 16 candidate positions at once, the loads at p + 1
+    // and p + 2 need two bytes past the block.
+    while (p + 18 <= end)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + 1));
+        __m128i c = _mm_loadu_si128((const __m128i*)(p + 2));
+        __m128i m = _mm_and_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)),
+            _mm_cmpeq_epi8(c, one));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return scan_c(p, end);
+}
+
+__attribute__((target("avx2")))
+static const uint8_t *scan_avx2(const uint8_t *p, const uint8_t *end)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one  = _mm256_set1_epi8(1);
+
+    while (p + 34 <= end)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(p));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(p + 1));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(p + 2));
+        __m256i m = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, zero),
+                             _mm256_cmpeq_epi8(b, zero)),
+            _mm256_cmpeq_epi8(c, one));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return scan_sse2(p, end);
+}
+#endif // USE_X86_STARTCODE
+
+typedef const uint8_t *(*scan_func_t)(const uint8_t*, const uint8_t*);
+
+static scan_func_t get_scan_func(void)
+{
+#ifdef USE_X86_STARTCODE
+    int flags = av_get_cpu_flags();
+    if (flags & AV_CPU_FLAG_AVX2)
+        return scan_avx2;
+    if (flags & AV_CPU_FLAG_SSE2)
+        return scan_sse2;
+#endif
+    return scan_c;
+}
+
+const uint8_t *myth_find_start_code(
+    const uint8_t *p, const uint8_t *end, uint32_t *state, bool useSIMD)
+{
+    static scan_func_t scan_simd = get_scan_func();
+
+    if (p >= end)
+        return end;
+
+    // Finish any start code that began in the previous buffer
+    for (int i = 0; i < 3; i++)
+    {
+        uint32_t tmp = *state << 8;
+        *state = tmp + *(p++);
+        if (tmp == 0x100 || p == end)
+            return p;
+    }
+
+    // A start code may begin in the three bytes consumed above
+    const uint8_t *q = (useSIMD) ? scan_simd(p - 3, end) : scan_c(p - 3, end);
+
+    const uint8_t *ret = end;
+    if (q < end && end - q > 4)
+        ret = q + 4;
+
+    *state = read_be32(ret - 4);
+
+    return ret;
+}
@@ -0,0 +1,28 @@
+// -*- Mode: c++ -*-
+#ifndef STARTCODE_H_
+#define STARTCODE_H_
+
+// POSIX
+#include <stdint.h>  // uint8_t, uint32_t
+
+#include "mythtvexp.h"
+
+/** \brief Finds the next MPEG-2/H.264 start code (00 00 01 xx).
+ *
+ *  Drop in replacement for FFmpeg's avpriv_find_start_code(); it returns
+ *  the same pointer and leaves the same value in \p state, so it can be
+ *  called repeatedly on consecutive buffers. The search itself uses
+ *  SSE2 or AVX2 when the CPU has them and a scalar loop otherwise.
+ *
+ *  \param p       Start of the data to search.
+ *  \param end     End of the data to search.
+ *  \param state   Last four bytes seen, 0xffffffff for a new stream.
+ *                 On return holds the start code found, if any.
+ *  \param useSIMD If false the scalar search is used.
+ *  \return Pointer just past the start code, or \p end if none was found.
+ */
+MTV_PUBLIC const uint8_t *myth_find_start_code(
+    const uint8_t *p, const uint8_t *end, uint32_t *state,
+    bool useSIMD = true);
+
+#endif // STARTCODE_H_
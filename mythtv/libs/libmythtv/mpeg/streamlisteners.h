@@ -64,6 +64,16 @@ class TSPacketListener
   public:
     virtual bool ProcessTSPacket(const TSPacket& tspacket) = 0;
 
+    /// Called with \p count packets stored back to back in memory,
+    /// by default they are passed on to ProcessTSPacket() one by one.
+    virtual bool ProcessTSPackets(const TSPacket *tspackets, uint count)
+    {
+        bool ok = true;
+        for (uint i = 0; i < count; i++)
+            ok &= ProcessTSPacket(tspackets[i]);
+        return ok;
+    }
+
   protected:
     virtual ~TSPacketListener() { }
 };
@@ -74,6 +84,25 @@ class TSPacketListenerAV
     virtual bool ProcessVideoTSPacket(const TSPacket& tspacket) = 0;
     virtual bool ProcessAudioTSPacket(const TSPacket& tspacket) = 0;
 
+    /// Called with \p count video packets stored back to back in memory,
+    /// by default they are passed on to ProcessVideoTSPacket() one by one.
+    virtual bool ProcessVideoTSPackets(const TSPacket *tspackets, uint count)
+    {
+        bool ok = true;
+        for (uint i = 0; i < count; i++)
+            ok &= ProcessVideoTSPacket(tspackets[i]);
+        return ok;
+    }
+    /// Called with \p count audio packets stored back to back in memory,
+    /// by default they are passed on to ProcessAudioTSPacket() one by one.
+    virtual bool ProcessAudioTSPackets(const TSPacket *tspackets, uint count)
+    {
+        bool ok = true;
+        for (uint i = 0; i < count; i++)
+            ok &= ProcessAudioTSPacket(tspackets[i]);
+        return ok;
+    }
+
   protected:
     virtual ~TSPacketListenerAV() { }
 };
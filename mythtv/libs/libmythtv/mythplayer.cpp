@@ -4519,6 +4519,9 @@ char *MythPlayer::GetScreenGrab(int secondsin, int &bufflen,
  *
  *   Warning: Don't use this on something you're playing!
  *
+ *   It can be called again for other frames of the same file, which
+ *   is only opened the first time.
+ *
  *  \param frameNum  [in]  Frame number to capture
  *  \param absolute  [in]  If False, make sure we aren't in cutlist or Comm brk
  *  \param bufflen   [out] Size of buffer returned in bytes
@@ -4544,7 +4547,8 @@ char *MythPlayer::GetScreenGrabAtFrame(uint64_t frameNum, bool absolute,
     vw = vh = 0;
     ar = 0;
 
-    if (OpenFile(0) < 0)
+    // Further grabs reuse the decoder and video output of the first
+    if ((!decoder || IsErrored()) && OpenFile(0) < 0)
     {
         LOG(VB_GENERAL, LOG_ERR, LOC + "Could not open file for preview.");
         return NULL;
@@ -4567,7 +4571,7 @@ char *MythPlayer::GetScreenGrabAtFrame(uint64_t frameNum, bool absolute,
         return (char*) outputbuf;
     }
 
-    if (!InitVideo())
+    if (!videoOutput && !InitVideo())
     {
         LOG(VB_GENERAL, LOG_ERR, LOC +
             "Unable to initialize video for screen grab.");
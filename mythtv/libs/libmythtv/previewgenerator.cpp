@@ -119,10 +119,12 @@ void PreviewGenerator::AttachSignals(QObject *obj)
     m_listener = obj;
 }
 
-/** \fn PreviewGenerator::RunReal(void)
+/** \fn PreviewGenerator::RunReal(PlayerContext*)
  *  \brief This call creates a preview without starting a new thread.
+ *  \param ctx A player already open on the recording, from OpenPlayer(),
+ *             or NULL to open one just for this preview.
  */
-bool PreviewGenerator::RunReal(void)
+bool PreviewGenerator::RunReal(PlayerContext *ctx)
 {
     QString msg;
     QTime tm = QTime::currentTime();
@@ -142,7 +144,7 @@ bool PreviewGenerator::RunReal(void)
                     "because mode was invalid 0x%2")
             .arg(m_pathname).arg((int)m_mode,0,16));
     }
-    else if (!!(m_mode & kLocal) && LocalPreviewRun())
+    else if (!!(m_mode & kLocal) && LocalPreviewRun(ctx))
     {
         ok = true;
         msg = QString("Generated on %1 in %2 seconds, starting at %3")
@@ -624,7 +626,7 @@ bool PreviewGenerator::SavePreview(const QString &filename,
     return false;
 }
 
-bool PreviewGenerator::LocalPreviewRun(void)
+bool PreviewGenerator::LocalPreviewRun(PlayerContext *ctx)
 {
     m_programInfo.MarkAsInUse(true, kPreviewGeneratorInUseID);
     m_programInfo.SetIgnoreProgStart(true);
@@ -686,10 +688,12 @@ bool PreviewGenerator::LocalPreviewRun(void)
     }
 
     width = height = sz = 0;
-    unsigned char *data = (unsigned char*)
+    unsigned char *data = (unsigned char*) ((ctx) ?
+        GrabFrame(ctx, m_pathname, captime, m_timeInSeconds,
+                  sz, width, height, aspect) :
         GetScreenGrab(m_programInfo, m_pathname,
                       captime, m_timeInSeconds,
-                      sz, width, height, aspect);
+                      sz, width, height, aspect));
 
     QString outname = CreateAccessibleFilename(m_pathname, m_outFileName);
 
@@ -796,16 +800,34 @@ char *PreviewGenerator::GetScreenGrab(
     int &bufferlen,
     int &video_width, int &video_height, float &video_aspect)
 {
-    (void) pginfo;
-    (void) filename;
-    (void) seektime;
-    (void) time_in_secs;
-    (void) bufferlen;
-    (void) video_width;
-    (void) video_height;
-    char *retbuf = NULL;
     bufferlen = 0;
 
+    PlayerContext *ctx = OpenPlayer(pginfo, filename);
+    if (!ctx)
+        return NULL;
+
+    char *retbuf = GrabFrame(ctx, filename, seektime, time_in_secs,
+                             bufferlen, video_width, video_height,
+                             video_aspect);
+
+    delete ctx;
+
+    return retbuf;
+}
+
+/**
+ *  \brief Returns a player for GrabFrame(), which the caller deletes.
+ *
+ *  The player opens the file and its decoder on the first grab, and
+ *  keeps them open for any further grabs from the same file.
+ *
+ *  \param pginfo       Recording to grab from.
+ *  \param filename     File containing recording.
+ *  \return NULL if the file could not be opened.
+ */
+PlayerContext *PreviewGenerator::OpenPlayer(
+    const ProgramInfo &pginfo, const QString &filename)
+{
     if (!MSqlQuery::testDBConnection())
     {
         LOG(VB_GENERAL, LOG_ERR, LOC + "Previewer could not connect to DB.");
@@ -841,6 +863,34 @@ char *PreviewGenerator::GetScreenGrab(
     ctx->SetPlayer(new MythPlayer((PlayerFlags)(kAudioMuted | kVideoIsNull | kNoITV)));
     ctx->player->SetPlayerInfo(NULL, NULL, ctx);
 
+    return ctx;
+}
+
+/**
+ *  \brief Returns a AV_PIX_FMT_RGBA32 buffer containg a frame from the
+ *         video a player from OpenPlayer() is open on.
+ *
+ *  \param ctx          Player to grab with.
+ *  \param filename     File the player is open on, for logging.
+ *  \param seektime     Seconds or frames into the video to seek before
+ *                      capturing a frame.
+ *  \param time_in_secs if true time is in seconds, otherwise it is in frames.
+ *  \param bufferlen    Returns size of buffer returned (in bytes).
+ *  \param video_width  Returns width of frame grabbed.
+ *  \param video_height Returns height of frame grabbed.
+ *  \param video_aspect Returns aspect ratio of frame grabbed.
+ *  \return Buffer allocated with new containing frame in RGBA32 format if
+ *          successful, NULL otherwise.
+ */
+char *PreviewGenerator::GrabFrame(
+    PlayerContext *ctx, const QString &filename,
+    long long seektime, bool time_in_secs,
+    int &bufferlen,
+    int &video_width, int &video_height, float &video_aspect)
+{
+    char *retbuf = NULL;
+    bufferlen = 0;
+
     if (time_in_secs)
         retbuf = ctx->player->GetScreenGrab(seektime, bufferlen,
                                     video_width, video_height, video_aspect);
@@ -849,8 +899,6 @@ char *PreviewGenerator::GetScreenGrab(
             seektime, true, bufferlen,
             video_width, video_height, video_aspect);
 
-    delete ctx;
-
     if (retbuf)
     {
         LOG(VB_GENERAL, LOG_INFO, LOC +
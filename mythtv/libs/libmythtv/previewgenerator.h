@@ -16,6 +16,7 @@
 #include "mythdate.h"
 
 class PreviewGenerator;
+class PlayerContext;
 class QByteArray;
 class MythSocket;
 class QObject;
@@ -32,6 +33,7 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
                               const QSize   &previewSize,
                               const QString &infile,
                               const QString &outfile);
+    friend class PreviewGeneratorBatch;
 
     Q_OBJECT
 
@@ -61,6 +63,8 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
     void SetOutputSize(const QSize &size) { m_outSize = size; }
 
     QString GetToken(void) const { return m_token; }
+    QString GetPathname(void) const { return m_pathname; }
+    bool IsLocal(void) const;
 
     void run(void); // MThread
     bool Run(void);
@@ -75,10 +79,9 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
     void TeardownAll(void);
 
     bool RemotePreviewRun(void);
-    bool LocalPreviewRun(void);
-    bool IsLocal(void) const;
+    bool LocalPreviewRun(PlayerContext *ctx = NULL);
 
-    bool RunReal(void);
+    bool RunReal(PlayerContext *ctx = NULL);
 
     static char *GetScreenGrab(const ProgramInfo &pginfo,
                                const QString     &filename,
@@ -88,6 +91,16 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
                                int               &video_width,
                                int               &video_height,
                                float             &video_aspect);
+    static PlayerContext *OpenPlayer(const ProgramInfo &pginfo,
+                                     const QString     &filename);
+    static char *GrabFrame(PlayerContext     *ctx,
+                           const QString     &filename,
+                           long long          seektime,
+                           bool               time_in_secs,
+                           int               &bufferlen,
+                           int               &video_width,
+                           int               &video_height,
+                           float             &video_aspect);
 
     static bool SavePreview(const QString &filename,
                             const unsigned char *data,
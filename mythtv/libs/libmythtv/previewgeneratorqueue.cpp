@@ -14,6 +14,7 @@ using std::max;
 #include "mythlogging.h"
 #include "mythdirs.h"
 #include "mthread.h"
+#include "mthreadpool.h"
 
 // libmyth
 #include "mythcontext.h"
@@ -21,9 +22,52 @@ using std::max;
 
 // libmythtv
 #include "previewgenerator.h"
+#include "playercontext.h"
 
 #define LOC QString("PreviewQueue: ")
 
+/** \class PreviewGeneratorBatch
+ *  \brief QRunnable class for making previews of one file in process
+ *
+ *  The PreviewGeneratorBatch class opens the file once for all of its
+ *  previews, and for any more that are queued for the same file by the
+ *  time it is done with them.
+ */
+class PreviewGeneratorBatch : public QRunnable
+{
+  public:
+    PreviewGeneratorBatch(PreviewGeneratorQueue *queue,
+                          const QList<PreviewGenerator*> &batch)
+      : m_queue(queue), m_batch(batch) {}
+
+    void run(void)
+    {
+        // The generators are deleted once their result is in
+        ProgramInfo pginfo(m_batch.front()->m_programInfo);
+        QString pathname = m_batch.front()->GetPathname();
+
+        PlayerContext *ctx = PreviewGenerator::OpenPlayer(pginfo, pathname);
+
+        while (!m_batch.isEmpty())
+        {
+            QList<PreviewGenerator*>::iterator it = m_batch.begin();
+            for (; it != m_batch.end(); ++it)
+                (*it)->RunReal(ctx);
+
+            m_batch = m_queue->TakeBatch(pathname);
+        }
+
+        delete ctx;
+
+        QCoreApplication::postEvent(
+            m_queue, new MythEvent("PREVIEW_BATCH_DONE"));
+    }
+
+  private:
+    PreviewGeneratorQueue    *m_queue;
+    QList<PreviewGenerator*>  m_batch;
+};
+
 PreviewGeneratorQueue *PreviewGeneratorQueue::s_pgq = NULL;
 
 /**
@@ -85,13 +129,19 @@ PreviewGeneratorQueue::PreviewGeneratorQueue(
     uint maxAttempts, uint minBlockSeconds) :
     MThread("PreviewGeneratorQueue"),
     m_mode(mode),
-    m_running(0), m_maxThreads(2),
+    m_running(0), m_maxThreads(2), m_pool(NULL),
     m_maxAttempts(maxAttempts), m_minBlockSeconds(minBlockSeconds)
 {
     if (PreviewGenerator::kLocal & mode)
     {
         int idealThreads = QThread::idealThreadCount();
         m_maxThreads = (idealThreads >= 1) ? idealThreads * 2 : 2;
+
+        if (gCoreContext->GetNumSetting("PreviewGeneratorInProcess", 0))
+        {
+            m_pool = new MThreadPool("PreviewGenerators");
+            m_pool->setMaxThreadCount(m_maxThreads);
+        }
     }
 
     moveToThread(qthread());
@@ -108,6 +158,17 @@ PreviewGeneratorQueue::PreviewGeneratorQueue(
  */
 PreviewGeneratorQueue::~PreviewGeneratorQueue()
 {
+    // let the running batches finish, without starting any more
+    if (m_pool)
+    {
+        m_lock.lock();
+        m_queue.clear();
+        m_lock.unlock();
+        m_pool->waitForDone();
+        delete m_pool;
+        m_pool = NULL;
+    }
+
     // disconnect preview generators
     QMutexLocker locker(&m_lock);
     PreviewMap::iterator it = m_previewMap.begin();
@@ -209,7 +270,8 @@ void PreviewGeneratorQueue::RemoveListener(QObject *listener)
  * The event handler running on the preview generation thread.
  *
  * \param[in] e The received message.  This should be one of the
- * messages GET_PREVIEW, PREVIEW_SUCCESS, or PREVIEW_FAILED.
+ * messages GET_PREVIEW, PREVIEW_SUCCESS, PREVIEW_FAILED, or
+ * PREVIEW_BATCH_DONE.
  *
  * \warning This function should only be called from the preview
  * generation thread.
@@ -325,6 +387,20 @@ bool PreviewGeneratorQueue::event(QEvent *e)
                 (*it).tokens.clear();
             }
 
+            // batches stop running with PREVIEW_BATCH_DONE instead
+            if (!(*it).inBatch)
+                m_running = (m_running > 0) ? m_running - 1 : 0;
+            (*it).inBatch = false;
+        }
+
+        UpdatePreviewGeneratorThreads();
+
+        return true;
+    }
+    else if (me->Message() == "PREVIEW_BATCH_DONE")
+    {
+        {
+            QMutexLocker locker(&m_lock);
             m_running = (m_running > 0) ? m_running - 1 : 0;
         }
 
@@ -639,22 +715,76 @@ void PreviewGeneratorQueue::IncPreviewGeneratorPriority(
 /**
  * As long as there are items in the queue, make sure we're running
  * the maximum allowed number of preview generators.
+ *
+ * The most recently requested previews, which are those of the items
+ * on screen, are started first. Previews of local files are made in
+ * batches by the pool, each batch taking every preview queued for its
+ * file.
  */
 void PreviewGeneratorQueue::UpdatePreviewGeneratorThreads(void)
 {
     QMutexLocker locker(&m_lock);
     QStringList &q = m_queue;
-    if (!q.empty() && (m_running < m_maxThreads))
+    while (!q.empty() && (m_running < m_maxThreads))
     {
         QString fn = q.back();
         q.pop_back();
         PreviewMap::iterator it = m_previewMap.find(fn);
-        if (it != m_previewMap.end() && (*it).gen && !(*it).genStarted)
+        if (it == m_previewMap.end() || !(*it).gen || (*it).genStarted)
+            continue;
+
+        m_running++;
+        (*it).genStarted = true;
+
+        if (m_pool && (*it).gen->IsLocal())
         {
-            m_running++;
-            (*it).gen->start();
-            (*it).genStarted = true;
+            (*it).inBatch = true;
+            QList<PreviewGenerator*> batch;
+            batch.push_back((*it).gen);
+            AddToBatch((*it).gen->GetPathname(), batch);
+            m_pool->start(new PreviewGeneratorBatch(this, batch),
+                          "PreviewGeneratorBatch");
+            continue;
         }
+
+        (*it).gen->start();
+    }
+}
+
+/**
+ * Takes the previews of pathname that are still queued, for a batch
+ * that is done with its previews of that file.
+ */
+QList<PreviewGenerator*> PreviewGeneratorQueue::TakeBatch(
+    const QString &pathname)
+{
+    QMutexLocker locker(&m_lock);
+    QList<PreviewGenerator*> batch;
+    AddToBatch(pathname, batch);
+    return batch;
+}
+
+/**
+ * Moves queued previews of pathname to batch, most recently requested
+ * first. They run in the batch's thread, so they don't count against
+ * m_maxThreads. m_lock must be held.
+ */
+void PreviewGeneratorQueue::AddToBatch(
+    const QString &pathname, QList<PreviewGenerator*> &batch)
+{
+    for (int i = m_queue.size() - 1; i >= 0; --i)
+    {
+        PreviewMap::iterator it = m_previewMap.find(m_queue[i]);
+        if (it == m_previewMap.end() || !(*it).gen || (*it).genStarted ||
+            (*it).gen->GetPathname() != pathname)
+        {
+            continue;
+        }
+
+        (*it).genStarted = true;
+        (*it).inBatch = true;
+        batch.push_back((*it).gen);
+        m_queue.removeAt(i);
     }
 }
 
@@ -13,6 +13,7 @@
 #include "mthread.h"
 
 class ProgramInfo;
+class MThreadPool;
 class QSize;
 
 /**
@@ -23,7 +24,7 @@ class PreviewGenState
 {
   public:
     PreviewGenState() :
-        gen(NULL), genStarted(false),
+        gen(NULL), genStarted(false), inBatch(false),
         attempts(0), lastBlockTime(0) {}
 
     /// A pointer to the generator that this state object describes.
@@ -32,6 +33,10 @@ class PreviewGenState
     /// The preview generator for this file is currently running.
     bool              genStarted;
 
+    /// The preview generator is run by a batch, which is what counts
+    /// as running.
+    bool              inBatch;
+
     /// How many attempts have been made to generate a preview for
     /// this file.
     uint              attempts;
@@ -65,11 +70,19 @@ typedef QMap<QString,PreviewGenState> PreviewMap;
  * keys which are the used internally for indexing.  Multiple caller
  * tokens can map to the same internal key. (I.E. A preview for a
  * program was requested from two different parts of the code.)
+ *
+ * If the PreviewGeneratorInProcess setting is turned on, previews of
+ * local files are made inside this process by a pool of threads
+ * instead of a mythpreviewgen run for each one. The previews queued
+ * for the same file are made in a batch, which keeps the file and its
+ * decoder open from one to the next.
  */
 class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
 {
     Q_OBJECT
 
+    friend class PreviewGeneratorBatch;
+
   public:
     static void CreatePreviewGeneratorQueue(
         PreviewGenerator::Mode mode,
@@ -112,6 +125,9 @@ class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
     void SetPreviewGenerator(const QString &key, PreviewGenerator *g);
     void IncPreviewGeneratorPriority(const QString &key, QString token);
     void UpdatePreviewGeneratorThreads(void);
+    QList<PreviewGenerator*> TakeBatch(const QString &pathname);
+    void AddToBatch(const QString &pathname,
+                    QList<PreviewGenerator*> &batch);
     bool IsGeneratingPreview(const QString &key) const;
     uint IncPreviewGeneratorAttempts(const QString &key);
     void ClearPreviewGeneratorAttempts(const QString &key);
@@ -144,11 +160,14 @@ class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
     /// The queue of previews to be generated. The next item to be
     /// processed is the one at the *back* of the queue.
     QStringList            m_queue;
-    /// The number of threads currently generating previews.
+    /// The number of threads currently generating previews, a batch
+    /// counting as one.
     uint                   m_running;
     /// The maximum number of threads that may concurrently generate
     /// previews.
     uint                   m_maxThreads;
+    /// Makes the previews of local files in this process, if not NULL.
+    MThreadPool           *m_pool;
     /// How many times total will the code attempt to generate a
     /// preview for a specific file, before giving up and ignoring all
     /// future requests.
@@ -14,7 +14,9 @@ using namespace std;
 #include "channelutil.h"
 #include "mythdb.h"
 #include "mythlogging.h"
+#include "mythtimer.h"
 #include "dvbdescriptors.h"
+#include "mthreadpool.h"
 
 #define LOC      QString("ProgramData: ")
 
@@ -324,6 +326,56 @@ uint DBEvent::UpdateDB(
     }
 }
 
+// Columns read by program_from_query().
+static const char *program_select_columns =
+    "       title,          subtitle,      description, "
+    "       category,       category_type, "
+    "       starttime,      endtime, "
+    "       subtitletypes+0,audioprop+0,   videoprop+0, "
+    "       seriesid,       programid, "
+    "       partnumber,     parttotal, "
+    "       syndicatedepisodenumber, "
+    "       airdate,        originalairdate, "
+    "       previouslyshown,listingsource, "
+    "       stars+0, "
+    "       season,         episode,       totalepisodes, "
+    "       inetref ";
+
+static DBEvent program_from_query(const MSqlQuery &query)
+{
+    ProgramInfo::CategoryType category_type =
+        string_to_myth_category_type(query.value(4).toString());
+
+    DBEvent prog(
+        query.value(0).toString(),
+        query.value(1).toString(),
+        query.value(2).toString(),
+        query.value(3).toString(),
+        category_type,
+        MythDate::as_utc(query.value(5).toDateTime()),
+        MythDate::as_utc(query.value(6).toDateTime()),
+        query.value(7).toUInt(),
+        query.value(8).toUInt(),
+        query.value(9).toUInt(),
+        query.value(19).toDouble(),
+        query.value(10).toString(),
+        query.value(11).toString(),
+        query.value(18).toUInt(),
+        query.value(20).toUInt(),  // Season
+        query.value(21).toUInt(),  // Episode
+        query.value(22).toUInt()); // Total Episodes
+
+    prog.inetref    = query.value(23).toString();
+    prog.partnumber = query.value(12).toUInt();
+    prog.parttotal  = query.value(13).toUInt();
+    prog.syndicatedepisodenumber = query.value(14).toString();
+    prog.airdate    = query.value(15).toUInt();
+    prog.originalairdate  = query.value(16).toDate();
+    prog.previouslyshown  = query.value(17).toBool();
+
+    return prog;
+}
+
 // Get all programs in the database that overlap with our new program.
 // We check for three ways in which we can have an overlap:
 // (1)   Start of old program is inside our new program:
@@ -351,25 +403,15 @@ uint DBEvent::GetOverlappingPrograms(
     MSqlQuery &query, uint chanid, vector<DBEvent> &programs) const
 {
     uint count = 0;
-    query.prepare(
-        "SELECT title,          subtitle,      description, "
-        "       category,       category_type, "
-        "       starttime,      endtime, "
-        "       subtitletypes+0,audioprop+0,   videoprop+0, "
-        "       seriesid,       programid, "
-        "       partnumber,     parttotal, "
-        "       syndicatedepisodenumber, "
-        "       airdate,        originalairdate, "
-        "       previouslyshown,listingsource, "
-        "       stars+0, "
-        "       season,         episode,       totalepisodes, "
-        "       inetref "
+    query.prepare(QString(
+        "SELECT %1"
         "FROM program "
         "WHERE chanid   = :CHANID AND "
         "      manualid = 0       AND "
         "      ( ( starttime >= :STIME1 AND starttime <  :ETIME1 ) OR "
         "        ( endtime   >  :STIME2 AND endtime   <= :ETIME2 ) OR "
-        "        ( starttime <  :STIME3 AND endtime   >  :ETIME3 ) )");
+        "        ( starttime <  :STIME3 AND endtime   >  :ETIME3 ) )")
+        .arg(program_select_columns));
     query.bindValue(":CHANID", chanid);
     query.bindValue(":STIME1", starttime);
     query.bindValue(":ETIME1", endtime);
@@ -386,37 +428,7 @@ uint DBEvent::GetOverlappingPrograms(
 
     while (query.next())
     {
-        ProgramInfo::CategoryType category_type =
-            string_to_myth_category_type(query.value(4).toString());
-
-        DBEvent prog(
-            query.value(0).toString(),
-            query.value(1).toString(),
-            query.value(2).toString(),
-            query.value(3).toString(),
-            category_type,
-            MythDate::as_utc(query.value(5).toDateTime()),
-            MythDate::as_utc(query.value(6).toDateTime()),
-            query.value(7).toUInt(),
-            query.value(8).toUInt(),
-            query.value(9).toUInt(),
-            query.value(19).toDouble(),
-            query.value(10).toString(),
-            query.value(11).toString(),
-            query.value(18).toUInt(),
-            query.value(20).toUInt(),  // Season
-            query.value(21).toUInt(),  // Episode
-            query.value(22).toUInt()); // Total Episodes
-
-        prog.inetref    = query.value(23).toString();
-        prog.partnumber = query.value(12).toUInt();
-        prog.parttotal  = query.value(13).toUInt();
-        prog.syndicatedepisodenumber = query.value(14).toString();
-        prog.airdate    = query.value(15).toUInt();
-        prog.originalairdate  = query.value(16).toDate();
-        prog.previouslyshown  = query.value(17).toBool();
-
-        programs.push_back(prog);
+        programs.push_back(program_from_query(query));
         count++;
     }
 
@@ -611,86 +623,82 @@ uint DBEvent::UpdateDB(
     return UpdateDB(q, chanid, p[match]);
 }
 
-// Update matched item with current data.
-//
-uint DBEvent::UpdateDB(
-    MSqlQuery &query, uint chanid, const DBEvent &match)  const
+// Merge the fields of the matched program "match" (from the database)
+// with our new program. Times come from our new program; the stars
+// rating is never changed by an update.
+DBEvent DBEvent::MergeMatch(const DBEvent &match) const
 {
-    QString  ltitle     = title;
-    QString  lsubtitle  = subtitle;
-    QString  ldesc      = description;
-    QString  lcategory  = category;
-    uint16_t lairdate   = airdate;
-    QString  lprogramId = programId;
-    QString  lseriesId  = seriesId;
-    QString  linetref   = inetref;
-    QDate loriginalairdate = originalairdate;
+    DBEvent merged(listingsource);
+    merged = *this;
+    delete merged.credits;
+    merged.credits = NULL;
 
-    if (match.title.length() >= ltitle.length())
-        ltitle = match.title;
+    if (match.title.length() >= merged.title.length())
+        merged.title = match.title;
 
-    if (match.subtitle.length() >= lsubtitle.length())
-        lsubtitle = match.subtitle;
+    if (match.subtitle.length() >= merged.subtitle.length())
+        merged.subtitle = match.subtitle;
 
-    if (match.description.length() >= ldesc.length())
-        ldesc = match.description;
+    if (match.description.length() >= merged.description.length())
+        merged.description = match.description;
 
-    if (lcategory.isEmpty() && !match.category.isEmpty())
-        lcategory = match.category;
+    if (merged.category.isEmpty() && !match.category.isEmpty())
+        merged.category = match.category;
 
-    if (!lairdate && !match.airdate)
-        lairdate = match.airdate;
+    if (!merged.airdate && !match.airdate)
+        merged.airdate = match.airdate;
 
-    if (!loriginalairdate.isValid() && match.originalairdate.isValid())
-        loriginalairdate = match.originalairdate;
+    if (!merged.originalairdate.isValid() && match.originalairdate.isValid())
+        merged.originalairdate = match.originalairdate;
 
-    if (lprogramId.isEmpty() && !match.programId.isEmpty())
-        lprogramId = match.programId;
+    if (merged.programId.isEmpty() && !match.programId.isEmpty())
+        merged.programId = match.programId;
 
-    if (lseriesId.isEmpty() && !match.seriesId.isEmpty())
-        lseriesId = match.seriesId;
+    if (merged.seriesId.isEmpty() && !match.seriesId.isEmpty())
+        merged.seriesId = match.seriesId;
 
-    if (linetref.isEmpty() && !match.inetref.isEmpty())
-        linetref= match.inetref;
+    if (merged.inetref.isEmpty() && !match.inetref.isEmpty())
+        merged.inetref = match.inetref;
 
-    ProgramInfo::CategoryType tmp = categoryType;
     if (!categoryType && match.categoryType)
-        tmp = match.categoryType;
+        merged.categoryType = match.categoryType;
 
-    QString lcattype = myth_category_type_to_string(tmp);
+    merged.subtitleType = subtitleType | match.subtitleType;
+    merged.audioProps   = audioProps   | match.audioProps;
+    merged.videoProps   = videoProps   | match.videoProps;
 
-    unsigned char lsubtype = subtitleType | match.subtitleType;
-    unsigned char laudio   = audioProps   | match.audioProps;
-    unsigned char lvideo   = videoProps   | match.videoProps;
-
-    uint lseason = match.season;
-    uint lepisode = match.episode;
-    uint lepisodeTotal = match.totalepisodes;
-
-    if (season || episode || totalepisodes)
+    if (!season && !episode && !totalepisodes)
     {
-        lseason = season;
-        lepisode = episode;
-        lepisodeTotal = totalepisodes;
+        merged.season        = match.season;
+        merged.episode       = match.episode;
+        merged.totalepisodes = match.totalepisodes;
     }
 
-    uint lpartnumber = match.partnumber;
-    uint lparttotal = match.parttotal;
-
-    if (partnumber || parttotal)
+    if (!partnumber && !parttotal)
     {
-        lpartnumber = partnumber;
-        lparttotal  = parttotal;
+        merged.partnumber = match.partnumber;
+        merged.parttotal  = match.parttotal;
     }
 
-    bool lpreviouslyshown = previouslyshown | match.previouslyshown;
+    merged.previouslyshown = previouslyshown | match.previouslyshown;
 
-    uint32_t llistingsource = listingsource | match.listingsource;
+    merged.listingsource = listingsource | match.listingsource;
 
-    QString lsyndicatedepisodenumber = syndicatedepisodenumber;
-    if (lsyndicatedepisodenumber.isEmpty() &&
+    if (merged.syndicatedepisodenumber.isEmpty() &&
         !match.syndicatedepisodenumber.isEmpty())
-        lsyndicatedepisodenumber = match.syndicatedepisodenumber;
+        merged.syndicatedepisodenumber = match.syndicatedepisodenumber;
+
+    merged.stars = match.stars;
+
+    return merged;
+}
+
+// Update matched item with current data.
+//
+uint DBEvent::UpdateDB(
+    MSqlQuery &query, uint chanid, const DBEvent &match)  const
+{
+    DBEvent m = MergeMatch(match);
 
     query.prepare(
         "UPDATE program "
@@ -715,33 +723,33 @@ uint DBEvent::UpdateDB(
 
     query.bindValue(":CHANID",      chanid);
     query.bindValue(":OLDSTART",    match.starttime);
-    query.bindValue(":TITLE",       denullify(ltitle));
-    query.bindValue(":SUBTITLE",    denullify(lsubtitle));
-    query.bindValue(":DESC",        denullify(ldesc));
-    query.bindValue(":CATEGORY",    denullify(lcategory));
-    query.bindValue(":CATTYPE",     lcattype);
+    query.bindValue(":TITLE",       denullify(m.title));
+    query.bindValue(":SUBTITLE",    denullify(m.subtitle));
+    query.bindValue(":DESC",        denullify(m.description));
+    query.bindValue(":CATEGORY",    denullify(m.category));
+    query.bindValue(":CATTYPE",     myth_category_type_to_string(m.categoryType));
     query.bindValue(":STARTTIME",   starttime);
     query.bindValue(":ENDTIME",     endtime);
-    query.bindValue(":CC",          (lsubtype & SUB_HARDHEAR) ? true : false);
-    query.bindValue(":HASSUBTITLES",(lsubtype & SUB_NORMAL)   ? true : false);
-    query.bindValue(":STEREO",      (laudio   & AUD_STEREO)   ? true : false);
-    query.bindValue(":HDTV",        (lvideo   & VID_HDTV)     ? true : false);
-    query.bindValue(":SUBTYPE",     lsubtype);
-    query.bindValue(":AUDIOPROP",   laudio);
-    query.bindValue(":VIDEOPROP",   lvideo);
-    query.bindValue(":SEASON",      lseason);
-    query.bindValue(":EPISODE",     lepisode);
-    query.bindValue(":TOTALEPS",    lepisodeTotal);
-    query.bindValue(":PARTNO",      lpartnumber);
-    query.bindValue(":PARTTOTAL",   lparttotal);
-    query.bindValue(":SYNDICATENO", denullify(lsyndicatedepisodenumber));
-    query.bindValue(":AIRDATE",     lairdate ? QString::number(lairdate) : "0000");
-    query.bindValue(":ORIGAIRDATE", loriginalairdate);
-    query.bindValue(":LSOURCE",     llistingsource);
-    query.bindValue(":SERIESID",    denullify(lseriesId));
-    query.bindValue(":PROGRAMID",   denullify(lprogramId));
-    query.bindValue(":PREVSHOWN",   lpreviouslyshown);
-    query.bindValue(":INETREF",     linetref);
+    query.bindValue(":CC",          (m.subtitleType & SUB_HARDHEAR) ? true : false);
+    query.bindValue(":HASSUBTITLES",(m.subtitleType & SUB_NORMAL)   ? true : false);
+    query.bindValue(":STEREO",      (m.audioProps   & AUD_STEREO)   ? true : false);
+    query.bindValue(":HDTV",        (m.videoProps   & VID_HDTV)     ? true : false);
+    query.bindValue(":SUBTYPE",     m.subtitleType);
+    query.bindValue(":AUDIOPROP",   m.audioProps);
+    query.bindValue(":VIDEOPROP",   m.videoProps);
+    query.bindValue(":SEASON",      m.season);
+    query.bindValue(":EPISODE",     m.episode);
+    query.bindValue(":TOTALEPS",    m.totalepisodes);
+    query.bindValue(":PARTNO",      m.partnumber);
+    query.bindValue(":PARTTOTAL",   m.parttotal);
+    query.bindValue(":SYNDICATENO", denullify(m.syndicatedepisodenumber));
+    query.bindValue(":AIRDATE",     m.airdate ? QString::number(m.airdate) : "0000");
+    query.bindValue(":ORIGAIRDATE", m.originalairdate);
+    query.bindValue(":LSOURCE",     m.listingsource);
+    query.bindValue(":SERIESID",    denullify(m.seriesId));
+    query.bindValue(":PROGRAMID",   denullify(m.programId));
+    query.bindValue(":PREVSHOWN",   m.previouslyshown);
+    query.bindValue(":INETREF",     m.inetref);
 
     if (!query.exec())
     {
@@ -989,65 +997,84 @@ bool DBEvent::MoveOutOfTheWayDB(
     return true;
 }
 
+// Columns written by DBEvent::InsertDB() and the batched EIT writer.
+static const char *program_columns =
+    "  chanid,         title,          subtitle,        description, "
+    "  category,       category_type, "
+    "  starttime,      endtime, "
+    "  closecaptioned, stereo,         hdtv,            subtitled, "
+    "  subtitletypes,  audioprop,      videoprop, "
+    "  stars,          partnumber,     parttotal, "
+    "  syndicatedepisodenumber, "
+    "  airdate,        originalairdate,listingsource, "
+    "  seriesid,       programid,      previouslyshown, "
+    "  season,         episode,        totalepisodes, "
+    "  inetref ";
+
+// Placeholders matching program_columns, each name followed by "suffix"
+// so that several rows can be bound in one statement.
+static QString program_placeholders(const QString &suffix)
+{
+    return QString(
+        " :CHANID%1,       :TITLE%1,        :SUBTITLE%1,      :DESCRIPTION%1, "
+        " :CATEGORY%1,     :CATTYPE%1, "
+        " :STARTTIME%1,    :ENDTIME%1, "
+        " :CC%1,           :STEREO%1,       :HDTV%1,          :HASSUBTITLES%1, "
+        " :SUBTYPES%1,     :AUDIOPROP%1,    :VIDEOPROP%1, "
+        " :STARS%1,        :PARTNUMBER%1,   :PARTTOTAL%1, "
+        " :SYNDICATENO%1, "
+        " :AIRDATE%1,      :ORIGAIRDATE%1,  :LSOURCE%1, "
+        " :SERIESID%1,     :PROGRAMID%1,    :PREVSHOWN%1, "
+        " :SEASON%1,       :EPISODE%1,      :TOTALEPISODES%1, "
+        " :INETREF%1 ").arg(suffix);
+}
+
+static void bind_program(MSqlQuery &query, const QString &n,
+                         uint chanid, const DBEvent &ev)
+{
+    query.bindValue(":CHANID"      + n, chanid);
+    query.bindValue(":TITLE"       + n, denullify(ev.title));
+    query.bindValue(":SUBTITLE"    + n, denullify(ev.subtitle));
+    query.bindValue(":DESCRIPTION" + n, denullify(ev.description));
+    query.bindValue(":CATEGORY"    + n, denullify(ev.category));
+    query.bindValue(":CATTYPE"     + n,
+                    myth_category_type_to_string(ev.categoryType));
+    query.bindValue(":STARTTIME"   + n, ev.starttime);
+    query.bindValue(":ENDTIME"     + n, ev.endtime);
+    query.bindValue(":CC"          + n,
+                    (ev.subtitleType & SUB_HARDHEAR) ? true : false);
+    query.bindValue(":STEREO"      + n,
+                    (ev.audioProps   & AUD_STEREO)   ? true : false);
+    query.bindValue(":HDTV"        + n,
+                    (ev.videoProps   & VID_HDTV)     ? true : false);
+    query.bindValue(":HASSUBTITLES"+ n,
+                    (ev.subtitleType & SUB_NORMAL)   ? true : false);
+    query.bindValue(":SUBTYPES"    + n, ev.subtitleType);
+    query.bindValue(":AUDIOPROP"   + n, ev.audioProps);
+    query.bindValue(":VIDEOPROP"   + n, ev.videoProps);
+    query.bindValue(":STARS"       + n, ev.stars);
+    query.bindValue(":PARTNUMBER"  + n, ev.partnumber);
+    query.bindValue(":PARTTOTAL"   + n, ev.parttotal);
+    query.bindValue(":SYNDICATENO" + n, denullify(ev.syndicatedepisodenumber));
+    query.bindValue(":AIRDATE"     + n,
+                    ev.airdate ? QString::number(ev.airdate) : "0000");
+    query.bindValue(":ORIGAIRDATE" + n, ev.originalairdate);
+    query.bindValue(":LSOURCE"     + n, ev.listingsource);
+    query.bindValue(":SERIESID"    + n, denullify(ev.seriesId));
+    query.bindValue(":PROGRAMID"   + n, denullify(ev.programId));
+    query.bindValue(":PREVSHOWN"   + n, ev.previouslyshown);
+    query.bindValue(":SEASON"      + n, ev.season);
+    query.bindValue(":EPISODE"     + n, ev.episode);
+    query.bindValue(":TOTALEPISODES" + n, ev.totalepisodes);
+    query.bindValue(":INETREF"     + n, ev.inetref);
+}
+
 uint DBEvent::InsertDB(MSqlQuery &query, uint chanid) const
 {
     query.prepare(
-        "REPLACE INTO program ("
-        "  chanid,         title,          subtitle,        description, "
-        "  category,       category_type, "
-        "  starttime,      endtime, "
-        "  closecaptioned, stereo,         hdtv,            subtitled, "
-        "  subtitletypes,  audioprop,      videoprop, "
-        "  stars,          partnumber,     parttotal, "
-        "  syndicatedepisodenumber, "
-        "  airdate,        originalairdate,listingsource, "
-        "  seriesid,       programid,      previouslyshown, "
-        "  season,         episode,        totalepisodes, "
-        "  inetref ) "
-        "VALUES ("
-        " :CHANID,        :TITLE,         :SUBTITLE,       :DESCRIPTION, "
-        " :CATEGORY,      :CATTYPE, "
-        " :STARTTIME,     :ENDTIME, "
-        " :CC,            :STEREO,        :HDTV,           :HASSUBTITLES, "
-        " :SUBTYPES,      :AUDIOPROP,     :VIDEOPROP, "
-        " :STARS,         :PARTNUMBER,    :PARTTOTAL, "
-        " :SYNDICATENO, "
-        " :AIRDATE,       :ORIGAIRDATE,   :LSOURCE, "
-        " :SERIESID,      :PROGRAMID,     :PREVSHOWN, "
-        " :SEASON,        :EPISODE,       :TOTALEPISODES, "
-        " :INETREF ) ");
-
-    QString cattype = myth_category_type_to_string(categoryType);
-    QString empty("");
-    query.bindValue(":CHANID",      chanid);
-    query.bindValue(":TITLE",       denullify(title));
-    query.bindValue(":SUBTITLE",    denullify(subtitle));
-    query.bindValue(":DESCRIPTION", denullify(description));
-    query.bindValue(":CATEGORY",    denullify(category));
-    query.bindValue(":CATTYPE",     cattype);
-    query.bindValue(":STARTTIME",   starttime);
-    query.bindValue(":ENDTIME",     endtime);
-    query.bindValue(":CC",          (subtitleType & SUB_HARDHEAR) ? true : false);
-    query.bindValue(":STEREO",      (audioProps   & AUD_STEREO)   ? true : false);
-    query.bindValue(":HDTV",        (videoProps   & VID_HDTV)     ? true : false);
-    query.bindValue(":HASSUBTITLES",(subtitleType & SUB_NORMAL)   ? true : false);
-    query.bindValue(":SUBTYPES",    subtitleType);
-    query.bindValue(":AUDIOPROP",   audioProps);
-    query.bindValue(":VIDEOPROP",   videoProps);
-    query.bindValue(":STARS",       stars);
-    query.bindValue(":PARTNUMBER",  partnumber);
-    query.bindValue(":PARTTOTAL",   parttotal);
-    query.bindValue(":SYNDICATENO", denullify(syndicatedepisodenumber));
-    query.bindValue(":AIRDATE",     airdate ? QString::number(airdate) : "0000");
-    query.bindValue(":ORIGAIRDATE", originalairdate);
-    query.bindValue(":LSOURCE",     listingsource);
-    query.bindValue(":SERIESID",    denullify(seriesId));
-    query.bindValue(":PROGRAMID",   denullify(programId));
-    query.bindValue(":PREVSHOWN",   previouslyshown);
-    query.bindValue(":SEASON",      season);
-    query.bindValue(":EPISODE",     episode);
-    query.bindValue(":TOTALEPISODES", totalepisodes);
-    query.bindValue(":INETREF",     inetref);
+        QString("REPLACE INTO program (%1) VALUES (%2)")
+            .arg(program_columns).arg(program_placeholders("")));
+    bind_program(query, "", chanid, *this);
 
     if (!query.exec())
     {
@@ -1082,176 +1109,913 @@ uint DBEvent::InsertDB(MSqlQuery &query, uint chanid) const
     return 1;
 }
 
-ProgInfo::ProgInfo(const ProgInfo &other) :
-    DBEvent(other.listingsource)
+// Assignments for the columns of program_columns, except for the key and
+// stars, which DBEvent::UpdateDB() does not change either.
+static const char *program_update_columns =
+    "  title         = VALUES(title),         subtitle = VALUES(subtitle), "
+    "  description   = VALUES(description), "
+    "  category      = VALUES(category), "
+    "  category_type = VALUES(category_type), "
+    "  endtime       = VALUES(endtime), "
+    "  closecaptioned = VALUES(closecaptioned), "
+    "  stereo        = VALUES(stereo),        hdtv     = VALUES(hdtv), "
+    "  subtitled     = VALUES(subtitled), "
+    "  subtitletypes = VALUES(subtitletypes), "
+    "  audioprop     = VALUES(audioprop),     videoprop = VALUES(videoprop), "
+    "  partnumber    = VALUES(partnumber),    parttotal = VALUES(parttotal), "
+    "  syndicatedepisodenumber = VALUES(syndicatedepisodenumber), "
+    "  airdate       = VALUES(airdate), "
+    "  originalairdate = VALUES(originalairdate), "
+    "  listingsource = VALUES(listingsource), "
+    "  seriesid      = VALUES(seriesid),      programid = VALUES(programid), "
+    "  previouslyshown = VALUES(previouslyshown), "
+    "  season        = VALUES(season),        episode  = VALUES(episode), "
+    "  totalepisodes = VALUES(totalepisodes), "
+    "  inetref       = VALUES(inetref) ";
+
+// "count" copies of "row", with %1 replaced by the row number.
+static QString multi_row_values(const QString &row, int count)
 {
-    *this = other;
+    QStringList values;
+    for (int i = 0; i < count; i++)
+        values.push_back(row.arg(i));
+    return values.join(", ");
 }
 
-ProgInfo &ProgInfo::operator=(const ProgInfo &other)
-{
-    if (this == &other)
-        return *this;
-
-    DBEvent::operator=(other);
-
-    channel         = other.channel;
-    startts         = other.startts;
-    endts           = other.endts;
-    title_pronounce = other.title_pronounce;
-    showtype        = other.showtype;
-    colorcode       = other.colorcode;
-    clumpidx        = other.clumpidx;
-    clumpmax        = other.clumpmax;
-
-    channel.squeeze();
-    startts.squeeze();
-    endts.squeeze();
-    title_pronounce.squeeze();
-    showtype.squeeze();
-    colorcode.squeeze();
-    clumpidx.squeeze();
-    clumpmax.squeeze();
+const int ProgramExtrasWriter::kMaxRows = 50;
 
-    return *this;
+void ProgramExtrasWriter::Add(const QDateTime &starttime,
+                              const DBEvent &event)
+{
+    m_starttimes.push_back(starttime);
+    m_events.push_back(&event);
 }
 
-void ProgInfo::Squeeze(void)
+/// Writes and forgets the queued extras.
+void ProgramExtrasWriter::Write(MSqlQuery &query, uint chanid)
 {
-    DBEvent::Squeeze();
-    channel.squeeze();
-    startts.squeeze();
-    endts.squeeze();
-    title_pronounce.squeeze();
-    showtype.squeeze();
-    colorcode.squeeze();
-    clumpidx.squeeze();
-    clumpmax.squeeze();
+    WriteRatings(query, chanid);
+    WriteCredits(query, chanid);
+    WriteGenres(query, chanid);
+    m_starttimes.clear();
+    m_events.clear();
 }
 
-uint ProgInfo::InsertDB(MSqlQuery &query, uint chanid) const
+void ProgramExtrasWriter::WriteRatings(MSqlQuery &query, uint chanid)
 {
-    LOG(VB_XMLTV, LOG_INFO,
-        QString("Inserting new program    : %1 - %2 %3 %4")
-            .arg(starttime.toString(Qt::ISODate))
-            .arg(endtime.toString(Qt::ISODate))
-            .arg(channel)
-            .arg(title));
+    QList<QDateTime>   starttimes;
+    QList<EventRating> ratings;
+    for (int i = 0; i < m_events.size(); i++)
+    {
+        QList<EventRating>::const_iterator j = m_events[i]->ratings.begin();
+        for (; j != m_events[i]->ratings.end(); ++j)
+        {
+            starttimes.push_back(m_starttimes[i]);
+            ratings.push_back(*j);
+        }
+    }
 
-    query.prepare(
-        "REPLACE INTO program ("
-        "  chanid,         title,          subtitle,        description, "
-        "  category,       category_type,  "
-        "  starttime,      endtime, "
-        "  closecaptioned, stereo,         hdtv,            subtitled, "
-        "  subtitletypes,  audioprop,      videoprop, "
-        "  partnumber,     parttotal, "
-        "  syndicatedepisodenumber, "
-        "  airdate,        originalairdate,listingsource, "
-        "  seriesid,       programid,      previouslyshown, "
-        "  stars,          showtype,       title_pronounce, colorcode, "
-        "  season,         episode,        totalepisodes, "
-        "  inetref ) "
+    for (int first = 0; first < ratings.size(); first += kMaxRows)
+    {
+        int count = min(kMaxRows, ratings.size() - first);
+        query.prepare(
+            "INSERT IGNORE INTO programrating "
+            "       ( chanid, starttime, system, rating) VALUES " +
+            multi_row_values("(:CHANID%1, :START%1, :SYS%1, :RATING%1)",
+                             count));
+        for (int i = 0; i < count; i++)
+        {
+            QString n = QString::number(i);
+            query.bindValue(":CHANID" + n, chanid);
+            query.bindValue(":START"  + n, starttimes[first + i]);
+            query.bindValue(":SYS"    + n, ratings[first + i].system);
+            query.bindValue(":RATING" + n, ratings[first + i].rating);
+        }
+        Exec(query, "programrating insert");
+    }
+}
 
-        "VALUES("
-        " :CHANID,        :TITLE,         :SUBTITLE,       :DESCRIPTION, "
-        " :CATEGORY,      :CATTYPE,       "
-        " :STARTTIME,     :ENDTIME, "
-        " :CC,            :STEREO,        :HDTV,           :HASSUBTITLES, "
-        " :SUBTYPES,      :AUDIOPROP,     :VIDEOPROP, "
-        " :PARTNUMBER,    :PARTTOTAL, "
-        " :SYNDICATENO, "
-        " :AIRDATE,       :ORIGAIRDATE,   :LSOURCE, "
-        " :SERIESID,      :PROGRAMID,     :PREVSHOWN, "
-        " :STARS,         :SHOWTYPE,      :TITLEPRON,      :COLORCODE, "
-        " :SEASON,        :EPISODE,       :TOTALEPISODES, "
-        " :INETREF )");
+void ProgramExtrasWriter::WriteCredits(MSqlQuery &query, uint chanid)
+{
+    QStringList names;
+    QSet<QString> seen;
+    for (int j = 0; j < m_events.size(); j++)
+    {
+        const DBCredits *credits = m_events[j]->credits;
+        for (uint i = 0; credits && (i < credits->size()); i++)
+        {
+            const QString &name = (*credits)[i].name;
+            if (!seen.contains(name))
+            {
+                seen.insert(name);
+                names.push_back(name);
+            }
+        }
+    }
 
-    QString cattype = myth_category_type_to_string(categoryType);
+    if (names.empty())
+        return;
 
-    query.bindValue(":CHANID",      chanid);
-    query.bindValue(":TITLE",       denullify(title));
-    query.bindValue(":SUBTITLE",    denullify(subtitle));
-    query.bindValue(":DESCRIPTION", denullify(description));
-    query.bindValue(":CATEGORY",    denullify(category));
-    query.bindValue(":CATTYPE",     cattype);
-    query.bindValue(":STARTTIME",   starttime);
-    query.bindValue(":ENDTIME",     denullify(endtime));
-    query.bindValue(":CC",
-                    (subtitleType & SUB_HARDHEAR) ? true : false);
-    query.bindValue(":STEREO",
-                    (audioProps   & AUD_STEREO)   ? true : false);
-    query.bindValue(":HDTV",
-                    (videoProps   & VID_HDTV)     ? true : false);
-    query.bindValue(":HASSUBTITLES",
-                    (subtitleType & SUB_NORMAL)   ? true : false);
-    query.bindValue(":SUBTYPES",    subtitleType);
-    query.bindValue(":AUDIOPROP",   audioProps);
-    query.bindValue(":VIDEOPROP",   videoProps);
-    query.bindValue(":PARTNUMBER",  partnumber);
-    query.bindValue(":PARTTOTAL",   parttotal);
-    query.bindValue(":SYNDICATENO", denullify(syndicatedepisodenumber));
-    query.bindValue(":AIRDATE",     airdate ? QString::number(airdate):"0000");
-    query.bindValue(":ORIGAIRDATE", originalairdate);
-    query.bindValue(":LSOURCE",     listingsource);
-    query.bindValue(":SERIESID",    denullify(seriesId));
-    query.bindValue(":PROGRAMID",   denullify(programId));
-    query.bindValue(":PREVSHOWN",   previouslyshown);
-    query.bindValue(":STARS",       stars);
-    query.bindValue(":SHOWTYPE",    showtype);
-    query.bindValue(":TITLEPRON",   title_pronounce);
-    query.bindValue(":COLORCODE",   colorcode);
-    query.bindValue(":SEASON",      season);
-    query.bindValue(":EPISODE",     episode);
-    query.bindValue(":TOTALEPISODES", totalepisodes);
-    query.bindValue(":INETREF",     inetref);
+    // Add everybody who is not in the people table yet,
+    // then look up all of them at once.
+    QHash<QString, uint> personids;
+    for (int first = 0; first < names.size(); first += kMaxRows)
+    {
+        int count = min(kMaxRows, names.size() - first);
+        query.prepare("INSERT IGNORE INTO people (name) VALUES " +
+                      multi_row_values("(:NAME%1)", count));
+        for (int i = 0; i < count; i++)
+            query.bindValue(":NAME" + QString::number(i), names[first + i]);
+        Exec(query, "insert_person");
+
+        query.prepare("SELECT person, name FROM people WHERE name IN (" +
+                      multi_row_values(":NAME%1", count) + ")");
+        for (int i = 0; i < count; i++)
+            query.bindValue(":NAME" + QString::number(i), names[first + i]);
+        if (Exec(query, "get_person"))
+        {
+            while (query.next())
+                personids[query.value(1).toString()] = query.value(0).toUInt();
+        }
+    }
 
-    if (!query.exec())
+    QList<uint>      persons;
+    QList<QDateTime> starttimes;
+    QStringList      roles;
+    for (int j = 0; j < m_events.size(); j++)
     {
-        MythDB::DBError("program insert", query);
-        return 0;
+        const DBCredits *credits = m_events[j]->credits;
+        for (uint i = 0; credits && (i < credits->size()); i++)
+        {
+            const DBPerson &person = (*credits)[i];
+            // The name may compare equal to one spelled differently
+            if (!personids.contains(person.name))
+            {
+                personids[person.name] = person.GetPersonDB(query);
+                m_statements++;
+            }
+
+            uint personid = personids[person.name];
+            if (!personid)
+                continue;
+            persons.push_back(personid);
+            starttimes.push_back(m_starttimes[j]);
+            roles.push_back(person.GetRole());
+        }
     }
 
-    QList<EventRating>::const_iterator j = ratings.begin();
-    for (; j != ratings.end(); ++j)
+    for (int first = 0; first < persons.size(); first += kMaxRows)
     {
+        int count = min(kMaxRows, persons.size() - first);
         query.prepare(
-            "INSERT IGNORE INTO programrating "
-            "       ( chanid, starttime, system, rating) "
-            "VALUES (:CHANID, :START,    :SYS,  :RATING)");
-        query.bindValue(":CHANID", chanid);
-        query.bindValue(":START",  starttime);
-        query.bindValue(":SYS",    (*j).system);
-        query.bindValue(":RATING", (*j).rating);
+            "REPLACE INTO credits "
+            "       ( person,  chanid,  starttime,  role) VALUES " +
+            multi_row_values(
+                "(:PERSON%1, :CHANID%1, :STARTTIME%1, :ROLE%1)", count));
+        for (int i = 0; i < count; i++)
+        {
+            QString n = QString::number(i);
+            query.bindValue(":PERSON"    + n, persons[first + i]);
+            query.bindValue(":CHANID"    + n, chanid);
+            query.bindValue(":STARTTIME" + n, starttimes[first + i]);
+            query.bindValue(":ROLE"      + n, roles[first + i]);
+        }
+        Exec(query, "insert_credits");
+    }
+}
 
-        if (!query.exec())
-            MythDB::DBError("programrating insert", query);
+void ProgramExtrasWriter::WriteGenres(MSqlQuery &query, uint chanid)
+{
+    QString relevance = QStringLiteral("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+    QList<QDateTime> starttimes;
+    QStringList      genres;
+    QString          relevances;
+    for (int j = 0; j < m_events.size(); j++)
+    {
+        const QStringList &g = m_events[j]->genres;
+        for (int i = 0; (i < g.size()) && (i < relevance.size()); i++)
+        {
+            starttimes.push_back(m_starttimes[j]);
+            genres.push_back(g[i]);
+            relevances.push_back(relevance.at(i));
+        }
     }
 
-    if (credits)
+    for (int first = 0; first < genres.size(); first += kMaxRows)
     {
-        for (uint i = 0; i < credits->size(); ++i)
-            (*credits)[i].InsertDB(query, chanid, starttime);
+        int count = min(kMaxRows, genres.size() - first);
+        query.prepare(
+            "INSERT IGNORE INTO programgenres "
+            "       ( chanid,  starttime, genre,  relevance) VALUES " +
+            multi_row_values(
+                "(:CHANID%1, :START%1, :genre%1, :relevance%1)", count));
+        for (int i = 0; i < count; i++)
+        {
+            QString n = QString::number(i);
+            query.bindValue(":CHANID"    + n, chanid);
+            query.bindValue(":START"     + n, starttimes[first + i]);
+            query.bindValue(":genre"     + n, genres[first + i]);
+            query.bindValue(":relevance" + n, relevances.at(first + i));
+        }
+        Exec(query, "programgenres insert");
     }
+}
 
-    add_genres(query, genres, chanid, starttime);
+bool ProgramExtrasWriter::Exec(MSqlQuery &query, const char *name)
+{
+    m_statements++;
+    if (query.exec())
+        return true;
 
-    return 1;
+    MythDB::DBError(name, query);
+    return false;
 }
 
-bool ProgramData::ClearDataByChannel(
-    uint chanid, const QDateTime &from, const QDateTime &to,
-    bool use_channel_time_offset)
+const int  EITBatchWriter::kWindowSecs = 12 * 60 * 60;
+const uint EITBatchWriter::kMaxRows    = 50;
+
+EITBatchWriter::EITBatchWriter() :
+    m_events(0),     m_written(0),    m_windows(0),
+    m_batched(0),    m_unbatched(0),  m_statements(0),
+    m_elapsed(0)
 {
-    int secs = 0;
-    if (use_channel_time_offset)
-        secs = ChannelUtil::GetTimeOffset(chanid) * 60;
+}
 
-    QDateTime newFrom = from.addSecs(secs);
-    QDateTime newTo   = to.addSecs(secs);
+/** \fn EITBatchWriter::Write(const QList<DBEventEIT*>&, int)
+ *  \brief Inserts or updates the events, with the same result as
+ *         calling DBEventEIT::UpdateDB() on each of them in turn.
+ *  \return Number of events written to the database.
+ */
+uint EITBatchWriter::Write(const QList<DBEventEIT*> &events,
+                           int match_threshold)
+{
+    MythTimer timer;
+    timer.start();
+
+    // Group the events per channel, keeping their order
+    QMap<uint, QList<const DBEventEIT*> > channels;
+    QList<DBEventEIT*>::const_iterator it = events.begin();
+    for (; it != events.end(); ++it)
+        channels[(*it)->chanid].push_back(*it);
 
     MSqlQuery query(MSqlQuery::InitCon());
-    query.prepare("DELETE FROM program "
+
+    // The program tables may well be MyISAM, in which case this only
+    // saves the per statement commits on converted InnoDB tables.
+    bool transaction = query.exec("START TRANSACTION");
+    if (!transaction)
+        MythDB::DBError("EITBatchWriter start", query);
+
+    uint count = 0;
+    QMap<uint, QList<const DBEventEIT*> >::const_iterator cit;
+    for (cit = channels.begin(); cit != channels.end(); ++cit)
+    {
+        // Split the channel into windows of consecutive events
+        QList<const DBEventEIT*> window;
+        QDateTime start, end;
+        QList<const DBEventEIT*>::const_iterator eit = (*cit).begin();
+        for (; eit != (*cit).end(); ++eit)
+        {
+            const DBEventEIT *event = *eit;
+            if (!window.empty())
+            {
+                QDateTime wstart = min(start, event->starttime);
+                QDateTime wend   = max(end,   event->endtime);
+                if (wstart.secsTo(wend) <= kWindowSecs)
+                {
+                    window.push_back(event);
+                    start = wstart;
+                    end   = wend;
+                    continue;
+                }
+                count += WriteWindow(query, cit.key(), window, start, end,
+                                     match_threshold);
+                window.clear();
+            }
+            window.push_back(event);
+            start = event->starttime;
+            end   = event->endtime;
+        }
+        if (!window.empty())
+        {
+            count += WriteWindow(query, cit.key(), window, start, end,
+                                 match_threshold);
+        }
+    }
+
+    if (transaction && !query.exec("COMMIT"))
+        MythDB::DBError("EITBatchWriter commit", query);
+
+    m_events  += events.size();
+    m_written += count;
+    m_elapsed += timer.elapsed();
+
+    return count;
+}
+
+QString EITBatchWriter::GetStatistics(void) const
+{
+    double rate = m_elapsed ? (m_events * 1000.0) / m_elapsed : 0.0;
+    return QString("DB writer: %1 events, %2 written (%3 batched, "
+                   "%4 unbatched) in %5 windows, %6 statements, "
+                   "%7 events/s")
+        .arg(m_events).arg(m_written).arg(m_batched).arg(m_unbatched)
+        .arg(m_windows).arg(m_statements).arg(rate, 0, 'f', 1);
+}
+
+uint EITBatchWriter::WriteWindow(
+    MSqlQuery &query, uint chanid, const QList<const DBEventEIT*> &events,
+    const QDateTime &start, const QDateTime &end, int match_threshold)
+{
+    uint count = 0;
+    QList<const DBEventEIT*>::const_iterator it = events.begin();
+
+    m_windows++;
+
+    if (!ReadWindow(query, chanid, start, end))
+    {
+        // Fall back to writing the events one at a time
+        ClearRows();
+        for (; it != events.end(); ++it)
+        {
+            uint written = (*it)->UpdateDB(query, match_threshold);
+            m_unbatched += written;
+            count += written;
+        }
+        return count;
+    }
+
+    for (; it != events.end(); ++it)
+        count += WriteEvent(query, chanid, **it, match_threshold);
+
+    count += Flush(query, chanid);
+    ClearRows();
+
+    return count;
+}
+
+// Read all programs overlapping the window. The overlap test is the one
+// of DBEvent::GetOverlappingPrograms(), except that programs starting
+// right at the end of the window are read too, for ProgramExists().
+bool EITBatchWriter::ReadWindow(MSqlQuery &query, uint chanid,
+                                const QDateTime &start, const QDateTime &end)
+{
+    query.prepare(QString(
+        "SELECT %1, manualid "
+        "FROM program "
+        "WHERE chanid   = :CHANID AND "
+        "      ( ( starttime >= :STIME1 AND starttime <= :ETIME1 ) OR "
+        "        ( endtime   >  :STIME2 AND endtime   <= :ETIME2 ) OR "
+        "        ( starttime <  :STIME3 AND endtime   >  :ETIME3 ) )")
+        .arg(program_select_columns));
+    query.bindValue(":CHANID", chanid);
+    query.bindValue(":STIME1", start);
+    query.bindValue(":ETIME1", end);
+    query.bindValue(":STIME2", start);
+    query.bindValue(":ETIME2", end);
+    query.bindValue(":STIME3", start);
+    query.bindValue(":ETIME3", end);
+
+    if (!Exec(query, "EITBatchWriter window"))
+        return false;
+
+    while (query.next())
+    {
+        DBEvent prog = program_from_query(query);
+        if (query.value(24).toUInt())
+            m_manual.push_back(prog.starttime);
+        else
+            AddRow(prog, NULL, false);
+    }
+
+    return true;
+}
+
+// Same decisions as DBEvent::UpdateDB(MSqlQuery&, uint, int), made
+// against the rows of the window instead of the database.
+uint EITBatchWriter::WriteEvent(MSqlQuery &query, uint chanid,
+                                const DBEventEIT &event, int match_threshold)
+{
+    uint count = 0;
+
+    LOG(VB_EIT, LOG_DEBUG,
+        QString("EIT: new program: %1 %2 '%3' chanid %4")
+                .arg(event.starttime.toString(Qt::ISODate))
+                .arg(event.endtime.toString(Qt::ISODate))
+                .arg(event.title.left(35))
+                .arg(chanid));
+
+    // Do not insert or update when the program is in the past
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    if (event.endtime < now)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT: skip '%1' endtime is in the past")
+                    .arg(event.title.left(35)));
+        return 0;
+    }
+
+    // Forget the rows deleted by previous events
+    for (int i = m_rows.size() - 1; i >= 0; i--)
+    {
+        if (!m_rows[i].program)
+            m_rows.removeAt(i);
+    }
+
+    // Get the rows that overlap with our new program
+    vector<DBEvent> programs;
+    QList<int> index;
+    bool pending = false;
+    for (int i = 0; i < m_rows.size(); i++)
+    {
+        const DBEvent &prog = *m_rows[i].program;
+        if ((prog.starttime >= event.starttime &&
+             prog.starttime <  event.endtime) ||
+            (prog.endtime   >  event.starttime &&
+             prog.endtime   <= event.endtime) ||
+            (prog.starttime <  event.starttime &&
+             prog.endtime   >  event.endtime))
+        {
+            programs.push_back(prog);
+            index.push_back(i);
+            pending |= (m_rows[i].source != NULL);
+        }
+    }
+
+    // Overlapping programs are moved or updated in the database right
+    // away, so those still waiting to be written must be written first.
+    if (pending)
+        count += Flush(query, chanid);
+
+    if (programs.empty())
+    {
+        AddRow(event, &event, false);
+        return count;
+    }
+
+    for (uint j = 0; j < programs.size(); j++)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT: overlap[%1] : %2 %3 '%4'")
+                .arg(j)
+                .arg(programs[j].starttime.toString(Qt::ISODate))
+                .arg(programs[j].endtime.toString(Qt::ISODate))
+                .arg(programs[j].title.left(35)));
+    }
+
+    int i = -1;
+    int match = event.GetMatch(programs, i);
+
+    if (match >= match_threshold)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT: accept match[%1]: %2 '%3' vs. '%4'")
+                .arg(i).arg(match).arg(event.title.left(35))
+                .arg(programs[i].title.left(35)));
+    }
+    else
+    {
+        if (i >= 0)
+        {
+            LOG(VB_EIT, LOG_DEBUG,
+                QString("EIT: reject match[%1]: %2 '%3' vs. '%4'")
+                    .arg(i).arg(match).arg(event.title.left(35))
+                    .arg(programs[i].title.left(35)));
+        }
+        i = -1;
+    }
+
+    // Adjust/delete overlaps
+    bool ok = true;
+    for (uint j = 0; j < programs.size(); j++)
+    {
+        if ((int)j != i)
+            ok &= MoveOutOfTheWay(query, chanid, event, m_rows[index[j]]);
+    }
+
+    if (!ok)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT: cannot insert '%1' MoveOutOfTheWayDB failed")
+                    .arg(event.title.left(35)));
+        return count;
+    }
+
+    if (i < 0)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT: insert '%1'").arg(event.title.left(35)));
+        AddRow(event, &event, false);
+        return count;
+    }
+
+    Row &row = m_rows[index[i]];
+
+    LOG(VB_EIT, LOG_DEBUG,
+         QString("EIT: update '%1' with '%2'")
+                 .arg(programs[i].title.left(35))
+                 .arg(event.title.left(35)));
+
+    if (event.starttime == programs[i].starttime)
+    {
+        // The key does not change, so this can be batched as an upsert
+        *row.program = event.MergeMatch(programs[i]);
+        row.source   = &event;
+        row.update   = true;
+        return count;
+    }
+
+    // Changing a starttime of a program that is being recorded can
+    // start another recording of the same program.
+    // Therefore we skip updates that change a starttime in the past
+    // unless the endtime is later.
+    if (event.starttime < now && event.endtime <= programs[i].endtime)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT:  skip '%1' starttime is in the past")
+                    .arg(event.title.left(35)));
+        return count;
+    }
+
+    uint written = event.DBEvent::UpdateDB(query, chanid, programs[i]);
+    if (written)
+        *row.program = event.MergeMatch(programs[i]);
+    m_unbatched += written;
+
+    return count + written;
+}
+
+// Same as DBEvent::MoveOutOfTheWayDB(), keeping the row up to date.
+bool EITBatchWriter::MoveOutOfTheWay(MSqlQuery &query, uint chanid,
+                                     const DBEvent &event, Row &row)
+{
+    DBEvent &prog = *row.program;
+    bool remove = false;
+    bool ok = true;
+
+    if (prog.starttime >= event.starttime && prog.endtime <= event.endtime)
+    {
+        remove = true;
+    }
+    else if (prog.starttime < event.starttime &&
+             prog.endtime > event.starttime)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT: change '%1' endtime to %2")
+                    .arg(prog.title.left(35))
+                    .arg(event.starttime.toString(Qt::ISODate)));
+        ok = change_program(query, chanid, prog.starttime,
+                            prog.starttime, event.starttime);
+        m_statements += 4;
+        if (ok)
+            prog.endtime = event.starttime;
+    }
+    else if (prog.starttime < event.endtime && prog.endtime > event.endtime)
+    {
+        if (ProgramExists(event.endtime))
+        {
+            remove = true;
+        }
+        else
+        {
+            LOG(VB_EIT, LOG_DEBUG,
+                QString("EIT: change '%1' starttime to %2")
+                        .arg(prog.title.left(35))
+                        .arg(event.endtime.toString(Qt::ISODate)));
+            ok = change_program(query, chanid, prog.starttime,
+                                event.endtime, prog.endtime);
+            m_statements += 4;
+            if (ok)
+                prog.starttime = event.endtime;
+        }
+    }
+
+    if (remove)
+    {
+        LOG(VB_EIT, LOG_DEBUG,
+            QString("EIT: delete '%1' %2 - %3")
+                    .arg(prog.title.left(35))
+                    .arg(prog.starttime.toString(Qt::ISODate))
+                    .arg(prog.endtime.toString(Qt::ISODate)));
+        ok = delete_program(query, chanid, prog.starttime);
+        m_statements += 4;
+        if (ok)
+        {
+            delete row.program;
+            row.program = NULL;
+        }
+    }
+
+    return ok;
+}
+
+bool EITBatchWriter::ProgramExists(const QDateTime &starttime) const
+{
+    if (m_manual.contains(starttime))
+        return true;
+
+    QList<Row>::const_iterator it = m_rows.begin();
+    for (; it != m_rows.end(); ++it)
+    {
+        if ((*it).program && (*it).program->starttime == starttime)
+            return true;
+    }
+
+    return false;
+}
+
+void EITBatchWriter::AddRow(const DBEvent &program, const DBEvent *source,
+                            bool update)
+{
+    Row row;
+    row.program = new DBEvent(program.listingsource);
+    *row.program = program;
+    delete row.program->credits;
+    row.program->credits = NULL;
+    row.source = source;
+    row.update = update;
+    m_rows.push_back(row);
+}
+
+// Write all pending rows, returns the number of programs written.
+uint EITBatchWriter::Flush(MSqlQuery &query, uint chanid)
+{
+    QList<const Row*> inserts;
+    QList<const Row*> updates;
+    QList<Row>::iterator it = m_rows.begin();
+    for (; it != m_rows.end(); ++it)
+    {
+        if (!(*it).program || !(*it).source)
+            continue;
+        if ((*it).update)
+            updates.push_back(&(*it));
+        else
+            inserts.push_back(&(*it));
+    }
+
+    if (inserts.empty() && updates.empty())
+        return 0;
+
+    QList<const Row*> written = FlushPrograms(query, chanid, inserts, false);
+    written += FlushPrograms(query, chanid, updates, true);
+
+    ProgramExtrasWriter extras;
+    QList<const Row*>::const_iterator wit = written.begin();
+    for (; wit != written.end(); ++wit)
+        extras.Add((*wit)->program->starttime, *(*wit)->source);
+    extras.Write(query, chanid);
+    m_statements += extras.GetStatements();
+
+    for (it = m_rows.begin(); it != m_rows.end(); ++it)
+        (*it).source = NULL;
+
+    m_batched += written.size();
+
+    return written.size();
+}
+
+QList<const EITBatchWriter::Row*> EITBatchWriter::FlushPrograms(
+    MSqlQuery &query, uint chanid, const QList<const Row*> &rows, bool update)
+{
+    QList<const Row*> written;
+
+    for (int first = 0; first < rows.size(); first += kMaxRows)
+    {
+        QList<const Row*> chunk = rows.mid(first, kMaxRows);
+        if (WritePrograms(query, chanid, chunk, update))
+        {
+            written += chunk;
+            continue;
+        }
+
+        // Write the rows one by one, so one bad row
+        // does not keep the others out of the database.
+        for (int i = 0; (chunk.size() > 1) && (i < chunk.size()); i++)
+        {
+            QList<const Row*> single = chunk.mid(i, 1);
+            if (WritePrograms(query, chanid, single, update))
+                written += single;
+        }
+    }
+
+    return written;
+}
+
+bool EITBatchWriter::WritePrograms(
+    MSqlQuery &query, uint chanid, const QList<const Row*> &rows, bool update)
+{
+    QString values = multi_row_values(
+        "(" + program_placeholders("%1") + ")", rows.size());
+
+    if (update)
+    {
+        query.prepare(
+            QString("INSERT INTO program (%1) VALUES %2 "
+                    "ON DUPLICATE KEY UPDATE %3")
+                .arg(program_columns, values, program_update_columns));
+    }
+    else
+    {
+        query.prepare(
+            QString("REPLACE INTO program (%1) VALUES %2")
+                .arg(program_columns, values));
+    }
+
+    for (int i = 0; i < rows.size(); i++)
+        bind_program(query, QString::number(i), chanid, *rows[i]->program);
+
+    return Exec(query, update ? "EITBatchWriter update" : "InsertDB");
+}
+
+bool EITBatchWriter::Exec(MSqlQuery &query, const char *name)
+{
+    m_statements++;
+    if (query.exec())
+        return true;
+
+    MythDB::DBError(name, query);
+    return false;
+}
+
+void EITBatchWriter::ClearRows(void)
+{
+    QList<Row>::iterator it = m_rows.begin();
+    for (; it != m_rows.end(); ++it)
+        delete (*it).program;
+    m_rows.clear();
+    m_manual.clear();
+}
+
+ProgInfo::ProgInfo(const ProgInfo &other) :
+    DBEvent(other.listingsource)
+{
+    *this = other;
+}
+
+ProgInfo &ProgInfo::operator=(const ProgInfo &other)
+{
+    if (this == &other)
+        return *this;
+
+    DBEvent::operator=(other);
+
+    channel         = other.channel;
+    startts         = other.startts;
+    endts           = other.endts;
+    title_pronounce = other.title_pronounce;
+    showtype        = other.showtype;
+    colorcode       = other.colorcode;
+    clumpidx        = other.clumpidx;
+    clumpmax        = other.clumpmax;
+
+    channel.squeeze();
+    startts.squeeze();
+    endts.squeeze();
+    title_pronounce.squeeze();
+    showtype.squeeze();
+    colorcode.squeeze();
+    clumpidx.squeeze();
+    clumpmax.squeeze();
+
+    return *this;
+}
+
+void ProgInfo::Squeeze(void)
+{
+    DBEvent::Squeeze();
+    channel.squeeze();
+    startts.squeeze();
+    endts.squeeze();
+    title_pronounce.squeeze();
+    showtype.squeeze();
+    colorcode.squeeze();
+    clumpidx.squeeze();
+    clumpmax.squeeze();
+}
+
+uint ProgInfo::InsertDB(MSqlQuery &query, uint chanid) const
+{
+    LOG(VB_XMLTV, LOG_INFO,
+        QString("Inserting new program    : %1 - %2 %3 %4")
+            .arg(starttime.toString(Qt::ISODate))
+            .arg(endtime.toString(Qt::ISODate))
+            .arg(channel)
+            .arg(title));
+
+    query.prepare(
+        "REPLACE INTO program ("
+        "  chanid,         title,          subtitle,        description, "
+        "  category,       category_type,  "
+        "  starttime,      endtime, "
+        "  closecaptioned, stereo,         hdtv,            subtitled, "
+        "  subtitletypes,  audioprop,      videoprop, "
+        "  partnumber,     parttotal, "
+        "  syndicatedepisodenumber, "
+        "  airdate,        originalairdate,listingsource, "
+        "  seriesid,       programid,      previouslyshown, "
+        "  stars,          showtype,       title_pronounce, colorcode, "
+        "  season,         episode,        totalepisodes, "
+        "  inetref ) "
+
+        "VALUES("
+        " :CHANID,        :TITLE,         :SUBTITLE,       :DESCRIPTION, "
+        " :CATEGORY,      :CATTYPE,       "
+        " :STARTTIME,     :ENDTIME, "
+        " :CC,            :STEREO,        :HDTV,           :HASSUBTITLES, "
+        " :SUBTYPES,      :AUDIOPROP,     :VIDEOPROP, "
+        " :PARTNUMBER,    :PARTTOTAL, "
+        " :SYNDICATENO, "
+        " :AIRDATE,       :ORIGAIRDATE,   :LSOURCE, "
+        " :SERIESID,      :PROGRAMID,     :PREVSHOWN, "
+        " :STARS,         :SHOWTYPE,      :TITLEPRON,      :COLORCODE, "
+        " :SEASON,        :EPISODE,       :TOTALEPISODES, "
+        " :INETREF )");
+
+    QString cattype = myth_category_type_to_string(categoryType);
+
+    query.bindValue(":CHANID",      chanid);
+    query.bindValue(":TITLE",       denullify(title));
+    query.bindValue(":SUBTITLE",    denullify(subtitle));
+    query.bindValue(":DESCRIPTION", denullify(description));
+    query.bindValue(":CATEGORY",    denullify(category));
+    query.bindValue(":CATTYPE",     cattype);
+    query.bindValue(":STARTTIME",   starttime);
+    query.bindValue(":ENDTIME",     denullify(endtime));
+    query.bindValue(":CC",
+                    (subtitleType & SUB_HARDHEAR) ? true : false);
+    query.bindValue(":STEREO",
+                    (audioProps   & AUD_STEREO)   ? true : false);
+    query.bindValue(":HDTV",
+                    (videoProps   & VID_HDTV)     ? true : false);
+    query.bindValue(":HASSUBTITLES",
+                    (subtitleType & SUB_NORMAL)   ? true : false);
+    query.bindValue(":SUBTYPES",    subtitleType);
+    query.bindValue(":AUDIOPROP",   audioProps);
+    query.bindValue(":VIDEOPROP",   videoProps);
+    query.bindValue(":PARTNUMBER",  partnumber);
+    query.bindValue(":PARTTOTAL",   parttotal);
+    query.bindValue(":SYNDICATENO", denullify(syndicatedepisodenumber));
+    query.bindValue(":AIRDATE",     airdate ? QString::number(airdate):"0000");
+    query.bindValue(":ORIGAIRDATE", originalairdate);
+    query.bindValue(":LSOURCE",     listingsource);
+    query.bindValue(":SERIESID",    denullify(seriesId));
+    query.bindValue(":PROGRAMID",   denullify(programId));
+    query.bindValue(":PREVSHOWN",   previouslyshown);
+    query.bindValue(":STARS",       stars);
+    query.bindValue(":SHOWTYPE",    showtype);
+    query.bindValue(":TITLEPRON",   title_pronounce);
+    query.bindValue(":COLORCODE",   colorcode);
+    query.bindValue(":SEASON",      season);
+    query.bindValue(":EPISODE",     episode);
+    query.bindValue(":TOTALEPISODES", totalepisodes);
+    query.bindValue(":INETREF",     inetref);
+
+    if (!query.exec())
+    {
+        MythDB::DBError("program insert", query);
+        return 0;
+    }
+
+    QList<EventRating>::const_iterator j = ratings.begin();
+    for (; j != ratings.end(); ++j)
+    {
+        query.prepare(
+            "INSERT IGNORE INTO programrating "
+            "       ( chanid, starttime, system, rating) "
+            "VALUES (:CHANID, :START,    :SYS,  :RATING)");
+        query.bindValue(":CHANID", chanid);
+        query.bindValue(":START",  starttime);
+        query.bindValue(":SYS",    (*j).system);
+        query.bindValue(":RATING", (*j).rating);
+
+        if (!query.exec())
+            MythDB::DBError("programrating insert", query);
+    }
+
+    if (credits)
+    {
+        for (uint i = 0; i < credits->size(); ++i)
+            (*credits)[i].InsertDB(query, chanid, starttime);
+    }
+
+    add_genres(query, genres, chanid, starttime);
+
+    return 1;
+}
+
+bool ProgramData::ClearDataByChannel(
+    uint chanid, const QDateTime &from, const QDateTime &to,
+    bool use_channel_time_offset)
+{
+    int secs = 0;
+    if (use_channel_time_offset)
+        secs = ChannelUtil::GetTimeOffset(chanid) * 60;
+
+    QDateTime newFrom = from.addSecs(secs);
+    QDateTime newTo   = to.addSecs(secs);
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("DELETE FROM program "
                   "WHERE starttime >= :FROM AND starttime < :TO "
                   "AND chanid = :CHANID ;");
     query.bindValue(":FROM", newFrom);
@@ -1379,6 +2143,24 @@ void ProgramData::HandlePrograms(
 {
     uint unchanged = 0, updated = 0;
 
+    HandlePrograms(sourceid, proglist, unchanged, updated);
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Updated programs: %1 Unchanged programs: %2")
+                .arg(updated) .arg(unchanged));
+}
+
+/** \fn ProgramData::HandlePrograms(uint, QMap<QString, QList<ProgInfo> >&, uint&, uint&, bool)
+ *  \brief Inserts the programs of each xmltvid in proglist, adding the
+ *         number of unchanged and updated programs to the counters.
+ *
+ *  With bulk set each channel is compared and written with a handful of
+ *  statements, see HandleProgramsBulk().
+ */
+void ProgramData::HandlePrograms(
+    uint sourceid, QMap<QString, QList<ProgInfo> > &proglist,
+    uint &unchanged, uint &updated, bool bulk)
+{
     MSqlQuery query(MSqlQuery::InitCon());
 
     QMap<QString, QList<ProgInfo> >::const_iterator mapiter;
@@ -1423,13 +2205,14 @@ void ProgramData::HandlePrograms(
 
         for (uint i = 0; i < chanids.size(); ++i)
         {
-            HandlePrograms(query, chanids[i], sortlist, unchanged, updated);
+            if (bulk)
+                HandleProgramsBulk(query, chanids[i], sortlist,
+                                   unchanged, updated);
+            else
+                HandlePrograms(query, chanids[i], sortlist,
+                               unchanged, updated);
         }
     }
-
-    LOG(VB_GENERAL, LOG_INFO,
-        QString("Updated programs: %1 Unchanged programs: %2")
-                .arg(updated) .arg(unchanged));
 }
 
 void ProgramData::HandlePrograms(MSqlQuery             &query,
@@ -1454,6 +2237,338 @@ void ProgramData::HandlePrograms(MSqlQuery             &query,
     }
 }
 
+// Columns compared by ProgramData::IsUnchanged(), in the order
+// load_programs() reads them. The SET columns are read as numbers.
+static const char *program_compare_columns =
+    "  starttime,      endtime,        title,           subtitle, "
+    "  description,    category,       category_type,   airdate, "
+    "  stars,          previouslyshown,title_pronounce, "
+    "  audioprop+0,    videoprop+0,    subtitletypes+0, "
+    "  partnumber,     parttotal,      seriesid,        showtype, "
+    "  colorcode,      syndicatedepisodenumber,         programid, "
+    "  inetref ";
+
+/** \fn ProgramData::LoadPrograms(MSqlQuery&, uint, const QDateTime&, const QDateTime&, QMultiMap<QDateTime, ProgInfo>&)
+ *  \brief Reads the programs of a channel starting in [from, to) into
+ *         existing, keyed on their start time.
+ *
+ *  A program with a column that cannot be compared in memory gets an
+ *  invalid end time so that it is never found unchanged.
+ */
+bool ProgramData::LoadPrograms(
+    MSqlQuery &query, uint chanid, const QDateTime &from,
+    const QDateTime &to, QMultiMap<QDateTime, ProgInfo> &existing)
+{
+    query.prepare(
+        QString("SELECT %1 "
+                "FROM program "
+                "WHERE chanid     = :CHANID AND "
+                "      starttime >= :FROM   AND "
+                "      starttime <  :TO "
+                "ORDER BY starttime")
+        .arg(program_compare_columns));
+    query.bindValue(":CHANID", chanid);
+    query.bindValue(":FROM",   from);
+    query.bindValue(":TO",     to);
+
+    if (!query.exec())
+    {
+        MythDB::DBError("ProgramData::LoadPrograms", query);
+        return false;
+    }
+
+    while (query.next())
+    {
+        ProgInfo pi;
+        pi.starttime       = MythDate::as_utc(query.value(0).toDateTime());
+        pi.endtime         = MythDate::as_utc(query.value(1).toDateTime());
+        pi.title           = query.value(2).toString();
+        pi.subtitle        = query.value(3).toString();
+        pi.description     = query.value(4).toString();
+        pi.category        = query.value(5).toString();
+        QString cattype    = query.value(6).toString();
+        pi.categoryType    = string_to_myth_category_type(cattype);
+        pi.airdate         = query.value(7).toUInt();
+        pi.stars           = query.value(8).toFloat();
+        pi.previouslyshown = query.value(9).toBool();
+        pi.title_pronounce = query.value(10).toString();
+        pi.audioProps      = query.value(11).toUInt();
+        pi.videoProps      = query.value(12).toUInt();
+        pi.subtitleType    = query.value(13).toUInt();
+        pi.partnumber      = query.value(14).toUInt();
+        pi.parttotal       = query.value(15).toUInt();
+        pi.seriesId        = query.value(16).toString();
+        pi.showtype        = query.value(17).toString();
+        pi.colorcode       = query.value(18).toString();
+        pi.syndicatedepisodenumber = query.value(19).toString();
+        pi.programId       = query.value(20).toString();
+        pi.inetref         = query.value(21).toString();
+
+        bool comparable =
+            (myth_category_type_to_string(pi.categoryType) == cattype);
+        for (int i = 0; comparable && i < 22; i++)
+            comparable = !query.isNull(i);
+        if (!comparable)
+            pi.endtime = QDateTime();
+
+        existing.insert(pi.starttime, pi);
+    }
+
+    return true;
+}
+
+// In memory version of the comparison made by ProgramData::IsUnchanged().
+// Strings are compared exactly, where MySQL may ignore case, so at worst
+// a few more programs than before are written again.
+static bool is_unchanged(const ProgInfo &db, const ProgInfo &pi)
+{
+    return db.endtime.isValid() && pi.endtime.isValid() &&
+        db.endtime         == pi.endtime &&
+        db.title           == pi.title &&
+        db.subtitle        == pi.subtitle &&
+        db.description     == pi.description &&
+        db.category        == pi.category &&
+        db.categoryType    == pi.categoryType &&
+        db.airdate         == pi.airdate &&
+        qAbs(db.stars - pi.stars) <= 0.001f &&
+        db.previouslyshown == pi.previouslyshown &&
+        db.title_pronounce == pi.title_pronounce &&
+        db.audioProps      == pi.audioProps &&
+        db.videoProps      == pi.videoProps &&
+        db.subtitleType    == pi.subtitleType &&
+        db.partnumber      == pi.partnumber &&
+        db.parttotal       == pi.parttotal &&
+        db.seriesId        == pi.seriesId &&
+        db.showtype        == pi.showtype &&
+        db.colorcode       == pi.colorcode &&
+        db.syndicatedepisodenumber == pi.syndicatedepisodenumber &&
+        db.programId       == pi.programId &&
+        db.inetref         == pi.inetref;
+}
+
+// Maximum number of rows or ranges in one statement of the bulk path
+static const int kMaxBulkRows = 50;
+
+/** \fn ProgramData::DeleteRanges(MSqlQuery&, uint, const QList<QPair<QDateTime, QDateTime> >&)
+ *  \brief Bulk version of ClearDataByChannel(), deleting the programs
+ *         starting in any of the given [from, to) ranges.
+ */
+bool ProgramData::DeleteRanges(
+    MSqlQuery &query, uint chanid,
+    const QList<QPair<QDateTime, QDateTime> > &ranges)
+{
+    static const char *tables[] =
+        { "program", "programrating", "credits", "programgenres" };
+
+    bool ok = true;
+    for (int first = 0; first < ranges.size(); first += kMaxBulkRows)
+    {
+        int count = min(kMaxBulkRows, ranges.size() - first);
+
+        QStringList where;
+        for (int i = 0; i < count; i++)
+        {
+            where.push_back(
+                QString("(starttime >= :FROM%1 AND starttime < :TO%1)")
+                .arg(i));
+        }
+
+        for (uint t = 0; t < sizeof(tables) / sizeof(tables[0]); t++)
+        {
+            query.prepare(
+                QString("DELETE FROM %1 WHERE chanid = :CHANID AND (%2)")
+                .arg(tables[t]).arg(where.join(" OR ")));
+            query.bindValue(":CHANID", chanid);
+            for (int i = 0; i < count; i++)
+            {
+                query.bindValue(QString(":FROM%1").arg(i),
+                                ranges[first + i].first);
+                query.bindValue(QString(":TO%1").arg(i),
+                                ranges[first + i].second);
+            }
+
+            if (!query.exec())
+            {
+                MythDB::DBError("ProgramData::DeleteRanges", query);
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+// Writes programs with one multi-row statement, as ProgInfo::InsertDB()
+// would write them one at a time, but without their extras.
+static bool insert_programs(MSqlQuery &query, uint chanid,
+                            const QList<const ProgInfo*> &programs)
+{
+    QString values = multi_row_values(
+        "(" + program_placeholders("%1") +
+        ", :SHOWTYPE%1, :TITLEPRON%1, :COLORCODE%1)", programs.size());
+    query.prepare(
+        QString("REPLACE INTO program "
+                "(%1, showtype, title_pronounce, colorcode) VALUES %2")
+        .arg(program_columns, values));
+
+    for (int i = 0; i < programs.size(); i++)
+    {
+        const ProgInfo &pi = *programs[i];
+        QString n = QString::number(i);
+
+        LOG(VB_XMLTV, LOG_INFO,
+            QString("Inserting new program    : %1 - %2 %3 %4")
+                .arg(pi.starttime.toString(Qt::ISODate))
+                .arg(pi.endtime.toString(Qt::ISODate))
+                .arg(pi.channel)
+                .arg(pi.title));
+
+        bind_program(query, n, chanid, pi);
+        query.bindValue(":ENDTIME"   + n, denullify(pi.endtime));
+        query.bindValue(":SHOWTYPE"  + n, pi.showtype);
+        query.bindValue(":TITLEPRON" + n, pi.title_pronounce);
+        query.bindValue(":COLORCODE" + n, pi.colorcode);
+    }
+
+    if (!query.exec())
+    {
+        MythDB::DBError("program insert", query);
+        return false;
+    }
+
+    return true;
+}
+
+/** \fn ProgramData::InsertPrograms(MSqlQuery&, uint, const QList<const ProgInfo*>&)
+ *  \brief Writes new programs and their extras with multi-row statements.
+ *  \return number of programs written
+ */
+uint ProgramData::InsertPrograms(
+    MSqlQuery &query, uint chanid, const QList<const ProgInfo*> &programs)
+{
+    ProgramExtrasWriter extras;
+    uint count = 0;
+
+    for (int first = 0; first < programs.size(); first += kMaxBulkRows)
+    {
+        QList<const ProgInfo*> chunk = programs.mid(first, kMaxBulkRows);
+        if (!insert_programs(query, chanid, chunk))
+        {
+            // Retry one at a time so a bad program only loses itself
+            QList<const ProgInfo*> written;
+            for (int i = 0; i < chunk.size(); i++)
+            {
+                if (insert_programs(query, chanid, chunk.mid(i, 1)))
+                    written.push_back(chunk[i]);
+            }
+            chunk = written;
+        }
+
+        for (int i = 0; i < chunk.size(); i++)
+            extras.Add(chunk[i]->starttime, *chunk[i]);
+        count += chunk.size();
+    }
+
+    extras.Write(query, chanid);
+
+    return count;
+}
+
+/** \fn ProgramData::HandleProgramsBulk(MSqlQuery&, uint, const QList<ProgInfo*>&, uint&, uint&)
+ *  \brief Same as HandlePrograms(MSqlQuery&, uint, const QList<ProgInfo*>&,
+ *         uint&, uint&), but with a handful of statements per channel.
+ *
+ *  The channel's schedule covering the new programs is read in one query
+ *  and compared in memory. Only the programs that changed are then
+ *  written, deleting what they overlap with bulk statements first.
+ */
+void ProgramData::HandleProgramsBulk(MSqlQuery              &query,
+                                     uint                    chanid,
+                                     const QList<ProgInfo*> &sortlist,
+                                     uint &unchanged,
+                                     uint &updated)
+{
+    if (sortlist.empty())
+        return;
+
+    // sortlist is ordered by start time
+    QDateTime from = sortlist.front()->starttime;
+    QDateTime to   = sortlist.back()->starttime.addSecs(1);
+    QList<ProgInfo*>::const_iterator it = sortlist.begin();
+    for (; it != sortlist.end(); ++it)
+    {
+        if ((*it)->endtime.isValid() && (*it)->endtime > to)
+            to = (*it)->endtime;
+    }
+
+    QMultiMap<QDateTime, ProgInfo> existing;
+    if (!LoadPrograms(query, chanid, from, to, existing))
+    {
+        HandlePrograms(query, chanid, sortlist, unchanged, updated);
+        return;
+    }
+
+    QList<QPair<QDateTime, QDateTime> > deletes;
+    QList<const ProgInfo*> inserts;
+    for (it = sortlist.begin(); it != sortlist.end(); ++it)
+    {
+        const ProgInfo &pi = **it;
+
+        bool same = false;
+        QMultiMap<QDateTime, ProgInfo>::const_iterator eit =
+            existing.constFind(pi.starttime);
+        for (; !same && eit != existing.constEnd() &&
+                 eit.key() == pi.starttime; ++eit)
+        {
+            same = is_unchanged(*eit, pi);
+        }
+
+        if (same)
+        {
+            unchanged++;
+            continue;
+        }
+
+        // Remove what DeleteOverlaps() would have removed
+        if (pi.endtime.isValid() && pi.starttime < pi.endtime)
+        {
+            QMultiMap<QDateTime, ProgInfo>::iterator dit =
+                existing.lowerBound(pi.starttime);
+            while (dit != existing.end() && dit.key() < pi.endtime)
+            {
+                LOG(VB_XMLTV, LOG_INFO,
+                    QString("Removing existing program: %1 - %2 %3 %4")
+                    .arg(dit->starttime.toString(Qt::ISODate))
+                    .arg(dit->endtime.toString(Qt::ISODate))
+                    .arg(pi.channel)
+                    .arg(dit->title));
+                dit = existing.erase(dit);
+            }
+
+            if (!deletes.empty() && deletes.back().second >= pi.starttime)
+                deletes.back().second = max(deletes.back().second, pi.endtime);
+            else
+                deletes.push_back(qMakePair(pi.starttime, pi.endtime));
+        }
+
+        inserts.push_back(&pi);
+    }
+
+    if (!deletes.empty() && !DeleteRanges(query, chanid, deletes))
+    {
+        LOG(VB_XMLTV, LOG_ERR,
+            QString("Program delete failed    : %1 - %2 %3, "
+                    "not writing %4 programs")
+                .arg(deletes.front().first.toString(Qt::ISODate))
+                .arg(deletes.back().second.toString(Qt::ISODate))
+                .arg(sortlist.front()->channel)
+                .arg(inserts.size()));
+        return;
+    }
+
+    updated += InsertPrograms(query, chanid, inserts);
+}
+
 int ProgramData::fix_end_times(void)
 {
     int count = 0;
@@ -1625,3 +2740,108 @@ bool ProgramData::DeleteOverlaps(
 
     return true;
 }
+
+/// Writes the programs of one xmltvid for a ProgramUpdater.
+class ProgramUpdaterRunner : public QRunnable
+{
+  public:
+    ProgramUpdaterRunner(ProgramUpdater *parent, const QString &xmltvid,
+                         QList<ProgInfo> &programs) :
+        m_parent(parent), m_xmltvid(xmltvid)
+    {
+        m_programs[xmltvid].swap(programs);
+    }
+
+    void run(void)
+    {
+        uint unchanged = 0, updated = 0;
+        ProgramData::HandlePrograms(m_parent->m_sourceid, m_programs,
+                                    unchanged, updated, m_parent->m_bulk);
+        m_parent->Done(m_xmltvid, unchanged, updated);
+    }
+
+  private:
+    ProgramUpdater                 *m_parent;
+    QString                         m_xmltvid;
+    QMap<QString, QList<ProgInfo> > m_programs;
+};
+
+ProgramUpdater::ProgramUpdater(uint sourceid, int threads, bool bulk) :
+    m_sourceid(sourceid), m_bulk(bulk), m_pool(NULL),
+    m_pending(0), m_maxPending(threads * 2),
+    m_unchanged(0), m_updated(0)
+{
+    if (threads > 1)
+    {
+        m_pool = new MThreadPool("ProgramUpdater");
+        m_pool->setMaxThreadCount(threads);
+    }
+}
+
+ProgramUpdater::~ProgramUpdater()
+{
+    Wait();
+    delete m_pool;
+}
+
+void ProgramUpdater::Add(QMap<QString, QList<ProgInfo> > &proglist)
+{
+    if (!m_pool)
+    {
+        uint unchanged = 0, updated = 0;
+        ProgramData::HandlePrograms(m_sourceid, proglist,
+                                    unchanged, updated, m_bulk);
+        proglist.clear();
+        Done(QString(), unchanged, updated);
+        return;
+    }
+
+    QMap<QString, QList<ProgInfo> >::iterator it = proglist.begin();
+    for (; it != proglist.end(); ++it)
+    {
+        if (it.key().isEmpty() || it->empty())
+            continue;
+
+        {
+            QMutexLocker locker(&m_lock);
+            while (m_pending >= m_maxPending || m_busy.contains(it.key()))
+                m_wait.wait(&m_lock);
+            m_busy.insert(it.key());
+            m_pending++;
+        }
+
+        m_pool->start(new ProgramUpdaterRunner(this, it.key(), *it),
+                      QString("ProgramUpdater-%1").arg(it.key()));
+    }
+
+    proglist.clear();
+}
+
+void ProgramUpdater::Wait(void)
+{
+    QMutexLocker locker(&m_lock);
+    while (m_pending > 0)
+        m_wait.wait(&m_lock);
+}
+
+uint ProgramUpdater::GetUnchanged(void) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_unchanged;
+}
+
+uint ProgramUpdater::GetUpdated(void) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_updated;
+}
+
+void ProgramUpdater::Done(const QString &xmltvid, uint unchanged, uint updated)
+{
+    QMutexLocker locker(&m_lock);
+    m_unchanged += unchanged;
+    m_updated   += updated;
+    if (m_busy.remove(xmltvid))
+        m_pending--;
+    m_wait.wakeAll();
+}
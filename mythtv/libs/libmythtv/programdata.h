@@ -13,6 +13,10 @@ using namespace std;
 #include <QDateTime>
 #include <QList>
 #include <QMap>
+#include <QPair>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
 #include <QStringList>
 
 // MythTV headers
@@ -22,6 +26,7 @@ using namespace std;
 #include "eithelper.h" /* for FixupValue */
 
 class MSqlQuery;
+class MThreadPool;
 
 class MTV_PUBLIC DBPerson
 {
@@ -52,6 +57,8 @@ class MTV_PUBLIC DBPerson
                   const QDateTime &starttime) const;
 
   private:
+    friend class ProgramExtrasWriter;
+
     uint GetPersonDB(MSqlQuery &query) const;
     uint InsertPersonDB(MSqlQuery &query) const;
     uint InsertCreditsDB(MSqlQuery &query, uint personid, uint chanid,
@@ -146,6 +153,9 @@ class MTV_PUBLIC DBEvent
     DBEvent &operator=(const DBEvent&);
 
   protected:
+    friend class EITBatchWriter;
+
+    DBEvent MergeMatch(const DBEvent &match) const;
     uint GetOverlappingPrograms(
         MSqlQuery&, uint chanid, vector<DBEvent> &programs) const;
     int  GetMatch(
@@ -238,6 +248,105 @@ class MTV_PUBLIC DBEventEIT : public DBEvent
     QMap<QString,QString> items;
 };
 
+/** \class ProgramExtrasWriter
+ *  \brief Writes the ratings, credits and genres of new programs with
+ *         multi-row statements.
+ */
+class ProgramExtrasWriter
+{
+  public:
+    ProgramExtrasWriter() : m_statements(0) {}
+
+    /// Queues the extras of event, written as the program at starttime.
+    void Add(const QDateTime &starttime, const DBEvent &event);
+    void Write(MSqlQuery &query, uint chanid);
+
+    /// Number of statements run so far
+    uint GetStatements(void) const { return m_statements; }
+
+  private:
+    void WriteRatings(MSqlQuery &query, uint chanid);
+    void WriteCredits(MSqlQuery &query, uint chanid);
+    void WriteGenres(MSqlQuery &query, uint chanid);
+    bool Exec(MSqlQuery &query, const char *name);
+
+  private:
+    QList<QDateTime>      m_starttimes;
+    QList<const DBEvent*> m_events;
+    uint                  m_statements;
+
+    /// Maximum number of rows in one multi-row statement
+    static const int kMaxRows;
+};
+
+/** \class EITBatchWriter
+ *  \brief Writes a batch of EIT events to the program tables.
+ *
+ *  Events are grouped per channel into time windows. The programs
+ *  overlapping a window are read with a single query and each event is
+ *  matched against them in memory, using the same rules as
+ *  DBEvent::UpdateDB(). New programs, and updates that keep their start
+ *  time, are then written with multi-row statements.
+ */
+class MTV_PUBLIC EITBatchWriter
+{
+  public:
+    EITBatchWriter();
+    ~EITBatchWriter() { ClearRows(); }
+
+    uint Write(const QList<DBEventEIT*> &events, int match_threshold);
+
+    QString GetStatistics(void) const;
+
+  private:
+    /// A program on the channel, as it will be once the window is flushed
+    struct Row
+    {
+        DBEvent       *program;
+        const DBEvent *source;   ///< Event still to be written, or NULL
+        bool           update;   ///< Update the existing program in place
+    };
+
+    uint WriteWindow(MSqlQuery &query, uint chanid,
+                     const QList<const DBEventEIT*> &events,
+                     const QDateTime &start, const QDateTime &end,
+                     int match_threshold);
+    bool ReadWindow(MSqlQuery &query, uint chanid,
+                    const QDateTime &start, const QDateTime &end);
+    uint WriteEvent(MSqlQuery &query, uint chanid,
+                    const DBEventEIT &event, int match_threshold);
+    bool MoveOutOfTheWay(MSqlQuery &query, uint chanid,
+                         const DBEvent &event, Row &row);
+    bool ProgramExists(const QDateTime &starttime) const;
+    void AddRow(const DBEvent &program, const DBEvent *source, bool update);
+    uint Flush(MSqlQuery &query, uint chanid);
+    QList<const Row*> FlushPrograms(MSqlQuery &query, uint chanid,
+                                    const QList<const Row*> &rows,
+                                    bool update);
+    bool WritePrograms(MSqlQuery &query, uint chanid,
+                       const QList<const Row*> &rows, bool update);
+    bool Exec(MSqlQuery &query, const char *name);
+    void ClearRows(void);
+
+  private:
+    QList<Row>       m_rows;
+    QList<QDateTime> m_manual;   ///< Start times of manual programs
+
+    // statistics
+    uint64_t m_events;
+    uint64_t m_written;
+    uint64_t m_windows;
+    uint64_t m_batched;          ///< written with multi-row statements
+    uint64_t m_unbatched;        ///< written one statement at a time
+    uint64_t m_statements;
+    uint64_t m_elapsed;          ///< milliseconds
+
+    /// Longest time span read and written as one window, in seconds
+    static const int  kWindowSecs;
+    /// Maximum number of rows in one multi-row statement
+    static const uint kMaxRows;
+};
+
 class MTV_PUBLIC ProgInfo : public DBEvent
 {
   public:
@@ -269,6 +378,10 @@ class MTV_PUBLIC ProgramData
   public:
     static void HandlePrograms(uint sourceid,
                                QMap<QString, QList<ProgInfo> > &proglist);
+    static void HandlePrograms(uint sourceid,
+                               QMap<QString, QList<ProgInfo> > &proglist,
+                               uint &unchanged, uint &updated,
+                               bool bulk = false);
 
     static int  fix_end_times(void);
     static bool ClearDataByChannel(
@@ -288,10 +401,68 @@ class MTV_PUBLIC ProgramData
         MSqlQuery &query, uint chanid,
         const QList<ProgInfo*> &sortlist,
         uint &unchanged, uint &updated);
+    static void HandleProgramsBulk(
+        MSqlQuery &query, uint chanid,
+        const QList<ProgInfo*> &sortlist,
+        uint &unchanged, uint &updated);
+    static bool LoadPrograms(
+        MSqlQuery &query, uint chanid,
+        const QDateTime &from, const QDateTime &to,
+        QMultiMap<QDateTime, ProgInfo> &existing);
+    static bool DeleteRanges(
+        MSqlQuery &query, uint chanid,
+        const QList<QPair<QDateTime, QDateTime> > &ranges);
+    static uint InsertPrograms(
+        MSqlQuery &query, uint chanid,
+        const QList<const ProgInfo*> &programs);
     static bool IsUnchanged(
         MSqlQuery &query, uint chanid, const ProgInfo &pi);
     static bool DeleteOverlaps(
         MSqlQuery &query, uint chanid, const ProgInfo &pi);
 };
 
+/** \class ProgramUpdater
+ *  \brief Hands the programs of each channel to a pool of threads, each
+ *         with its own database connection, to be written.
+ *
+ *  With a single thread the programs are written as they are added,
+ *  on the caller's connection. With bulk set they are compared and
+ *  written a channel at a time, see ProgramData::HandleProgramsBulk().
+ *
+ *  Add() only blocks when enough channels are queued already, so parsing
+ *  continues while earlier channels are written. The programs of one
+ *  xmltvid are never written by two threads at the same time.
+ */
+class MTV_PUBLIC ProgramUpdater
+{
+    friend class ProgramUpdaterRunner;
+
+  public:
+    ProgramUpdater(uint sourceid, int threads, bool bulk);
+    ~ProgramUpdater();
+
+    /// Queues the programs in proglist, leaving it empty.
+    void Add(QMap<QString, QList<ProgInfo> > &proglist);
+    /// Waits until all queued programs are written.
+    void Wait(void);
+
+    uint GetUnchanged(void) const;
+    uint GetUpdated(void) const;
+
+  private:
+    void Done(const QString &xmltvid, uint unchanged, uint updated);
+
+  private:
+    uint            m_sourceid;
+    bool            m_bulk;
+    MThreadPool    *m_pool;
+    mutable QMutex  m_lock;
+    QWaitCondition  m_wait;
+    QSet<QString>   m_busy;        ///< xmltvids being written
+    int             m_pending;
+    int             m_maxPending;
+    uint            m_unchanged;
+    uint            m_updated;
+};
+
 #endif // _PROGRAMDATA_H_
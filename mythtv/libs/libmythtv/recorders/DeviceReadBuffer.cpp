@@ -11,6 +11,11 @@ using namespace std;
 
 #ifndef _WIN32
 #include <sys/poll.h>
+#include <fcntl.h>
+#endif
+
+#ifdef __linux__
+#include <sys/eventfd.h>
 #endif
 
 /// Set this to 1 to report on statistics
@@ -26,18 +31,22 @@ DeviceReadBuffer::DeviceReadBuffer(
 
       // Data for managing the device ringbuffer
       dorun(false),
-      eof(false),                   error(false),
-      request_pause(false),         paused(false),
+      eof(0),                       error(0),
+      request_pause(0),             paused(false),
       using_poll(use_poll),
       poll_timeout_is_error(error_exit_on_poll_timeout),
       max_poll_wait(2500 /*ms*/),
 
-      size(0),                      used(0),
+      size(0),
       read_quanta(0),               dev_buffer_count(1),
       dev_read_size(0),             readThreshold(0),
 
-      buffer(NULL),                 readPtr(NULL),
-      writePtr(NULL),               endPtr(NULL),
+      buffer(NULL),                 endPtr(NULL),
+
+      writeTotal(0),                writePtr(NULL),
+      readTotal(0),                 readPtr(NULL),
+      discardTotal(0),
+      readerWaiting(0),             writerWaiting(0),
 
       // statistics
       max_used(0),                  avg_used(0),
@@ -50,6 +59,9 @@ DeviceReadBuffer::DeviceReadBuffer(
         wake_pipe_flags[i] = 0;
     }
 
+    OpenWakeFds(dataReadyFd);
+    OpenWakeFds(spaceReadyFd);
+
 #ifdef USING_MINGW
 #warning mingw DeviceReadBuffer::Poll
     if (using_poll)
@@ -69,6 +81,8 @@ DeviceReadBuffer::~DeviceReadBuffer()
         delete[] buffer;
         buffer = NULL;
     }
+    CloseWakeFds(dataReadyFd);
+    CloseWakeFds(spaceReadyFd);
 }
 
 bool DeviceReadBuffer::Setup(const QString &streamName, int streamfd,
@@ -85,16 +99,15 @@ bool DeviceReadBuffer::Setup(const QString &streamName, int streamfd,
     _stream_fd    = streamfd;
 
     // Setup device ringbuffer
-    eof           = false;
-    error         = false;
-    request_pause = false;
+    eof.storeRelease(0);
+    error.storeRelease(0);
+    request_pause.storeRelease(0);
     paused        = false;
 
     read_quanta   = (readQuanta) ? readQuanta : read_quanta;
     dev_buffer_count = deviceBufferCount;
     size          = gCoreContext->GetNumSetting(
         "HDRingbufferSize", 50 * read_quanta) * 1024;
-    used          = 0;
     dev_read_size = read_quanta * (using_poll ? 256 : 48);
     dev_read_size = (deviceBufferSize) ?
         min(dev_read_size, (size_t)deviceBufferSize) : dev_read_size;
@@ -104,6 +117,9 @@ bool DeviceReadBuffer::Setup(const QString &streamName, int streamfd,
     readPtr       = buffer;
     writePtr      = buffer;
     endPtr        = buffer + size;
+    readTotal.storeRelease(0);
+    writeTotal.storeRelease(0);
+    discardTotal.storeRelease(0);
 
     // Initialize buffer, if it exists
     if (!buffer)
@@ -143,8 +159,8 @@ void DeviceReadBuffer::Start(void)
     }
 
     dorun = true;
-    error = false;
-    eof   = false;
+    error.storeRelease(0);
+    eof.storeRelease(0);
 
     start();
 
@@ -164,11 +180,12 @@ void DeviceReadBuffer::Reset(const QString &streamName, int streamfd)
     videodevice   = videodevice.isNull() ? "" : videodevice;
     _stream_fd    = streamfd;
 
-    used          = 0;
-    readPtr       = buffer;
-    writePtr      = buffer;
+    // Drop anything buffered, the reader continues from where
+    // the device thread will write next. The read indices belong
+    // to the reader, so it does the dropping on its next Read().
+    discardTotal.storeRelease(writeTotal.loadAcquire());
 
-    error         = false;
+    error.storeRelease(0);
 }
 
 void DeviceReadBuffer::Stop(void)
@@ -180,6 +197,7 @@ void DeviceReadBuffer::Stop(void)
         dorun = false;
         locker.unlock();
         WakePoll();
+        WakeWaiter(writerWaiting, spaceReadyFd);
         wait();
     }
     LOG(VB_RECORD, LOG_INFO, LOC + "Stop() -- end");
@@ -188,8 +206,9 @@ void DeviceReadBuffer::Stop(void)
 void DeviceReadBuffer::SetRequestPause(bool req)
 {
     QMutexLocker locker(&lock);
-    request_pause = req;
+    request_pause.storeRelease(req ? 1 : 0);
     WakePoll();
+    WakeWaiter(writerWaiting, spaceReadyFd);
 }
 
 void DeviceReadBuffer::SetPaused(bool val)
@@ -220,6 +239,91 @@ void DeviceReadBuffer::WakePoll(void) const
     }
 }
 
+/** \fn DeviceReadBuffer::OpenWakeFds(int[2])
+ *  \brief Opens the descriptors one side of the ring blocks on while
+ *         waiting for the other. On Linux both ends are one eventfd.
+ */
+void DeviceReadBuffer::OpenWakeFds(int fds[2])
+{
+    fds[0] = fds[1] = -1;
+#if defined(__linux__)
+    fds[0] = fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif !defined(_WIN32)
+    if (pipe(fds) < 0)
+    {
+        fds[0] = fds[1] = -1;
+        return;
+    }
+    for (uint i = 0; i < 2; i++)
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+#endif
+    if (fds[0] < 0)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            "Unable to create wakeup descriptor, falling back to polling");
+    }
+}
+
+void DeviceReadBuffer::CloseWakeFds(int fds[2])
+{
+    if (fds[0] >= 0)
+        ::close(fds[0]);
+    if (fds[1] >= 0 && fds[1] != fds[0])
+        ::close(fds[1]);
+    fds[0] = fds[1] = -1;
+}
+
+/** \fn DeviceReadBuffer::WakeWaiter(QAtomicInt&,const int[2]) const
+ *  \brief Wakes the other side of the ring, if it said it was waiting.
+ *
+ *   Only the transition of \p waiting from 1 to 0 costs a system call,
+ *   so a busy ring doesn't pay for wakeups nobody is waiting for.
+ */
+void DeviceReadBuffer::WakeWaiter(QAtomicInt &waiting, const int fds[2]) const
+{
+    if (!waiting.testAndSetOrdered(1, 0) || fds[1] < 0)
+        return;
+
+#ifdef __linux__
+    uint64_t val = 1;
+#else
+    char val = '0';
+#endif
+    if (::write(fds[1], &val, sizeof(val)) < 0 && EAGAIN != errno)
+    {
+        LOG(VB_RECORD, LOG_DEBUG, LOC + "WakeWaiter failed" + ENO);
+    }
+}
+
+/** \fn DeviceReadBuffer::WaitForWake(QAtomicInt&,const int[2],int) const
+ *  \brief Blocks for up to \p timeout ms until WakeWaiter() is called.
+ *
+ *   The caller must set \p waiting and recheck its condition before
+ *   calling this, otherwise a wakeup sent in between can be missed.
+ */
+void DeviceReadBuffer::WaitForWake(
+    QAtomicInt &waiting, const int fds[2], int timeout) const
+{
+#ifdef _WIN32
+    (void) fds;
+    usleep(timeout * 1000);
+#else
+    struct pollfd pfd;
+    pfd.fd      = fds[0];
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+    if (fds[0] < 0)
+        usleep(timeout * 1000);
+    else if (poll(&pfd, 1, timeout) > 0)
+    {
+        char dummy[128];
+        if (::read(fds[0], dummy, sizeof(dummy)) < 0 && EAGAIN != errno)
+            LOG(VB_RECORD, LOG_DEBUG, LOC + "WaitForWake failed" + ENO);
+    }
+#endif
+    waiting.storeRelease(0);
+}
+
 void DeviceReadBuffer::ClosePipes(void) const
 {
     for (uint i = 0; i < 2; i++)
@@ -261,69 +365,77 @@ bool DeviceReadBuffer::WaitForUnpause(unsigned long timeout)
 
 bool DeviceReadBuffer::IsPauseRequested(void) const
 {
-    QMutexLocker locker(&lock);
-    return request_pause;
+    return request_pause.loadAcquire();
 }
 
 bool DeviceReadBuffer::IsErrored(void) const
 {
-    QMutexLocker locker(&lock);
-    return error;
+    return error.loadAcquire();
 }
 
 bool DeviceReadBuffer::IsEOF(void) const
 {
-    QMutexLocker locker(&lock);
-    return eof;
+    return eof.loadAcquire();
 }
 
 bool DeviceReadBuffer::IsRunning(void) const
 {
-    QMutexLocker locker(&lock);
     return isRunning();
 }
 
 uint DeviceReadBuffer::GetUnused(void) const
 {
-    QMutexLocker locker(&lock);
-    return size - used;
+    return size - GetUsed();
 }
 
 uint DeviceReadBuffer::GetUsed(void) const
 {
-    QMutexLocker locker(&lock);
-    return used;
+    // Load the read index first, the write index can then only be
+    // ahead of it, whichever thread we are called from.
+    quint64 read  = readTotal.loadAcquire();
+    quint64 write = writeTotal.loadAcquire();
+    return write - read;
 }
 
 uint DeviceReadBuffer::GetContiguousUnused(void) const
 {
-    QMutexLocker locker(&lock);
     return endPtr - writePtr;
 }
 
+/// Called by the device thread only, publishes \p len new bytes
 void DeviceReadBuffer::IncrWritePointer(uint len)
 {
-    QMutexLocker locker(&lock);
-    used     += len;
     writePtr += len;
     writePtr  = (writePtr >= endPtr) ? buffer + (writePtr - endPtr) : writePtr;
+    writeTotal.fetchAndAddOrdered(len);
 #if REPORT_RING_STATS
+    size_t used = GetUsed();
     max_used = max(used, max_used);
     avg_used = ((avg_used * avg_buf_write_cnt) + used) / (avg_buf_write_cnt+1);
     ++avg_buf_write_cnt;
 #endif
-    dataWait.wakeAll();
+    WakeWaiter(readerWaiting, dataReadyFd);
 }
 
+/// Called by the reader only, releases \p len bytes to the device thread
 void DeviceReadBuffer::IncrReadPointer(uint len)
 {
-    QMutexLocker locker(&lock);
-    used    -= len;
     readPtr += len;
-    readPtr  = (readPtr == endPtr) ? buffer : readPtr;
+    readPtr  = (readPtr >= endPtr) ? buffer + (readPtr - endPtr) : readPtr;
+    readTotal.fetchAndAddOrdered(len);
 #if REPORT_RING_STATS
     ++avg_buf_read_cnt;
 #endif
+    WakeWaiter(writerWaiting, spaceReadyFd);
+}
+
+/// Called by the reader only, drops what was buffered before a Reset()
+void DeviceReadBuffer::HandleDiscard(void)
+{
+    quint64 discard = discardTotal.fetchAndStoreOrdered(0);
+    quint64 read    = readTotal.loadAcquire();
+    if (discard > read)
+        IncrReadPointer(discard - read);
 }
 
 void DeviceReadBuffer::run(void)
@@ -359,13 +471,10 @@ void DeviceReadBuffer::run(void)
         if (using_poll && !Poll())
             continue;
 
+        if (error.loadAcquire())
         {
-            QMutexLocker locker(&lock);
-            if (error)
-            {
-                LOG(VB_RECORD, LOG_ERR, LOC + "fill_ringbuffer: error state");
-                break;
-            }
+            LOG(VB_RECORD, LOG_ERR, LOC + "fill_ringbuffer: error state");
+            break;
         }
 
         /* Some device drivers segment their buffer into small pieces,
@@ -404,9 +513,9 @@ void DeviceReadBuffer::run(void)
     ClosePipes();
 
     lock.lock();
-    eof     = true;
+    eof.storeRelease(1);
+    WakeWaiter(readerWaiting, dataReadyFd);
     runWait.wakeAll();
-    dataWait.wakeAll();
     pauseWait.wakeAll();
     unpauseWait.wakeAll();
     lock.unlock();
@@ -489,7 +598,7 @@ bool DeviceReadBuffer::Poll(void) const
         else if (polls[0].revents & POLLNVAL)
         {
             LOG(VB_GENERAL, LOG_ERR, LOC + "poll error" + ENO);
-            error = true;
+            error.storeRelease(1);
             return true;
         }
 
@@ -524,8 +633,7 @@ bool DeviceReadBuffer::Poll(void) const
                     (timer.elapsed() >= (int)max_poll_wait))
                 {
                     LOG(VB_GENERAL, LOG_ERR, LOC + "Poll giving up 1");
-                    QMutexLocker locker(&lock);
-                    error = true;
+                    error.storeRelease(1);
                     return true;
                 }
             }
@@ -543,8 +651,7 @@ bool DeviceReadBuffer::Poll(void) const
         {
             LOG(VB_GENERAL, LOG_ERR, LOC + QString("Poll giving up after %1ms")
                 .arg(max_poll_wait));
-            QMutexLocker locker(&lock);
-            error = true;
+            error.storeRelease(1);
             return true;
         }
     }
@@ -571,8 +678,7 @@ bool DeviceReadBuffer::CheckForErrors(
         if (++errcnt > 5)
         {
             LOG(VB_RECORD, LOG_ERR, LOC + "Too many errors.");
-            QMutexLocker locker(&lock);
-            error = true;
+            error.storeRelease(1);
         }
         return false;
     }
@@ -608,8 +714,7 @@ bool DeviceReadBuffer::CheckForErrors(
         if (++errcnt > 5)
         {
             LOG(VB_RECORD, LOG_ERR, LOC + "Too many errors.");
-            QMutexLocker locker(&lock);
-            error = true;
+            error.storeRelease(1);
             return false;
         }
 
@@ -623,9 +728,7 @@ bool DeviceReadBuffer::CheckForErrors(
             LOG(VB_GENERAL, LOG_ERR, LOC +
                 QString("End-Of-File? fd(%1)").arg(_stream_fd));
 
-            lock.lock();
-            eof = true;
-            lock.unlock();
+            eof.storeRelease(1);
 
             return false;
         }
@@ -644,6 +747,8 @@ bool DeviceReadBuffer::CheckForErrors(
  */
 uint DeviceReadBuffer::Read(unsigned char *buf, const uint count)
 {
+    HandleDiscard();
+
     uint avail = WaitForUsed(min(count, (uint)readThreshold), 20);
     size_t cnt = min(count, avail);
 
@@ -682,7 +787,8 @@ uint DeviceReadBuffer::Read(unsigned char *buf, const uint count)
 
 /** \fn DeviceReadBuffer::WaitForUnused(uint) const
  *  \param needed Number of bytes we want to write
- *  \return bytes available for writing
+ *  \return bytes available for writing, without waiting when no more
+ *          than read_quanta bytes are free
  */
 uint DeviceReadBuffer::WaitForUnused(uint needed) const
 {
@@ -692,10 +798,18 @@ uint DeviceReadBuffer::WaitForUnused(uint needed) const
     {
         while (unused < needed)
         {
-            unused = GetUnused();
             if (IsPauseRequested() || !IsOpen() || !dorun)
                 return 0;
-            usleep(5000);
+
+            writerWaiting.fetchAndStoreOrdered(1);
+            unused = GetUnused();
+            if (unused >= needed)
+            {
+                writerWaiting.storeRelease(0);
+                break;
+            }
+            WaitForWake(writerWaiting, spaceReadyFd, 5);
+            unused = GetUnused();
         }
         if (IsPauseRequested() || !IsOpen() || !dorun)
             return 0;
@@ -715,14 +829,20 @@ uint DeviceReadBuffer::WaitForUsed(uint needed, uint max_wait) const
     MythTimer timer;
     timer.start();
 
-    QMutexLocker locker(&lock);
-    size_t avail = used;
+    size_t avail = GetUsed();
     while ((needed > avail) && isRunning() &&
-           !request_pause && !error && !eof &&
+           !IsPauseRequested() && !IsErrored() && !IsEOF() &&
            (timer.elapsed() < (int)max_wait))
     {
-        dataWait.wait(locker.mutex(), 10);
-        avail = used;
+        readerWaiting.fetchAndStoreOrdered(1);
+        avail = GetUsed();
+        if (needed <= avail)
+        {
+            readerWaiting.storeRelease(0);
+            break;
+        }
+        WaitForWake(readerWaiting, dataReadyFd, 10);
+        avail = GetUsed();
     }
     return avail;
 }
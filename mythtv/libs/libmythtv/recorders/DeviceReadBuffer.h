@@ -8,6 +8,7 @@
 
 #include <QMutex>
 #include <QWaitCondition>
+#include <QAtomicInt>
 #include <QString>
 
 #include "mythtimer.h"
@@ -29,6 +30,12 @@ class DeviceReaderCB
  *  This allows us to read the device regularly even in the presence
  *  of long blocking conditions on writing to disk or accessing the
  *  database.
+ *
+ *  The ring itself is a lock free single producer, single consumer
+ *  queue: the device thread is the only writer and the recorder calling
+ *  Read() the only reader. Each side blocks on an eventfd (a pipe where
+ *  eventfd is not available) that the other side only signals when it
+ *  has announced it is waiting.
  */
 class DeviceReadBuffer : protected MThread
 {
@@ -66,16 +73,22 @@ class DeviceReadBuffer : protected MThread
     void SetPaused(bool);
     void IncrWritePointer(uint len);
     void IncrReadPointer(uint len);
+    void HandleDiscard(void);
 
     bool HandlePausing(void);
     bool Poll(void) const;
     void WakePoll(void) const;
     uint WaitForUnused(uint needed) const;
     uint WaitForUsed  (uint needed, uint max_wait /*ms*/) const;
+    void WakeWaiter(QAtomicInt &waiting, const int fds[2]) const;
+    void WaitForWake(QAtomicInt &waiting, const int fds[2],
+                     int timeout /*ms*/) const;
 
     bool IsPauseRequested(void) const;
     bool IsOpen(void) const { return _stream_fd >= 0; }
     void ClosePipes(void) const;
+    void OpenWakeFds(int fds[2]);
+    void CloseWakeFds(int fds[2]);
     uint GetUnused(void) const;
     uint GetContiguousUnused(void) const;
 
@@ -92,26 +105,38 @@ class DeviceReadBuffer : protected MThread
     // Data for managing the device ringbuffer
     mutable QMutex   lock;
     volatile bool    dorun;
-    bool             eof;
-    mutable bool     error;
-    bool             request_pause;
+    QAtomicInt       eof;
+    mutable QAtomicInt error;
+    QAtomicInt       request_pause;
     bool             paused;
     bool             using_poll;
     bool             poll_timeout_is_error;
     uint             max_poll_wait;
 
     size_t           size;
-    size_t           used;
     size_t           read_quanta;
     size_t           dev_buffer_count;
     size_t           dev_read_size;
     size_t           readThreshold;
     unsigned char   *buffer;
-    unsigned char   *readPtr;
-    unsigned char   *writePtr;
     unsigned char   *endPtr;
 
-    mutable QWaitCondition dataWait;
+    // Ring indices. writeTotal and writePtr are only changed by the
+    // device thread, readTotal and readPtr only by the reader. Each
+    // side's index starts its own cache line, and so does what follows.
+    // Reset() asks the reader to drop everything up to discardTotal.
+    alignas(64) QAtomicInteger<quint64> writeTotal;
+    unsigned char   *writePtr;
+    alignas(64) QAtomicInteger<quint64> readTotal;
+    unsigned char   *readPtr;
+    QAtomicInteger<quint64> discardTotal;
+
+    // Wakeups, set by a side before it blocks on its wake fd
+    alignas(64) mutable QAtomicInt readerWaiting;
+    mutable QAtomicInt writerWaiting;
+    int              dataReadyFd[2];
+    int              spaceReadyFd[2];
+
     QWaitCondition   runWait;
     QWaitCondition   pauseWait;
     QWaitCondition   unpauseWait;
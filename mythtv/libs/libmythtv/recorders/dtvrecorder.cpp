@@ -28,6 +28,7 @@
 #include "ringbuffer.h"
 #include "tv_rec.h"
 #include "mythsystemevent.h"
+#include "startcode.h"
 
 extern "C" {
 #include "libavcodec/mpegvideo.h"
@@ -283,8 +284,19 @@ void DTVRecorder::InitStreamData(void)
         _stream_data->SetDesiredProgram(_stream_data->DesiredProgram());
 }
 
-void DTVRecorder::BufferedWrite(const TSPacket &tspacket, bool insert)
+/** \fn DTVRecorder::BufferedWrite(const TSPacket*,uint,bool)
+ *  \brief Writes \p count packets stored back to back in memory,
+ *         or buffers them if we are waiting for a keyframe.
+ */
+void DTVRecorder::BufferedWrite(
+    const TSPacket *tspackets, uint count, bool insert)
 {
+    if (!count)
+        return;
+
+    const unsigned char *data = tspackets[0].data();
+    const uint size = count * TSPacket::kSize;
+
     if (!insert) // PAT/PMT may need inserted in front of any buffered data
     {
         // delay until first GOP to avoid decoder crash on res change
@@ -300,7 +312,7 @@ void DTVRecorder::BufferedWrite(const TSPacket &tspacket, bool insert)
             timeOfLatestDataTimer.start();
         }
 
-        int val = timeOfLatestDataCount.fetchAndAddRelaxed(1);
+        int val = timeOfLatestDataCount.fetchAndAddRelaxed(count);
         int thresh = timeOfLatestDataPacketInterval.fetchAndAddRelaxed(0);
         if (val > thresh)
         {
@@ -326,8 +338,8 @@ void DTVRecorder::BufferedWrite(const TSPacket &tspacket, bool insert)
         if (_buffer_packets)
         {
             int idx = _payload_buffer.size();
-            _payload_buffer.resize(idx + TSPacket::kSize);
-            memcpy(&_payload_buffer[idx], tspacket.data(), TSPacket::kSize);
+            _payload_buffer.resize(idx + size);
+            memcpy(&_payload_buffer[idx], data, size);
             return;
         }
 
@@ -341,7 +353,7 @@ void DTVRecorder::BufferedWrite(const TSPacket &tspacket, bool insert)
         }
     }
 
-    if (ringBuffer && ringBuffer->Write(tspacket.data(), TSPacket::kSize) < 0 &&
+    if (ringBuffer && ringBuffer->Write(data, size) < 0 &&
         curRecording && curRecording->GetRecordingStatus() != RecStatus::Failing)
     {
         LOG(VB_GENERAL, LOG_INFO, LOC +
@@ -463,7 +475,7 @@ bool DTVRecorder::FindMPEG2Keyframes(const TSPacket* tspacket)
 
     while (bufptr < bufend)
     {
-        bufptr = avpriv_find_start_code(bufptr, bufend, &_start_code);
+        bufptr = myth_find_start_code(bufptr, bufend, &_start_code);
         bytes_left = bufend - bufptr;
         if ((_start_code & 0xffffff00) == 0x00000100)
         {
@@ -1097,7 +1109,7 @@ void DTVRecorder::FindPSKeyFrames(const uint8_t *buffer, uint len)
 
         const uint8_t *tmp = bufptr;
         bufptr =
-            avpriv_find_start_code(bufptr + skip, bufend, &_start_code);
+            myth_find_start_code(bufptr + skip, bufend, &_start_code);
         _audio_bytes_remaining = 0;
         _other_bytes_remaining = 0;
         _video_bytes_remaining -= std::min(
@@ -1465,6 +1477,42 @@ void DTVRecorder::HandleSingleProgramPMT(ProgramMapTable *pmt, bool insert)
 }
 
 bool DTVRecorder::ProcessTSPacket(const TSPacket &tspacket)
+{
+    if (IsWritableTSPacket(tspacket))
+        BufferedWrite(tspacket);
+
+    return true;
+}
+
+/** \fn DTVRecorder::ProcessTSPackets(const TSPacket*,uint)
+ *  \brief Batch version of ProcessTSPacket(), consecutive packets that
+ *         are to be written are handed to BufferedWrite() together.
+ */
+bool DTVRecorder::ProcessTSPackets(const TSPacket *tspackets, uint count)
+{
+    // Fake keyframes are placed relative to the data written so far,
+    // so every packet has to be written before the next one is examined.
+    if (_input_pmt && _has_no_av)
+        return TSPacketListener::ProcessTSPackets(tspackets, count);
+
+    uint start = 0;
+    for (uint i = 0; i < count; i++)
+    {
+        if (IsWritableTSPacket(tspackets[i]))
+            continue;
+        BufferedWrite(tspackets + start, i - start);
+        start = i + 1;
+    }
+    BufferedWrite(tspackets + start, count - start);
+
+    return true;
+}
+
+/** \fn DTVRecorder::IsWritableTSPacket(const TSPacket&)
+ *  \brief Updates the packet statistics and returns true if this
+ *         non audio/video packet should be written to the recording.
+ */
+bool DTVRecorder::IsWritableTSPacket(const TSPacket &tspacket)
 {
     const uint pid = tspacket.PID();
 
@@ -1493,18 +1541,16 @@ bool DTVRecorder::ProcessTSPacket(const TSPacket &tspacket)
     else if (_stream_id[pid] == 0)
     {
         // Ignore this packet if the PID should be stripped
-        return true;
+        return false;
     }
     else
     {
         // There are audio/video streams. Only write the packet
         // if audio/video key-frames have been found
         if (_wait_for_keyframe_option && _first_keyframe < 0)
-            return true;
+            return false;
     }
 
-    BufferedWrite(tspacket);
-
     return true;
 }
 
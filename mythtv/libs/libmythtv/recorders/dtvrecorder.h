@@ -82,6 +82,7 @@ class DTVRecorder :
 
     // TSPacketListener
     bool ProcessTSPacket(const TSPacket &tspacket);
+    bool ProcessTSPackets(const TSPacket *tspackets, uint count);
 
     // TSPacketListenerAV
     bool ProcessVideoTSPacket(const TSPacket& tspacket);
@@ -100,7 +101,11 @@ class DTVRecorder :
     void HandleTimestamps(int stream_id, int64_t pts, int64_t dts);
     void UpdateFramesWritten(void);
 
-    void BufferedWrite(const TSPacket &tspacket, bool insert = false);
+    void BufferedWrite(const TSPacket &tspacket, bool insert = false)
+        { BufferedWrite(&tspacket, 1, insert); }
+    void BufferedWrite(const TSPacket *tspackets, uint count,
+                       bool insert = false);
+    bool IsWritableTSPacket(const TSPacket &tspacket);
 
     // MPEG TS "audio only" support
     bool FindAudioKeyframes(const TSPacket *tspacket);
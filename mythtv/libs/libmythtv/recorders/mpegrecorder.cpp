@@ -1266,6 +1266,15 @@ bool MpegRecorder::ProcessTSPacket(const TSPacket &tspacket_real)
     return ret;
 }
 
+bool MpegRecorder::ProcessTSPackets(const TSPacket *tspackets, uint count)
+{
+    // The HD-PVR PCR packets need to be rewritten one at a time
+    if (driver == "hdpvr")
+        return TSPacketListener::ProcessTSPackets(tspackets, count);
+
+    return DTVRecorder::ProcessTSPackets(tspackets, count);
+}
+
 void MpegRecorder::Reset(void)
 {
     LOG(VB_RECORD, LOG_INFO, LOC + "Reset(void)");
@@ -42,6 +42,7 @@ class MpegRecorder : public V4LRecorder,
 
     // TSPacketListener
     bool ProcessTSPacket(const TSPacket &tspacket);
+    bool ProcessTSPackets(const TSPacket *tspackets, uint count);
 
     // DeviceReaderCB
     virtual void ReaderPaused(int /*fd*/) { pauseWait.wakeAll(); }
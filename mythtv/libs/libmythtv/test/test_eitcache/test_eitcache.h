@@ -0,0 +1,102 @@
+/*
+ *  Class TestEITCache
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "eitcache.h"
+
+class TestEITCache: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void insert_find(void)
+    {
+        EITCacheMap map;
+
+        QVERIFY(map.Find(1001, 1) == NULL);
+
+        // enough to grow the table a few times
+        for (uint chanid = 1001; chanid <= 1020; chanid++)
+        {
+            for (uint eventid = 0; eventid < 1000; eventid++)
+                map.Insert(chanid, eventid, ((uint64_t)chanid << 32) | eventid);
+        }
+        QCOMPARE(map.Size(), 20000U);
+        QVERIFY(map.Size() * 2 <= map.Capacity());
+
+        for (uint chanid = 1001; chanid <= 1020; chanid++)
+        {
+            for (uint eventid = 0; eventid < 1000; eventid++)
+            {
+                uint64_t *sig = map.Find(chanid, eventid);
+                QVERIFY(sig != NULL);
+                QCOMPARE(*sig, ((uint64_t)chanid << 32) | eventid);
+            }
+        }
+        QVERIFY(map.Find(1021, 0) == NULL);
+        QVERIFY(map.Find(1001, 1000) == NULL);
+
+        // replacing keeps the size
+        map.Insert(1005, 17, 42);
+        QCOMPARE(map.Size(), 20000U);
+        QCOMPARE(*map.Find(1005, 17), (uint64_t)42);
+
+        // chanid 0 marks empty slots
+        map.Insert(0, 1, 1);
+        QCOMPARE(map.Size(), 20000U);
+    }
+
+    void compact(void)
+    {
+        EITCacheMap map;
+        for (uint eventid = 0; eventid < 10000; eventid++)
+            map.Insert(1001 + eventid % 7, eventid, eventid);
+
+        QVector<EITCacheMap::Entry> &table = map.Slots();
+        for (int i = 0; i < table.size(); i++)
+        {
+            if (table[i].chanid && (table[i].eventid % 10))
+                table[i].chanid = 0;
+        }
+        map.Compact();
+
+        QCOMPARE(map.Size(), 1000U);
+        QVERIFY(map.Capacity() < 8192);
+        for (uint eventid = 0; eventid < 10000; eventid++)
+        {
+            uint64_t *sig = map.Find(1001 + eventid % 7, eventid);
+            if (eventid % 10)
+            {
+                QVERIFY(sig == NULL);
+            }
+            else
+            {
+                QVERIFY(sig != NULL);
+                QCOMPARE(*sig, (uint64_t)eventid);
+            }
+        }
+
+        QVector<EITCacheMap::Entry> &rest = map.Slots();
+        for (int i = 0; i < rest.size(); i++)
+            rest[i].chanid = 0;
+        map.Compact();
+        QCOMPARE(map.Size(), 0U);
+        QCOMPARE(map.Capacity(), 0U);
+    }
+};
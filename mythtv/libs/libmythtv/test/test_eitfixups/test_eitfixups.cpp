@@ -823,4 +823,109 @@ void TestEITFixups::test64BitEnum(void)
     QVERIFY(1<<31 & 1ull<<32);
 }
 
+void TestEITFixups::testRequiredLiteral(void)
+{
+    QCOMPARE(EITRegExp::RequiredLiteral("\\s*IMDb Rating: (\\d\\.\\d)\\s?/10$",
+                                        Qt::CaseSensitive),
+             QString("IMDb Rating: "));
+    QCOMPARE(EITRegExp::RequiredLiteral("\\b\\(?[sS]tereo\\)?\\b",
+                                        Qt::CaseSensitive),
+             QString("tereo"));
+    QCOMPARE(EITRegExp::RequiredLiteral("</?EM>", Qt::CaseSensitive),
+             QString("EM>"));
+    QCOMPARE(EITRegExp::RequiredLiteral("\\[Rptd?[^]]+\\d{1,2}\\.\\d{1,2}[ap]m\\]\\.",
+                                        Qt::CaseSensitive),
+             QString("[Rpt"));
+    QCOMPARE(EITRegExp::RequiredLiteral("\\.\\.+$", Qt::CaseSensitive),
+             QString(".."));
+    QCOMPARE(EITRegExp::RequiredLiteral("herh.", Qt::CaseSensitive),
+             QString("herh"));
+
+    // top level alternatives and nothing but classes and groups
+    QCOMPARE(EITRegExp::RequiredLiteral("\\set\\s|,", Qt::CaseSensitive),
+             QString());
+    QCOMPARE(EITRegExp::RequiredLiteral("(starring|stars\\s|drama)",
+                                        Qt::CaseSensitive),
+             QString());
+    QCOMPARE(EITRegExp::RequiredLiteral("[\\[\\(]([\\d]{4})[\\)\\]]",
+                                        Qt::CaseSensitive),
+             QString());
+
+    // case insensitive literals keep to ASCII and leave out i
+    QCOMPARE(EITRegExp::RequiredLiteral("\\s*Also in HD\\.",
+                                        Qt::CaseInsensitive),
+             QString("Also "));
+    QCOMPARE(EITRegExp::RequiredLiteral("\\bταινία\\b", Qt::CaseInsensitive),
+             QString());
+
+    EITRegExp rx("\\s*IMDb Rating: (\\d\\.\\d)\\s?/10$");
+    QVERIFY(!rx.CanMatch("Beschreibung ..."));
+    QCOMPARE(rx.IndexIn("Beschreibung ..."), -1);
+    QVERIFY(rx.CanMatch("Beschreibung ... IMDb Rating: 8.9 /10"));
+    QCOMPARE(rx.IndexIn("Beschreibung ... IMDb Rating: 8.9 /10"), 16);
+    QCOMPARE(rx.cap(1), QString("8.9"));
+    QCOMPARE(rx.IndexIn("IMDb Rating: none"), -1);
+    QVERIFY(rx.cap(1).isEmpty());
+}
+
+void TestEITFixups::benchmarkFix_data(void)
+{
+    QTest::addColumn<qulonglong>("fixup");
+    QTest::addColumn<QString>("title");
+    QTest::addColumn<QString>("subtitle");
+    QTest::addColumn<QString>("description");
+
+    QTest::newRow("UK")
+        << (qulonglong)EITFixUp::kFixUK
+        << "Book of the Week" << ""
+        << "Girl in the Dark: Anna Lyndsey's account of finding light in the "
+           "darkness after illness changed her life. 3/5. A Descent into "
+           "Darkness: The disquieting persistence of the light.";
+    QTest::newRow("UK plain")
+        << (qulonglong)EITFixUp::kFixUK
+        << "Hoarders" << ""
+        << "Fascinating series chronicling the lives of serial hoarders, "
+           "often facing loss of their children, career or marriage";
+    QTest::newRow("PRO7")
+        << (qulonglong)EITFixUp::kFixP7S1
+        << "Titel" << "Folgentitel, Mystery, USA 2011" << "Beschreibung";
+    QTest::newRow("Unitymedia")
+        << (qulonglong)EITFixUp::kFixUnitymedia
+        << "Titel" << "Beschreib" << "Beschreibung ... IMDb Rating: 8.9 /10";
+    QTest::newRow("ATV")
+        << (qulonglong)EITFixUp::kFixATV
+        << "Gilmore Girls" << "Eine Hochzeit und ein Todesfall, Folge 17"
+        << "Lorelai und Rory helfen Luke in seinem Café aus, der mit den "
+           "Vorbereitungen für das ...";
+    QTest::newRow("RTL")
+        << (qulonglong)EITFixUp::kFixRTL
+        << "Alarm für Cobra 11" << ""
+        << "Folge 3: 'Der Anschlag' Semir und Ben jagen einen Bombenleger.";
+    QTest::newRow("NL")
+        << (qulonglong)EITFixUp::kFixNL
+        << "Journaal HD" << ""
+        << "Nieuws en actualiteiten. Presentatie: Sacha de Boer. breedbeeld txt";
+    QTest::newRow("Greek")
+        << (qulonglong)(EITFixUp::kFixGreekEIT | EITFixUp::kFixGreekCategories)
+        << "Ειδήσεις" << ""
+        << "Δελτίο ειδήσεων με την επικαιρότητα της ημέρας.";
+}
+
+void TestEITFixups::benchmarkFix(void)
+{
+    QFETCH(qulonglong, fixup);
+    QFETCH(QString, title);
+    QFETCH(QString, subtitle);
+    QFETCH(QString, description);
+
+    EITFixUp fix;
+    QBENCHMARK
+    {
+        DBEventEIT *event = SimpleDBEventEIT(fixup, title, subtitle,
+                                             description);
+        fix.Fix(*event);
+        delete event;
+    }
+}
+
 QTEST_APPLESS_MAIN(TestEITFixups)
@@ -47,6 +47,9 @@ class TestEITFixups : public QObject
     void testDeDisneyChannel(void);
     void testATV(void);
     void test64BitEnum(void);
+    void testRequiredLiteral(void);
+    void benchmarkFix_data(void);
+    void benchmarkFix(void);
 
   private:
     static DBEventEIT *SimpleDBEventEIT (FixupValue fix, QString title, QString subtitle, QString description);
@@ -0,0 +1,182 @@
+/*
+ *  Class TestMPEGStreamData
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "mpegstreamdata.h"
+
+#define VIDEO_TEST_PID    0x0100
+#define AUDIO_TEST_PID    0x0101
+#define WRITING_TEST_PID  0x0102
+#define NULL_TEST_PID     0x1fff
+#define MUX_PACKETS       (64 * 1024)
+
+/** Gives the test access to the single program video PID, which
+ *  is normally only set when a PMT is processed.
+ */
+class TestStreamData : public MPEGStreamData
+{
+  public:
+    TestStreamData() : MPEGStreamData(-1, -1, false) { }
+
+    void SetVideoPID(uint pid)
+    {
+        _pid_video_single_program = pid;
+        _pid_class_dirty = true;
+    }
+};
+
+class CountingListener : public TSPacketListener, public TSPacketListenerAV
+{
+  public:
+    CountingListener() : m_video(0), m_audio(0), m_writing(0) { }
+
+    bool ProcessTSPacket(const TSPacket&)      { m_writing++; return true; }
+    bool ProcessVideoTSPacket(const TSPacket&) { m_video++;   return true; }
+    bool ProcessAudioTSPacket(const TSPacket&) { m_audio++;   return true; }
+
+    uint m_video;
+    uint m_audio;
+    uint m_writing;
+};
+
+class TestMPEGStreamData: public QObject
+{
+    Q_OBJECT
+
+  private:
+    QByteArray m_mux;
+    uint       m_video;
+    uint       m_audio;
+    uint       m_writing;
+
+    static void AddPacket(QByteArray &mux, uint pid, uint cc)
+    {
+        unsigned char pkt[TSPacket::kSize];
+        memset(pkt, 0xff, sizeof(pkt));
+        pkt[0] = SYNC_BYTE;
+        pkt[1] = (pid >> 8) & 0x1f;
+        pkt[2] = pid & 0xff;
+        pkt[3] = 0x10 | (cc & 0xf); // payload only, not scrambled
+        mux.append(reinterpret_cast<const char*>(pkt), sizeof(pkt));
+    }
+
+  private slots:
+    /** Builds the mux replayed by the tests. If MYTHTV_TEST_MUX points
+     *  at a recorded transport stream that is used instead of the
+     *  synthetic one, so real PID distributions can be benchmarked.
+     */
+    void initTestCase(void)
+    {
+        m_video = m_audio = m_writing = 0;
+
+        QString recorded = qgetenv("MYTHTV_TEST_MUX");
+        if (!recorded.isEmpty())
+        {
+            QFile file(recorded);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            m_mux = file.readAll();
+            return;
+        }
+
+        // Roughly the PID mix of a DVB-T multiplex: mostly video,
+        // some audio, teletext/subtitles and a lot of packets for
+        // services that are not being recorded.
+        for (uint i = 0; i < MUX_PACKETS; i++)
+        {
+            uint pid;
+            switch (i % 16)
+            {
+                case 0: case 1: case 2: case 3: case 4: case 5:
+                    pid = VIDEO_TEST_PID;   m_video++;   break;
+                case 6:
+                    pid = AUDIO_TEST_PID;   m_audio++;   break;
+                case 7:
+                    pid = WRITING_TEST_PID; m_writing++; break;
+                case 15:
+                    pid = NULL_TEST_PID;                 break;
+                default:
+                    pid = 0x200 + (i % 13) * 0x10;       break;
+            }
+            AddPacket(m_mux, pid, i);
+        }
+    }
+
+    /** Checks that every packet is routed to the listeners it
+     *  was routed to before the PID table was introduced, and that
+     *  changes to the PID sets take effect on the next packet.
+     */
+    void dispatch_test(void)
+    {
+        if (!qgetenv("MYTHTV_TEST_MUX").isEmpty())
+            QSKIP("Packet counts are only known for the synthetic mux");
+
+        TestStreamData sd;
+        CountingListener listener;
+        sd.AddAVListener(&listener);
+        sd.AddWritingListener(&listener);
+        sd.SetVideoPID(VIDEO_TEST_PID);
+        sd.AddAudioPID(AUDIO_TEST_PID);
+        sd.AddWritingPID(WRITING_TEST_PID);
+
+        const unsigned char *buf =
+            reinterpret_cast<const unsigned char*>(m_mux.constData());
+        QCOMPARE(sd.ProcessData(buf, m_mux.size()), 0);
+        QCOMPARE(listener.m_video,   m_video);
+        QCOMPARE(listener.m_audio,   m_audio);
+        QCOMPARE(listener.m_writing, m_writing);
+
+        sd.RemoveAudioPID(AUDIO_TEST_PID);
+        sd.RemoveWritingPID(WRITING_TEST_PID);
+        QCOMPARE(sd.ProcessData(buf, m_mux.size()), 0);
+        QCOMPARE(listener.m_video,   m_video * 2);
+        QCOMPARE(listener.m_audio,   m_audio);
+        QCOMPARE(listener.m_writing, m_writing);
+
+        sd.RemoveAVListener(&listener);
+        sd.RemoveWritingListener(&listener);
+    }
+
+    /** Replays the mux through ProcessData() the way a recorder
+     *  does it for every buffer read from the device.
+     */
+    void ProcessData_benchmark(void)
+    {
+        TestStreamData sd;
+        CountingListener listener;
+        sd.AddAVListener(&listener);
+        sd.AddWritingListener(&listener);
+        sd.SetVideoPID(VIDEO_TEST_PID);
+        sd.AddAudioPID(AUDIO_TEST_PID);
+        sd.AddWritingPID(WRITING_TEST_PID);
+        for (uint pid = 0x10; pid < 0x20; pid++)
+            sd.AddListeningPID(pid);
+
+        const unsigned char *buf =
+            reinterpret_cast<const unsigned char*>(m_mux.constData());
+        int len = m_mux.size();
+
+        QBENCHMARK
+        {
+            sd.ProcessData(buf, len);
+        }
+
+        sd.RemoveAVListener(&listener);
+        sd.RemoveWritingListener(&listener);
+    }
+};
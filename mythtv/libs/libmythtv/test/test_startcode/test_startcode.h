@@ -0,0 +1,137 @@
+/*
+ *  Class TestStartCode
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "startcode.h"
+
+extern "C" {
+// libavcodec/internal.h can't be included outside of FFmpeg
+const uint8_t *avpriv_find_start_code(const uint8_t *p,
+                                      const uint8_t *end,
+                                      uint32_t *state);
+}
+
+#define ES_SIZE (8 * 1024 * 1024)
+#define TS_PAYLOAD 184
+
+class TestStartCode: public QObject
+{
+    Q_OBJECT
+
+  private:
+    QByteArray m_es;
+
+  private slots:
+    /** Uses the elementary stream MYTHTV_TEST_ES points at, e.g. one
+     *  demuxed from a captured HD H.264 recording, or otherwise builds
+     *  a pseudo random one with the byte statistics of compressed
+     *  video and a NAL unit every few kilobytes.
+     */
+    void initTestCase(void)
+    {
+        QString captured = qgetenv("MYTHTV_TEST_ES");
+        if (!captured.isEmpty())
+        {
+            QFile file(captured);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            m_es = file.readAll();
+            return;
+        }
+
+        qsrand(1);
+        m_es.resize(ES_SIZE);
+        for (int i = 0; i < ES_SIZE; i++)
+        {
+            // plenty of zero bytes, as in real slice data
+            int r = qrand();
+            m_es[i] = (r & 0x700) ? (char)(r & 0xff) : 0;
+        }
+        for (int i = 0; i + 4 < ES_SIZE; i += 1000 + (qrand() % 8000))
+        {
+            m_es[i + 0] = 0x00;
+            m_es[i + 1] = 0x00;
+            m_es[i + 2] = 0x01;
+            m_es[i + 3] = (char)(qrand() & 0xff);
+        }
+    }
+
+    void find_start_code_data(void)
+    {
+        QTest::addColumn<bool>("SIMD");
+        QTest::newRow("SIMD") << true;
+        QTest::newRow("Pure C") << false;
+    }
+
+    /** Walks the stream in TS payload sized pieces, the way
+     *  DTVRecorder does, and checks every result against FFmpeg.
+     */
+    void find_start_code(void)
+    {
+        QFETCH(bool, SIMD);
+
+        const uint8_t *buf =
+            reinterpret_cast<const uint8_t*>(m_es.constData());
+        const uint8_t *end = buf + m_es.size();
+
+        uint32_t ref_state = 0xffffffff;
+        uint32_t state = 0xffffffff;
+        for (const uint8_t *pkt = buf; pkt < end; pkt += TS_PAYLOAD)
+        {
+            const uint8_t *pkt_end = qMin(pkt + TS_PAYLOAD, end);
+            const uint8_t *ref_p = pkt;
+            const uint8_t *p = pkt;
+            while (ref_p < pkt_end)
+            {
+                ref_p = avpriv_find_start_code(ref_p, pkt_end, &ref_state);
+                p = myth_find_start_code(p, pkt_end, &state, SIMD);
+                QCOMPARE(p, ref_p);
+                QCOMPARE(state, ref_state);
+            }
+        }
+    }
+
+    void find_start_code_benchmark_data(void)
+    {
+        find_start_code_data();
+    }
+
+    void find_start_code_benchmark(void)
+    {
+        QFETCH(bool, SIMD);
+
+        const uint8_t *buf =
+            reinterpret_cast<const uint8_t*>(m_es.constData());
+        const uint8_t *end = buf + m_es.size();
+        uint found = 0;
+
+        QBENCHMARK
+        {
+            uint32_t state = 0xffffffff;
+            const uint8_t *p = buf;
+            while (p < end)
+            {
+                p = myth_find_start_code(p, end, &state, SIMD);
+                if ((state & 0xffffff00) == 0x00000100)
+                    found++;
+            }
+        }
+
+        QVERIFY(found > 0);
+    }
+};
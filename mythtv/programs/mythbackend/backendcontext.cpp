@@ -1,5 +1,6 @@
 
 #include "backendcontext.h"
+#include "recordingsindex.h"
 
 #include "mythlogging.h"
 #include "mythcorecontext.h"
@@ -13,13 +14,16 @@ BackendContext *gBackendContext = NULL;
 QString      pidfile;
 QString      logfile;
 
-BackendContext::BackendContext()
+BackendContext::BackendContext() :
+    m_recordingsIndex(new RecordingsIndex())
 {
 
 }
 
 BackendContext::~BackendContext()
 {
+    delete m_recordingsIndex;
+
     QMap<QString, Frontend*>::iterator it = m_knownFrontends.begin();
     while (it != m_knownFrontends.end())
     {
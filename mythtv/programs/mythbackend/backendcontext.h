@@ -13,6 +13,7 @@ class JobQueue;
 class HouseKeeper;
 class MediaServer;
 class BackendContext;
+class RecordingsIndex;
 
 extern QMap<int, EncoderLink *> tvList;
 extern AutoExpire  *expirer;
@@ -49,9 +50,12 @@ class BackendContext
     const QMap<QString, Frontend*> GetConnectedFrontends() const { return m_connectedFrontends; }
     const QMap<QString, Frontend*> GetFrontends() const { return m_knownFrontends; }
 
+    RecordingsIndex *GetRecordingsIndex(void) const { return m_recordingsIndex; }
+
   private:
     QMap<QString, Frontend*> m_connectedFrontends;
     QMap<QString, Frontend*> m_knownFrontends;
+    RecordingsIndex *m_recordingsIndex;
 };
 
 #endif // _BACKEND_CONTEXT_H_
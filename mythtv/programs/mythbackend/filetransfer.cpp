@@ -1,3 +1,7 @@
+// POSIX headers
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QFileInfo>
@@ -8,6 +12,11 @@
 #include "mythsocket.h"
 #include "programinfo.h"
 #include "mythlogging.h"
+#include "mythcorecontext.h"
+
+#ifndef O_LARGEFILE
+#define O_LARGEFILE 0
+#endif
 
 FileTransfer::FileTransfer(QString &filename, MythSocket *remote,
                            bool usereadahead, int timeout_ms) :
@@ -15,11 +24,16 @@ FileTransfer::FileTransfer(QString &filename, MythSocket *remote,
     readthreadlive(true), readsLocked(false),
     rbuffer(RingBuffer::Create(filename, false, usereadahead, timeout_ms, true)),
     sock(remote), ateof(false), lock(QMutex::NonRecursive),
-    writemode(false)
+    writemode(false), sendfd(-1), sendpos(0)
 {
     pginfo = new ProgramInfo(filename);
     pginfo->MarkAsInUse(true, kFileTransferInUseID);
-    rbuffer->Start();
+    OpenSendFile(filename);
+
+    // The ring buffer's read ahead would only read the file a second
+    // time while sendfile() is in use, so it is started on fallback
+    if (sendfd < 0)
+        rbuffer->Start();
 }
 
 FileTransfer::FileTransfer(QString &filename, MythSocket *remote, bool write) :
@@ -27,7 +41,7 @@ FileTransfer::FileTransfer(QString &filename, MythSocket *remote, bool write) :
     readthreadlive(true), readsLocked(false),
     rbuffer(RingBuffer::Create(filename, write)),
     sock(remote), ateof(false), lock(QMutex::NonRecursive),
-    writemode(write)
+    writemode(write), sendfd(-1), sendpos(0)
 {
     pginfo = new ProgramInfo(filename);
     pginfo->MarkAsInUse(true, kFileTransferInUseID);
@@ -40,6 +54,7 @@ FileTransfer::FileTransfer(QString &filename, MythSocket *remote, bool write) :
 FileTransfer::~FileTransfer()
 {
     Stop();
+    CloseSendFile();
 
     if (sock) // FileTransfer becomes responsible for deleting the socket
         sock->DecrRef();
@@ -57,6 +72,48 @@ FileTransfer::~FileTransfer()
     }
 }
 
+/** \brief Opens a second descriptor on the file if it is a finished
+ *         local file, so RequestBlock() can hand the data to the kernel
+ *         with sendfile() instead of copying it through rbuffer.
+ *
+ *  Files still being recorded (registered for write on this backend)
+ *  grow while they are streamed and keep using the ring buffer.
+ */
+void FileTransfer::OpenSendFile(const QString &filename)
+{
+#ifdef __linux__
+    if (!rbuffer || !rbuffer->IsOpen() || rbuffer->IsStreamed() ||
+        gCoreContext->IsRegisteredFileForWrite(filename))
+    {
+        return;
+    }
+
+    QFileInfo fi(filename);
+    if (!fi.isFile())
+        return;
+
+    QByteArray fname = filename.toLocal8Bit();
+    sendfd = open(fname.constData(), O_RDONLY | O_LARGEFILE);
+    sendpos = 0;
+    if (sendfd >= 0)
+    {
+        LOG(VB_FILE, LOG_INFO,
+            QString("FileTransfer: using sendfile() for %1").arg(filename));
+    }
+#else
+    (void) filename;
+#endif
+}
+
+void FileTransfer::CloseSendFile(void)
+{
+    if (sendfd >= 0)
+    {
+        close(sendfd);
+        sendfd = -1;
+    }
+}
+
 bool FileTransfer::isOpen(void)
 {
     if (rbuffer && rbuffer->IsOpen())
@@ -130,6 +187,26 @@ int FileTransfer::RequestBlock(int size)
     while (readsLocked)
         readsUnlockedCond.wait(&lock, 100 /*ms*/);
 
+    if (sendfd >= 0 && size > 0 && !rbuffer->GetStopReads())
+    {
+        ret = sock->SendFile(sendfd, sendpos, size);
+        if (ret >= 0)
+        {
+            sendpos += ret;
+            if (pginfo)
+                pginfo->UpdateInUseMark();
+            return ret;
+        }
+
+        // Nothing was sent, continue with the ring buffer from here on
+        LOG(VB_FILE, LOG_INFO,
+            "FileTransfer: sendfile() failed, using the ring buffer");
+        CloseSendFile();
+        rbuffer->Seek(sendpos, SEEK_SET);
+        rbuffer->Start();
+        ret = 0;
+    }
+
     requestBuffer.resize(max((size_t)max(size,0) + 128, requestBuffer.size()));
     char *buf = &requestBuffer[0];
     while (tot < size && !rbuffer->GetStopReads() && readthreadlive)
@@ -235,6 +312,13 @@ long long FileTransfer::Seek(long long curpos, long long pos, int whence)
 
     Pause();
 
+    if (sendfd >= 0 && whence == SEEK_CUR)
+    {
+        // rbuffer isn't read while sendfile() is in use
+        pos = curpos + pos;
+        whence = SEEK_SET;
+    }
+
     if (whence == SEEK_CUR)
     {
         long long desired = curpos + pos;
@@ -245,6 +329,12 @@ long long FileTransfer::Seek(long long curpos, long long pos, int whence)
 
     long long ret = rbuffer->Seek(pos, whence);
 
+    if (sendfd >= 0 && ret >= 0)
+    {
+        QMutexLocker locker(&lock);
+        sendpos = ret;
+    }
+
     Unpause();
 
     if (pginfo)
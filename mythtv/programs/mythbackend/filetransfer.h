@@ -51,6 +51,9 @@ class FileTransfer : public ReferenceCounter
   private:
    ~FileTransfer();
 
+    void OpenSendFile(const QString &filename);
+    void CloseSendFile(void);
+
     volatile bool  readthreadlive;
     bool           readsLocked;
     QWaitCondition readsUnlockedCond;
@@ -62,6 +65,11 @@ class FileTransfer : public ReferenceCounter
 
     vector<char> requestBuffer;
 
+    /// Descriptor for sending finished local files with sendfile(),
+    /// bypassing rbuffer, or -1 when the ring buffer path is used.
+    int       sendfd;
+    long long sendpos;
+
     QMutex lock;
 
     bool writemode;
@@ -0,0 +1,63 @@
+// Qt headers
+#include <QByteArray>
+
+// MythTV headers
+#include "httplivestreamserver.h"
+#include "HLS/httplivestreamtranscoder.h"
+#include "HLS/httplivestreamremuxer.h"
+#include "mythlogging.h"
+
+HTTPLiveStreamServer::HTTPLiveStreamServer() :
+    HttpServerExtension("HTTPLiveStreamServer", QString())
+{
+}
+
+HTTPLiveStreamServer::~HTTPLiveStreamServer()
+{
+}
+
+QStringList HTTPLiveStreamServer::GetBasePaths()
+{
+    QStringList paths;
+    paths << "/StorageGroup/Streaming";
+    return paths;
+}
+
+bool HTTPLiveStreamServer::ProcessRequest(HTTPRequest *request)
+{
+    if (!request)
+        return false;
+
+    if ((request->m_eType != RequestTypeGet) &&
+        (request->m_eType != RequestTypeHead))
+        return false;
+
+    if (request->m_sBaseUrl != "/StorageGroup/Streaming" ||
+        !request->m_sMethod.endsWith(".ts"))
+        return false;
+
+    // Segments of remuxed streams are only made when first asked for
+    QByteArray segment;
+    if (HTTPLiveStreamSegmentCache::Find(request->m_sMethod, segment))
+    {
+        LOG(VB_HTTP, LOG_DEBUG,
+            QString("HTTPLiveStreamServer: Serving %1 from memory")
+                .arg(request->m_sMethod));
+    }
+    else if (HTTPLiveStreamRemuxer::GetSegment(request->m_sMethod, segment))
+    {
+        LOG(VB_HTTP, LOG_DEBUG,
+            QString("HTTPLiveStreamServer: Serving %1 remuxed")
+                .arg(request->m_sMethod));
+    }
+    else
+    {
+        return false;
+    }
+
+    request->m_eResponseType     = ResponseTypeOther;
+    request->m_sResponseTypeText = "video/mp2t";
+    request->m_response.write(segment);
+
+    return true;
+}
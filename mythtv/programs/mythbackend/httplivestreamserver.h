@@ -0,0 +1,27 @@
+// -*- Mode: c++ -*-
+
+#ifndef _HTTPLIVESTREAMSERVER_H_
+#define _HTTPLIVESTREAMSERVER_H_
+
+#include "httpserver.h"
+
+/** \class HTTPLiveStreamServer
+ *  \brief Serves HTTP Live Stream segments that are still in memory,
+ *         and remuxes those of remuxed streams when first requested.
+ *
+ *  Requests for segments that have already been dropped from
+ *  HTTPLiveStreamSegmentCache, and for everything else in the Streaming
+ *  storage group, are left to HtmlServerExtension to serve from disk.
+ */
+class HTTPLiveStreamServer : public HttpServerExtension
+{
+  public:
+    HTTPLiveStreamServer();
+    virtual ~HTTPLiveStreamServer();
+
+    virtual QStringList GetBasePaths();
+
+    bool ProcessRequest(HTTPRequest *pRequest);
+};
+
+#endif
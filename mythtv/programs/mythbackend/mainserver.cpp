@@ -82,6 +82,7 @@ using namespace std;
 
 // mythbackend headers
 #include "backendcontext.h"
+#include "recordingsindex.h"
 
 /** Milliseconds to wait for an existing thread from
  *  process request thread pool.
@@ -545,6 +546,13 @@ void MainServer::ProcessRequestWork(MythSocket *sock)
         else
             HandleQueryRecordings(tokens[1], pbs);
     }
+    else if (command == "QUERY_RECORDINGS_CHANGES")
+    {
+        if (tokens.size() != 2)
+            SendErrorResponse(pbs, "Bad QUERY_RECORDINGS_CHANGES query");
+        else
+            HandleQueryRecordingsChanges(tokens[1], pbs);
+    }
     else if (command == "QUERY_RECORDING")
     {
         HandleQueryRecording(tokens, pbs);
@@ -1630,9 +1638,12 @@ void MainServer::customEvent(QEvent *e)
 
 /**
  * \addtogroup myth_network_protocol
- * \par        MYTH_PROTO_VERSION \e version \e token
+ * \par        MYTH_PROTO_VERSION \e version \e token [BINARY]
  * Checks that \e version and \e token match the backend's version.
  * If it matches, the stringlist of "ACCEPT" \e "version" is returned.
+ * If the client added BINARY, "BINARY" is appended to the reply and all
+ * further string lists on the socket use the binary framing, see
+ * MythSocket::EncodeStringList().
  * If it does not, "REJECT" \e "version" is returned,
  * and the socket is closed (for this client)
  */
@@ -1675,8 +1686,15 @@ void MainServer::HandleVersion(MythSocket *socket, const QStringList &slist)
         return;
     }
 
+    // Clients that can read the binary framing ask for it after the token
+    bool binary = (slist.size() >= 4) &&
+        (slist[3] == MythSocket::kBinaryFramingToken);
+
     retlist << "ACCEPT" << MYTH_PROTO_VERSION;
+    if (binary)
+        retlist << MythSocket::kBinaryFramingToken;
     socket->WriteStringList(retlist);
+    socket->SetBinaryFraming(binary);
 }
 
 /**
@@ -2127,17 +2145,6 @@ void MainServer::SendResponse(MythSocket *socket, QStringList &commands)
  */
 void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
 {
-    MythSocket *pbssock = pbs->getSocket();
-    QString playbackhost = pbs->getHostname();
-
-    QMap<QString,ProgramInfo*> recMap;
-    if (m_sched)
-        recMap = m_sched->GetRecording();
-
-    QMap<QString,uint32_t> inUseMap = ProgramInfo::QueryInUseMap();
-    QMap<QString,bool> isJobRunning =
-        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
-
     int sort = 0;
     // Allow "Play" and "Delete" for backwards compatibility with protocol
     // version 56 and below.
@@ -2147,15 +2154,51 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
         sort = -1;
 
     ProgramList destination;
-    LoadFromRecorded(
-        destination, (type == "Recording"),
-        inUseMap, isJobRunning, recMap, sort);
-
-    QMap<QString,ProgramInfo*>::iterator mit = recMap.begin();
-    for (; mit != recMap.end(); mit = recMap.erase(mit))
-        delete *mit;
+    gBackendContext->GetRecordingsIndex()->GetRecordings(
+        destination, (type == "Recording"), sort);
 
     QStringList outputlist(QString::number(destination.size()));
+    AddRecordingsToList(destination, pbs, outputlist);
+
+    SendResponse(pbs->getSocket(), outputlist);
+}
+
+/**
+ * \addtogroup myth_network_protocol
+ * \par        QUERY_RECORDINGS_CHANGES \e generation
+ * Returns the recordings that changed after \e generation: the current
+ * generation, 1 if the recordings replace the whole list or 0 if they
+ * update it, the number of deleted recordings followed by their
+ * recordedids, and the number of added or changed recordings followed by
+ * their programinfo. Generation 0 always gets the whole list.
+ */
+void MainServer::HandleQueryRecordingsChanges(const QString &generation,
+                                              PlaybackSock *pbs)
+{
+    ProgramList changed;
+    QList<uint> deleted;
+    uint current = 0;
+    bool full = gBackendContext->GetRecordingsIndex()->GetChanges(
+        generation.toUInt(), changed, deleted, current);
+
+    QStringList outputlist;
+    outputlist << QString::number(current) << (full ? "1" : "0");
+    outputlist << QString::number(deleted.size());
+    for (int i = 0; i < deleted.size(); ++i)
+        outputlist << QString::number(deleted[i]);
+    outputlist << QString::number(changed.size());
+    AddRecordingsToList(changed, pbs, outputlist);
+
+    SendResponse(pbs->getSocket(), outputlist);
+}
+
+/// Fills in the playback URLs of recordings for pbs and appends them to
+/// outputlist.
+void MainServer::AddRecordingsToList(ProgramList &destination,
+                                     PlaybackSock *pbs,
+                                     QStringList &outputlist)
+{
+    QString playbackhost = pbs->getHostname();
     QMap<QString, QString> backendPortMap;
     QString ip   = gCoreContext->GetBackendServerIP();
     int port = gCoreContext->GetBackendServerPort();
@@ -2245,8 +2288,6 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
 
         proginfo->ToStringList(outputlist);
     }
-
-    SendResponse(pbssock, outputlist);
 }
 
 /**
@@ -169,6 +169,10 @@ class MainServer : public QObject, public MythSocketCBs
     bool HandleDeleteFile(QString filename, QString storagegroup,
                           PlaybackSock *pbs = NULL);
     void HandleQueryRecordings(QString type, PlaybackSock *pbs);
+    void HandleQueryRecordingsChanges(const QString &generation,
+                                      PlaybackSock *pbs);
+    void AddRecordingsToList(ProgramList &destination, PlaybackSock *pbs,
+                             QStringList &outputlist);
     void HandleQueryRecording(QStringList &slist, PlaybackSock *pbs);
     void HandleStopRecording(QStringList &slist, PlaybackSock *pbs);
     void DoHandleStopRecording(RecordingInfo &recinfo, PlaybackSock *pbs);
@@ -10,6 +10,7 @@
 
 #include "mediaserver.h"
 #include "httpconfig.h"
+#include "httplivestreamserver.h"
 #include "internetContent.h"
 #include "mythdirs.h"
 #include "htmlserver.h"
@@ -139,6 +140,7 @@ void MediaServer::Init(bool bIsMaster, bool bDisableUPnp /* = false */)
     pHtmlServer = new HtmlServerExtension(m_sSharePath + "html", "backend_");
     pHttpServer->RegisterExtension( pHtmlServer );
     pHttpServer->RegisterExtension( new HttpConfig() );
+    pHttpServer->RegisterExtension( new HTTPLiveStreamServer() );
     pHttpServer->RegisterExtension( new InternetContent   ( m_sSharePath ));
 
     pHttpServer->RegisterExtension( new MythServiceHost   ( m_sSharePath ));
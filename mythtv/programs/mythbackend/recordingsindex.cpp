@@ -0,0 +1,419 @@
+// C++ headers
+#include <algorithm>
+using namespace std;
+
+// MythTV headers
+#include "recordingsindex.h"
+#include "mythcorecontext.h"
+#include "mythscheduler.h"
+#include "mythlogging.h"
+#include "mythevent.h"
+#include "mythdate.h"
+#include "mythdb.h"
+#include "jobqueue.h"
+
+#define LOC QString("RecordingsIndex: ")
+
+const int RecordingsIndex::kReloadSecs = 15 * 60;
+const int RecordingsIndex::kMaxChanges = 10000;
+
+RecordingsIndex::RecordingsIndex() :
+    m_reload(true), m_generation(1), m_oldest(1)
+{
+    gCoreContext->addListener(this);
+}
+
+RecordingsIndex::~RecordingsIndex()
+{
+    if (gCoreContext)
+        gCoreContext->removeListener(this);
+
+    QMap<uint, ProgramInfo*>::iterator it = m_recordings.begin();
+    for (; it != m_recordings.end(); ++it)
+        delete *it;
+}
+
+static bool recstart_less_than(const ProgramInfo *a, const ProgramInfo *b)
+{
+    return a->GetRecordingStartTime() < b->GetRecordingStartTime();
+}
+
+static bool recstart_greater_than(const ProgramInfo *a, const ProgramInfo *b)
+{
+    return a->GetRecordingStartTime() > b->GetRecordingStartTime();
+}
+
+/** \brief Copies the recordings into destination, as
+ *         LoadFromRecorded(destination, possiblyInProgressRecordingsOnly,
+ *         ..., sort) would load them.
+ *
+ *  Unsorted recordings are in the order they were recorded.
+ *  \return the generation of the copied recordings
+ */
+uint RecordingsIndex::GetRecordings(
+    ProgramList &destination, bool possiblyInProgressRecordingsOnly,
+    int sort)
+{
+    destination.clear();
+
+    Sync();
+
+    QDateTime now = MythDate::current();
+    uint generation;
+    {
+        QMutexLocker locker(&m_lock);
+        QMap<uint, ProgramInfo*>::const_iterator it = m_recordings.begin();
+        for (; it != m_recordings.end(); ++it)
+        {
+            if (possiblyInProgressRecordingsOnly &&
+                ((*it)->GetRecordingEndTime() < now ||
+                 (*it)->GetRecordingStartTime() > now))
+            {
+                continue;
+            }
+            destination.push_back(new ProgramInfo(**it));
+        }
+        generation = m_generation;
+    }
+
+    if (sort > 0)
+        stable_sort(destination.begin(), destination.end(),
+                    recstart_less_than);
+    else if (sort < 0)
+        stable_sort(destination.begin(), destination.end(),
+                    recstart_greater_than);
+
+    UpdateStatus(destination);
+
+    return generation;
+}
+
+/** \brief Gets the recordings that changed after generation.
+ *
+ *  If the changes since generation are no longer known, or generation
+ *  is 0, every recording is returned in changed instead.
+ *
+ *  \param changed recordings added or updated since generation
+ *  \param deleted recordedids of the recordings deleted since generation
+ *  \param current set to the generation the changes lead to
+ *  \return true if changed holds every recording and replaces the list
+ */
+bool RecordingsIndex::GetChanges(uint generation, ProgramList &changed,
+                                 QList<uint> &deleted, uint &current)
+{
+    changed.clear();
+    deleted.clear();
+
+    Sync();
+
+    bool full = false;
+    {
+        QMutexLocker locker(&m_lock);
+        full = !generation || generation < m_oldest ||
+            generation > m_generation;
+        if (full)
+        {
+            QMap<uint, ProgramInfo*>::const_iterator it = m_recordings.begin();
+            for (; it != m_recordings.end(); ++it)
+                changed.push_back(new ProgramInfo(**it));
+        }
+        else
+        {
+            QHash<uint, uint>::const_iterator it = m_changes.begin();
+            for (; it != m_changes.end(); ++it)
+            {
+                if (*it <= generation)
+                    continue;
+
+                QMap<uint, ProgramInfo*>::const_iterator rit =
+                    m_recordings.find(it.key());
+                if (rit != m_recordings.end())
+                    changed.push_back(new ProgramInfo(**rit));
+                else
+                    deleted.push_back(it.key());
+            }
+        }
+        current = m_generation;
+    }
+
+    UpdateStatus(changed);
+
+    return full;
+}
+
+void RecordingsIndex::customEvent(QEvent *event)
+{
+    if (event->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = static_cast<MythEvent *>(event);
+    QString message = me->Message();
+    QStringList tokens = message.simplified().split(" ");
+
+    QMutexLocker locker(&m_lock);
+
+    if (tokens[0] == "RECORDING_LIST_CHANGE")
+    {
+        // ADD, UPDATE and DELETE name the recording, anything else
+        // could have changed any of them.
+        if (tokens.size() >= 3 &&
+            (tokens[1] == "ADD" || tokens[1] == "DELETE"))
+        {
+            m_dirty.insert(tokens[2].toUInt());
+        }
+        else if (tokens.size() >= 2 && tokens[1] == "UPDATE")
+        {
+            ProgramInfo pginfo(me->ExtraDataList());
+            if (pginfo.GetRecordingID())
+                m_dirty.insert(pginfo.GetRecordingID());
+        }
+        else
+        {
+            m_reload = true;
+        }
+    }
+    else if (tokens[0] == "MASTER_UPDATE_REC_INFO" && tokens.size() >= 2)
+    {
+        // The master turns these into RECORDING_LIST_CHANGE UPDATE
+        // without dispatching those locally.
+        m_dirty.insert(tokens[1].toUInt());
+    }
+    else if (tokens[0] == "UPDATE_FILE_SIZE" && tokens.size() >= 3)
+    {
+        QMap<uint, ProgramInfo*>::iterator it =
+            m_recordings.find(tokens[1].toUInt());
+        if (it != m_recordings.end())
+        {
+            (*it)->SetFilesize(tokens[2].toLongLong());
+            Changed(it.key());
+        }
+    }
+}
+
+/** \brief Applies the changes announced since the last call.
+ *
+ *  The recordings are loaded without m_lock held and swapped in
+ *  afterwards. Changes announced meanwhile are applied by the next call.
+ */
+void RecordingsIndex::Sync(void)
+{
+    QMutexLocker synclocker(&m_syncLock);
+    QMutexLocker locker(&m_lock);
+
+    if (!m_reload && m_loaded.secsTo(MythDate::current()) >= kReloadSecs)
+        m_reload = true;
+
+    if (m_reload)
+    {
+        m_reload = false;
+        m_dirty.clear();
+        locker.unlock();
+
+        ProgramList list;
+        list.setAutoDelete(false);
+        LoadRecordings(list);
+
+        locker.relock();
+        Reload(list);
+        return;
+    }
+
+    if (m_dirty.empty())
+        return;
+
+    QSet<uint> dirty;
+    dirty.swap(m_dirty);
+    locker.unlock();
+
+    bool ok = true;
+    QMap<uint, ProgramInfo*> loaded;
+    QSet<uint>::const_iterator it = dirty.begin();
+    for (; it != dirty.end() && ok; ++it)
+        loaded[*it] = LoadRecording(*it, ok);
+
+    locker.relock();
+    QMap<uint, ProgramInfo*>::iterator lit = loaded.begin();
+    for (; lit != loaded.end(); ++lit)
+    {
+        if (ok)
+            SetRecording(lit.key(), *lit);
+        else
+            delete *lit;
+    }
+    if (!ok)
+        m_reload = true;
+}
+
+/// Loads every recording from the database.
+void RecordingsIndex::LoadRecordings(ProgramList &list)
+{
+    // Flags and status are recomputed when handed out, but these keep
+    // LoadFromRecorded() from resetting the commercial flagging state
+    // of recordings that are being flagged.
+    QMap<QString, ProgramInfo*> recMap;
+    MythScheduler *sched = gCoreContext->GetScheduler();
+    if (sched)
+        recMap = sched->GetRecording();
+    QMap<QString, uint32_t> inUseMap = ProgramInfo::QueryInUseMap();
+    QMap<QString, bool> isJobRunning =
+        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
+
+    LoadFromRecorded(list, false, inUseMap, isJobRunning, recMap);
+
+    QMap<QString, ProgramInfo*>::iterator mit = recMap.begin();
+    for (; mit != recMap.end(); mit = recMap.erase(mit))
+        delete *mit;
+}
+
+/** \brief Replaces every recording with those in list, recording what
+ *         differs from before as changes. m_lock must be held.
+ */
+void RecordingsIndex::Reload(ProgramList &list)
+{
+    bool first = m_recordings.empty() && m_loaded.isNull();
+    QMap<uint, ProgramInfo*> old;
+    old.swap(m_recordings);
+
+    ProgramList::iterator it = list.begin();
+    for (; it != list.end(); ++it)
+    {
+        uint recordedid = (*it)->GetRecordingID();
+        m_recordings[recordedid] = *it;
+
+        QMap<uint, ProgramInfo*>::iterator oit = old.find(recordedid);
+        if (oit == old.end())
+        {
+            if (!first)
+                Changed(recordedid);
+            continue;
+        }
+
+        QStringList before, after;
+        (*oit)->ToStringList(before);
+        (*it)->ToStringList(after);
+        if (before != after)
+            Changed(recordedid);
+        delete *oit;
+        old.erase(oit);
+    }
+
+    QMap<uint, ProgramInfo*>::iterator mit = old.begin();
+    for (; mit != old.end(); ++mit)
+    {
+        Changed(mit.key());
+        delete *mit;
+    }
+
+    m_loaded = MythDate::current();
+
+    LOG(VB_GENERAL, LOG_DEBUG, LOC + QString("Loaded %1 recordings")
+        .arg(m_recordings.size()));
+}
+
+/** \brief Loads one recording from the database.
+ *  \param ok set to false if the database could not be queried
+ *  \return the recording, NULL if it is gone
+ */
+ProgramInfo *RecordingsIndex::LoadRecording(uint recordedid, bool &ok)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("SELECT chanid, starttime FROM recorded "
+                  "WHERE recordedid = :RECORDEDID");
+    query.bindValue(":RECORDEDID", recordedid);
+
+    if (!query.exec())
+    {
+        MythDB::DBError("RecordingsIndex::LoadRecording", query);
+        ok = false;
+        return NULL;
+    }
+
+    ProgramInfo *pginfo = NULL;
+    if (query.next())
+    {
+        pginfo = new ProgramInfo(
+            query.value(0).toUInt(),
+            MythDate::as_utc(query.value(1).toDateTime()));
+        if (!pginfo->GetChanID())
+        {
+            delete pginfo;
+            pginfo = NULL;
+        }
+    }
+
+    return pginfo;
+}
+
+/// Replaces the recording, or removes it if pginfo is NULL.
+void RecordingsIndex::SetRecording(uint recordedid, ProgramInfo *pginfo)
+{
+    QMap<uint, ProgramInfo*>::iterator it = m_recordings.find(recordedid);
+    if (it != m_recordings.end())
+    {
+        delete *it;
+        m_recordings.erase(it);
+    }
+    else if (!pginfo)
+    {
+        return;
+    }
+
+    if (pginfo)
+        m_recordings[recordedid] = pginfo;
+    Changed(recordedid);
+}
+
+void RecordingsIndex::Changed(uint recordedid)
+{
+    if (m_changes.size() >= kMaxChanges)
+    {
+        // Anybody further behind has to start over
+        m_changes.clear();
+        m_oldest = m_generation;
+    }
+
+    m_changes[recordedid] = ++m_generation;
+}
+
+/// Brings what is not in the recorded table up to date.
+void RecordingsIndex::UpdateStatus(ProgramList &list)
+{
+    if (list.empty())
+        return;
+
+    QMap<QString, ProgramInfo*> recMap;
+    MythScheduler *sched = gCoreContext->GetScheduler();
+    if (sched)
+        recMap = sched->GetRecording();
+    QMap<QString, uint32_t> inUseMap = ProgramInfo::QueryInUseMap();
+    QMap<QString, bool> isJobRunning =
+        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
+    QDateTime rectime = MythDate::current().addSecs(
+        -gCoreContext->GetNumSetting("RecordOverTime"));
+
+    QList<uint> stale;
+    ProgramList::iterator it = list.begin();
+    for (; it != list.end(); ++it)
+    {
+        if ((*it)->UpdateRecordedStatus(inUseMap, isJobRunning, recMap,
+                                        rectime))
+            stale.push_back((*it)->GetRecordingID());
+    }
+
+    QMap<QString, ProgramInfo*>::iterator mit = recMap.begin();
+    for (; mit != recMap.end(); mit = recMap.erase(mit))
+        delete *mit;
+
+    // Save a commercial flagging job that is no longer running once, in
+    // the index, rather than with every copy that is handed out
+    QMutexLocker locker(&m_lock);
+    for (int i = 0; i < stale.size(); ++i)
+    {
+        QMap<uint, ProgramInfo*>::iterator rit = m_recordings.find(stale[i]);
+        if (rit != m_recordings.end() &&
+            ((*rit)->GetProgramFlags() & FL_COMMPROCESSING))
+        {
+            (*rit)->SaveCommFlagged(COMM_FLAG_NOT_FLAGGED);
+        }
+    }
+}
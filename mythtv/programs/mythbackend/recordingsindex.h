@@ -0,0 +1,76 @@
+#ifndef RECORDINGSINDEX_H_
+#define RECORDINGSINDEX_H_
+
+#include <QDateTime>
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSet>
+
+#include "programinfo.h"
+
+class QEvent;
+
+/** \class RecordingsIndex
+ *  \brief Keeps the recorded programs in memory for the recording lists
+ *         served by the protocol and the Services API.
+ *
+ *  The index is loaded with LoadFromRecorded() once and is then kept
+ *  current from the RECORDING_LIST_CHANGE ADD, UPDATE and DELETE events,
+ *  reloading only the recordings they name. Each change bumps the
+ *  generation, so that a client holding the list as of one generation
+ *  can ask for just what changed since. A plain RECORDING_LIST_CHANGE
+ *  reloads everything and turns the differences into changes as well.
+ *
+ *  The in-use flags, recording status and commercial flagging state
+ *  are not in the recorded table and are brought up to date whenever
+ *  recordings are handed out.
+ *
+ *  Recordings are loaded from the database without m_lock held, so
+ *  that events and clients served from the index don't wait for them.
+ */
+class RecordingsIndex : public QObject
+{
+  public:
+    RecordingsIndex();
+    ~RecordingsIndex();
+
+    uint GetRecordings(ProgramList &destination,
+                       bool possiblyInProgressRecordingsOnly = false,
+                       int sort = 0);
+    bool GetChanges(uint generation, ProgramList &changed,
+                    QList<uint> &deleted, uint &current);
+
+  protected:
+    void customEvent(QEvent *event);
+
+  private:
+    void Sync(void);
+    void Reload(ProgramList &list);
+    void SetRecording(uint recordedid, ProgramInfo *pginfo);
+    void Changed(uint recordedid);
+    void UpdateStatus(ProgramList &list);
+    static void LoadRecordings(ProgramList &list);
+    static ProgramInfo *LoadRecording(uint recordedid, bool &ok);
+
+  private:
+    QMutex                    m_syncLock;     ///< one Sync() at a time
+    QMutex                    m_lock;
+    QMap<uint, ProgramInfo*>  m_recordings;   ///< by recordedid
+    QHash<uint, uint>         m_changes;      ///< recordedid -> generation
+    QSet<uint>                m_dirty;        ///< recordings to reload
+    bool                      m_reload;       ///< reload everything
+    QDateTime                 m_loaded;
+    uint                      m_generation;
+    /// Changes made in later generations are all in m_changes
+    uint                      m_oldest;
+
+    /// Everything is reloaded this often to pick up missed changes
+    static const int kReloadSecs;
+    /// Most changes remembered before clients need the full list again
+    static const int kMaxChanges;
+};
+
+#endif // RECORDINGSINDEX_H_
@@ -0,0 +1,72 @@
+// C++ headers
+#include <algorithm>
+
+// MythTV headers
+#include "recordingtimeindex.h"
+#include "recordinginfo.h"
+
+/** \fn RecordingTimeIndex::Build(const RecList&)
+ *  \brief Indexes the recording start and end times of every entry.
+ */
+void RecordingTimeIndex::Build(const RecList &list)
+{
+    Clear();
+    m_entries.reserve(list.size());
+    for (uint i = 0; i < list.size(); ++i)
+    {
+        const RecordingInfo *p = list[i];
+        Add(i, p->GetRecordingStartTime().toMSecsSinceEpoch(),
+            p->GetRecordingEndTime().toMSecsSinceEpoch());
+    }
+    Finish();
+}
+
+/** \fn RecordingTimeIndex::Add(uint, qint64, qint64)
+ *  \brief Adds an entry, Finish() must be called before lookups.
+ */
+void RecordingTimeIndex::Add(uint pos, qint64 start, qint64 end)
+{
+    Entry e = { start, end, pos };
+    m_entries.push_back(e);
+    m_maxLength = std::max(m_maxLength, end - start);
+}
+
+void RecordingTimeIndex::Finish(void)
+{
+    std::stable_sort(m_entries.begin(), m_entries.end());
+}
+
+void RecordingTimeIndex::Clear(void)
+{
+    m_entries.clear();
+    m_maxLength = 0;
+}
+
+/** \fn RecordingTimeIndex::FindOverlaps(qint64, qint64, std::vector<uint>&) const
+ *  \brief Returns the list positions of all entries with
+ *         start <= end && end >= start, in list order.
+ *
+ *  Ranges are inclusive, entries that only touch the given range are
+ *  returned as well since the scheduler treats those specially.
+ */
+void RecordingTimeIndex::FindOverlaps(
+    qint64 start, qint64 end, std::vector<uint> &positions) const
+{
+    positions.clear();
+
+    // No entry starting before start - m_maxLength can reach start
+    Entry lo = { start - m_maxLength, 0, 0 };
+    Entry hi = { end, 0, 0 };
+    std::vector<Entry>::const_iterator it =
+        std::lower_bound(m_entries.begin(), m_entries.end(), lo);
+    std::vector<Entry>::const_iterator last =
+        std::upper_bound(it, m_entries.end(), hi);
+
+    for (; it != last; ++it)
+    {
+        if (it->end >= start)
+            positions.push_back(it->pos);
+    }
+
+    std::sort(positions.begin(), positions.end());
+}
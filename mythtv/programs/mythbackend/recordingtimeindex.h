@@ -0,0 +1,52 @@
+#ifndef RECORDING_TIME_INDEX_H
+#define RECORDING_TIME_INDEX_H
+
+// C++ headers
+#include <vector>
+
+// Qt headers
+#include <QtGlobal>
+
+// MythTV headers
+#include "mythscheduler.h"
+
+/** \class RecordingTimeIndex
+ *  \brief Index of the recording time ranges of a RecList, used by the
+ *         scheduler to find the entries overlapping a showing without
+ *         walking the whole list. Times are in ms since the epoch.
+ *
+ *  Entries are kept sorted by start time together with the longest
+ *  entry duration, so a lookup is a binary search followed by a scan of
+ *  only the entries that could overlap. The index refers to list
+ *  positions, so the list must not change while the index is in use.
+ */
+class RecordingTimeIndex
+{
+  public:
+    RecordingTimeIndex() : m_maxLength(0) {}
+
+    void Build(const RecList &list);
+    void Add(uint pos, qint64 start, qint64 end);
+    void Finish(void);
+    void Clear(void);
+
+    void FindOverlaps(qint64 start, qint64 end,
+                      std::vector<uint> &positions) const;
+
+    size_t size(void) const { return m_entries.size(); }
+
+  private:
+    struct Entry
+    {
+        qint64 start;
+        qint64 end;
+        uint   pos;
+
+        bool operator<(const Entry &o) const { return start < o.start; }
+    };
+
+    std::vector<Entry> m_entries;
+    qint64             m_maxLength;
+};
+
+#endif // RECORDING_TIME_INDEX_H
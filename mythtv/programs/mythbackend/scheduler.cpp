@@ -25,7 +25,10 @@ using namespace std;
 #include <QRegExp>
 #include <QMutex>
 #include <QFile>
+#include <QHash>
 #include <QMap>
+#include <QRunnable>
+#include <QThread>
 
 #include "mythmiscutil.h"
 #include "mythsystemlegacy.h"
@@ -47,6 +50,7 @@ using namespace std;
 #include "mythdb.h"
 #include "mythsystemevent.h"
 #include "mythlogging.h"
+#include "mthreadpool.h"
 #include "tv_rec.h"
 
 #define LOC QString("Scheduler: ")
@@ -73,7 +77,12 @@ Scheduler::Scheduler(bool runthread, QMap<int, EncoderLink *> *tvList,
     error(0),
     livetvTime(QDateTime()),
     lastPrepareTime(QDateTime()),
-    m_openEnd(openEndNever)
+    m_openEnd(openEndNever),
+    m_incremental(false),
+    m_candidatesValid(false),
+    m_lastPassIncremental(false),
+    m_lastPassRules(0),
+    m_lastFullPlaceTime(0.0f)
 {
 
     tmLastLog = 0;
@@ -1075,12 +1084,16 @@ void Scheduler::BuildListMaps(void)
             QString("Ignored %1 entries for invalid input %2")
             .arg(badinputs[it.value()]).arg(it.key()));
     }
+
+    for (uint j = 0; j < conflictlists.size(); ++j)
+        conflictindexes[conflictlists[j]].Build(*conflictlists[j]);
 }
 
 void Scheduler::ClearListMaps(void)
 {
     for (uint i = 0; i < conflictlists.size(); ++i)
         conflictlists[i]->clear();
+    conflictindexes.clear();
     titlelistmap.clear();
     recordidlistmap.clear();
     cache_is_same_program.clear();
@@ -1089,6 +1102,9 @@ void Scheduler::ClearListMaps(void)
 bool Scheduler::IsSameProgram(
     const RecordingInfo *a, const RecordingInfo *b) const
 {
+    // Placement of independent groups runs in parallel
+    QMutexLocker locker(&cache_is_same_program_lock);
+
     IsSameKey X(a,b);
     IsSameCacheType::const_iterator it = cache_is_same_program.find(X);
     if (it != cache_is_same_program.end())
@@ -1102,96 +1118,163 @@ bool Scheduler::IsSameProgram(
     return cache_is_same_program[X] = a->IsDuplicateProgram(*b);
 }
 
-bool Scheduler::FindNextConflict(
-    const RecList     &cardlist,
+/** \fn Scheduler::IsConflict(const RecordingInfo*, const RecordingInfo*, OpenEndType, uint&) const
+ *  \brief Returns true if q keeps p from recording, affinity is
+ *         incremented for entries p could share a multiplex with.
+ */
+bool Scheduler::IsConflict(
     const RecordingInfo *p,
-    RecConstIter      &j,
-    OpenEndType        openEnd,
-    uint              *paffinity) const
+    const RecordingInfo *q,
+    OpenEndType          openEnd,
+    uint                &affinity) const
 {
-    uint affinity = 0;
-    for ( ; j != cardlist.end(); ++j)
-    {
-        const RecordingInfo *q = *j;
-        QString msg;
+    QString msg;
 
-        if (p == q)
-            continue;
+    if (p == q)
+        return false;
 
-        if (!Recording(q))
-            continue;
+    if (!Recording(q))
+        return false;
 
-        if (debugConflicts)
-            msg = QString("comparing with '%1' ").arg(q->GetTitle());
+    if (debugConflicts)
+        msg = QString("comparing with '%1' ").arg(q->GetTitle());
 
-        if (p->GetInputID() != q->GetInputID())
+    if (p->GetInputID() != q->GetInputID())
+    {
+        const vector <uint> &conflicting_inputs =
+            sinputinfomap[p->GetInputID()].conflicting_inputs;
+        if (find(conflicting_inputs.begin(), conflicting_inputs.end(),
+                 q->GetInputID()) == conflicting_inputs.end())
         {
-            const vector <uint> &conflicting_inputs =
-                sinputinfomap[p->GetInputID()].conflicting_inputs;
-            if (find(conflicting_inputs.begin(), conflicting_inputs.end(),
-                     q->GetInputID()) == conflicting_inputs.end())
-            {
-                if (debugConflicts)
-                    msg += "  cardid== ";
-                continue;
-            }
+            if (debugConflicts)
+                msg += "  cardid== ";
+            return false;
         }
+    }
 
-        if (p->GetRecordingEndTime() < q->GetRecordingStartTime() ||
-            p->GetRecordingStartTime() > q->GetRecordingEndTime())
+    if (p->GetRecordingEndTime() < q->GetRecordingStartTime() ||
+        p->GetRecordingStartTime() > q->GetRecordingEndTime())
+    {
+        if (debugConflicts)
+            msg += "  no-overlap ";
+        return false;
+    }
+
+    bool mplexid_ok =
+        (p->sgroupid != q->sgroupid ||
+         sinputinfomap[p->sgroupid].schedgroup) &&
+        ((p->mplexid && p->mplexid == q->mplexid) ||
+         (!p->mplexid && p->GetChanID() == q->GetChanID()));
+
+    if (p->GetRecordingEndTime() == q->GetRecordingStartTime() ||
+        p->GetRecordingStartTime() == q->GetRecordingEndTime())
+    {
+        if (openEnd == openEndNever ||
+            (openEnd == openEndDiffChannel &&
+             p->GetChanID() == q->GetChanID()) ||
+            (openEnd == openEndAlways &&
+             mplexid_ok))
         {
             if (debugConflicts)
                 msg += "  no-overlap ";
-            continue;
+            if (mplexid_ok)
+                ++affinity;
+            return false;
         }
+    }
 
-        bool mplexid_ok =
-            (p->sgroupid != q->sgroupid ||
-             sinputinfomap[p->sgroupid].schedgroup) &&
-            ((p->mplexid && p->mplexid == q->mplexid) ||
-             (!p->mplexid && p->GetChanID() == q->GetChanID()));
+    if (debugConflicts)
+    {
+        LOG(VB_SCHEDULE, LOG_INFO, msg);
+        LOG(VB_SCHEDULE, LOG_INFO,
+            QString("  cardid's: [%1], [%2] Share an input group"
+                    "mplexid's: %3, %4")
+                 .arg(p->GetInputID()).arg(q->GetInputID())
+                 .arg(p->mplexid).arg(q->mplexid));
+    }
 
-        if (p->GetRecordingEndTime() == q->GetRecordingStartTime() ||
-            p->GetRecordingStartTime() == q->GetRecordingEndTime())
-        {
-            if (openEnd == openEndNever ||
-                (openEnd == openEndDiffChannel &&
-                 p->GetChanID() == q->GetChanID()) ||
-                (openEnd == openEndAlways &&
-                 mplexid_ok))
-            {
-                if (debugConflicts)
-                    msg += "  no-overlap ";
-                if (mplexid_ok)
-                    ++affinity;
-                continue;
-            }
-        }
+    // if two inputs are in the same input group we have a conflict
+    // unless the programs are on the same multiplex.
+    if (mplexid_ok)
+    {
+        ++affinity;
+        return false;
+    }
 
-        if (debugConflicts)
-        {
-            LOG(VB_SCHEDULE, LOG_INFO, msg);
-            LOG(VB_SCHEDULE, LOG_INFO,
-                QString("  cardid's: [%1], [%2] Share an input group"
-                        "mplexid's: %3, %4")
-                     .arg(p->GetInputID()).arg(q->GetInputID())
-                     .arg(p->mplexid).arg(q->mplexid));
-        }
+    if (debugConflicts)
+        LOG(VB_SCHEDULE, LOG_INFO, "Found conflict");
 
-        // if two inputs are in the same input group we have a conflict
-        // unless the programs are on the same multiplex.
-        if (mplexid_ok)
+    return true;
+}
+
+bool Scheduler::FindNextConflict(
+    const RecList     &cardlist,
+    const RecordingInfo *p,
+    RecConstIter      &j,
+    OpenEndType        openEnd,
+    uint              *paffinity) const
+{
+    uint affinity = 0;
+    for ( ; j != cardlist.end(); ++j)
+    {
+        if (IsConflict(p, *j, openEnd, affinity))
         {
-            ++affinity;
-            continue;
+            if (paffinity)
+                *paffinity += affinity;
+            return true;
         }
+    }
 
-        if (debugConflicts)
-            LOG(VB_SCHEDULE, LOG_INFO, "Found conflict");
+    if (debugConflicts)
+        LOG(VB_SCHEDULE, LOG_INFO, "No conflict");
 
-        if (paffinity)
-            *paffinity += affinity;
-        return true;
+    if (paffinity)
+        *paffinity += affinity;
+    return false;
+}
+
+/** \fn Scheduler::FindOverlaps(const RecList&, const RecordingInfo*, vector<uint>&) const
+ *  \brief Returns the positions in a conflict list of the entries whose
+ *         recording times overlap or touch those of p, in list order.
+ *
+ *  Entries that don't overlap p can never conflict with it, so
+ *  checking only these gives the same result as walking the list.
+ */
+void Scheduler::FindOverlaps(const RecList &cardlist, const RecordingInfo *p,
+                             vector<uint> &overlaps) const
+{
+    QMap<const RecList *, RecordingTimeIndex>::const_iterator it =
+        conflictindexes.find(&cardlist);
+    if (it != conflictindexes.end() && (*it).size() == cardlist.size())
+    {
+        (*it).FindOverlaps(p->GetRecordingStartTime().toMSecsSinceEpoch(),
+                           p->GetRecordingEndTime().toMSecsSinceEpoch(),
+                           overlaps);
+        return;
+    }
+
+    overlaps.resize(cardlist.size());
+    for (uint i = 0; i < cardlist.size(); ++i)
+        overlaps[i] = i;
+}
+
+bool Scheduler::FindNextConflict(
+    const RecList       &cardlist,
+    const RecordingInfo *p,
+    const vector<uint>  &overlaps,
+    uint                &k,
+    OpenEndType          openEnd,
+    uint                *paffinity) const
+{
+    uint affinity = 0;
+    for ( ; k < overlaps.size(); ++k)
+    {
+        if (IsConflict(p, cardlist[overlaps[k]], openEnd, affinity))
+        {
+            if (paffinity)
+                *paffinity += affinity;
+            return true;
+        }
     }
 
     if (debugConflicts)
@@ -1209,12 +1292,15 @@ const RecordingInfo *Scheduler::FindConflict(
     bool checkAll) const
 {
     RecList &conflictlist = *sinputinfomap[p->GetInputID()].conflictlist;
-    RecConstIter k = conflictlist.begin();
-    if (FindNextConflict(conflictlist, p, k, openend, affinity))
+    vector<uint> overlaps;
+    FindOverlaps(conflictlist, p, overlaps);
+    uint k = 0;
+    if (FindNextConflict(conflictlist, p, overlaps, k, openend, affinity))
     {
-        RecordingInfo *firstConflict = *k;
+        RecordingInfo *firstConflict = conflictlist[overlaps[k]];
         while (checkAll &&
-               FindNextConflict(conflictlist, p, ++k, openend, affinity))
+               FindNextConflict(conflictlist, p, overlaps, ++k,
+                                openend, affinity))
             ;
         return firstConflict;
     }
@@ -1224,23 +1310,26 @@ const RecordingInfo *Scheduler::FindConflict(
 
 void Scheduler::MarkOtherShowings(RecordingInfo *p)
 {
-    RecList *showinglist;
-
-    showinglist = &titlelistmap[p->GetTitle().toLower()];
-    MarkShowingsList(*showinglist, p);
-
+    // Use find() rather than operator[], the maps are shared by the
+    // placement threads and must not be modified.
+    QMap<QString, RecList>::iterator tit =
+        titlelistmap.find(p->GetTitle().toLower());
+    if (tit != titlelistmap.end())
+        MarkShowingsList(*tit, p);
+
+    QMap<uint, RecList>::iterator rit = recordidlistmap.end();
     if (p->GetRecordingRuleType() == kOneRecord ||
         p->GetRecordingRuleType() == kDailyRecord ||
         p->GetRecordingRuleType() == kWeeklyRecord)
     {
-        showinglist = &recordidlistmap[p->GetRecordingRuleID()];
-        MarkShowingsList(*showinglist, p);
+        rit = recordidlistmap.find(p->GetRecordingRuleID());
     }
     else if (p->GetRecordingRuleType() == kOverrideRecord && p->GetFindID())
     {
-        showinglist = &recordidlistmap[p->GetParentRecordingRuleID()];
-        MarkShowingsList(*showinglist, p);
+        rit = recordidlistmap.find(p->GetParentRecordingRuleID());
     }
+    if (rit != recordidlistmap.end())
+        MarkShowingsList(*rit, p);
 }
 
 void Scheduler::MarkShowingsList(RecList &showinglist, RecordingInfo *p)
@@ -1270,26 +1359,33 @@ void Scheduler::MarkShowingsList(RecList &showinglist, RecordingInfo *p)
     }
 }
 
-void Scheduler::BackupRecStatus(void)
+void Scheduler::BackupRecStatus(const RecList &list)
 {
-    RecIter i = worklist.begin();
-    for ( ; i != worklist.end(); ++i)
+    RecConstIter i = list.begin();
+    for ( ; i != list.end(); ++i)
     {
         RecordingInfo *p = *i;
         p->savedrecstatus = p->GetRecordingStatus();
     }
 }
 
-void Scheduler::RestoreRecStatus(void)
+void Scheduler::RestoreRecStatus(const RecList &list)
 {
-    RecIter i = worklist.begin();
-    for ( ; i != worklist.end(); ++i)
+    RecConstIter i = list.begin();
+    for ( ; i != list.end(); ++i)
     {
         RecordingInfo *p = *i;
         p->SetRecordingStatus(p->savedrecstatus);
     }
 }
 
+void Scheduler::UpdateLiveTVTime(const QDateTime &recstartts)
+{
+    QMutexLocker locker(&livetvTimeLock);
+    if (recstartts < livetvTime)
+        livetvTime = recstartts;
+}
+
 bool Scheduler::TryAnotherShowing(RecordingInfo *p, bool samePriority,
                                    bool livetv)
 {
@@ -1301,7 +1397,11 @@ bool Scheduler::TryAnotherShowing(RecordingInfo *p, bool samePriority,
         p->GetRecordingStatus() == RecStatus::Pending)
         return false;
 
-    RecList *showinglist = &recordidlistmap[p->GetRecordingRuleID()];
+    QMap<uint, RecList>::iterator rit =
+        recordidlistmap.find(p->GetRecordingRuleID());
+    if (rit == recordidlistmap.end())
+        return false;
+    RecList *showinglist = &(*rit);
 
     RecStatus::Type oldstatus = p->GetRecordingStatus();
     p->SetRecordingStatus(RecStatus::LaterShowing);
@@ -1389,8 +1489,7 @@ bool Scheduler::TryAnotherShowing(RecordingInfo *p, bool samePriority,
 
         best->SetRecordingStatus(RecStatus::WillRecord);
         MarkOtherShowings(best);
-        if (best->GetRecordingStartTime() < livetvTime)
-            livetvTime = best->GetRecordingStartTime();
+        UpdateLiveTVTime(best->GetRecordingStartTime());
         PrintRec(p, "    -");
         PrintRec(best, "    +");
         return true;
@@ -1400,6 +1499,40 @@ bool Scheduler::TryAnotherShowing(RecordingInfo *p, bool samePriority,
     return false;
 }
 
+/// Places a share of the independent groups found by SplitWorkList()
+class SchedPlaceRunnable : public QRunnable
+{
+  public:
+    explicit SchedPlaceRunnable(Scheduler *sched) :
+        m_sched(sched), m_size(0)
+    {
+        setAutoDelete(false);
+    }
+
+    void run(void)
+    {
+        for (uint g = 0; g < m_groups.size(); ++g)
+            m_sched->PlaceRecords(*m_groups[g]);
+    }
+
+    Scheduler        *m_sched;
+    vector<RecList*>  m_groups;
+    uint              m_size;
+};
+
+class GroupSizeCompare
+{
+  public:
+    explicit GroupSizeCompare(const vector<RecList> &groups) :
+        m_groups(groups) { }
+    bool operator()(uint a, uint b) const
+    {
+        return m_groups[a].size() > m_groups[b].size();
+    }
+  private:
+    const vector<RecList> &m_groups;
+};
+
 void Scheduler::SchedNewRecords(void)
 {
     if (VERBOSE_LEVEL_CHECK(VB_SCHEDULE, LOG_DEBUG))
@@ -1426,9 +1559,176 @@ void Scheduler::SchedNewRecords(void)
     m_openEnd =
         (OpenEndType)gCoreContext->GetNumSetting("SchedOpenEnd", openEndNever);
 
-    RecIter i = worklist.begin();
+    vector<RecList> groups;
+    int ideal = QThread::idealThreadCount();
+    uint threads = (ideal > 1) ? min(ideal, 8) : 1;
+    if (!SplitWorkList(groups) || threads <= 1 || groups.size() <= 1)
+    {
+        PlaceRecords(worklist);
+        return;
+    }
+    threads = min(threads, (uint)groups.size());
 
-    for ( ; i != worklist.end(); ++i)
+    LOG(VB_SCHEDULE, LOG_INFO,
+        QString("Placing %1 independent groups with %2 threads")
+        .arg(groups.size()).arg(threads));
+
+    // Balance the groups over the threads, largest first
+    vector<SchedPlaceRunnable*> tasks;
+    for (uint t = 0; t < threads; ++t)
+        tasks.push_back(new SchedPlaceRunnable(this));
+    vector<uint> order(groups.size());
+    for (uint g = 0; g < groups.size(); ++g)
+        order[g] = g;
+    stable_sort(order.begin(), order.end(), GroupSizeCompare(groups));
+    for (uint g = 0; g < order.size(); ++g)
+    {
+        SchedPlaceRunnable *least = tasks[0];
+        for (uint t = 1; t < threads; ++t)
+        {
+            if (tasks[t]->m_size < least->m_size)
+                least = tasks[t];
+        }
+        least->m_groups.push_back(&groups[order[g]]);
+        least->m_size += groups[order[g]].size();
+    }
+
+    MThreadPool pool("SchedPlace");
+    pool.setMaxThreadCount(threads);
+    for (uint t = 0; t < threads; ++t)
+        pool.start(tasks[t], QString("SchedPlace%1").arg(t));
+    pool.waitForDone();
+
+    for (uint t = 0; t < threads; ++t)
+        delete tasks[t];
+}
+
+static uint FindGroupRoot(vector<uint> &parent, uint n)
+{
+    while (parent[n] != n)
+        n = parent[n] = parent[parent[n]];
+    return n;
+}
+
+// Joins two groups, always keeping the lower node as root
+static void JoinGroups(vector<uint> &parent, uint a, uint b)
+{
+    a = FindGroupRoot(parent, a);
+    b = FindGroupRoot(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+static void JoinGroupList(vector<uint> &parent,
+                          const QHash<const RecordingInfo *, uint> &node,
+                          const RecList &list)
+{
+    for (uint i = 1; i < list.size(); ++i)
+        JoinGroups(parent, node.value(list[0]), node.value(list[i]));
+}
+
+/** \fn Scheduler::SplitWorkList(vector<RecList>&)
+ *  \brief Splits the placeable part of the work list into groups that
+ *         can be placed independently of each other.
+ *
+ *  Placement only reaches other showings through the conflict, title
+ *  and rule lists built by BuildListMaps(), so the groups are the
+ *  connected components of those lists, with overrides also joined to
+ *  their parent rule's list. Every showing that placing a group can
+ *  change is therefore in the group, and backing up and restoring the
+ *  group's statuses in the retry pass is the same as doing it for the
+ *  whole work list. Each group keeps the work list order, which is what
+ *  makes placing them separately give the same result as one pass.
+ *
+ *  \return false if the work list has to be placed in one pass
+ */
+bool Scheduler::SplitWorkList(vector<RecList> &groups)
+{
+    QHash<const RecordingInfo *, uint> node;
+    vector<uint> parent;
+
+    for (uint i = 0; i < worklist.size(); ++i)
+    {
+        const RecordingInfo *p = worklist[i];
+
+        // A failing recording ends the marking of already recording
+        // showings for the whole list, keep that in one pass.
+        if (p->GetRecordingStatus() == RecStatus::Failing)
+            return false;
+
+        if (p->GetRecordingStatus() != RecStatus::Recording &&
+            p->GetRecordingStatus() != RecStatus::Tuning &&
+            p->GetRecordingStatus() != RecStatus::WillRecord &&
+            p->GetRecordingStatus() != RecStatus::Pending &&
+            p->GetRecordingStatus() != RecStatus::Unknown)
+            continue;
+
+        // Let the single pass deal with showings left out of the lists
+        QMap<uint, SchedInputInfo>::const_iterator info =
+            sinputinfomap.constFind(p->GetInputID());
+        if (info == sinputinfomap.constEnd() || !(*info).conflictlist)
+            return false;
+
+        node[p] = parent.size();
+        parent.push_back(parent.size());
+    }
+
+    for (uint i = 0; i < conflictlists.size(); ++i)
+        JoinGroupList(parent, node, *conflictlists[i]);
+
+    QMap<QString, RecList>::const_iterator tit = titlelistmap.constBegin();
+    for ( ; tit != titlelistmap.constEnd(); ++tit)
+        JoinGroupList(parent, node, *tit);
+
+    QMap<uint, RecList>::const_iterator rit = recordidlistmap.constBegin();
+    for ( ; rit != recordidlistmap.constEnd(); ++rit)
+    {
+        JoinGroupList(parent, node, *rit);
+
+        const RecordingInfo *p = (*rit)[0];
+        if (!p->GetParentRecordingRuleID())
+            continue;
+        QMap<uint, RecList>::const_iterator pit =
+            recordidlistmap.constFind(p->GetParentRecordingRuleID());
+        if (pit != recordidlistmap.constEnd())
+            JoinGroups(parent, node.value(p), node.value((*pit)[0]));
+    }
+
+    QHash<uint, uint> groupof;
+    for (uint i = 0; i < worklist.size(); ++i)
+    {
+        QHash<const RecordingInfo *, uint>::const_iterator nit =
+            node.constFind(worklist[i]);
+        if (nit == node.constEnd())
+            continue;
+        uint root = FindGroupRoot(parent, *nit);
+        QHash<uint, uint>::const_iterator git = groupof.constFind(root);
+        uint g;
+        if (git == groupof.constEnd())
+        {
+            g = groups.size();
+            groupof[root] = g;
+            groups.push_back(RecList());
+        }
+        else
+            g = *git;
+        groups[g].push_back(worklist[i]);
+    }
+
+    return true;
+}
+
+/** \fn Scheduler::PlaceRecords(RecList&)
+ *  \brief Runs the placement passes over list, which is either the
+ *         whole work list or one group from SplitWorkList().
+ */
+void Scheduler::PlaceRecords(RecList &list)
+{
+    RecIter i = list.begin();
+
+    for ( ; i != list.end(); ++i)
     {
         if ((*i)->GetRecordingStatus() != RecStatus::Recording &&
             (*i)->GetRecordingStatus() != RecStatus::Tuning &&
@@ -1437,14 +1737,14 @@ void Scheduler::SchedNewRecords(void)
         MarkOtherShowings(*i);
     }
 
-    while (i != worklist.end())
+    while (i != list.end())
     {
         RecIter levelStart = i;
         int recpriority = (*i)->GetRecordingPriority();
 
-        while (i != worklist.end())
+        while (i != list.end())
         {
-            if (i == worklist.end() ||
+            if (i == list.end() ||
                 (*i)->GetRecordingPriority() != recpriority)
                 break;
 
@@ -1453,17 +1753,17 @@ void Scheduler::SchedNewRecords(void)
             LOG(VB_SCHEDULE, LOG_DEBUG, QString("Trying priority %1/%2...")
                 .arg(recpriority).arg(recpriority2));
             // First pass for anything in this priority sublevel.
-            SchedNewFirstPass(i, worklist.end(), recpriority, recpriority2);
+            SchedNewFirstPass(i, list.end(), recpriority, recpriority2);
 
             LOG(VB_SCHEDULE, LOG_DEBUG, QString("Retrying priority %1/%2...")
                 .arg(recpriority).arg(recpriority2));
-            SchedNewRetryPass(sublevelStart, i, true);
+            SchedNewRetryPass(sublevelStart, i, true, list);
         }
 
         // Retry pass for anything in this priority level.
         LOG(VB_SCHEDULE, LOG_DEBUG, QString("Retrying priority %1/*...")
             .arg(recpriority));
-        SchedNewRetryPass(levelStart, i, false);
+        SchedNewRetryPass(levelStart, i, false, list);
     }
 }
 
@@ -1538,8 +1838,7 @@ void Scheduler::SchedNewFirstPass(RecIter &i, RecIter end,
             PrintRec(best, "  +");
             best->SetRecordingStatus(RecStatus::WillRecord);
             MarkOtherShowings(best);
-            if (best->GetRecordingStartTime() < livetvTime)
-                livetvTime = best->GetRecordingStartTime();
+            UpdateLiveTVTime(best->GetRecordingStartTime());
         }
     }
 }
@@ -1548,7 +1847,8 @@ void Scheduler::SchedNewFirstPass(RecIter &i, RecIter end,
 // unscheduled program, try to move the conflicting programs to
 // another time or tuner using the given constraints.
 void Scheduler::SchedNewRetryPass(RecIter i, RecIter end,
-                                  bool samePriority, bool livetv)
+                                  bool samePriority, RecList &statuslist,
+                                  bool livetv)
 {
     RecList retry_list;
     for ( ; i != end; ++i)
@@ -1571,28 +1871,31 @@ void Scheduler::SchedNewRetryPass(RecIter i, RecIter end,
             PrintRec(p, "  ?");
 
         // Assume we can successfully move all of the conflicts.
-        BackupRecStatus();
+        BackupRecStatus(statuslist);
         p->SetRecordingStatus(RecStatus::WillRecord);
         if (!livetv)
             MarkOtherShowings(p);
 
         // Try to move each conflict.  Restore the old status if we
         // can't.
-        RecList &conflictlist = *sinputinfomap[p->GetInputID()].conflictlist;
-        RecConstIter k = conflictlist.begin();
-        for ( ; FindNextConflict(conflictlist, p, k); ++k)
+        RecList &conflictlist =
+            *sinputinfomap.constFind(p->GetInputID())->conflictlist;
+        vector<uint> overlaps;
+        FindOverlaps(conflictlist, p, overlaps);
+        uint k = 0;
+        for ( ; FindNextConflict(conflictlist, p, overlaps, k); ++k)
         {
-            if (!TryAnotherShowing(*k, samePriority, livetv))
+            if (!TryAnotherShowing(conflictlist[overlaps[k]], samePriority,
+                                   livetv))
             {
-                RestoreRecStatus();
+                RestoreRecStatus(statuslist);
                 break;
             }
         }
 
         if (!livetv && p->GetRecordingStatus() == RecStatus::WillRecord)
         {
-            if (p->GetRecordingStartTime() < livetvTime)
-                livetvTime = p->GetRecordingStartTime();
+            UpdateLiveTVTime(p->GetRecordingStartTime());
             PrintRec(p, "  +");
         }
     }
@@ -2348,6 +2651,8 @@ bool Scheduler::HandleReschedule(void)
     bool deleteFuture = false;
     bool runCheck = false;
 
+    m_incremental = gCoreContext->GetBoolSetting("SchedIncremental", false);
+
     while (HaveQueuedRequests())
     {
         QStringList request = reschedQueue.dequeue();
@@ -2380,6 +2685,12 @@ bool Scheduler::HandleReschedule(void)
             QDateTime maxstarttime = MythDate::fromString(tokens[4]);
             deleteFuture = true;
             runCheck = true;
+            // A changed rule only affects its own candidates, new
+            // guide data or channels can affect all of them.
+            if (recordid && !sourceid && !mplexid)
+                m_staleRules.insert(recordid);
+            else
+                m_candidatesValid = false;
             schedLock.unlock();
             recordmatchLock.lock();
             UpdateMatches(recordid, sourceid, mplexid, maxstarttime);
@@ -2403,6 +2714,8 @@ bool Scheduler::HandleReschedule(void)
             QString descrip = request[3];
             QString programid = request[4];
             runCheck = true;
+            // Duplicate status may have changed for any rule
+            m_candidatesValid = false;
             schedLock.unlock();
             recordmatchLock.lock();
             ResetDuplicates(recordid, findid, title, subtitle, descrip,
@@ -2475,6 +2788,17 @@ bool Scheduler::HandleReschedule(void)
                 "= %.2f match + %.2f check + %.2f place",
                 (int)reclist.size(), matchTime + checkTime + placeTime,
                 matchTime, checkTime, placeTime);
+    if (m_lastPassIncremental)
+    {
+        msg += QString(" (incremental, %1 of %2 rules queried")
+            .arg(m_lastPassRules).arg(m_candidateRows.size());
+        if (m_lastFullPlaceTime > 0)
+            msg += QString().sprintf(", full place was %.2f",
+                                     m_lastFullPlaceTime);
+        msg += ")";
+    }
+    else
+        m_lastFullPlaceTime = placeTime;
     LOG(VB_GENERAL, LOG_INFO, msg);
 
     fsInfoCacheFillTime = MythDate::current().addSecs(-1000);
@@ -4495,40 +4819,131 @@ void Scheduler::AddNewRecords(void)
         "ON ( oldrecstatus.station   = c.callsign  AND "
         "     oldrecstatus.starttime = p.starttime AND "
         "     oldrecstatus.title     = p.title ) "
-        "WHERE p.endtime > (NOW() - INTERVAL 480 MINUTE) "
-        "ORDER BY RECTABLE.recordid DESC, p.starttime, p.title, c.callsign, "
-        "         c.channum ");
+        "WHERE p.endtime > (NOW() - INTERVAL 480 MINUTE) ");
     query.replace("RECTABLE", schedTmpRecord);
 
-    LOG(VB_SCHEDULE, LOG_INFO, QString(" |-- Start DB Query..."));
+    // In incremental mode only the rules that changed since the last
+    // pass are read from the database, the rest come from the rows
+    // cached then. Anything that changes the query itself, like the
+    // priority settings, needs a full pass.
+    bool incremental = m_incremental && m_candidatesValid &&
+        m_candidateQuery == query;
+    if (!incremental)
+    {
+        m_candidateRows.clear();
+        m_candidatesValid = false;
+    }
+    m_lastPassIncremental = incremental;
+    m_lastPassRules = 0;
 
-    gettimeofday(&dbstart, NULL);
-    result.prepare(query);
-    if (!result.exec())
+    CandidateRows fetched;
+    if (!incremental || !m_staleRules.empty())
     {
-        MythDB::DBError("AddNewRecords", result);
-        return;
+        QString thequery = query;
+        if (incremental)
+        {
+            QStringList ids;
+            QSet<uint>::const_iterator sit = m_staleRules.begin();
+            for (; sit != m_staleRules.end(); ++sit)
+            {
+                ids << QString::number(*sit);
+                m_candidateRows.remove(*sit);
+            }
+            thequery += QString("AND %1.recordid IN (%2) ")
+                .arg(schedTmpRecord).arg(ids.join(","));
+            m_lastPassRules = ids.size();
+        }
+        thequery += QString(
+            "ORDER BY %1.recordid DESC, p.starttime, p.title, c.callsign, "
+            "         c.channum ").arg(schedTmpRecord);
+
+        LOG(VB_SCHEDULE, LOG_INFO, QString(" |-- Start DB Query..."));
+
+        gettimeofday(&dbstart, NULL);
+        result.prepare(thequery);
+        if (!result.exec())
+        {
+            MythDB::DBError("AddNewRecords", result);
+            m_candidatesValid = false;
+            return;
+        }
+        gettimeofday(&dbend, NULL);
+
+        LOG(VB_SCHEDULE, LOG_INFO,
+            QString(" |-- %1 results in %2 sec. Processing...")
+                .arg(result.size())
+                .arg(((dbend.tv_sec  - dbstart.tv_sec) * 1000000 +
+                      (dbend.tv_usec - dbstart.tv_usec)) / 1000000.0));
+
+        int columns = result.record().count();
+        while (result.next())
+        {
+            CandidateRow row(columns);
+            for (int col = 0; col < columns; ++col)
+                row[col] = result.value(col);
+            if (m_incremental)
+                m_candidateRows[row[17].toUInt()].push_back(row);
+            else
+                fetched.push_back(row);
+        }
     }
-    gettimeofday(&dbend, NULL);
 
-    LOG(VB_SCHEDULE, LOG_INFO,
-        QString(" |-- %1 results in %2 sec. Processing...")
-            .arg(result.size())
-            .arg(((dbend.tv_sec  - dbstart.tv_sec) * 1000000 +
-                  (dbend.tv_usec - dbstart.tv_usec)) / 1000000.0));
+    m_staleRules.clear();
+    if (m_incremental)
+    {
+        m_candidateQuery = query;
+        m_candidatesValid = true;
+        if (incremental)
+            RefreshCandidateHistory();
+    }
+
+    // Replay the rows in the order of the full query, rules are kept
+    // in ascending recordid order and each rule's rows in query order.
+    QVector<const CandidateRow*> rows;
+    if (m_incremental)
+    {
+        QDateTime oldest = MythDate::current().addSecs(-480 * 60);
+        QMap<uint, CandidateRows>::const_iterator rit =
+            m_candidateRows.constEnd();
+        while (rit != m_candidateRows.constBegin())
+        {
+            --rit;
+            CandidateRows::const_iterator row = (*rit).begin();
+            for (; row != (*rit).end(); ++row)
+            {
+                if (MythDate::as_utc((*row)[3].toDateTime()) > oldest)
+                    rows.push_back(&(*row));
+            }
+        }
+        if (incremental)
+        {
+            LOG(VB_SCHEDULE, LOG_INFO,
+                QString(" |-- %1 cached results for %2 rules")
+                    .arg(rows.size()).arg(m_candidateRows.size()));
+        }
+    }
+    else
+    {
+        CandidateRows::const_iterator row = fetched.begin();
+        for (; row != fetched.end(); ++row)
+            rows.push_back(&(*row));
+    }
 
     RecordingInfo *lastp = NULL;
 
-    while (result.next())
+    QVector<const CandidateRow*>::const_iterator rowit = rows.begin();
+    for (; rowit != rows.end(); ++rowit)
     {
+        const CandidateRow &row = **rowit;
+
         // If this is the same program we saw in the last pass and it
         // wasn't a viable candidate, then neither is this one so
         // don't bother with it.  This is essentially an early call to
         // PruneRedundants().
-        uint recordid = result.value(17).toUInt();
-        QDateTime startts = MythDate::as_utc(result.value(2).toDateTime());
-        QString title = result.value(4).toString();
-        QString callsign = result.value(8).toString();
+        uint recordid = row[17].toUInt();
+        QDateTime startts = MythDate::as_utc(row[2].toDateTime());
+        QString title = row[4].toString();
+        QString callsign = row[8].toString();
         if (lastp && lastp->GetRecordingStatus() != RecStatus::Unknown
             && lastp->GetRecordingStatus() != RecStatus::Offline
             && lastp->GetRecordingStatus() != RecStatus::DontRecord
@@ -4538,80 +4953,80 @@ void Scheduler::AddNewRecords(void)
             && callsign == lastp->GetChannelSchedulingID())
             continue;
 
-       uint mplexid = result.value(51).toUInt();
+       uint mplexid = row[51].toUInt();
         if (mplexid == 32767)
             mplexid = 0;
 
-        QString inputname = result.value(52).toString();
+        QString inputname = row[52].toString();
         if (inputname.isEmpty())
-            inputname = QString("Input %1").arg(result.value(24).toUInt());
+            inputname = QString("Input %1").arg(row[24].toUInt());
 
         RecordingInfo *p = new RecordingInfo(
             title,
-            result.value(5).toString(),//subtitle
-            result.value(6).toString(),//description
+            row[5].toString(),//subtitle
+            row[6].toString(),//description
             0, // season
             0, // episode
             0, // total episodes
-            result.value(48).toString(),//synidcatedepisode
-            result.value(11).toString(),//category
+            row[48].toString(),//synidcatedepisode
+            row[11].toString(),//category
 
-            result.value(0).toUInt(),//chanid
-            result.value(7).toString(),//channum
+            row[0].toUInt(),//chanid
+            row[7].toString(),//channum
             callsign,
-            result.value(9).toString(),//channame
+            row[9].toString(),//channame
 
-            result.value(21).toString(),//recgroup
-            result.value(36).toString(),//playgroup
+            row[21].toString(),//recgroup
+            row[36].toString(),//playgroup
 
-            result.value(43).toString(),//hostname
-            result.value(42).toString(),//storagegroup
+            row[43].toString(),//hostname
+            row[42].toString(),//storagegroup
 
-            result.value(30).toUInt(),//year
-            result.value(49).toUInt(),//partnumber
-            result.value(50).toUInt(),//parttotal
+            row[30].toUInt(),//year
+            row[49].toUInt(),//partnumber
+            row[50].toUInt(),//parttotal
 
-            result.value(26).toString(),//seriesid
-            result.value(27).toString(),//programid
-            result.value(28).toString(),//inetref
-            string_to_myth_category_type(result.value(29).toString()),//catType
+            row[26].toString(),//seriesid
+            row[27].toString(),//programid
+            row[28].toString(),//inetref
+            string_to_myth_category_type(row[29].toString()),//catType
 
-            result.value(12).toInt(),//recpriority
+            row[12].toInt(),//recpriority
 
             startts,
-            MythDate::as_utc(result.value(3).toDateTime()),//endts
-            MythDate::as_utc(result.value(18).toDateTime()),//recstartts
-            MythDate::as_utc(result.value(19).toDateTime()),//recendts
+            MythDate::as_utc(row[3].toDateTime()),//endts
+            MythDate::as_utc(row[18].toDateTime()),//recstartts
+            MythDate::as_utc(row[19].toDateTime()),//recendts
 
-            result.value(31).toDouble(),//stars
-            (result.value(32).isNull()) ? QDate() :
-            QDate::fromString(result.value(32).toString(), Qt::ISODate),
+            row[31].toDouble(),//stars
+            (row[32].isNull()) ? QDate() :
+            QDate::fromString(row[32].toString(), Qt::ISODate),
             //originalAirDate
 
-            result.value(20).toInt(),//repeat
+            row[20].toInt(),//repeat
 
-            RecStatus::Type(result.value(37).toInt()),//oldrecstatus
-            result.value(38).toInt(),//reactivate
+            RecStatus::Type(row[37].toInt()),//oldrecstatus
+            row[38].toInt(),//reactivate
 
             recordid,
-            result.value(34).toUInt(),//parentid
-            RecordingType(result.value(16).toInt()),//rectype
-            RecordingDupInType(result.value(13).toInt()),//dupin
-            RecordingDupMethodType(result.value(22).toInt()),//dupmethod
-
-            result.value(1).toUInt(),//sourceid
-            result.value(24).toUInt(),//inputid
-
-            result.value(35).toUInt(),//findid
-
-            result.value(23).toInt() == COMM_DETECT_COMMFREE,//commfree
-            result.value(40).toUInt(),//subtitleType
-            result.value(39).toUInt(),//videoproperties
-            result.value(41).toUInt(),//audioproperties
-            result.value(46).toInt(),//future
-            result.value(47).toInt(),//schedorder
+            row[34].toUInt(),//parentid
+            RecordingType(row[16].toInt()),//rectype
+            RecordingDupInType(row[13].toInt()),//dupin
+            RecordingDupMethodType(row[22].toInt()),//dupmethod
+
+            row[1].toUInt(),//sourceid
+            row[24].toUInt(),//inputid
+
+            row[35].toUInt(),//findid
+
+            row[23].toInt() == COMM_DETECT_COMMFREE,//commfree
+            row[40].toUInt(),//subtitleType
+            row[39].toUInt(),//videoproperties
+            row[41].toUInt(),//audioproperties
+            row[46].toInt(),//future
+            row[47].toInt(),//schedorder
             mplexid,                 //mplexid
-            result.value(24).toUInt(), //sgroupid
+            row[24].toUInt(), //sgroupid
             inputname);              //inputname
 
         if (!p->future && !p->IsReactivated() &&
@@ -4621,7 +5036,7 @@ void Scheduler::AddNewRecords(void)
             p->SetRecordingStatus(p->oldrecstatus);
         }
 
-        p->SetRecordingPriority2(result.value(53).toInt());
+        p->SetRecordingPriority2(row[53].toInt());
 
         // Check to see if the program is currently recording and if
         // the end time was changed.  Ideally, checking for a new end
@@ -4685,7 +5100,7 @@ void Scheduler::AddNewRecords(void)
         // Check for RecStatus::CurrentRecording and RecStatus::PreviousRecording
         if (p->GetRecordingRuleType() == kDontRecord)
             newrecstatus = RecStatus::DontRecord;
-        else if (result.value(15).toInt() && !p->IsReactivated())
+        else if (row[15].toInt() && !p->IsReactivated())
             newrecstatus = RecStatus::PreviousRecording;
         else if (p->GetRecordingRuleType() != kSingleRecord &&
                  p->GetRecordingRuleType() != kOverrideRecord &&
@@ -4697,19 +5112,19 @@ void Scheduler::AddNewRecords(void)
             if ((dupin & kDupsNewEpi) && p->IsRepeat())
                 newrecstatus = RecStatus::Repeat;
 
-            if ((dupin & kDupsInOldRecorded) && result.value(10).toInt())
+            if ((dupin & kDupsInOldRecorded) && row[10].toInt())
             {
-                if (result.value(44).toInt() == RecStatus::NeverRecord)
+                if (row[44].toInt() == RecStatus::NeverRecord)
                     newrecstatus = RecStatus::NeverRecord;
                 else
                     newrecstatus = RecStatus::PreviousRecording;
             }
 
-            if ((dupin & kDupsInRecorded) && result.value(14).toInt())
+            if ((dupin & kDupsInRecorded) && row[14].toInt())
                 newrecstatus = RecStatus::CurrentRecording;
         }
 
-        bool inactive = result.value(33).toInt();
+        bool inactive = row[33].toInt();
         if (inactive)
             newrecstatus = RecStatus::Inactive;
 
@@ -4735,6 +5150,121 @@ void Scheduler::AddNewRecords(void)
         worklist.push_back(*tmp);
 }
 
+/** \fn Scheduler::RefreshCandidateHistory(void)
+ *  \brief Updates the oldrecorded and recordmatch columns of the cached
+ *         AddNewRecords() rows.
+ *
+ *  The scheduler itself writes oldrecorded after every pass and while
+ *  recording, and UpdateDuplicates() rewrites the duplicate columns of
+ *  recordmatch for every rule, without a request naming the rule, so
+ *  these columns are always read again. These are much smaller queries
+ *  than the full join.
+ */
+void Scheduler::RefreshCandidateHistory(void)
+{
+    QDateTime minstart;
+    QMap<uint, CandidateRows>::const_iterator rit =
+        m_candidateRows.constBegin();
+    for (; rit != m_candidateRows.constEnd(); ++rit)
+    {
+        CandidateRows::const_iterator row = (*rit).begin();
+        for (; row != (*rit).end(); ++row)
+        {
+            QDateTime start = (*row)[2].toDateTime();
+            if (!minstart.isValid() || start < minstart)
+                minstart = start;
+        }
+    }
+    if (!minstart.isValid())
+        return;
+
+    MSqlQuery result(dbConn);
+    result.prepare("SELECT station, starttime, title, "
+                   "       recstatus, reactivate, future "
+                   "FROM oldrecorded "
+                   "WHERE starttime >= :MINSTART");
+    result.bindValue(":MINSTART", minstart);
+    if (!result.exec())
+    {
+        MythDB::DBError("RefreshCandidateHistory", result);
+        m_candidatesValid = false;
+        return;
+    }
+
+    QHash<QString, CandidateRow> history;
+    while (result.next())
+    {
+        QString key = result.value(0).toString() + '|' +
+            result.value(1).toDateTime().toString(Qt::ISODate) + '|' +
+            result.value(2).toString();
+        CandidateRow cols(3);
+        cols[0] = result.value(3);
+        cols[1] = result.value(4);
+        cols[2] = result.value(5);
+        history[key] = cols;
+    }
+
+    result.prepare("SELECT recordid, chanid, starttime, oldrecduplicate, "
+                   "       recduplicate, findduplicate, oldrecstatus "
+                   "FROM recordmatch "
+                   "WHERE starttime >= :MINSTART");
+    result.bindValue(":MINSTART", minstart);
+    if (!result.exec())
+    {
+        MythDB::DBError("RefreshCandidateHistory", result);
+        m_candidatesValid = false;
+        return;
+    }
+
+    QHash<QString, CandidateRow> matches;
+    while (result.next())
+    {
+        QString key = result.value(0).toString() + '|' +
+            result.value(1).toString() + '|' +
+            result.value(2).toDateTime().toString(Qt::ISODate);
+        CandidateRow cols(4);
+        cols[0] = result.value(3);
+        cols[1] = result.value(4);
+        cols[2] = result.value(5);
+        cols[3] = result.value(6);
+        matches[key] = cols;
+    }
+
+    QMap<uint, CandidateRows>::iterator wit = m_candidateRows.begin();
+    for (; wit != m_candidateRows.end(); ++wit)
+    {
+        CandidateRows::iterator row = (*wit).begin();
+        while (row != (*wit).end())
+        {
+            QString key = (*row)[8].toString() + '|' +
+                (*row)[2].toDateTime().toString(Qt::ISODate) + '|' +
+                (*row)[4].toString();
+            QHash<QString, CandidateRow>::const_iterator hit =
+                history.find(key);
+            bool found = (hit != history.end());
+            (*row)[37] = found ? (*hit)[0] : QVariant(); // recstatus
+            (*row)[38] = found ? (*hit)[1] : QVariant(); // reactivate
+            (*row)[46] = found ? (*hit)[2] : QVariant(); // future
+
+            key = (*row)[17].toString() + '|' + (*row)[0].toString() + '|' +
+                (*row)[2].toDateTime().toString(Qt::ISODate);
+            QHash<QString, CandidateRow>::const_iterator mit =
+                matches.find(key);
+            if (mit == matches.end())
+            {
+                // The program is no longer matched by its rule
+                row = (*wit).erase(row);
+                continue;
+            }
+            (*row)[10] = (*mit)[0]; // oldrecduplicate
+            (*row)[14] = (*mit)[1]; // recduplicate
+            (*row)[15] = (*mit)[2]; // findduplicate
+            (*row)[44] = (*mit)[3]; // recordmatch.oldrecstatus
+            ++row;
+        }
+    }
+}
+
 void Scheduler::AddNotListed(void) {
 
     struct timeval dbstart, dbend;
@@ -5657,7 +6187,8 @@ void Scheduler::SchedLiveTV(void)
     if (livetvlist.empty())
         return;
 
-    SchedNewRetryPass(livetvlist.begin(), livetvlist.end(), false, true);
+    SchedNewRetryPass(livetvlist.begin(), livetvlist.end(), false,
+                      worklist, true);
 
     while (!livetvlist.empty())
     {
@@ -13,6 +13,8 @@ using namespace std;
 #include <QMutex>
 #include <QMap>
 #include <QSet>
+#include <QVariant>
+#include <QVector>
 
 // MythTV headers
 #include "filesysteminfo.h"
@@ -22,10 +24,12 @@ using namespace std;
 #include "mythscheduler.h"
 #include "mthread.h"
 #include "scheduledrecording.h"
+#include "recordingtimeindex.h"
 
 class EncoderLink;
 class MainServer;
 class AutoExpire;
+class SchedPlaceRunnable;
 
 class Scheduler;
 
@@ -51,6 +55,9 @@ class SchedInputInfo
 
 class Scheduler : public MThread, public MythScheduler
 {
+    friend class SchedPlaceRunnable;
+    friend class TestScheduler;
+
   public:
     Scheduler(bool runthread, QMap<int, EncoderLink *> *tvList,
               QString recordTbl = "record", Scheduler *master_sched = NULL);
@@ -149,6 +156,7 @@ class Scheduler : public MThread, public MythScheduler
     void BuildWorkList(void);
     bool ClearWorkList(void);
     void AddNewRecords(void);
+    void RefreshCandidateHistory(void);
     void AddNotListed(void);
     void BuildNewRecordsQueries(uint recordid, QStringList &from,
                                 QStringList &where, MSqlBindings &bindings);
@@ -160,10 +168,19 @@ class Scheduler : public MThread, public MythScheduler
 
     bool IsSameProgram(const RecordingInfo *a, const RecordingInfo *b) const;
 
+    bool IsConflict(const RecordingInfo *p, const RecordingInfo *q,
+                    OpenEndType openEnd, uint &affinity) const;
     bool FindNextConflict(const RecList &cardlist,
                           const RecordingInfo *p, RecConstIter &iter,
                           OpenEndType openEnd = openEndNever,
                           uint *paffinity = NULL) const;
+    void FindOverlaps(const RecList &cardlist, const RecordingInfo *p,
+                      vector<uint> &overlaps) const;
+    bool FindNextConflict(const RecList &cardlist,
+                          const RecordingInfo *p,
+                          const vector<uint> &overlaps, uint &k,
+                          OpenEndType openEnd = openEndNever,
+                          uint *paffinity = NULL) const;
     const RecordingInfo *FindConflict(const RecordingInfo *p,
                                       OpenEndType openEnd = openEndNever,
                                       uint *affinity = NULL,
@@ -171,15 +188,19 @@ class Scheduler : public MThread, public MythScheduler
         const;
     void MarkOtherShowings(RecordingInfo *p);
     void MarkShowingsList(RecList &showinglist, RecordingInfo *p);
-    void BackupRecStatus(void);
-    void RestoreRecStatus(void);
+    void BackupRecStatus(const RecList &list);
+    void RestoreRecStatus(const RecList &list);
     bool TryAnotherShowing(RecordingInfo *p,  bool samePriority,
                            bool livetv = false);
+    void UpdateLiveTVTime(const QDateTime &recstartts);
     void SchedNewRecords(void);
+    bool SplitWorkList(vector<RecList> &groups);
+    void PlaceRecords(RecList &list);
     void SchedNewFirstPass(RecIter &start, RecIter end,
                            int recpriority, int recpriority2);
     void SchedNewRetryPass(RecIter start, RecIter end,
-                           bool samePriority, bool livetv = false);
+                           bool samePriority, RecList &statuslist,
+                           bool livetv = false);
     void SchedLiveTV(void);
     void PruneRedundants(void);
     void UpdateNextRecord(void);
@@ -248,6 +269,8 @@ class Scheduler : public MThread, public MythScheduler
     RecList livetvlist;
     QMap<uint, SchedInputInfo> sinputinfomap;
     vector<RecList *> conflictlists;
+    // time index of each conflict list, valid while the list maps are
+    QMap<const RecList *, RecordingTimeIndex> conflictindexes;
     QMap<uint, RecList> recordidlistmap;
     QMap<QString, RecList> titlelistmap;
 
@@ -282,6 +305,7 @@ class Scheduler : public MThread, public MythScheduler
 
     // Try to avoid LiveTV sessions until this time
     QDateTime livetvTime;
+    QMutex livetvTimeLock;
 
     QDateTime lastPrepareTime;
 
@@ -291,7 +315,23 @@ class Scheduler : public MThread, public MythScheduler
     typedef pair<const RecordingInfo*,const RecordingInfo*> IsSameKey;
     typedef QMap<IsSameKey,bool> IsSameCacheType;
     mutable IsSameCacheType cache_is_same_program;
+    mutable QMutex cache_is_same_program_lock;
     int tmLastLog;
+
+    // Incremental rescheduling. The rows AddNewRecords() reads from the
+    // database are kept per recording rule, and only rules named in
+    // MATCH requests since the last pass are queried again.
+    typedef QVector<QVariant> CandidateRow;
+    typedef QList<CandidateRow> CandidateRows;
+    bool m_incremental;
+    bool m_candidatesValid;
+    QString m_candidateQuery;
+    QMap<uint, CandidateRows> m_candidateRows;
+    QSet<uint> m_staleRules;
+    // Statistics for the reschedule report
+    bool m_lastPassIncremental;
+    uint m_lastPassRules;
+    float m_lastFullPlaceTime;
 };
 
 #endif
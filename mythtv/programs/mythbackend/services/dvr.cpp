@@ -52,6 +52,8 @@
 
 #include "scheduler.h"
 #include "tv_rec.h"
+#include "backendcontext.h"
+#include "recordingsindex.h"
 
 extern QMap<int, EncoderLink *> tvList;
 extern AutoExpire  *expirer;
@@ -70,26 +72,35 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
                                         const QString &sSort
                                       )
 {
-    QMap< QString, ProgramInfo* > recMap;
-
-    if (gCoreContext->GetScheduler())
-        recMap = gCoreContext->GetScheduler()->GetRecording();
-
-    QMap< QString, uint32_t > inUseMap    = ProgramInfo::QueryInUseMap();
-    QMap< QString, bool >     isJobRunning= ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
-
     ProgramList progList;
 
     int desc = 1;
     if (bDescending)
         desc = -1;
 
-    LoadFromRecorded( progList, false, inUseMap, isJobRunning, recMap, desc, sSort );
+    if (sSort.isEmpty())
+    {
+        // The index only sorts by recording start time
+        gBackendContext->GetRecordingsIndex()->GetRecordings( progList, false,
+                                                              desc );
+    }
+    else
+    {
+        QMap< QString, ProgramInfo* > recMap;
+
+        if (gCoreContext->GetScheduler())
+            recMap = gCoreContext->GetScheduler()->GetRecording();
 
-    QMap< QString, ProgramInfo* >::iterator mit = recMap.begin();
+        QMap< QString, uint32_t > inUseMap    = ProgramInfo::QueryInUseMap();
+        QMap< QString, bool >     isJobRunning= ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
 
-    for (; mit != recMap.end(); mit = recMap.erase(mit))
-        delete *mit;
+        LoadFromRecorded( progList, false, inUseMap, isJobRunning, recMap, desc, sSort );
+
+        QMap< QString, ProgramInfo* >::iterator mit = recMap.begin();
+
+        for (; mit != recMap.end(); mit = recMap.erase(mit))
+            delete *mit;
+    }
 
     // ----------------------------------------------------------------------
     // Build Response
@@ -147,6 +158,47 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
 //
 /////////////////////////////////////////////////////////////////////////////
 
+DTC::RecordedListChanges* Dvr::GetRecordedListChanges( uint nGeneration )
+{
+    ProgramList  changed;
+    QList<uint>  deleted;
+    uint         nCurrent = 0;
+
+    bool bFull = gBackendContext->GetRecordingsIndex()->GetChanges(
+        nGeneration, changed, deleted, nCurrent );
+
+    // ----------------------------------------------------------------------
+    // Build Response
+    // ----------------------------------------------------------------------
+
+    DTC::RecordedListChanges *pChanges = new DTC::RecordedListChanges();
+
+    for( unsigned int n = 0; n < changed.size(); n++)
+    {
+        DTC::Program *pProgram = pChanges->AddNewProgram();
+
+        FillProgramInfo( pProgram, changed[ n ], true );
+    }
+
+    QStringList deletedIds;
+    QList<uint>::const_iterator it = deleted.begin();
+    for (; it != deleted.end(); ++it)
+        deletedIds << QString::number(*it);
+
+    pChanges->setGeneration( nCurrent            );
+    pChanges->setFull      ( bFull               );
+    pChanges->setDeleted   ( deletedIds          );
+    pChanges->setAsOf      ( MythDate::current() );
+    pChanges->setVersion   ( MYTH_BINARY_VERSION );
+    pChanges->setProtoVer  ( MYTH_PROTO_VERSION  );
+
+    return pChanges;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 DTC::ProgramList* Dvr::GetOldRecordedList( bool             bDescending,
                                            int              nStartIndex,
                                            int              nCount,
@@ -52,6 +52,8 @@ class Dvr : public DvrServices
                                                 const QString   &Category,
                                                 const QString   &Sort);
 
+        DTC::RecordedListChanges* GetRecordedListChanges( uint Generation );
+
         DTC::ProgramList* GetOldRecordedList  ( bool             Descending,
                                                 int              StartIndex,
                                                 int              Count,
@@ -334,6 +336,13 @@ class ScriptableDvr : public QObject
             )
         }
 
+        QObject* GetRecordedListChanges( uint Generation )
+        {
+            SCRIPT_CATCH_EXCEPTION( NULL,
+                return m_obj.GetRecordedListChanges( Generation );
+            )
+        }
+
         QObject* GetOldRecordedList  ( bool             Descending,
                                        int              StartIndex,
                                        int              Count,
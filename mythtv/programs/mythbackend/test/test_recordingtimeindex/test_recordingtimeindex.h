@@ -0,0 +1,165 @@
+/*
+ *  Class TestRecordingTimeIndex
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include <vector>
+
+#include "recordingtimeindex.h"
+
+#define GUIDE_INPUTS    8
+#define GUIDE_DAYS      14
+#define MSECS_PER_MIN   (60 * 1000LL)
+
+class TestRecordingTimeIndex: public QObject
+{
+    Q_OBJECT
+
+  private:
+    // Synthetic guide, all showings of several inputs sharing one
+    // conflict list as the scheduler would see them.
+    std::vector<qint64> m_start;
+    std::vector<qint64> m_end;
+    RecordingTimeIndex  m_index;
+
+    static uint Random(uint &seed)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    }
+
+    void Linear(qint64 start, qint64 end, std::vector<uint> &positions) const
+    {
+        positions.clear();
+        for (uint i = 0; i < m_start.size(); ++i)
+        {
+            if (m_start[i] <= end && m_end[i] >= start)
+                positions.push_back(i);
+        }
+    }
+
+  private slots:
+    /** Generates back to back showings of 15 minutes to 3 hours on
+     *  every input, with start and end offsets on some of them like
+     *  recording rules add.
+     */
+    void initTestCase(void)
+    {
+        static const int lengths[] = { 30, 60, 30, 15, 90, 60, 120, 180 };
+        uint seed = 1;
+
+        for (uint input = 0; input < GUIDE_INPUTS; ++input)
+        {
+            qint64 t = 0;
+            while (t < GUIDE_DAYS * 24 * 60 * MSECS_PER_MIN)
+            {
+                qint64 len = lengths[Random(seed) % 8] * MSECS_PER_MIN;
+                qint64 start = t;
+                qint64 end = t + len;
+                if (Random(seed) % 4 == 0)
+                {
+                    start -= 2 * MSECS_PER_MIN;
+                    end += 5 * MSECS_PER_MIN;
+                }
+                m_start.push_back(start);
+                m_end.push_back(end);
+                t += len;
+            }
+        }
+
+        for (uint i = 0; i < m_start.size(); ++i)
+            m_index.Add(i, m_start[i], m_end[i]);
+        m_index.Finish();
+    }
+
+    /** Ranges are inclusive, entries touching the searched range are
+     *  reported since the scheduler decides about back to back
+     *  recordings itself.
+     */
+    void touching_test(void)
+    {
+        RecordingTimeIndex index;
+        index.Add(0, 10, 20);
+        index.Add(1, 40, 50);
+        index.Finish();
+
+        std::vector<uint> positions;
+        index.FindOverlaps(20, 30, positions);
+        QCOMPARE(positions.size(), (size_t)1);
+        QCOMPARE(positions[0], 0U);
+
+        index.FindOverlaps(21, 39, positions);
+        QVERIFY(positions.empty());
+
+        index.FindOverlaps(0, 100, positions);
+        QCOMPARE(positions.size(), (size_t)2);
+    }
+
+    /** Compares the index against a linear scan for random ranges,
+     *  including the order of the returned positions.
+     */
+    void overlaps_test(void)
+    {
+        uint seed = 2;
+        qint64 span = GUIDE_DAYS * 24 * 60;
+        std::vector<uint> expected;
+        std::vector<uint> found;
+
+        for (uint i = 0; i < 5000; ++i)
+        {
+            qint64 start = ((Random(seed) << 15 | Random(seed)) % span) *
+                MSECS_PER_MIN;
+            qint64 end = start + (Random(seed) % 240) * MSECS_PER_MIN;
+            Linear(start, end, expected);
+            m_index.FindOverlaps(start, end, found);
+            QCOMPARE(found, expected);
+        }
+    }
+
+    void lookup_benchmark_data(void)
+    {
+        QTest::addColumn<bool>("useIndex");
+        QTest::newRow("Index") << true;
+        QTest::newRow("Linear") << false;
+    }
+
+    /** Looks up the overlaps of every showing, as one placement pass
+     *  does when each candidate is checked for conflicts.
+     */
+    void lookup_benchmark(void)
+    {
+        QFETCH(bool, useIndex);
+        std::vector<uint> positions;
+        size_t total = 0;
+
+        QBENCHMARK
+        {
+            total = 0;
+            for (uint i = 0; i < m_start.size(); ++i)
+            {
+                if (useIndex)
+                    m_index.FindOverlaps(m_start[i], m_end[i], positions);
+                else
+                    Linear(m_start[i], m_end[i], positions);
+                total += positions.size();
+            }
+        }
+
+        QVERIFY(total >= m_start.size());
+    }
+};
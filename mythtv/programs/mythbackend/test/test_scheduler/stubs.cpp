@@ -0,0 +1,92 @@
+/*
+ *  Stubs for the parts of mythbackend the scheduler calls into
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+// The placement code under test never gets here, these only satisfy
+// the linker for the rest of scheduler.cpp.
+
+#include "encoderlink.h"
+#include "autoexpire.h"
+#include "mainserver.h"
+
+void EncoderLink::SetSleepStatus(SleepStatus newStatus)
+{
+    sleepStatus = newStatus;
+}
+
+bool EncoderLink::GoToSleep(void)
+{
+    return false;
+}
+
+long long EncoderLink::GetMaxBitrate(void)
+{
+    return -1;
+}
+
+bool EncoderLink::IsBusy(InputInfo *, int)
+{
+    return false;
+}
+
+TVState EncoderLink::GetState(void)
+{
+    return kState_None;
+}
+
+void EncoderLink::RecordPending(const ProgramInfo *, int, bool)
+{
+}
+
+RecStatus::Type EncoderLink::StartRecording(ProgramInfo *)
+{
+    return RecStatus::Aborted;
+}
+
+void EncoderLink::SetNextLiveTVDir(QString)
+{
+}
+
+void AutoExpire::Update(int, int, bool)
+{
+}
+
+void AutoExpire::GetAllExpiring(pginfolist_t &)
+{
+}
+
+uint64_t AutoExpire::GetDesiredSpace(int) const
+{
+    return 0;
+}
+
+void AutoExpire::ClearExpireList(pginfolist_t &, bool)
+{
+}
+
+bool MainServer::isClientConnected(bool)
+{
+    return false;
+}
+
+void MainServer::ShutSlaveBackendsDown(QString &)
+{
+}
+
+void MainServer::GetFilesystemInfos(QList<FileSystemInfo> &)
+{
+}
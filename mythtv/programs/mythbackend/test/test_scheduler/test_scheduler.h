@@ -0,0 +1,235 @@
+/*
+ *  Class TestScheduler
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "mythcorecontext.h"
+#include "mythdate.h"
+#include "scheduler.h"
+
+#define GUIDE_GROUPS    3   // independent pairs of conflicting inputs
+#define GUIDE_CHANNELS  3   // per pair of inputs
+#define GUIDE_RULES     6   // per pair of inputs
+#define GUIDE_EPISODES  10  // per rule
+#define GUIDE_SLOTS     48  // half hour slots
+
+class TestScheduler: public QObject
+{
+    Q_OBJECT
+
+  private:
+    /// The showings and conflict lists of a guide, which the scheduler
+    /// only borrows. Declare it after the scheduler, so that it is
+    /// taken back before the scheduler would delete it.
+    class Guide
+    {
+      public:
+        explicit Guide(Scheduler &sched) : m_sched(sched) { }
+        ~Guide() { ReleaseGuide(m_sched); }
+
+        std::deque<RecordingInfo> m_showings;
+        std::deque<RecList>       m_conflictlists;
+
+      private:
+        Scheduler &m_sched;
+    };
+
+    static void ReleaseGuide(Scheduler &sched)
+    {
+        sched.ClearListMaps();
+        sched.worklist.clear();
+        sched.conflictlists.clear();
+        sched.sinputinfomap.clear();
+    }
+
+    static uint Random(uint &seed)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    }
+
+    // The order SchedNewRecords() gets the work list in, for showings
+    // that are neither recording nor in the past.
+    static bool ComparePriority(const RecordingInfo *a,
+                                const RecordingInfo *b)
+    {
+        if (a->GetRecordingPriority() != b->GetRecordingPriority())
+            return a->GetRecordingPriority() > b->GetRecordingPriority();
+        if (a->GetRecordingPriority2() != b->GetRecordingPriority2())
+            return a->GetRecordingPriority2() > b->GetRecordingPriority2();
+        if (a->GetRecordingStartTime() != b->GetRecordingStartTime())
+            return a->GetRecordingStartTime() < b->GetRecordingStartTime();
+        if (a->GetRecordingRuleID() != b->GetRecordingRuleID())
+            return a->GetRecordingRuleID() < b->GetRecordingRuleID();
+        if (a->GetTitle() != b->GetTitle())
+            return a->GetTitle() < b->GetTitle();
+        if (a->GetProgramID() != b->GetProgramID())
+            return a->GetProgramID() < b->GetProgramID();
+        if (a->GetInputID() != b->GetInputID())
+            return a->GetInputID() < b->GetInputID();
+        return a->GetChanID() < b->GetChanID();
+    }
+
+    /**
+     * Fills the inputs and the work list of a scheduler with a guide
+     * that has more showings than the inputs can record. Each pair of
+     * inputs shares a conflict list and has its own channels and rules,
+     * except for one title that the first two pairs both record, so
+     * those two have to be placed together.
+     */
+    static void FillGuide(Scheduler &sched, Guide &guide,
+                          const QDateTime &start)
+    {
+        uint seed = 1;
+
+        for (uint g = 0; g < GUIDE_GROUPS; ++g)
+        {
+            guide.m_conflictlists.emplace_back();
+            RecList *conflictlist = &guide.m_conflictlists.back();
+            sched.conflictlists.push_back(conflictlist);
+
+            uint inputs[2] = { g * 2 + 1, g * 2 + 2 };
+            for (uint i = 0; i < 2; ++i)
+            {
+                SchedInputInfo &info = sched.sinputinfomap[inputs[i]];
+                info.inputid = inputs[i];
+                info.sgroupid = inputs[i];
+                info.conflicting_inputs.push_back(inputs[1 - i]);
+                info.conflictlist = conflictlist;
+            }
+
+            for (uint r = 0; r < GUIDE_RULES; ++r)
+            {
+                uint recordid = g * GUIDE_RULES + r + 1;
+                bool shared = (r == 0 && g < 2);
+                QString title = shared ? QString("News") :
+                    QString("Show %1-%2").arg(g).arg(r);
+
+                for (uint e = 0; e < GUIDE_EPISODES; ++e)
+                {
+                    QString programid = shared ?
+                        QString("EP0000%1").arg(e, 4, 10, QChar('0')) :
+                        QString("EP%1%2").arg(recordid, 4, 10, QChar('0'))
+                                         .arg(e, 4, 10, QChar('0'));
+
+                    uint showings = 2 + Random(seed) % 2;
+                    for (uint s = 0; s < showings; ++s)
+                    {
+                        QDateTime startts =
+                            start.addSecs((Random(seed) % GUIDE_SLOTS) * 1800);
+                        QDateTime endts =
+                            startts.addSecs((1 + Random(seed) % 2) * 1800);
+                        uint chanid = 1000 + g * 10 +
+                            Random(seed) % GUIDE_CHANNELS;
+
+                        for (uint i = 0; i < 2; ++i)
+                        {
+                            guide.m_showings.emplace_back();
+                            RecordingInfo *p = &guide.m_showings.back();
+                            p->SetTitle(title);
+                            p->SetProgramID(programid);
+                            p->SetChanID(chanid);
+                            p->SetScheduledStartTime(startts);
+                            p->SetScheduledEndTime(endts);
+                            p->SetRecordingStartTime(startts);
+                            p->SetRecordingEndTime(endts);
+                            p->SetRecordingRuleID(recordid);
+                            p->SetRecordingRuleType(kAllRecord);
+                            p->SetRecordingPriority(r % 3);
+                            p->SetInputID(inputs[i]);
+                            p->SetRecordingStatus(RecStatus::Unknown);
+                            p->sgroupid = inputs[i];
+                            sched.worklist.push_back(p);
+                        }
+                    }
+                }
+            }
+        }
+
+        stable_sort(sched.worklist.begin(), sched.worklist.end(),
+                    ComparePriority);
+
+        sched.schedTime = MythDate::current();
+        sched.livetvTime = sched.schedTime.addSecs(3600);
+        sched.m_openEnd = openEndNever;
+        sched.BuildListMaps();
+    }
+
+  private slots:
+    // called at the beginning of these sets of tests
+    void initTestCase(void)
+    {
+        gCoreContext = new MythCoreContext("bin_version", NULL);
+    }
+
+    /**
+     * Placing the independent groups of the work list one by one, or
+     * with several threads, has to give every showing the same status
+     * as placing the whole work list in one pass, retries included.
+     */
+    void GroupedPlacement(void)
+    {
+        QDateTime start = MythDate::current().addDays(1);
+
+        Scheduler single(false, NULL);
+        Scheduler grouped(false, NULL);
+        Scheduler threaded(false, NULL);
+        Guide singleGuide(single);
+        Guide groupedGuide(grouped);
+        Guide threadedGuide(threaded);
+        FillGuide(single, singleGuide, start);
+        FillGuide(grouped, groupedGuide, start);
+        FillGuide(threaded, threadedGuide, start);
+
+        single.PlaceRecords(single.worklist);
+
+        vector<RecList> groups;
+        QVERIFY(grouped.SplitWorkList(groups));
+        QCOMPARE(groups.size(), (size_t)(GUIDE_GROUPS - 1));
+        for (uint g = 0; g < groups.size(); ++g)
+            grouped.PlaceRecords(groups[g]);
+
+        threaded.SchedNewRecords();
+
+        QCOMPARE(grouped.worklist.size(), single.worklist.size());
+        QCOMPARE(threaded.worklist.size(), single.worklist.size());
+
+        uint recorded = 0;
+        uint others = 0;
+        for (uint i = 0; i < single.worklist.size(); ++i)
+        {
+            RecStatus::Type status = single.worklist[i]->GetRecordingStatus();
+            QCOMPARE((int)grouped.worklist[i]->GetRecordingStatus(),
+                     (int)status);
+            QCOMPARE((int)threaded.worklist[i]->GetRecordingStatus(),
+                     (int)status);
+            if (status == RecStatus::WillRecord)
+                ++recorded;
+            else if (status != RecStatus::Unknown)
+                ++others;
+        }
+
+        // Make sure the guide really needed more than a first pass
+        QVERIFY(recorded > 0);
+        QVERIFY(others > 0);
+    }
+};
@@ -14,6 +14,7 @@ using namespace std;
 
 // Qt headers
 #include <QString>
+#include <QRunnable>
 #include <QCoreApplication>
 
 // MythTV headers
@@ -21,6 +22,7 @@ using namespace std;
 #include "mythcontext.h"
 #include "programinfo.h"
 #include "mythplayer.h"
+#include "mthreadpool.h"
 
 // Commercial Flagging headers
 #include "ClassicCommDetector.h"
@@ -125,6 +127,28 @@ QString FrameInfoEntry::toString(uint64_t frame, bool verbose) const
         .arg(toStringFrameMaskValues(flagMask, verbose));
 }
 
+/// Analyzes one segment of the recording for parallel flagging
+class ClassicCommSegmentRunner : public QRunnable
+{
+  public:
+    ClassicCommSegmentRunner(ClassicCommDetector *owner,
+                             ClassicCommDetector *detector) :
+        m_owner(owner), m_detector(detector) { }
+
+    void run(void)
+    {
+        m_detector->GoSegment();
+
+        QMutexLocker locker(&m_owner->segmentLock);
+        m_detector->segmentDone.fetchAndStoreOrdered(1);
+        m_owner->segmentFinished.wakeAll();
+    }
+
+  private:
+    ClassicCommDetector *m_owner;
+    ClassicCommDetector *m_detector;
+};
+
 ClassicCommDetector::ClassicCommDetector(SkipType commDetectMethod_in,
                                          bool showProgress_in,
                                          bool fullSpeed_in,
@@ -151,6 +175,10 @@ ClassicCommDetector::ClassicCommDetector(SkipType commDetectMethod_in,
     sceneHasChanged(false),                    stationLogoPresent(false),
     lastFrameWasBlank(false),                  lastFrameWasSceneChange(false),
     decoderFoundAspectChanges(false),          sceneChangeDetector(0),
+    segmentPool(NULL),
+    segmentStart(0),                           segmentEnd(-1),
+    segmentFrames(0),                          segmentDone(0),
+    threadsUsed(1),
     player(player_in),
     startedAt(startedAt_in),                   stopsAt(stopsAt_in),
     recordingStartedAt(recordingStartedAt_in),
@@ -271,11 +299,13 @@ void ClassicCommDetector::Init()
 
     sceneChangeDetector = new ClassicSceneChangeDetector(width, height,
         commDetectBorder, horizSpacing, vertSpacing);
+    // Direct, segments are analyzed on pool threads
     connect(
          sceneChangeDetector,
          SIGNAL(haveNewInformation(unsigned int,bool,float)),
          this,
-         SLOT(sceneChangeDetectorHasNewInformation(unsigned int,bool,float))
+         SLOT(sceneChangeDetectorHasNewInformation(unsigned int,bool,float)),
+         Qt::DirectConnection
     );
 
     frameIsBlank = false;
@@ -296,6 +326,8 @@ void ClassicCommDetector::Init()
 
 void ClassicCommDetector::deleteLater(void)
 {
+    DropSegments();
+
     if (sceneChangeDetector)
         sceneChangeDetector->deleteLater();
 
@@ -436,6 +468,24 @@ bool ClassicCommDetector::go()
 
     player->ResetTotalDuration();
 
+    if (!keyframes.empty())
+    {
+        if (!stillRecording)
+            return GoKeyframes(myTotalFrames);
+
+        LOG(VB_COMMFLAG, LOG_INFO, "Recording in progress, "
+            "analyzing every frame instead of the keyframes");
+        keyframes.clear();
+    }
+
+    if (!segments.empty())
+    {
+        if (StartSegments())
+            threadsUsed = segments.size() + 1;
+        else
+            DropSegments();
+    }
+
     while (player->GetEof() == kEofStateNone)
     {
         struct timeval startTime;
@@ -445,6 +495,13 @@ bool ClassicCommDetector::go()
         VideoFrame* currentFrame = player->GetRawVideoFrame();
         currentFrameNumber = currentFrame->frameNumber;
 
+        // The rest of the recording is analyzed by the other segments
+        if ((segmentEnd >= 0) && (currentFrameNumber >= segmentEnd))
+        {
+            player->DiscardVideoFrame(currentFrame);
+            break;
+        }
+
         //Lucas: maybe we should make the nuppelvideoplayer send out a signal
         //when the aspect ratio changes.
         //In order to not change too many things at a time, I"m using basic
@@ -464,6 +521,7 @@ bool ClassicCommDetector::go()
             if (m_bStop)
             {
                 player->DiscardVideoFrame(currentFrame);
+                FinishSegments();
                 return false;
             }
         }
@@ -523,15 +581,17 @@ bool ClassicCommDetector::go()
              ((currentFrameNumber % 100) == 0)))
         {
             float elapsed = flagTime.elapsed() / 1000.0;
+            long long doneFrames =
+                currentFrameNumber + SegmentFramesProcessed();
 
             if (elapsed)
-                flagFPS = currentFrameNumber / elapsed;
+                flagFPS = doneFrames / elapsed;
             else
                 flagFPS = 0.0;
 
             int percentage;
             if (myTotalFrames)
-                percentage = currentFrameNumber * 100 / myTotalFrames;
+                percentage = doneFrames * 100 / myTotalFrames;
             else
                 percentage = 0;
 
@@ -606,6 +666,15 @@ bool ClassicCommDetector::go()
         player->DiscardVideoFrame(currentFrame);
     }
 
+    if (!segments.empty())
+    {
+        emit statusUpdate(QCoreApplication::translate("(mythcommflag)",
+            "Waiting for the other segments"));
+        if (!FinishSegments())
+            return false;
+        currentFrameNumber = lastFrameNumber;
+    }
+
     if (showProgress)
     {
         float elapsed = flagTime.elapsed() / 1000.0;
@@ -626,6 +695,475 @@ bool ClassicCommDetector::go()
     return true;
 }
 
+/** \fn ClassicCommDetector::AddSegment(MythPlayer*, long long)
+ *  \brief Splits off the part of a finished recording starting at
+ *         startFrame, to be analyzed by its own player and thread.
+ *
+ *  Segments must be added in order, startFrame should be a keyframe so
+ *  the segment's player can seek to it cheaply. The per frame results
+ *  of all segments are merged before the breaks are built, so only the
+ *  decoding and frame analysis run in parallel.
+ */
+bool ClassicCommDetector::AddSegment(MythPlayer *segPlayer, long long startFrame)
+{
+    if (!segPlayer || startFrame <= 0 ||
+        startFrame <= (segments.empty() ? 0 : segments.back()->segmentStart))
+        return false;
+
+    ClassicCommDetector *seg = new ClassicCommDetector(
+        commDetectMethod, false, true, segPlayer, startedAt, stopsAt,
+        recordingStartedAt, recordingStopsAt);
+    seg->segmentStart = startFrame;
+
+    if (segments.empty())
+        segmentEnd = startFrame;
+    else
+        segments.back()->segmentEnd = startFrame;
+    segments.push_back(seg);
+
+    return true;
+}
+
+/// \brief Opens the segment players and starts analyzing them, returns
+///        false if this recording has to be flagged in a single pass.
+bool ClassicCommDetector::StartSegments(void)
+{
+    if (stillRecording)
+    {
+        LOG(VB_COMMFLAG, LOG_INFO,
+            "Recording in progress, flagging it in a single pass");
+        return false;
+    }
+
+    for (int i = 0; i < segments.size(); ++i)
+    {
+        ClassicCommDetector *seg = segments[i];
+
+        if (seg->player->OpenFile() < 0)
+            return false;
+
+        seg->Init();
+        seg->aggressiveDetection = aggressiveDetection;
+        seg->logoDetector = logoDetector;
+        seg->logoInfoAvailable = logoInfoAvailable;
+
+        if (!seg->player->InitVideo())
+        {
+            LOG(VB_GENERAL, LOG_ERR,
+                "Unable to initialize video for a flagging segment.");
+            return false;
+        }
+        seg->player->EnableSubtitles(false);
+    }
+
+    LOG(VB_COMMFLAG, LOG_INFO,
+        QString("Flagging in %1 segments, this one ends at frame %2")
+            .arg(segments.size() + 1).arg(segmentEnd));
+
+    segmentPool = new MThreadPool("CommFlagSegments");
+    segmentPool->setMaxThreadCount(segments.size());
+    for (int i = 0; i < segments.size(); ++i)
+    {
+        segmentPool->start(new ClassicCommSegmentRunner(this, segments[i]),
+                           QString("CommFlagSeg%1").arg(i + 1));
+    }
+
+    return true;
+}
+
+/// \brief Analyzes this segment, runs on a pool thread.
+void ClassicCommDetector::GoSegment(void)
+{
+    float aspect = player->GetVideoAspect();
+    float newAspect = aspect;
+
+    SetVideoParams(aspect);
+
+    // Run the frame before the segment through the detectors first, so
+    // scene change and blank detection continue from the state a single
+    // pass would have. Its results are dropped again below.
+    long long seekFrame = segmentStart - 1;
+    lastFrameNumber = seekFrame - 1;
+    static_cast<ClassicSceneChangeDetector*>(sceneChangeDetector)
+        ->SetFrameNumber(seekFrame);
+
+    while (!m_bStop && player->GetEof() == kEofStateNone)
+    {
+        VideoFrame* currentFrame = player->GetRawVideoFrame(seekFrame);
+        long long currentFrameNumber = currentFrame->frameNumber;
+        seekFrame = -1;
+
+        if ((segmentEnd >= 0) && (currentFrameNumber >= segmentEnd))
+        {
+            player->DiscardVideoFrame(currentFrame);
+            break;
+        }
+
+        newAspect = currentFrame->aspect;
+        if (newAspect != aspect)
+        {
+            SetVideoParams(aspect);
+            aspect = newAspect;
+        }
+
+        ProcessFrame(currentFrame, currentFrameNumber);
+        player->DiscardVideoFrame(currentFrame);
+
+        if (currentFrameNumber < segmentStart)
+        {
+            // Only the segment itself counts towards the total duration
+            player->ResetTotalDuration();
+            ClearAllMaps();
+            framesProcessed = 0;
+            blankFrameCount = 0;
+            totalMinBrightness = 0;
+            decoderFoundAspectChanges = false;
+        }
+
+        segmentFrames.fetchAndStoreOrdered(framesProcessed);
+    }
+
+    // Skipped frame entries may reach back before the segment
+    while (!frameInfo.empty() && frameInfo.firstKey() < segmentStart)
+        frameInfo.erase(frameInfo.begin());
+    while (!blankFrameMap.empty() && blankFrameMap.firstKey() <
+           (uint64_t)segmentStart)
+        blankFrameMap.erase(blankFrameMap.begin());
+    while (!sceneMap.empty() && sceneMap.firstKey() < (uint64_t)segmentStart)
+        sceneMap.erase(sceneMap.begin());
+}
+
+/// \brief Waits for the segments and merges their results into this
+///        detector, returns false if flagging was stopped.
+bool ClassicCommDetector::FinishSegments(void)
+{
+    if (!segmentPool)
+        return true;
+
+    segmentLock.lock();
+    while (true)
+    {
+        bool done = true;
+        for (int i = 0; i < segments.size(); ++i)
+        {
+            if (m_bStop)
+                segments[i]->stop();
+            if (!segments[i]->segmentDone.loadAcquire())
+                done = false;
+        }
+        if (done)
+            break;
+
+        // The runners wake us up as they finish, the timeout only
+        // keeps the job queue checks in breathe() going meanwhile.
+        segmentFinished.wait(&segmentLock, 500);
+
+        segmentLock.unlock();
+        emit breathe();
+        segmentLock.lock();
+    }
+    segmentLock.unlock();
+
+    segmentPool->waitForDone();
+    delete segmentPool;
+    segmentPool = NULL;
+
+    bool ok = !m_bStop;
+    if (ok)
+    {
+        for (int i = 0; i < segments.size(); ++i)
+            MergeSegment(segments[i]);
+    }
+    DropSegments();
+
+    return ok;
+}
+
+void ClassicCommDetector::MergeSegment(const ClassicCommDetector *seg)
+{
+    QMap<long long, FrameInfoEntry>::const_iterator fit;
+    for (fit = seg->frameInfo.begin(); fit != seg->frameInfo.end(); ++fit)
+        frameInfo[fit.key()] = *fit;
+
+    frm_dir_map_t::const_iterator it;
+    for (it = seg->blankFrameMap.begin(); it != seg->blankFrameMap.end(); ++it)
+        blankFrameMap[it.key()] = *it;
+    for (it = seg->sceneMap.begin(); it != seg->sceneMap.end(); ++it)
+        sceneMap[it.key()] = *it;
+
+    framesProcessed += seg->framesProcessed;
+    blankFrameCount += seg->blankFrameCount;
+    totalMinBrightness += seg->totalMinBrightness;
+    decoderFoundAspectChanges |= seg->decoderFoundAspectChanges;
+
+    lastFrameNumber = seg->lastFrameNumber;
+    curFrameNumber = seg->curFrameNumber;
+    currentAspect = seg->currentAspect;
+    commDetectDimAverage = seg->commDetectDimAverage;
+}
+
+void ClassicCommDetector::DropSegments(void)
+{
+    if (segmentPool)
+    {
+        for (int i = 0; i < segments.size(); ++i)
+            segments[i]->stop();
+        segmentPool->waitForDone();
+        delete segmentPool;
+        segmentPool = NULL;
+    }
+
+    for (int i = 0; i < segments.size(); ++i)
+    {
+        segments[i]->logoDetector = NULL; // shared with this detector
+        segments[i]->deleteLater();
+    }
+    segments.clear();
+    segmentEnd = -1;
+}
+
+long long ClassicCommDetector::SegmentFramesProcessed(void) const
+{
+    long long frames = 0;
+    for (int i = 0; i < segments.size(); ++i)
+        frames += segments[i]->segmentFrames.loadAcquire();
+    return frames;
+}
+
+/** \fn ClassicCommDetector::SetKeyframes(const frm_pos_map_t&)
+ *  \brief Analyzes only the keyframes of a finished recording, taken
+ *         from its seek table, instead of every frame.
+ *
+ *  Blank frames, logo presence and aspect changes mostly last longer
+ *  than a group of pictures, so seeking from keyframe to keyframe finds
+ *  the breaks while decoding only the I-frames. The groups in which a
+ *  break may begin or end are then decoded in full to place its edges.
+ */
+bool ClassicCommDetector::SetKeyframes(const frm_pos_map_t &keyframeMap)
+{
+    keyframes = keyframeMap.keys();
+    return true;
+}
+
+/// Whether a break may begin or end between two analyzed keyframes.
+static bool keyframes_differ(const FrameInfoEntry &a, const FrameInfoEntry &b,
+                             bool useScenes)
+{
+    if ((a.flagMask | b.flagMask) &
+        (COMM_FRAME_BLANK | COMM_FRAME_ASPECT_CHANGE))
+        return true;
+    if ((a.flagMask ^ b.flagMask) & COMM_FRAME_LOGO_PRESENT)
+        return true;
+    if ((a.aspect != b.aspect) || (a.format != b.format))
+        return true;
+    // Without a logo, scene changes are all there is to go by
+    return useScenes && (b.flagMask & COMM_FRAME_SCENE_CHANGE);
+}
+
+/// \brief Runs the keyframes through ProcessFrame(), then decodes the
+///        intervals between keyframes that differ frame by frame.
+bool ClassicCommDetector::GoKeyframes(long long totalFrames)
+{
+    ClassicSceneChangeDetector *scd =
+        static_cast<ClassicSceneChangeDetector*>(sceneChangeDetector);
+    float aspect = player->GetVideoAspect();
+    float newAspect = aspect;
+    bool useScenes = !logoInfoAvailable;
+    QMap<long long, long long> intervals;
+    long long prevFrameNumber = -1;
+
+    if (!segments.empty())
+    {
+        LOG(VB_COMMFLAG, LOG_INFO,
+            "Keyframe only flagging uses a single thread");
+        DropSegments();
+    }
+
+    emit statusUpdate(QCoreApplication::translate("(mythcommflag)",
+        "Analyzing keyframes"));
+
+    for (int i = 0; i < keyframes.size(); ++i)
+    {
+        if ((i % 100) == 0)
+        {
+            emit breathe();
+            if (m_bStop)
+                return false;
+
+            if (showProgress && totalFrames)
+            {
+                QString tmp = QString("\r%1%  \r")
+                    .arg(keyframes[i] * 100 / totalFrames, 3);
+                cerr << qPrintable(tmp) << flush;
+            }
+        }
+
+        if (player->GetEof() != kEofStateNone)
+            break;
+
+        VideoFrame* currentFrame = player->GetRawVideoFrame(keyframes[i]);
+        long long currentFrameNumber = currentFrame->frameNumber;
+
+        // The seek may land on a frame that was analyzed already
+        if (currentFrameNumber <= lastFrameNumber)
+        {
+            player->DiscardVideoFrame(currentFrame);
+            continue;
+        }
+
+        newAspect = currentFrame->aspect;
+        if (newAspect != aspect)
+        {
+            SetVideoParams(aspect);
+            aspect = newAspect;
+        }
+
+        scd->SetFrameNumber(currentFrameNumber);
+        ProcessFrame(currentFrame, currentFrameNumber);
+        player->DiscardVideoFrame(currentFrame);
+
+        if ((prevFrameNumber >= 0) &&
+            keyframes_differ(frameInfo.value(prevFrameNumber),
+                             frameInfo.value(currentFrameNumber), useScenes))
+        {
+            intervals[prevFrameNumber] = currentFrameNumber;
+        }
+        prevFrameNumber = currentFrameNumber;
+    }
+
+    long long keyframeFrames = framesProcessed;
+    long long lastKeyframe = lastFrameNumber;
+
+    emit statusUpdate(QCoreApplication::translate("(mythcommflag)",
+        "Refining %1 possible break edges").arg(intervals.size()));
+
+    QMap<long long, long long>::const_iterator it = intervals.begin();
+    for (int i = 0; it != intervals.end(); ++it, ++i)
+    {
+        if ((i % 10) == 0)
+        {
+            emit breathe();
+            if (m_bStop)
+                return false;
+        }
+        RefineKeyframeInterval(it.key(), *it);
+    }
+    lastFrameNumber = lastKeyframe;
+
+    LOG(VB_COMMFLAG, LOG_INFO,
+        QString("Analyzed %1 keyframes and %2 frames around %3 "
+                "possible break edges")
+            .arg(keyframeFrames).arg(framesProcessed - keyframeFrames)
+            .arg(intervals.size()));
+
+    HoldKeyframeInfo(max(lastKeyframe, totalFrames - 1));
+
+    // The break lists treat this as the number of frames
+    framesProcessed = max(lastKeyframe, totalFrames - 1) + 1;
+
+    if (showProgress)
+    {
+        cerr << "\b\b\b\b\b\b      \b\b\b\b\b\b";
+        cerr.flush();
+    }
+
+    return !m_bStop;
+}
+
+/// \brief Analyzes every frame after the keyframe start up to the
+///        keyframe end.
+void ClassicCommDetector::RefineKeyframeInterval(long long start,
+                                                 long long end)
+{
+    ClassicSceneChangeDetector *scd =
+        static_cast<ClassicSceneChangeDetector*>(sceneChangeDetector);
+
+    VideoFrame* currentFrame = player->GetRawVideoFrame(start);
+    if (currentFrame->frameNumber != start)
+    {
+        player->DiscardVideoFrame(currentFrame);
+        return;
+    }
+
+    // Show the scene change detector the keyframe again so the next
+    // frame is compared with it, but keep what the first pass found.
+    FrameInfoEntry saved = frameInfo.value(start);
+    bool savedScene = sceneMap.contains(start);
+    scd->SetFrameNumber(start);
+    sceneChangeDetector->processFrame(currentFrame);
+    player->DiscardVideoFrame(currentFrame);
+    frameInfo[start] = saved;
+    if (savedScene)
+        sceneMap[start] = MARK_SCENE_CHANGE;
+    else
+        sceneMap.remove(start);
+
+    float aspect = player->GetVideoAspect();
+    float newAspect = aspect;
+
+    lastFrameNumber = start;
+    while (!m_bStop && player->GetEof() == kEofStateNone)
+    {
+        currentFrame = player->GetRawVideoFrame();
+        long long currentFrameNumber = currentFrame->frameNumber;
+
+        if (currentFrameNumber >= end)
+        {
+            player->DiscardVideoFrame(currentFrame);
+            break;
+        }
+
+        if (currentFrameNumber <= lastFrameNumber)
+        {
+            player->DiscardVideoFrame(currentFrame);
+            continue;
+        }
+
+        newAspect = currentFrame->aspect;
+        if (newAspect != aspect)
+        {
+            SetVideoParams(aspect);
+            aspect = newAspect;
+        }
+
+        scd->SetFrameNumber(currentFrameNumber);
+        ProcessFrame(currentFrame, currentFrameNumber);
+        player->DiscardVideoFrame(currentFrame);
+    }
+}
+
+/// \brief Gives the frames that were not decoded the results of the last
+///        analyzed frame before them, up to and including lastFrame.
+void ClassicCommDetector::HoldKeyframeInfo(long long lastFrame)
+{
+    FrameInfoEntry held;
+    held.minBrightness = -1;
+    held.maxBrightness = -1;
+    held.avgBrightness = -1;
+    held.sceneChangePercent = -1;
+    held.aspect = currentAspect;
+    held.format = COMM_FORMAT_NORMAL;
+    held.flagMask = COMM_FRAME_SKIPPED;
+
+    long long frame = frameInfo.empty() ? 0 : frameInfo.firstKey();
+    for (; frame <= lastFrame; ++frame)
+    {
+        QMap<long long, FrameInfoEntry>::iterator it = frameInfo.find(frame);
+        if (it == frameInfo.end())
+            it = frameInfo.insert(frame, held);
+        else if (it->flagMask != COMM_FRAME_SKIPPED)
+        {
+            // Blanks and scene changes only last a frame, a logo stays
+            held = *it;
+            held.sceneChangePercent = -1;
+            held.flagMask = COMM_FRAME_SKIPPED |
+                (it->flagMask & COMM_FRAME_LOGO_PRESENT);
+        }
+        else
+            *it = held;
+    }
+}
+
 void ClassicCommDetector::sceneChangeDetectorHasNewInformation(
     unsigned int framenum,bool isSceneChange,float debugValue)
 {
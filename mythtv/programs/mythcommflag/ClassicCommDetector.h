@@ -7,7 +7,11 @@
 // Qt headers
 #include <QObject>
 #include <QMap>
+#include <QList>
 #include <QDateTime>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
 
 // MythTV headers
 #include "programinfo.h"
@@ -17,6 +21,7 @@
 #include "CommDetectorBase.h"
 
 class MythPlayer;
+class MThreadPool;
 class LogoDetectorBase;
 class SceneChangeDetectorBase;
 
@@ -60,6 +65,9 @@ class ClassicCommDetector : public CommDetectorBase
         void GetCommercialBreakList(frm_dir_map_t &comms);
         void recordingFinished(long long totalFileSize);
         void requestCommBreakMapUpdate(void);
+        bool AddSegment(MythPlayer *player, long long startFrame);
+        bool SetKeyframes(const frm_pos_map_t &keyframes);
+        int ThreadsUsed(void) const { return threadsUsed; }
 
         void PrintFullMap(
             ostream &out, const frm_dir_map_t *comm_breaks,
@@ -68,6 +76,7 @@ class ClassicCommDetector : public CommDetectorBase
         void logoDetectorBreathe();
 
         friend class ClassicLogoDetector;
+        friend class ClassicCommSegmentRunner;
 
     protected:
         virtual ~ClassicCommDetector() {}
@@ -112,6 +121,17 @@ class ClassicCommDetector : public CommDetectorBase
         void CleanupFrameInfo(void);
         void GetLogoCommBreakMap(show_map_t &map);
 
+        bool StartSegments(void);
+        void GoSegment(void);
+        bool FinishSegments(void);
+        void MergeSegment(const ClassicCommDetector *seg);
+        void DropSegments(void);
+        long long SegmentFramesProcessed(void) const;
+
+        bool GoKeyframes(long long totalFrames);
+        void RefineKeyframeInterval(long long start, long long end);
+        void HoldKeyframeInfo(long long lastFrame);
+
         enum SkipTypes commDetectMethod;
         frm_dir_map_t lastSentCommBreakMap;
         bool commBreakMapUpdateRequested;
@@ -171,6 +191,21 @@ class ClassicCommDetector : public CommDetectorBase
 
         SceneChangeDetectorBase* sceneChangeDetector;
 
+        // Parallel flagging, segments after the first one are analyzed
+        // by detectors of their own and merged into this one.
+        QList<ClassicCommDetector*> segments;
+        MThreadPool *segmentPool;
+        long long segmentStart;
+        long long segmentEnd;
+        QAtomicInt segmentFrames;
+        QAtomicInt segmentDone;             // protected by segmentLock
+        QMutex segmentLock;
+        QWaitCondition segmentFinished;
+        int threadsUsed;
+
+        // Keyframe only flagging, empty when every frame is analyzed.
+        QList<long long> keyframes;
+
 protected:
         MythPlayer *player;
         QDateTime startedAt, stopsAt;
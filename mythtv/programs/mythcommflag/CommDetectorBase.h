@@ -9,6 +9,8 @@ using namespace std;
 
 #include "programtypes.h"
 
+class MythPlayer;
+
 #define MAX_BLANK_FRAMES 180
 
 typedef enum commMapValues {
@@ -40,6 +42,16 @@ public:
     virtual void recordingFinished(long long totalFileSize)
         { (void)totalFileSize; };
     virtual void requestCommBreakMapUpdate(void) {};
+    /// Adds a player that analyzes the recording from startFrame on in
+    /// parallel with the others, returns false if this is not supported.
+    virtual bool AddSegment(MythPlayer *player, long long startFrame)
+        { (void)player; (void)startFrame; return false; }
+    /// Analyzes only the given keyframes, and the frames around the
+    /// breaks found, returns false if this is not supported.
+    virtual bool SetKeyframes(const frm_pos_map_t &keyframes)
+        { (void)keyframes; return false; }
+    /// The number of threads go() analyzed the recording with.
+    virtual int ThreadsUsed(void) const { return 1; }
 
     virtual void PrintFullMap(
         ostream &out, const frm_dir_map_t *comm_breaks, bool verbose) const = 0;
@@ -19,6 +19,7 @@ extern "C" {
 // Commercial Flagging headers
 #include "FrameAnalyzer.h"
 #include "EdgeDetector.h"
+#include "pgmkernels.h"
 
 namespace edgeDetector {
 
@@ -36,26 +37,31 @@ sgm_init_exclude(unsigned int *sgm, const AVFrame *src, int srcheight,
      * that pixel: how much it differs from its neighbors.
      */
     const int       srcwidth = src->linesize[0];
-    int             rr, cc, dx, dy, rr2, cc2;
-    unsigned char   *rr0, *rr1;
+    const int       rr2 = srcheight - 1;
+    const int       cc2 = srcwidth - 1;
+    const int       excludecc1 = max(0, min(excludecol, cc2));
+    const int       excludecc2 = max(excludecc1,
+                                     min(excludecol + excludewidth, cc2));
+    int             rr;
 
     memset(sgm, 0, srcwidth * srcheight * sizeof(*sgm));
-    rr2 = srcheight - 1;
-    cc2 = srcwidth - 1;
     for (rr = 0; rr < rr2; rr++)
     {
-        for (cc = 0; cc < cc2; cc++)
+        const unsigned char *rr0 = &src->data[0][rr * srcwidth];
+        const unsigned char *rr1 = &src->data[0][(rr + 1) * srcwidth];
+        unsigned int *out = &sgm[rr * srcwidth];
+
+        if (rr < excluderow || rr >= excluderow + excludeheight ||
+                excludecc1 == excludecc2)
         {
-            if (!rrccinrect(rr, cc, excluderow, excludecol,
-                        excludewidth, excludeheight))
-            {
-                rr0 = &src->data[0][rr * srcwidth + cc];
-                rr1 = &src->data[0][(rr + 1) * srcwidth + cc];
-                dx = rr1[1] - rr0[0];   /* southeast - northwest */
-                dy = rr1[0] - rr0[1];   /* southwest - northeast */
-                sgm[rr * srcwidth + cc] = dx * dx + dy * dy;
-            }
+            pgm_sgm_line(out, rr0, rr1, cc2);
+            continue;
         }
+
+        /* Leave the excluded columns zeroed. */
+        pgm_sgm_line(out, rr0, rr1, excludecc1);
+        pgm_sgm_line(out + excludecc2, rr0 + excludecc2, rr1 + excludecc2,
+                cc2 - excludecc2);
     }
     return sgm;
 }
@@ -12,6 +12,7 @@
 // Commercial Flagging headers
 #include "CommDetector2.h"
 #include "FrameAnalyzer.h"
+#include "pgmkernels.h"
 #include "PGMConverter.h"
 #include "BorderDetector.h"
 #include "quickselect.h"
@@ -315,7 +316,7 @@ HistogramAnalyzer::analyzeFrame(const VideoFrame *frame, long long frameno)
     unsigned int        borderpixels, livepixels, npixels, halfnpixels;
     unsigned char       *pp, bordercolor;
     unsigned long long  sumval, sumsquares;
-    int                 rr, cc, rr1, cc1, rr2, cc2, rr3, cc3;
+    int                 rr, rr1, cc1, rr2, cc2, rr3, cc3;
     struct timeval      start, end, elapsed;
 
     if (lastframeno != UNCACHED && lastframeno == frameno)
@@ -363,21 +364,14 @@ HistogramAnalyzer::analyzeFrame(const VideoFrame *frame, long long frameno)
     histval[DEFAULT_COLOR] += borderpixels;
     for (rr = rr1; rr < rr2; rr += RINC)
     {
-        int rroffset = rr * pgmwidth;
-
-        for (cc = cc1; cc < cc2; cc += CINC)
-        {
-            if (logo && rr >= logorr1 && rr <= logorr2 &&
-                    cc >= logocc1 && cc <= logocc2)
-                continue; /* Exclude logo area from analysis. */
-
-            unsigned char val = pgm->data[0][rroffset + cc];
-            *pp++ = val;
-            sumval += val;
-            sumsquares += val * val;
-            livepixels++;
-            histval[val]++;
-        }
+        /* Exclude logo area from analysis. */
+        bool inlogo = logo && rr >= logorr1 && rr <= logorr2;
+        int nsamples = pgm_sample_row(pp, &pgm->data[0][rr * pgmwidth],
+                pgmwidth, cc1, cc2, CINC,
+                inlogo ? logocc1 : 1, inlogo ? logocc2 : 0,
+                &sumval, &sumsquares, histval);
+        pp += nsamples;
+        livepixels += nsamples;
     }
     npixels = borderpixels + livepixels;
 
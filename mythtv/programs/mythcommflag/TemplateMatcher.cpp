@@ -22,6 +22,7 @@ using namespace std;
 #include "CommDetector2.h"
 #include "FrameAnalyzer.h"
 #include "pgm.h"
+#include "pgmkernels.h"
 #include "PGMConverter.h"
 #include "EdgeDetector.h"
 #include "BlankFrameDetector.h"
@@ -41,13 +42,8 @@ int pgm_set(const AVFrame *pict, int height)
 {
     const int   width = pict->linesize[0];
     const int   size = height * width;
-    int         score, ii;
 
-    score = 0;
-    for (ii = 0; ii < size; ii++)
-        if (pict->data[0][ii])
-            score++;
-    return score;
+    return pgm_count_set(pict->data[0], size);
 }
 
 int pgm_match(const AVFrame *tmpl, const AVFrame *test, int height,
@@ -65,6 +61,14 @@ int pgm_match(const AVFrame *tmpl, const AVFrame *test, int height,
         return -1;
     }
 
+    if (radius == 0)
+    {
+        /* Pixel for pixel, no search of the neighborhood. */
+        *pscore = pgm_count_both_set(tmpl->data[0], test->data[0],
+                height * width);
+        return 0;
+    }
+
     score = 0;
     for (rr = 0; rr < height; rr++)
     {
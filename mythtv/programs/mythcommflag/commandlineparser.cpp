@@ -61,6 +61,17 @@ void MythCommFlagCommandLineParser::LoadArguments(void)
         "off, blank, scene, blankscene, logo, all, "
         "d2, d2_logo, d2_blank, d2_scene, d2_all", "")
             ->SetGroup("Commflagging");
+    add("--threads", "threads", 1,
+        "Number of threads to flag a finished recording with. The "
+        "recording is split at keyframes and the parts are analyzed "
+        "in parallel (classic methods only).", "")
+            ->SetGroup("Commflagging");
+    add("--keyframes-only", "keyframesonly", false,
+        "Analyze a finished recording from the keyframes in its seek "
+        "table, decoding every frame only where a break may begin or "
+        "end. Much faster, but may miss short blank frames between "
+        "commercials (classic methods only).", "")
+            ->SetGroup("Commflagging");
     add("--outputmethod", "outputmethod", "",
         "Format of output written to outputfile, essentials, full.", "")
             ->SetGroup("Commflagging");
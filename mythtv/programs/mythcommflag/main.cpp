@@ -20,6 +20,7 @@ using namespace std;
 #include <QRegExp>
 #include <QDir>
 #include <QEvent>
+#include <QElapsedTimer>
 
 // MythTV headers
 #include "mythmiscutil.h"
@@ -522,11 +523,14 @@ static void incomingCustomEvent(QEvent* e)
     }
 }
 
+typedef QMap<long long, MythCommFlagPlayer*> SegmentPlayers;
+
 static int DoFlagCommercials(
     ProgramInfo *program_info,
     bool showPercentage, bool fullSpeed, int jobid,
     MythCommFlagPlayer* cfp, enum SkipTypes commDetectMethod,
-    const QString &outputfilename, bool useDB)
+    const QString &outputfilename, bool useDB,
+    const SegmentPlayers &segments, const frm_pos_map_t &keyframes)
 {
     CommDetectorFactory factory;
     commDetector = factory.makeCommDetector(
@@ -538,6 +542,28 @@ static int DoFlagCommercials(
         program_info->GetRecordingStartTime(),
         program_info->GetRecordingEndTime(), useDB);
 
+    int threads = 1;
+    SegmentPlayers::const_iterator sit = segments.begin();
+    for (; sit != segments.end(); ++sit)
+    {
+        if (!commDetector->AddSegment(*sit, sit.key()))
+        {
+            LOG(VB_COMMFLAG, LOG_INFO,
+                "This flagging method can only use a single thread");
+            break;
+        }
+        threads++;
+    }
+
+    bool keyframeOnly = false;
+    if (!keyframes.empty())
+    {
+        keyframeOnly = commDetector->SetKeyframes(keyframes);
+        if (!keyframeOnly)
+            LOG(VB_COMMFLAG, LOG_INFO,
+                "This flagging method has to analyze every frame");
+    }
+
     if (jobid > 0)
         LOG(VB_COMMFLAG, LOG_INFO,
             QString("mythcommflag processing JobID %1").arg(jobid));
@@ -565,12 +591,33 @@ static int DoFlagCommercials(
         gCoreContext->SendMessage(message);
     }
 
+    QElapsedTimer flagTimer;
+    flagTimer.start();
+
     bool result = commDetector->go();
     int comms_found = 0;
 
+    // Segments are dropped again if they can't be used
+    threads = commDetector->ThreadsUsed();
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Flagging took %1 seconds using %2 thread(s)")
+            .arg(flagTimer.elapsed() / 1000.0, 0, 'f', 1).arg(threads));
+
     if (result)
     {
-        cfp->SaveTotalDuration();
+        // Each segment player only decoded its own part of the recording
+        if (!keyframeOnly)
+        {
+            DecoderBase *decoder = cfp->GetDecoder();
+            for (sit = segments.begin();
+                 threads > 1 && decoder && sit != segments.end(); ++sit)
+            {
+                if ((*sit)->GetDecoder())
+                    decoder->AddTotalDuration((*sit)->GetDecoder());
+            }
+            cfp->SaveTotalDuration();
+        }
 
         frm_dir_map_t commBreakList;
         commDetector->GetCommercialBreakList(commBreakList);
@@ -607,6 +654,54 @@ static int DoFlagCommercials(
     return comms_found;
 }
 
+/** \brief Creates the players for flagging a recording with several
+ *         threads, keyed by the keyframe each one starts at.
+ *
+ *  The first segment is flagged by the main player, so this creates
+ *  threads - 1 players. Nothing is created without a seek table.
+ */
+static SegmentPlayers CreateSegmentPlayers(
+    ProgramInfo *program_info, const QString &filename, PlayerFlags flags,
+    int threads, QList<PlayerContext*> &contexts)
+{
+    SegmentPlayers players;
+
+    frm_pos_map_t keyframes;
+    program_info->QueryPositionMap(keyframes, MARK_GOP_BYFRAME);
+    if (keyframes.size() < threads * 2)
+    {
+        LOG(VB_COMMFLAG, LOG_INFO, "No seek table to split the recording "
+            "at, flagging it with a single thread");
+        return players;
+    }
+
+    long long lastFrame = keyframes.lastKey();
+    for (int i = 1; i < threads; ++i)
+    {
+        frm_pos_map_t::const_iterator it =
+            keyframes.lowerBound(lastFrame * i / threads);
+        if (it == keyframes.end() || it.key() <= 0 ||
+            players.contains(it.key()))
+            continue;
+
+        RingBuffer *rbuf = RingBuffer::Create(filename, false);
+        if (!rbuf)
+            break;
+
+        MythCommFlagPlayer *player = new MythCommFlagPlayer(flags);
+        PlayerContext *ctx = new PlayerContext(kFlaggerInUseID);
+        ctx->SetPlayingInfo(program_info);
+        ctx->SetRingBuffer(rbuf);
+        ctx->SetPlayer(player);
+        player->SetPlayerInfo(NULL, NULL, ctx);
+
+        contexts.push_back(ctx);
+        players[it.key()] = player;
+    }
+
+    return players;
+}
+
 static qint64 GetFileSize(ProgramInfo *program_info)
 {
     QString filename = get_filename(program_info);
@@ -921,9 +1016,30 @@ static int FlagCommercials(ProgramInfo *program_info, int jobid,
 
     // TODO: Add back insertion of job if not in jobqueue
 
+    QList<PlayerContext*> segmentContexts;
+    SegmentPlayers segments;
+    frm_pos_map_t keyframes;
+    if (cmdline.toBool("keyframesonly") && useDB && !watchingRecording)
+    {
+        program_info->QueryPositionMap(keyframes, MARK_GOP_BYFRAME);
+        if (keyframes.empty())
+            LOG(VB_COMMFLAG, LOG_INFO,
+                "No seek table, analyzing every frame");
+    }
+
+    int threads = cmdline.toInt("threads");
+    if (threads > 1 && keyframes.empty() && useDB && !watchingRecording)
+    {
+        segments = CreateSegmentPlayers(program_info, filename, flags,
+                                        threads, segmentContexts);
+    }
+
     breaksFound = DoFlagCommercials(
         program_info, progress, fullSpeed, jobid,
-        cfp, commDetectMethod, outputfilename, useDB);
+        cfp, commDetectMethod, outputfilename, useDB, segments, keyframes);
+
+    while (!segmentContexts.isEmpty())
+        delete segmentContexts.takeFirst();
 
     if (progress)
         cerr << breaksFound << "\n";
@@ -19,7 +19,7 @@ HEADERS += ClassicCommDetector.h
 HEADERS += Histogram.h
 HEADERS += quickselect.h
 HEADERS += CommDetector2.h
-HEADERS += pgm.h
+HEADERS += pgm.h pgmkernels.h
 HEADERS += EdgeDetector.h CannyEdgeDetector.h
 HEADERS += PGMConverter.h BorderDetector.h
 HEADERS += FrameAnalyzer.h
@@ -40,7 +40,7 @@ SOURCES += ClassicCommDetector.cpp
 SOURCES += Histogram.cpp
 SOURCES += quickselect.c
 SOURCES += CommDetector2.cpp
-SOURCES += pgm.cpp
+SOURCES += pgm.cpp pgmkernels.cpp
 SOURCES += EdgeDetector.cpp CannyEdgeDetector.cpp
 SOURCES += PGMConverter.cpp BorderDetector.cpp
 SOURCES += FrameAnalyzer.cpp
@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cstring>
+
+#include "mythconfig.h"
+#include "pgmkernels.h"
+
+#if ARCH_X86 && defined(__GNUC__)
+#define USE_X86_PGMKERNELS 1
+#include <immintrin.h>
+extern "C" {
+#include "libavutil/cpu.h"
+}
+#endif
+
+/*
+ * Scalar kernels. These are the loops the analyzers used before, the
+ * vector versions below fall back to them for whatever is left over at
+ * the end of a line.
+ */
+
+static void convolve_c(unsigned char *dst, const unsigned char *src,
+        int count, const double *mask, int radius, int tapstride)
+{
+    for (int ii = 0; ii < count; ii++)
+    {
+        double sum = 0;
+        for (int kk = -radius; kk <= radius; kk++)
+            sum += mask[kk + radius] * src[ii + kk * tapstride];
+        dst[ii] = (unsigned char)(sum + 0.5);
+    }
+}
+
+static void sgm_c(unsigned int *dst, const unsigned char *row0,
+        const unsigned char *row1, int count)
+{
+    for (int ii = 0; ii < count; ii++)
+    {
+        int dx = row1[ii + 1] - row0[ii];   /* southeast - northwest */
+        int dy = row1[ii] - row0[ii + 1];   /* southwest - northeast */
+        dst[ii] = dx * dx + dy * dy;
+    }
+}
+
+static int count_set_c(const unsigned char *buf, int size)
+{
+    int score = 0;
+    for (int ii = 0; ii < size; ii++)
+        if (buf[ii])
+            score++;
+    return score;
+}
+
+static int count_both_set_c(const unsigned char *aa, const unsigned char *bb,
+        int size)
+{
+    int score = 0;
+    for (int ii = 0; ii < size; ii++)
+        if (aa[ii] && bb[ii])
+            score++;
+    return score;
+}
+
+static int sample_c(unsigned char *out, const unsigned char *row, int width,
+        int cc, int cc2, int cinc, unsigned long long *sumval,
+        unsigned long long *sumsquares, int *histval)
+{
+    (void)width;
+    int nsamples = 0;
+    for (; cc < cc2; cc += cinc)
+    {
+        unsigned char val = row[cc];
+        out[nsamples++] = val;
+        *sumval += val;
+        *sumsquares += val * val;
+        histval[val]++;
+    }
+    return nsamples;
+}
+
+#ifdef USE_X86_PGMKERNELS
+/*
+ * The convolutions convert pixels to double and keep the scalar order of
+ * the multiply-adds, one output pixel per lane. They deliberately avoid
+ * FMA, which rounds differently than a separate multiply and add.
+ */
+__attribute__((target("sse2")))
+static void convolve_sse2(unsigned char *dst, const unsigned char *src,
+        int count, const double *mask, int radius, int tapstride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128d half = _mm_set1_pd(0.5);
+    int ii = 0;
+
+    for (; ii + 4 <= count; ii += 4)
+    {
+        __m128d lo = _mm_setzero_pd();
+        __m128d hi = _mm_setzero_pd();
+        for (int kk = -radius; kk <= radius; kk++)
+        {
+            int bytes;
+            memcpy(&bytes, src + ii + kk * tapstride, sizeof(bytes));
+            __m128i px = _mm_cvtsi32_si128(bytes);
+            px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(px, zero), zero);
+            __m128d mm = _mm_set1_pd(mask[kk + radius]);
+            lo = _mm_add_pd(lo, _mm_mul_pd(mm, _mm_cvtepi32_pd(px)));
+            hi = _mm_add_pd(hi, _mm_mul_pd(mm,
+                        _mm_cvtepi32_pd(_mm_unpackhi_epi64(px, px))));
+        }
+        int res[4];
+        _mm_storel_epi64((__m128i*)&res[0],
+                _mm_cvttpd_epi32(_mm_add_pd(lo, half)));
+        _mm_storel_epi64((__m128i*)&res[2],
+                _mm_cvttpd_epi32(_mm_add_pd(hi, half)));
+        for (int jj = 0; jj < 4; jj++)
+            dst[ii + jj] = (unsigned char)res[jj];
+    }
+    convolve_c(dst + ii, src + ii, count - ii, mask, radius, tapstride);
+}
+
+__attribute__((target("avx2")))
+static void convolve_avx2(unsigned char *dst, const unsigned char *src,
+        int count, const double *mask, int radius, int tapstride)
+{
+    const __m256d half = _mm256_set1_pd(0.5);
+    int ii = 0;
+
+    for (; ii + 8 <= count; ii += 8)
+    {
+        __m256d lo = _mm256_setzero_pd();
+        __m256d hi = _mm256_setzero_pd();
+        for (int kk = -radius; kk <= radius; kk++)
+        {
+            __m256i px = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                        (const __m128i*)(src + ii + kk * tapstride)));
+            __m256d mm = _mm256_set1_pd(mask[kk + radius]);
+            lo = _mm256_add_pd(lo, _mm256_mul_pd(mm,
+                        _mm256_cvtepi32_pd(_mm256_castsi256_si128(px))));
+            hi = _mm256_add_pd(hi, _mm256_mul_pd(mm,
+                        _mm256_cvtepi32_pd(_mm256_extracti128_si256(px, 1))));
+        }
+        int res[8];
+        _mm_storeu_si128((__m128i*)&res[0],
+                _mm256_cvttpd_epi32(_mm256_add_pd(lo, half)));
+        _mm_storeu_si128((__m128i*)&res[4],
+                _mm256_cvttpd_epi32(_mm256_add_pd(hi, half)));
+        for (int jj = 0; jj < 8; jj++)
+            dst[ii + jj] = (unsigned char)res[jj];
+    }
+    convolve_sse2(dst + ii, src + ii, count - ii, mask, radius, tapstride);
+}
+
+/*
+ * dx and dy fit in 16 bits, so interleaving them and using madd gives
+ * dx * dx + dy * dy in one instruction.
+ */
+__attribute__((target("sse2")))
+static void sgm_sse2(unsigned int *dst, const unsigned char *row0,
+        const unsigned char *row1, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int ii = 0;
+
+    // the loads at ii + 1 read the pixel after the block
+    for (; ii + 16 <= count; ii += 16)
+    {
+        __m128i nw = _mm_loadu_si128((const __m128i*)(row0 + ii));
+        __m128i ne = _mm_loadu_si128((const __m128i*)(row0 + ii + 1));
+        __m128i sw = _mm_loadu_si128((const __m128i*)(row1 + ii));
+        __m128i se = _mm_loadu_si128((const __m128i*)(row1 + ii + 1));
+
+        __m128i dxlo = _mm_sub_epi16(_mm_unpacklo_epi8(se, zero),
+                                     _mm_unpacklo_epi8(nw, zero));
+        __m128i dxhi = _mm_sub_epi16(_mm_unpackhi_epi8(se, zero),
+                                     _mm_unpackhi_epi8(nw, zero));
+        __m128i dylo = _mm_sub_epi16(_mm_unpacklo_epi8(sw, zero),
+                                     _mm_unpacklo_epi8(ne, zero));
+        __m128i dyhi = _mm_sub_epi16(_mm_unpackhi_epi8(sw, zero),
+                                     _mm_unpackhi_epi8(ne, zero));
+
+        __m128i *out = (__m128i*)(dst + ii);
+        __m128i dd;
+        dd = _mm_unpacklo_epi16(dxlo, dylo);
+        _mm_storeu_si128(out + 0, _mm_madd_epi16(dd, dd));
+        dd = _mm_unpackhi_epi16(dxlo, dylo);
+        _mm_storeu_si128(out + 1, _mm_madd_epi16(dd, dd));
+        dd = _mm_unpacklo_epi16(dxhi, dyhi);
+        _mm_storeu_si128(out + 2, _mm_madd_epi16(dd, dd));
+        dd = _mm_unpackhi_epi16(dxhi, dyhi);
+        _mm_storeu_si128(out + 3, _mm_madd_epi16(dd, dd));
+    }
+    sgm_c(dst + ii, row0 + ii, row1 + ii, count - ii);
+}
+
+__attribute__((target("avx2")))
+static void sgm_avx2(unsigned int *dst, const unsigned char *row0,
+        const unsigned char *row1, int count)
+{
+    int ii = 0;
+
+    for (; ii + 16 <= count; ii += 16)
+    {
+        __m256i nw = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i*)(row0 + ii)));
+        __m256i ne = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i*)(row0 + ii + 1)));
+        __m256i sw = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i*)(row1 + ii)));
+        __m256i se = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i*)(row1 + ii + 1)));
+
+        __m256i dx = _mm256_sub_epi16(se, nw);
+        __m256i dy = _mm256_sub_epi16(sw, ne);
+
+        // unpack works within 128 bit lanes: lo holds pixels 0-3 and
+        // 8-11, hi holds 4-7 and 12-15.
+        __m256i lo = _mm256_unpacklo_epi16(dx, dy);
+        __m256i hi = _mm256_unpackhi_epi16(dx, dy);
+        lo = _mm256_madd_epi16(lo, lo);
+        hi = _mm256_madd_epi16(hi, hi);
+
+        __m256i *out = (__m256i*)(dst + ii);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    sgm_sse2(dst + ii, row0 + ii, row1 + ii, count - ii);
+}
+
+__attribute__((target("sse2")))
+static int count_set_sse2(const unsigned char *buf, int size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int score = 0;
+    int ii = 0;
+
+    for (; ii + 16 <= size; ii += 16)
+    {
+        __m128i px = _mm_loadu_si128((const __m128i*)(buf + ii));
+        int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(px, zero));
+        score += 16 - __builtin_popcount(zeros);
+    }
+    return score + count_set_c(buf + ii, size - ii);
+}
+
+__attribute__((target("avx2")))
+static int count_set_avx2(const unsigned char *buf, int size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int score = 0;
+    int ii = 0;
+
+    for (; ii + 32 <= size; ii += 32)
+    {
+        __m256i px = _mm256_loadu_si256((const __m256i*)(buf + ii));
+        unsigned int zeros =
+            (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(px, zero));
+        score += 32 - __builtin_popcount(zeros);
+    }
+    return score + count_set_sse2(buf + ii, size - ii);
+}
+
+__attribute__((target("sse2")))
+static int count_both_set_sse2(const unsigned char *aa,
+        const unsigned char *bb, int size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int score = 0;
+    int ii = 0;
+
+    for (; ii + 16 <= size; ii += 16)
+    {
+        __m128i pa = _mm_loadu_si128((const __m128i*)(aa + ii));
+        __m128i pb = _mm_loadu_si128((const __m128i*)(bb + ii));
+        int zeros = _mm_movemask_epi8(_mm_or_si128(
+                    _mm_cmpeq_epi8(pa, zero), _mm_cmpeq_epi8(pb, zero)));
+        score += 16 - __builtin_popcount(zeros);
+    }
+    return score + count_both_set_c(aa + ii, bb + ii, size - ii);
+}
+
+__attribute__((target("avx2")))
+static int count_both_set_avx2(const unsigned char *aa,
+        const unsigned char *bb, int size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int score = 0;
+    int ii = 0;
+
+    for (; ii + 32 <= size; ii += 32)
+    {
+        __m256i pa = _mm256_loadu_si256((const __m256i*)(aa + ii));
+        __m256i pb = _mm256_loadu_si256((const __m256i*)(bb + ii));
+        unsigned int zeros = (unsigned int)_mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_cmpeq_epi8(pa, zero),
+                                _mm256_cmpeq_epi8(pb, zero)));
+        score += 32 - __builtin_popcount(zeros);
+    }
+    return score + count_both_set_sse2(aa + ii, bb + ii, size - ii);
+}
+
+/*
+ * Gathers every fourth pixel, 16 at a time, and sums them and their
+ * squares in vector registers. The histogram is a scatter and stays
+ * scalar, which is also why there is no AVX2 version of this one.
+ */
+__attribute__((target("sse2")))
+static int sample_sse2(unsigned char *out, const unsigned char *row,
+        int width, int cc, int cc2, int cinc, unsigned long long *sumval,
+        unsigned long long *sumsquares, int *histval)
+{
+    if (cinc != 4)
+        return sample_c(out, row, width, cc, cc2, cinc,
+                        sumval, sumsquares, histval);
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowbyte = _mm_set1_epi32(0xff);
+    __m128i vsum = _mm_setzero_si128();
+    __m128i vsquares = _mm_setzero_si128();
+    int nsamples = 0;
+
+    // 16 samples are cc .. cc + 60, the last load reads up to cc + 63
+    for (; cc + 60 < cc2 && cc + 64 <= width; cc += 64)
+    {
+        const __m128i *in = (const __m128i*)(row + cc);
+        __m128i w0 = _mm_packs_epi32(
+                _mm_and_si128(_mm_loadu_si128(in + 0), lowbyte),
+                _mm_and_si128(_mm_loadu_si128(in + 1), lowbyte));
+        __m128i w1 = _mm_packs_epi32(
+                _mm_and_si128(_mm_loadu_si128(in + 2), lowbyte),
+                _mm_and_si128(_mm_loadu_si128(in + 3), lowbyte));
+        __m128i px = _mm_packus_epi16(w0, w1);
+        _mm_storeu_si128((__m128i*)(out + nsamples), px);
+
+        vsum = _mm_add_epi64(vsum, _mm_sad_epu8(px, zero));
+        __m128i sq = _mm_add_epi32(_mm_madd_epi16(w0, w0),
+                                   _mm_madd_epi16(w1, w1));
+        vsquares = _mm_add_epi64(vsquares, _mm_unpacklo_epi32(sq, zero));
+        vsquares = _mm_add_epi64(vsquares, _mm_unpackhi_epi32(sq, zero));
+
+        for (int jj = 0; jj < 16; jj++)
+            histval[out[nsamples + jj]]++;
+        nsamples += 16;
+    }
+
+    unsigned long long sums[2], squares[2];
+    _mm_storeu_si128((__m128i*)sums, vsum);
+    _mm_storeu_si128((__m128i*)squares, vsquares);
+    *sumval += sums[0] + sums[1];
+    *sumsquares += squares[0] + squares[1];
+
+    return nsamples + sample_c(out + nsamples, row, width, cc, cc2, cinc,
+                               sumval, sumsquares, histval);
+}
+#endif // USE_X86_PGMKERNELS
+
+/* Run time selection of the kernels, 2 = AVX2, 1 = SSE2, 0 = scalar. */
+static int simd_level(void)
+{
+#ifdef USE_X86_PGMKERNELS
+    int flags = av_get_cpu_flags();
+    if (flags & AV_CPU_FLAG_AVX2)
+        return 2;
+    if (flags & AV_CPU_FLAG_SSE2)
+        return 1;
+#endif
+    return 0;
+}
+
+typedef void (*convolve_func_t)(unsigned char*, const unsigned char*,
+        int, const double*, int, int);
+typedef void (*sgm_func_t)(unsigned int*, const unsigned char*,
+        const unsigned char*, int);
+typedef int (*count_set_func_t)(const unsigned char*, int);
+typedef int (*count_both_set_func_t)(const unsigned char*,
+        const unsigned char*, int);
+typedef int (*sample_func_t)(unsigned char*, const unsigned char*, int,
+        int, int, int, unsigned long long*, unsigned long long*, int*);
+
+static convolve_func_t get_convolve_func(void)
+{
+#ifdef USE_X86_PGMKERNELS
+    switch (simd_level())
+    {
+        case 2: return convolve_avx2;
+        case 1: return convolve_sse2;
+    }
+#endif
+    return convolve_c;
+}
+
+static sgm_func_t get_sgm_func(void)
+{
+#ifdef USE_X86_PGMKERNELS
+    switch (simd_level())
+    {
+        case 2: return sgm_avx2;
+        case 1: return sgm_sse2;
+    }
+#endif
+    return sgm_c;
+}
+
+static count_set_func_t get_count_set_func(void)
+{
+#ifdef USE_X86_PGMKERNELS
+    switch (simd_level())
+    {
+        case 2: return count_set_avx2;
+        case 1: return count_set_sse2;
+    }
+#endif
+    return count_set_c;
+}
+
+static count_both_set_func_t get_count_both_set_func(void)
+{
+#ifdef USE_X86_PGMKERNELS
+    switch (simd_level())
+    {
+        case 2: return count_both_set_avx2;
+        case 1: return count_both_set_sse2;
+    }
+#endif
+    return count_both_set_c;
+}
+
+static sample_func_t get_sample_func(void)
+{
+#ifdef USE_X86_PGMKERNELS
+    if (simd_level())
+        return sample_sse2;
+#endif
+    return sample_c;
+}
+
+void pgm_convolve_line(unsigned char *dst, const unsigned char *src,
+        int count, const double *mask, int radius, int tapstride,
+        bool useSIMD)
+{
+    static convolve_func_t convolve_simd = get_convolve_func();
+
+    if (useSIMD)
+        convolve_simd(dst, src, count, mask, radius, tapstride);
+    else
+        convolve_c(dst, src, count, mask, radius, tapstride);
+}
+
+void pgm_sgm_line(unsigned int *dst, const unsigned char *row0,
+        const unsigned char *row1, int count, bool useSIMD)
+{
+    static sgm_func_t sgm_simd = get_sgm_func();
+
+    if (useSIMD)
+        sgm_simd(dst, row0, row1, count);
+    else
+        sgm_c(dst, row0, row1, count);
+}
+
+int pgm_count_set(const unsigned char *buf, int size, bool useSIMD)
+{
+    static count_set_func_t count_set_simd = get_count_set_func();
+
+    return (useSIMD) ? count_set_simd(buf, size) : count_set_c(buf, size);
+}
+
+int pgm_count_both_set(const unsigned char *aa, const unsigned char *bb,
+        int size, bool useSIMD)
+{
+    static count_both_set_func_t count_both_set_simd =
+        get_count_both_set_func();
+
+    return (useSIMD) ? count_both_set_simd(aa, bb, size) :
+        count_both_set_c(aa, bb, size);
+}
+
+int pgm_sample_row(unsigned char *out, const unsigned char *row, int width,
+        int cc1, int cc2, int cinc, int skip1, int skip2,
+        unsigned long long *sumval, unsigned long long *sumsquares,
+        int *histval, bool useSIMD)
+{
+    static sample_func_t sample_simd = get_sample_func();
+    sample_func_t sample = (useSIMD) ? sample_simd : sample_c;
+
+    if (skip1 > skip2 || skip2 < cc1 || skip1 >= cc2)
+        return sample(out, row, width, cc1, cc2, cinc,
+                      sumval, sumsquares, histval);
+
+    /* Sample up to the skipped columns, then from the first column after. */
+    int nsamples = sample(out, row, width, cc1, std::min(cc2, skip1), cinc,
+                          sumval, sumsquares, histval);
+    int next = cc1 + ((skip2 - cc1) / cinc + 1) * cinc;
+    return nsamples + sample(out + nsamples, row, width, next, cc2, cinc,
+                             sumval, sumsquares, histval);
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,60 @@
+/*
+ * pgmkernels.h
+ *
+ * Per-pixel inner loops of the commercial flagging frame analyzers.
+ *
+ * Each kernel has a scalar version and SSE2/AVX2 versions that are picked
+ * at run time from the CPU flags. The vector versions produce results that
+ * are bit-identical to the scalar ones, so flagging output does not depend
+ * on the CPU it ran on. Passing useSIMD = false forces the scalar version.
+ */
+
+#ifndef __PGMKERNELS_H__
+#define __PGMKERNELS_H__
+
+/*
+ * One line of a one-dimensional convolution:
+ *
+ *  dst[ii] = round(sum(mask[kk + radius] * src[ii + kk * tapstride]))
+ *
+ * for kk in [-radius, radius], summed in that order in double precision.
+ * A tapstride of 1 convolves along the row, the image width convolves
+ * along the column.
+ */
+void pgm_convolve_line(unsigned char *dst, const unsigned char *src,
+        int count, const double *mask, int radius, int tapstride,
+        bool useSIMD = true);
+
+/*
+ * One line of the squared gradient magnitude over 45-degree rotated axes:
+ *
+ *  dx = row1[ii + 1] - row0[ii], dy = row1[ii] - row0[ii + 1]
+ *  dst[ii] = dx * dx + dy * dy
+ *
+ * Reads count + 1 pixels from each row.
+ */
+void pgm_sgm_line(unsigned int *dst, const unsigned char *row0,
+        const unsigned char *row1, int count, bool useSIMD = true);
+
+/* Number of non-zero pixels in buf. */
+int pgm_count_set(const unsigned char *buf, int size, bool useSIMD = true);
+
+/* Number of positions at which both aa and bb are non-zero. */
+int pgm_count_both_set(const unsigned char *aa, const unsigned char *bb,
+        int size, bool useSIMD = true);
+
+/*
+ * Samples row[cc] for cc = cc1, cc1 + cinc, ... < cc2, leaving out the
+ * columns skip1 <= cc <= skip2 (pass skip1 > skip2 to keep them all).
+ * Samples are appended to out, added to *sumval, their squares to
+ * *sumsquares and counted in histval. width is the number of bytes that
+ * may be read from row. Returns the number of samples taken.
+ */
+int pgm_sample_row(unsigned char *out, const unsigned char *row, int width,
+        int cc1, int cc2, int cinc, int skip1, int skip2,
+        unsigned long long *sumval, unsigned long long *sumsquares,
+        int *histval, bool useSIMD = true);
+
+#endif  /* !__PGMKERNELS_H__ */
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,255 @@
+/*
+ *  Class TestPGMKernels
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <cmath>
+
+#include <QtTest/QtTest>
+
+#include "pgmkernels.h"
+
+#define FRAME_WIDTH  720
+#define FRAME_HEIGHT 480
+#define MASK_RADIUS  3
+#define SAMPLE_INC   4
+
+class TestPGMKernels: public QObject
+{
+    Q_OBJECT
+
+  private:
+    QByteArray m_frame;
+    QByteArray m_edges;
+    double     m_mask[2 * MASK_RADIUS + 1];
+
+    const unsigned char *frame(void) const
+    {
+        return reinterpret_cast<const unsigned char*>(m_frame.constData());
+    }
+
+    const unsigned char *edges(void) const
+    {
+        return reinterpret_cast<const unsigned char*>(m_edges.constData());
+    }
+
+    /// Smooths the frame the way pgm_convolve_radial() does.
+    void convolve(QByteArray &tmp, QByteArray &out, bool useSIMD) const
+    {
+        tmp = m_frame;
+        out = m_frame;
+        unsigned char *t = reinterpret_cast<unsigned char*>(tmp.data());
+        unsigned char *o = reinterpret_cast<unsigned char*>(out.data());
+        for (int rr = MASK_RADIUS; rr < FRAME_HEIGHT - MASK_RADIUS; rr++)
+        {
+            int offset = rr * FRAME_WIDTH + MASK_RADIUS;
+            pgm_convolve_line(t + offset, frame() + offset,
+                    FRAME_WIDTH - 2 * MASK_RADIUS, m_mask, MASK_RADIUS,
+                    FRAME_WIDTH, useSIMD);
+        }
+        for (int rr = MASK_RADIUS; rr < FRAME_HEIGHT - MASK_RADIUS; rr++)
+        {
+            int offset = rr * FRAME_WIDTH + MASK_RADIUS;
+            pgm_convolve_line(o + offset, t + offset,
+                    FRAME_WIDTH - 2 * MASK_RADIUS, m_mask, MASK_RADIUS,
+                    1, useSIMD);
+        }
+    }
+
+    void sgm(QVector<unsigned int> &out, bool useSIMD) const
+    {
+        out.fill(0, FRAME_WIDTH * FRAME_HEIGHT);
+        for (int rr = 0; rr < FRAME_HEIGHT - 1; rr++)
+        {
+            pgm_sgm_line(out.data() + rr * FRAME_WIDTH,
+                    frame() + rr * FRAME_WIDTH,
+                    frame() + (rr + 1) * FRAME_WIDTH,
+                    FRAME_WIDTH - 1, useSIMD);
+        }
+    }
+
+    /// Samples the frame the way HistogramAnalyzer does, with a logo
+    /// excluded from the top right corner.
+    int sample(QByteArray &out, unsigned long long &sumval,
+               unsigned long long &sumsquares, QVector<int> &histval,
+               bool useSIMD) const
+    {
+        out.fill(0, FRAME_WIDTH * FRAME_HEIGHT / SAMPLE_INC);
+        histval.fill(0, UCHAR_MAX + 1);
+        sumval = sumsquares = 0;
+        unsigned char *pp = reinterpret_cast<unsigned char*>(out.data());
+        int nsamples = 0;
+        for (int rr = 0; rr < FRAME_HEIGHT; rr += SAMPLE_INC)
+        {
+            bool inlogo = rr >= 40 && rr <= 90;
+            nsamples += pgm_sample_row(pp + nsamples,
+                    frame() + rr * FRAME_WIDTH, FRAME_WIDTH,
+                    SAMPLE_INC, FRAME_WIDTH - SAMPLE_INC, SAMPLE_INC,
+                    inlogo ? 571 : 1, inlogo ? 650 : 0,
+                    &sumval, &sumsquares, histval.data(), useSIMD);
+        }
+        return nsamples;
+    }
+
+    static void addSIMDRows(void)
+    {
+        QTest::addColumn<bool>("SIMD");
+        QTest::newRow("SIMD") << true;
+        QTest::newRow("Pure C") << false;
+    }
+
+  private slots:
+    /** Builds a noisy frame with some hard edges, and a sparse edge
+     *  map like the ones TemplateMatcher compares.
+     */
+    void initTestCase(void)
+    {
+        qsrand(1);
+        m_frame.resize(FRAME_WIDTH * FRAME_HEIGHT);
+        m_edges.resize(FRAME_WIDTH * FRAME_HEIGHT);
+        for (int rr = 0; rr < FRAME_HEIGHT; rr++)
+        {
+            for (int cc = 0; cc < FRAME_WIDTH; cc++)
+            {
+                int base = ((rr / 60 + cc / 90) & 1) ? 200 : 30;
+                int ii = rr * FRAME_WIDTH + cc;
+                m_frame[ii] = (char)(base + (qrand() % 51) - 25);
+                m_edges[ii] = (qrand() % 8) ? 0 : (char)UCHAR_MAX;
+            }
+        }
+
+        // Gaussian, as CannyEdgeDetector uses
+        double sum = 0;
+        for (int ii = -MASK_RADIUS; ii <= MASK_RADIUS; ii++)
+        {
+            m_mask[ii + MASK_RADIUS] = exp(-ii * ii / 2.0);
+            sum += m_mask[ii + MASK_RADIUS];
+        }
+        for (int ii = 0; ii < 2 * MASK_RADIUS + 1; ii++)
+            m_mask[ii] /= sum;
+    }
+
+    /** Checks that the vector kernels give bit-identical results to
+     *  the scalar ones, whichever of SSE2 or AVX2 this CPU picked.
+     */
+    void convolve_test(void)
+    {
+        QByteArray tmp, simd, plain;
+        convolve(tmp, simd, true);
+        convolve(tmp, plain, false);
+        QCOMPARE(simd, plain);
+    }
+
+    void sgm_test(void)
+    {
+        QVector<unsigned int> simd, plain;
+        sgm(simd, true);
+        sgm(plain, false);
+        QCOMPARE(simd, plain);
+    }
+
+    void count_test(void)
+    {
+        // odd sizes exercise the scalar tails
+        int sizes[] = { 0, 1, 15, 33, FRAME_WIDTH * FRAME_HEIGHT - 7 };
+        for (uint ii = 0; ii < sizeof(sizes) / sizeof(*sizes); ii++)
+        {
+            QCOMPARE(pgm_count_set(edges(), sizes[ii], true),
+                     pgm_count_set(edges(), sizes[ii], false));
+            QCOMPARE(pgm_count_both_set(edges(), frame(), sizes[ii], true),
+                     pgm_count_both_set(edges(), frame(), sizes[ii], false));
+        }
+    }
+
+    void sample_test(void)
+    {
+        QByteArray simd, plain;
+        unsigned long long simdsum, simdsquares, plainsum, plainsquares;
+        QVector<int> simdhist, plainhist;
+
+        int nsimd = sample(simd, simdsum, simdsquares, simdhist, true);
+        int nplain = sample(plain, plainsum, plainsquares, plainhist, false);
+        QCOMPARE(nsimd, nplain);
+        QCOMPARE(simd, plain);
+        QCOMPARE(simdsum, plainsum);
+        QCOMPARE(simdsquares, plainsquares);
+        QCOMPARE(simdhist, plainhist);
+    }
+
+    void convolve_benchmark_data(void)
+    {
+        addSIMDRows();
+    }
+
+    void convolve_benchmark(void)
+    {
+        QFETCH(bool, SIMD);
+        QByteArray tmp, out;
+        QBENCHMARK
+        {
+            convolve(tmp, out, SIMD);
+        }
+    }
+
+    void sgm_benchmark_data(void)
+    {
+        addSIMDRows();
+    }
+
+    void sgm_benchmark(void)
+    {
+        QFETCH(bool, SIMD);
+        QVector<unsigned int> out;
+        QBENCHMARK
+        {
+            sgm(out, SIMD);
+        }
+    }
+
+    void match_benchmark_data(void)
+    {
+        addSIMDRows();
+    }
+
+    void match_benchmark(void)
+    {
+        QFETCH(bool, SIMD);
+        int score = 0;
+        QBENCHMARK
+        {
+            score = pgm_count_both_set(edges(), frame(),
+                    FRAME_WIDTH * FRAME_HEIGHT, SIMD);
+        }
+        QVERIFY(score > 0);
+    }
+
+    void sample_benchmark_data(void)
+    {
+        addSIMDRows();
+    }
+
+    void sample_benchmark(void)
+    {
+        QFETCH(bool, SIMD);
+        QByteArray out;
+        unsigned long long sumval, sumsquares;
+        QVector<int> histval;
+        QBENCHMARK
+        {
+            sample(out, sumval, sumsquares, histval, SIMD);
+        }
+    }
+};
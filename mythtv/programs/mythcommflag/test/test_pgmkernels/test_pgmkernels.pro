@@ -0,0 +1,34 @@
+include ( ../../../../settings.pro )
+
+QT += testlib
+
+TEMPLATE = app
+TARGET = test_pgmkernels
+DEPENDPATH += . ../..
+INCLUDEPATH += . ../.. ../../../../libs/libmythbase
+INCLUDEPATH += ../../../../external/FFmpeg
+
+LIBS += -L../../../../external/FFmpeg/libavutil -lmythavutil
+
+contains(QMAKE_CXX, "g++") {
+  QMAKE_CXXFLAGS += -O0 -fprofile-arcs -ftest-coverage
+  QMAKE_LFLAGS += -fprofile-arcs
+}
+
+QMAKE_LFLAGS += -Wl,$$_RPATH_$(PWD)/../../../../external/FFmpeg/libavutil
+
+# Input
+HEADERS += test_pgmkernels.h
+SOURCES += test_pgmkernels.cpp
+
+# The kernels have no dependencies on the rest of mythcommflag
+HEADERS += ../../pgmkernels.h
+SOURCES += ../../pgmkernels.cpp
+
+QMAKE_CLEAN += $(TARGET) $(TARGETA) $(TARGETD) $(TARGET0) $(TARGET1) $(TARGET2)
+QMAKE_CLEAN += ; ( cd $(OBJECTS_DIR) && rm -f *.gcov *.gcda *.gcno )
+
+LIBS += $$EXTRA_LIBS $$LATE_LIBS
+
+# Fix runtime linking on Ubuntu 17.10.
+linux:QMAKE_LFLAGS += -Wl,--disable-new-dtags
@@ -70,6 +70,19 @@ void MythFillDatabaseCommandLineParser::LoadArguments(void)
             "Only update the guide data, do not alter channels or icons.")
         ->SetBlocks("manual")
         ->SetGroup("Guide Data Handling");
+    add("--bulk-update", "bulkupdate", false,
+            "Compare and write guide data a channel at a time",
+            "Read the stored guide data each channel's new programs "
+            "cover with one query, and only write the programs that "
+            "changed, with multi-row statements. By default every "
+            "program is checked and written with its own statements.")
+        ->SetGroup("Guide Data Handling");
+    add("--update-threads", "updatethreads", 1,
+            "Number of database connections to write guide data with",
+            "Write the guide data of this many channels at once, each "
+            "on its own database connection, while the XMLTV data is "
+            "still being read. Defaults to one.")
+        ->SetGroup("Guide Data Handling");
 
 
     add("--do-channel-updates", "dochannelupdates", false,
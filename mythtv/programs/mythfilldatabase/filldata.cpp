@@ -306,24 +306,60 @@ bool FillData::GrabDDData(Source source, int poffset,
 }
 
 // XMLTV stuff
+
+/// Stores the channels and programmes of an XMLTV file as they are parsed
+class XMLTVFiller : public XMLTVListener
+{
+  public:
+    XMLTVFiller(int sourceid, ChannelData &chan_data,
+                int threads, bool bulk) :
+        programs(0), m_sourceid(sourceid), m_chan_data(chan_data),
+        m_updater(sourceid, threads, bulk) {}
+
+    void HandleChannels(ChannelInfoList &chanlist)
+    {
+        m_chan_data.handleChannels(m_sourceid, &chanlist);
+    }
+
+    void HandlePrograms(QMap<QString, QList<ProgInfo> > &proglist)
+    {
+        QMap<QString, QList<ProgInfo> >::const_iterator it;
+        for (it = proglist.begin(); it != proglist.end(); ++it)
+            programs += it->size();
+        m_updater.Add(proglist);
+    }
+
+    ProgramUpdater &Updater(void) { return m_updater; }
+
+    uint programs;
+
+  private:
+    int             m_sourceid;
+    ChannelData    &m_chan_data;
+    ProgramUpdater  m_updater;
+};
+
 bool FillData::GrabDataFromFile(int id, QString &filename)
 {
-    ChannelInfoList chanlist;
-    QMap<QString, QList<ProgInfo> > proglist;
+    XMLTVFiller filler(id, chan_data, update_threads, bulk_update);
 
     xmltv_parser.lateInit();
-    if (!xmltv_parser.parseFile(filename, &chanlist, &proglist))
+    bool ok = xmltv_parser.parseFile(filename, &filler);
+    filler.Updater().Wait();
+    if (!ok)
         return false;
 
-    chan_data.handleChannels(id, &chanlist);
-    if (proglist.count() == 0)
+    if (filler.programs == 0)
     {
         LOG(VB_GENERAL, LOG_INFO, "No programs found in data.");
         endofdata = true;
     }
     else
     {
-        prog_data.HandlePrograms(id, proglist);
+        LOG(VB_GENERAL, LOG_INFO,
+            QString("Updated programs: %1 Unchanged programs: %2")
+                    .arg(filler.Updater().GetUpdated())
+                    .arg(filler.Updater().GetUnchanged()));
     }
     return true;
 }
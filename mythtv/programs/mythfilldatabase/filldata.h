@@ -53,6 +53,7 @@ class FillData
         dddataretrieved(false),
         need_post_grab_proc(true),      only_update_channels(false),
         channel_update_run(false),      no_allatonce(false),
+        bulk_update(false),             update_threads(1),
         refresh_all(false)
     {
         SetRefresh(1, true);
@@ -97,6 +98,8 @@ class FillData
     bool    only_update_channels;
     bool    channel_update_run;
     bool    no_allatonce;
+    bool    bulk_update;
+    int     update_threads;
 
   private:
     QMap<uint,bool>     refresh_day;
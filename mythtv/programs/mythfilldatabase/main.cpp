@@ -275,6 +275,10 @@ int main(int argc, char *argv[])
         fill_data.only_update_channels = true;
     if (cmdline.toBool("noallatonce"))
         fill_data.no_allatonce = true;
+    if (cmdline.toBool("bulkupdate"))
+        fill_data.bulk_update = true;
+    if (cmdline.toBool("updatethreads") && cmdline.toInt("updatethreads") > 0)
+        fill_data.update_threads = cmdline.toInt("updatethreads");
 
     mark_repeats = cmdline.toBool("markrepeats");
 
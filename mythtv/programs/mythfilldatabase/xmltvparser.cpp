@@ -2,10 +2,11 @@
 
 // Qt headers
 #include <QFile>
+#include <QSet>
 #include <QStringList>
 #include <QDateTime>
-#include <QDomDocument>
 #include <QUrl>
+#include <QXmlStreamReader>
 
 // C++ headers
 #include <iostream>
@@ -60,67 +61,68 @@ static uint ELFHash(const QByteArray &ba)
     return h;
 }
 
-static QString getFirstText(QDomElement element)
+// Reads the text of the current element, leaving xml at its end.
+static QString readText(QXmlStreamReader &xml)
 {
-    for (QDomNode dname = element.firstChild(); !dname.isNull();
-         dname = dname.nextSibling())
-    {
-        QDomText t = dname.toText();
-        if (!t.isNull())
-            return t.data();
-    }
-    return QString();
+    return xml.readElementText(QXmlStreamReader::SkipChildElements);
+}
+
+static QString attribute(QXmlStreamReader &xml, const char *name)
+{
+    return xml.attributes().value(name).toString();
 }
 
-ChannelInfo *XMLTVParser::parseChannel(QDomElement &element, QUrl &baseUrl)
+ChannelInfo *XMLTVParser::parseChannel(QXmlStreamReader &xml, QUrl &baseUrl)
 {
     ChannelInfo *chaninfo = new ChannelInfo;
 
-    QString xmltvid = element.attribute("id", "");
+    QString xmltvid = attribute(xml, "id");
 
     chaninfo->xmltvid = xmltvid;
     chaninfo->tvformat = "Default";
 
-    for (QDomNode child = element.firstChild(); !child.isNull();
-         child = child.nextSibling())
+    while (xml.readNextStartElement())
     {
-        QDomElement info = child.toElement();
-        if (!info.isNull())
+        if (xml.name() == "icon")
         {
-            if (info.tagName() == "icon")
+            if (chaninfo->icon.isEmpty())
             {
-                if (chaninfo->icon.isEmpty())
+                QString path = attribute(xml, "src");
+                if (!path.isEmpty() && !path.contains("://"))
                 {
-                    QString path = info.attribute("src", "");
-                    if (!path.isEmpty() && !path.contains("://"))
-                    {
-                        QString base = baseUrl.toString(QUrl::StripTrailingSlash);
-                        chaninfo->icon = base +
-                            ((path.startsWith("/")) ? path : QString("/") + path);
-                    }
-                    else if (!path.isEmpty())
-                    {
-                        QUrl url(path);
-                        if (url.isValid())
-                            chaninfo->icon = url.toString();
-                    }
+                    QString base = baseUrl.toString(QUrl::StripTrailingSlash);
+                    chaninfo->icon = base +
+                        ((path.startsWith("/")) ? path : QString("/") + path);
                 }
-            }
-            else if (info.tagName() == "display-name")
-            {
-                if (chaninfo->name.isEmpty())
+                else if (!path.isEmpty())
                 {
-                    chaninfo->name = info.text();
-                }
-                else if (chaninfo->callsign.isEmpty())
-                {
-                    chaninfo->callsign = info.text();
-                }
-                else if (chaninfo->channum.isEmpty())
-                {
-                    chaninfo->channum = info.text();
+                    QUrl url(path);
+                    if (url.isValid())
+                        chaninfo->icon = url.toString();
                 }
             }
+            xml.skipCurrentElement();
+        }
+        else if (xml.name() == "display-name")
+        {
+            QString text = xml.readElementText(
+                QXmlStreamReader::IncludeChildElements);
+            if (chaninfo->name.isEmpty())
+            {
+                chaninfo->name = text;
+            }
+            else if (chaninfo->callsign.isEmpty())
+            {
+                chaninfo->callsign = text;
+            }
+            else if (chaninfo->channum.isEmpty())
+            {
+                chaninfo->channum = text;
+            }
+        }
+        else
+        {
+            xml.skipCurrentElement();
         }
     }
 
@@ -248,90 +250,106 @@ static void fromXMLTVDate(QString &timestr, QDateTime &dt)
     timestr = MythDate::toString(dt, MythDate::kFilename);
 }
 
-static void parseCredits(QDomElement &element, ProgInfo *pginfo)
+static void parseCredits(QXmlStreamReader &xml, ProgInfo *pginfo)
 {
-    for (QDomNode child = element.firstChild(); !child.isNull();
-         child = child.nextSibling())
+    while (xml.readNextStartElement())
     {
-        QDomElement info = child.toElement();
-        if (!info.isNull())
-            pginfo->AddPerson(info.tagName(), getFirstText(info));
+        QString role = xml.name().toString();
+        pginfo->AddPerson(role, readText(xml));
+    }
+}
+
+static void parseVideo(QXmlStreamReader &xml, ProgInfo *pginfo)
+{
+    while (xml.readNextStartElement())
+    {
+        if (xml.name() == "quality")
+        {
+            if (readText(xml) == "HDTV")
+                pginfo->videoProps |= VID_HDTV;
+        }
+        else if (xml.name() == "aspect")
+        {
+            if (readText(xml) == "16:9")
+                pginfo->videoProps |= VID_WIDESCREEN;
+        }
+        else
+        {
+            xml.skipCurrentElement();
+        }
     }
 }
 
-static void parseVideo(QDomElement &element, ProgInfo *pginfo)
+static void parseAudio(QXmlStreamReader &xml, ProgInfo *pginfo)
 {
-    for (QDomNode child = element.firstChild(); !child.isNull();
-         child = child.nextSibling())
+    while (xml.readNextStartElement())
     {
-        QDomElement info = child.toElement();
-        if (!info.isNull())
+        if (xml.name() == "stereo")
         {
-            if (info.tagName() == "quality")
+            QString text = readText(xml);
+            if (text == "mono")
+            {
+                pginfo->audioProps |= AUD_MONO;
+            }
+            else if (text == "stereo")
             {
-                if (getFirstText(info) == "HDTV")
-                    pginfo->videoProps |= VID_HDTV;
+                pginfo->audioProps |= AUD_STEREO;
             }
-            else if (info.tagName() == "aspect")
+            else if (text == "dolby" || text == "dolby digital")
             {
-                if (getFirstText(info) == "16:9")
-                    pginfo->videoProps |= VID_WIDESCREEN;
+                pginfo->audioProps |= AUD_DOLBY;
             }
+            else if (text == "surround")
+            {
+                pginfo->audioProps |= AUD_SURROUND;
+            }
+        }
+        else
+        {
+            xml.skipCurrentElement();
         }
     }
 }
 
-static void parseAudio(QDomElement &element, ProgInfo *pginfo)
+// Reads the text of the first <value> inside the current element, leaving
+// xml at the end of the element. Returns false if there is no <value>.
+static bool readFirstValue(QXmlStreamReader &xml, QString &value)
 {
-    for (QDomNode child = element.firstChild(); !child.isNull();
-         child = child.nextSibling())
+    bool found = false;
+    while (xml.readNextStartElement())
     {
-        QDomElement info = child.toElement();
-        if (!info.isNull())
+        if (!found && xml.name() == "value")
         {
-            if (info.tagName() == "stereo")
-            {
-                if (getFirstText(info) == "mono")
-                {
-                    pginfo->audioProps |= AUD_MONO;
-                }
-                else if (getFirstText(info) == "stereo")
-                {
-                    pginfo->audioProps |= AUD_STEREO;
-                }
-                else if (getFirstText(info) == "dolby" ||
-                        getFirstText(info) == "dolby digital")
-                {
-                    pginfo->audioProps |= AUD_DOLBY;
-                }
-                else if (getFirstText(info) == "surround")
-                {
-                    pginfo->audioProps |= AUD_SURROUND;
-                }
-            }
+            value = readText(xml);
+            found = true;
+        }
+        else
+        {
+            xml.skipCurrentElement();
         }
     }
+    return found;
 }
 
-ProgInfo *XMLTVParser::parseProgram(QDomElement &element)
+ProgInfo *XMLTVParser::parseProgram(QXmlStreamReader &xml)
 {
     QString programid, season, episode, totalepisodes;
     ProgInfo *pginfo = new ProgInfo();
 
-    QString text = element.attribute("start", "");
+    QString text = attribute(xml, "start");
     fromXMLTVDate(text, pginfo->starttime);
     pginfo->startts = text;
 
-    text = element.attribute("stop", "");
+    text = attribute(xml, "stop");
     fromXMLTVDate(text, pginfo->endtime);
     pginfo->endts = text;
 
-    text = element.attribute("channel", "");
+    text = attribute(xml, "channel");
     QStringList split = text.split(" ");
 
     pginfo->channel = split[0];
 
-    text = element.attribute("clumpidx", "");
+    text = attribute(xml, "clumpidx");
     if (!text.isEmpty())
     {
         split = text.split('/');
@@ -339,249 +357,246 @@ ProgInfo *XMLTVParser::parseProgram(QDomElement &element)
         pginfo->clumpmax = split[1];
     }
 
-    for (QDomNode child = element.firstChild(); !child.isNull();
-         child = child.nextSibling())
+    while (xml.readNextStartElement())
     {
-        QDomElement info = child.toElement();
-        if (!info.isNull())
+        if (xml.name() == "title")
         {
-            if (info.tagName() == "title")
+            QString lang = attribute(xml, "lang");
+            QString title = readText(xml);
+            if (lang == "ja_JP")
             {
-                if (info.attribute("lang") == "ja_JP")
-                {
-                    pginfo->title = getFirstText(info);
-                }
-                else if (info.attribute("lang") == "ja_JP@kana")
-                {
-                    pginfo->title_pronounce = getFirstText(info);
-                }
-                else if (pginfo->title.isEmpty())
-                {
-                    pginfo->title = getFirstText(info);
-                }
+                pginfo->title = title;
             }
-            else if (info.tagName() == "sub-title" &&
-                     pginfo->subtitle.isEmpty())
+            else if (lang == "ja_JP@kana")
             {
-                pginfo->subtitle = getFirstText(info);
+                pginfo->title_pronounce = title;
             }
-            else if (info.tagName() == "desc" && pginfo->description.isEmpty())
+            else if (pginfo->title.isEmpty())
             {
-                pginfo->description = getFirstText(info);
+                pginfo->title = title;
             }
-            else if (info.tagName() == "category")
-            {
-                const QString cat = getFirstText(info);
-
-                if (ProgramInfo::kCategoryNone == pginfo->categoryType &&
-                    string_to_myth_category_type(cat) != ProgramInfo::kCategoryNone)
-                {
-                    pginfo->categoryType = string_to_myth_category_type(cat);
-                }
-                else if (pginfo->category.isEmpty())
-                {
-                    pginfo->category = cat;
-                }
-
-                if ((cat.compare(QObject::tr("movie"),Qt::CaseInsensitive) == 0) ||
-                    (cat.compare(QObject::tr("film"),Qt::CaseInsensitive) == 0))
-                {
-                    // Hack for tv_grab_uk_rt
-                    pginfo->categoryType = ProgramInfo::kCategoryMovie;
-                }
-
-                pginfo->genres.append(cat);
-            }
-            else if (info.tagName() == "date" && !pginfo->airdate)
-            {
-                // Movie production year
-                QString date = getFirstText(info);
-                pginfo->airdate = date.left(4).toUInt();
-            }
-            else if (info.tagName() == "star-rating" && pginfo->stars == 0.0)
-            {
-                QDomNodeList values = info.elementsByTagName("value");
-                QDomElement item;
-                QString stars;
-                float num, den;
-                float rating = 0.0;
-
-                // Use the first rating to appear in the xml, this should be
-                // the most important one.
-                //
-                // Averaging is not a good idea here, any subsequent ratings
-                // are likely to represent that days recommended programmes
-                // which on a bad night could given to an average programme.
-                // In the case of uk_rt it's not unknown for a recommendation
-                // to be given to programmes which are 'so bad, you have to
-                // watch!'
-                //
-                // XMLTV uses zero based ratings and signals no rating by absence.
-                // A rating from 1 to 5 is encoded as 0/4 to 4/4.
-                // MythTV uses zero to signal no rating!
-                // The same rating is encoded as 0.2 to 1.0 with steps of 0.2, it
-                // is not encoded as 0.0 to 1.0 with steps of 0.25 because
-                // 0 signals no rating!
-                // See http://xmltv.cvs.sourceforge.net/viewvc/xmltv/xmltv/xmltv.dtd?revision=1.47&view=markup#l539
-                item = values.item(0).toElement();
-                if (!item.isNull())
-                {
-                    stars = getFirstText(item);
-                    num = stars.section('/', 0, 0).toFloat() + 1;
-                    den = stars.section('/', 1, 1).toFloat() + 1;
-                    if (0.0 < den)
-                        rating = num/den;
-                }
+        }
+        else if (xml.name() == "sub-title" && pginfo->subtitle.isEmpty())
+        {
+            pginfo->subtitle = readText(xml);
+        }
+        else if (xml.name() == "desc" && pginfo->description.isEmpty())
+        {
+            pginfo->description = readText(xml);
+        }
+        else if (xml.name() == "category")
+        {
+            const QString cat = readText(xml);
 
-                pginfo->stars = rating;
-            }
-            else if (info.tagName() == "rating")
+            if (ProgramInfo::kCategoryNone == pginfo->categoryType &&
+                string_to_myth_category_type(cat) != ProgramInfo::kCategoryNone)
             {
-                // again, the structure of ratings seems poorly represented
-                // in the XML.  no idea what we'd do with multiple values.
-                QDomNodeList values = info.elementsByTagName("value");
-                QDomElement item = values.item(0).toElement();
-                if (item.isNull())
-                    continue;
-                EventRating rating;
-                rating.system = info.attribute("system", "");
-                rating.rating = getFirstText(item);
-                pginfo->ratings.append(rating);
+                pginfo->categoryType = string_to_myth_category_type(cat);
             }
-            else if (info.tagName() == "previously-shown")
+            else if (pginfo->category.isEmpty())
             {
-                pginfo->previouslyshown = true;
-
-                QString prevdate = info.attribute("start");
-                if (!prevdate.isEmpty())
-                {
-                    QDateTime date;
-                    fromXMLTVDate(prevdate, date);
-                    pginfo->originalairdate = date.date();
-                }
+                pginfo->category = cat;
             }
-            else if (info.tagName() == "credits")
+
+            if ((cat.compare(QObject::tr("movie"),Qt::CaseInsensitive) == 0) ||
+                (cat.compare(QObject::tr("film"),Qt::CaseInsensitive) == 0))
             {
-                parseCredits(info, pginfo);
+                // Hack for tv_grab_uk_rt
+                pginfo->categoryType = ProgramInfo::kCategoryMovie;
             }
-            else if (info.tagName() == "subtitles")
+
+            pginfo->genres.append(cat);
+        }
+        else if (xml.name() == "date" && !pginfo->airdate)
+        {
+            // Movie production year
+            QString date = readText(xml);
+            pginfo->airdate = date.left(4).toUInt();
+        }
+        else if (xml.name() == "star-rating" && pginfo->stars == 0.0)
+        {
+            QString stars;
+            float num, den;
+            float rating = 0.0;
+
+            // Use the first rating to appear in the xml, this should be
+            // the most important one.
+            //
+            // Averaging is not a good idea here, any subsequent ratings
+            // are likely to represent that days recommended programmes
+            // which on a bad night could given to an average programme.
+            // In the case of uk_rt it's not unknown for a recommendation
+            // to be given to programmes which are 'so bad, you have to
+            // watch!'
+            //
+            // XMLTV uses zero based ratings and signals no rating by absence.
+            // A rating from 1 to 5 is encoded as 0/4 to 4/4.
+            // MythTV uses zero to signal no rating!
+            // The same rating is encoded as 0.2 to 1.0 with steps of 0.2, it
+            // is not encoded as 0.0 to 1.0 with steps of 0.25 because
+            // 0 signals no rating!
+            // See http://xmltv.cvs.sourceforge.net/viewvc/xmltv/xmltv/xmltv.dtd?revision=1.47&view=markup#l539
+            if (readFirstValue(xml, stars))
             {
-                if (info.attribute("type") == "teletext")
-                    pginfo->subtitleType |= SUB_NORMAL;
-                else if (info.attribute("type") == "onscreen")
-                    pginfo->subtitleType |= SUB_ONSCREEN;
-                else if (info.attribute("type") == "deaf-signed")
-                    pginfo->subtitleType |= SUB_SIGNED;
+                num = stars.section('/', 0, 0).toFloat() + 1;
+                den = stars.section('/', 1, 1).toFloat() + 1;
+                if (0.0 < den)
+                    rating = num/den;
             }
-            else if (info.tagName() == "audio")
+
+            pginfo->stars = rating;
+        }
+        else if (xml.name() == "rating")
+        {
+            // again, the structure of ratings seems poorly represented
+            // in the XML.  no idea what we'd do with multiple values.
+            EventRating rating;
+            rating.system = attribute(xml, "system");
+            if (!readFirstValue(xml, rating.rating))
+                continue;
+            pginfo->ratings.append(rating);
+        }
+        else if (xml.name() == "previously-shown")
+        {
+            pginfo->previouslyshown = true;
+
+            QString prevdate = attribute(xml, "start");
+            if (!prevdate.isEmpty())
             {
-                parseAudio(info, pginfo);
+                QDateTime date;
+                fromXMLTVDate(prevdate, date);
+                pginfo->originalairdate = date.date();
             }
-            else if (info.tagName() == "video")
+            xml.skipCurrentElement();
+        }
+        else if (xml.name() == "credits")
+        {
+            parseCredits(xml, pginfo);
+        }
+        else if (xml.name() == "subtitles")
+        {
+            QString type = attribute(xml, "type");
+            if (type == "teletext")
+                pginfo->subtitleType |= SUB_NORMAL;
+            else if (type == "onscreen")
+                pginfo->subtitleType |= SUB_ONSCREEN;
+            else if (type == "deaf-signed")
+                pginfo->subtitleType |= SUB_SIGNED;
+            xml.skipCurrentElement();
+        }
+        else if (xml.name() == "audio")
+        {
+            parseAudio(xml, pginfo);
+        }
+        else if (xml.name() == "video")
+        {
+            parseVideo(xml, pginfo);
+        }
+        else if (xml.name() == "episode-num")
+        {
+            QString system = attribute(xml, "system");
+            QString episodenum = readText(xml);
+
+            if (system == "dd_progid")
             {
-                parseVideo(info, pginfo);
+                // if this field includes a dot, strip it out
+                int idx = episodenum.indexOf('.');
+                if (idx != -1)
+                    episodenum.remove(idx, 1);
+                programid = episodenum;
+                /* Only EPisodes and SHows are part of a series for SD */
+                if (programid.startsWith(QString("EP")) ||
+                    programid.startsWith(QString("SH")))
+                    pginfo->seriesId = QString("EP") + programid.mid(2,8);
             }
-            else if (info.tagName() == "episode-num")
+            else if (system == "xmltv_ns")
             {
-                if (info.attribute("system") == "dd_progid")
+                int tmp;
+                episode = episodenum.section('.',1,1);
+                totalepisodes = episode.section('/',1,1).trimmed();
+                episode = episode.section('/',0,0).trimmed();
+                season = episodenum.section('.',0,0).trimmed();
+                season = season.section('/',0,0).trimmed();
+                QString part(episodenum.section('.',2,2));
+                QString partnumber(part.section('/',0,0).trimmed());
+                QString parttotal(part.section('/',1,1).trimmed());
+
+                pginfo->categoryType = ProgramInfo::kCategorySeries;
+
+                if (!season.isEmpty())
                 {
-                    QString episodenum(getFirstText(info));
-                    // if this field includes a dot, strip it out
-                    int idx = episodenum.indexOf('.');
-                    if (idx != -1)
-                        episodenum.remove(idx, 1);
-                    programid = episodenum;
-                    /* Only EPisodes and SHows are part of a series for SD */
-                    if (programid.startsWith(QString("EP")) ||
-                        programid.startsWith(QString("SH")))
-                        pginfo->seriesId = QString("EP") + programid.mid(2,8);
+                    tmp = season.toUInt() + 1;
+                    pginfo->season = tmp;
+                    season = QString::number(tmp);
+                    pginfo->syndicatedepisodenumber = QString('S' + season);
                 }
-                else if (info.attribute("system") == "xmltv_ns")
-                {
-                    int tmp;
-                    QString episodenum(getFirstText(info));
-                    episode = episodenum.section('.',1,1);
-                    totalepisodes = episode.section('/',1,1).trimmed();
-                    episode = episode.section('/',0,0).trimmed();
-                    season = episodenum.section('.',0,0).trimmed();
-                    season = season.section('/',0,0).trimmed();
-                    QString part(episodenum.section('.',2,2));
-                    QString partnumber(part.section('/',0,0).trimmed());
-                    QString parttotal(part.section('/',1,1).trimmed());
-
-                    pginfo->categoryType = ProgramInfo::kCategorySeries;
-
-                    if (!season.isEmpty())
-                    {
-                        tmp = season.toUInt() + 1;
-                        pginfo->season = tmp;
-                        season = QString::number(tmp);
-                        pginfo->syndicatedepisodenumber = QString('S' + season);
-                    }
 
-                    if (!episode.isEmpty())
-                    {
-                        tmp = episode.toUInt() + 1;
-                        pginfo->episode = tmp;
-                        episode = QString::number(tmp);
-                        pginfo->syndicatedepisodenumber.append(QString('E' + episode));
-                    }
-
-                    if (!totalepisodes.isEmpty())
-                    {
-                        pginfo->totalepisodes = totalepisodes.toUInt();
-                    }
+                if (!episode.isEmpty())
+                {
+                    tmp = episode.toUInt() + 1;
+                    pginfo->episode = tmp;
+                    episode = QString::number(tmp);
+                    pginfo->syndicatedepisodenumber.append(QString('E' + episode));
+                }
 
-                    uint partno = 0;
-                    if (!partnumber.isEmpty())
-                    {
-                        bool ok;
-                        partno = partnumber.toUInt(&ok) + 1;
-                        partno = (ok) ? partno : 0;
-                    }
+                if (!totalepisodes.isEmpty())
+                {
+                    pginfo->totalepisodes = totalepisodes.toUInt();
+                }
 
-                    if (!parttotal.isEmpty() && partno > 0)
-                    {
-                        bool ok;
-                        uint partto = parttotal.toUInt(&ok);
-                        if (ok && partnumber <= parttotal)
-                        {
-                            pginfo->parttotal  = partto;
-                            pginfo->partnumber = partno;
-                        }
-                    }
+                uint partno = 0;
+                if (!partnumber.isEmpty())
+                {
+                    bool ok;
+                    partno = partnumber.toUInt(&ok) + 1;
+                    partno = (ok) ? partno : 0;
                 }
-                else if (info.attribute("system") == "onscreen")
+
+                if (!parttotal.isEmpty() && partno > 0)
                 {
-                    pginfo->categoryType = ProgramInfo::kCategorySeries;
-                    if (pginfo->subtitle.isEmpty())
+                    bool ok;
+                    uint partto = parttotal.toUInt(&ok);
+                    if (ok && partnumber <= parttotal)
                     {
-                        pginfo->subtitle = getFirstText(info);
+                        pginfo->parttotal  = partto;
+                        pginfo->partnumber = partno;
                     }
                 }
-                else if ((info.attribute("system") == "themoviedb.org") &&
-                    (_movieGrabberPath.endsWith(QString("/tmdb3.py"))))
+            }
+            else if (system == "onscreen")
+            {
+                pginfo->categoryType = ProgramInfo::kCategorySeries;
+                if (pginfo->subtitle.isEmpty())
                 {
-                    /* text is movie/<inetref> */
-                    QString inetrefRaw(getFirstText(info));
-                    if (inetrefRaw.startsWith(QString("movie/"))) {
-                        QString inetref(QString ("tmdb3.py_") + inetrefRaw.section('/',1,1).trimmed());
-                        pginfo->inetref = inetref;
-                    }
+                    pginfo->subtitle = episodenum;
                 }
-                else if ((info.attribute("system") == "thetvdb.com") &&
-                    (_tvGrabberPath.endsWith(QString("/ttvdb.py"))))
-                {
-                    /* text is series/<inetref> */
-                    QString inetrefRaw(getFirstText(info));
-                    if (inetrefRaw.startsWith(QString("series/"))) {
-                        QString inetref(QString ("ttvdb.py_") + inetrefRaw.section('/',1,1).trimmed());
-                        pginfo->inetref = inetref;
-                        /* ProgInfo does not have a collectionref, so we don't set any */
-                    }
+            }
+            else if ((system == "themoviedb.org") &&
+                (_movieGrabberPath.endsWith(QString("/tmdb3.py"))))
+            {
+                /* text is movie/<inetref> */
+                QString inetrefRaw(episodenum);
+                if (inetrefRaw.startsWith(QString("movie/"))) {
+                    QString inetref(QString ("tmdb3.py_") + inetrefRaw.section('/',1,1).trimmed());
+                    pginfo->inetref = inetref;
+                }
+            }
+            else if ((system == "thetvdb.com") &&
+                (_tvGrabberPath.endsWith(QString("/ttvdb.py"))))
+            {
+                /* text is series/<inetref> */
+                QString inetrefRaw(episodenum);
+                if (inetrefRaw.startsWith(QString("series/"))) {
+                    QString inetref(QString ("ttvdb.py_") + inetrefRaw.section('/',1,1).trimmed());
+                    pginfo->inetref = inetref;
+                    /* ProgInfo does not have a collectionref, so we don't set any */
                 }
             }
         }
+        else
+        {
+            xml.skipCurrentElement();
+        }
     }
 
     if (pginfo->category.isEmpty() &&
@@ -649,11 +664,18 @@ ProgInfo *XMLTVParser::parseProgram(QDomElement &element)
     return pginfo;
 }
 
-bool XMLTVParser::parseFile(
-    QString filename, ChannelInfoList *chanlist,
-    QMap<QString, QList<ProgInfo> > *proglist)
+/** \fn XMLTVParser::parseFile(QString, XMLTVListener*)
+ *  \brief Reads an XMLTV file element by element, passing the channels and
+ *         programmes to listener as it goes.
+ *
+ *  Grabbers normally write all programmes of one channel together, so the
+ *  programmes of a channel are handed over as soon as the next channel
+ *  starts and only one channel's schedule is held in memory. If a channel
+ *  turns up again after that, the file is not grouped by channel and the
+ *  remaining programmes are kept until the end of the file.
+ */
+bool XMLTVParser::parseFile(QString filename, XMLTVListener *listener)
 {
-    QDomDocument doc;
     QFile f;
 
     if (!dash_open(f, filename, QIODevice::ReadOnly))
@@ -663,107 +685,147 @@ bool XMLTVParser::parseFile(
         return false;
     }
 
-    QString errorMsg = "unknown";
-    int errorLine = 0;
-    int errorColumn = 0;
-
-    if (!doc.setContent(&f, &errorMsg, &errorLine, &errorColumn))
-    {
-        LOG(VB_GENERAL, LOG_ERR, QString("Error in %1:%2: %3")
-            .arg(errorLine).arg(errorColumn).arg(errorMsg));
-
-        f.close();
-        return true;
-    }
-
-    f.close();
+    QXmlStreamReader xml(&f);
 
-    QDomElement docElem = doc.documentElement();
+    ChannelInfoList chanlist;
+    bool channelsHandled = false;
 
-    QUrl baseUrl(docElem.attribute("source-data-url", ""));
-    //QUrl sourceUrl(docElem.attribute("source-info-url", ""));
+    QMap<QString, QList<ProgInfo> > proglist;
+    QSet<QString> handledChannels;
+    QString lastChannel;
+    bool grouped = true;
 
     QString aggregatedTitle;
     QString aggregatedDesc;
 
-    QDomNode n = docElem.firstChild();
-    while (!n.isNull())
+    if (xml.readNextStartElement())
     {
-        QDomElement e = n.toElement();
-        if (!e.isNull())
+        QUrl baseUrl(attribute(xml, "source-data-url"));
+        //QUrl sourceUrl(attribute(xml, "source-info-url"));
+
+        while (xml.readNextStartElement())
         {
-            if (e.tagName() == "channel")
+            if (xml.name() == "channel")
             {
-                ChannelInfo *chinfo = parseChannel(e, baseUrl);
+                ChannelInfo *chinfo = parseChannel(xml, baseUrl);
                 if (!chinfo->xmltvid.isEmpty())
-                    chanlist->push_back(*chinfo);
+                    chanlist.push_back(*chinfo);
                 delete chinfo;
+                continue;
+            }
+
+            if (xml.name() != "programme")
+            {
+                xml.skipCurrentElement();
+                continue;
             }
-            else if (e.tagName() == "programme")
+
+            if (!channelsHandled)
             {
-                ProgInfo *pginfo = parseProgram(e);
+                listener->HandleChannels(chanlist);
+                channelsHandled = true;
+            }
 
-                if (!(pginfo->starttime.isValid()))
+            ProgInfo *pginfo = parseProgram(xml);
+            bool keep = false;
+
+            if (!(pginfo->starttime.isValid()))
+            {
+                LOG(VB_GENERAL, LOG_WARNING, QString("Invalid programme (%1), "
+                                                    "invalid start time, "
+                                                    "skipping")
+                                                    .arg(pginfo->title));
+            }
+            else if (pginfo->channel.isEmpty())
+            {
+                LOG(VB_GENERAL, LOG_WARNING, QString("Invalid programme (%1), "
+                                                    "missing channel, "
+                                                    "skipping")
+                                                    .arg(pginfo->title));
+            }
+            else if (pginfo->startts == pginfo->endts)
+            {
+                LOG(VB_GENERAL, LOG_WARNING, QString("Invalid programme (%1), "
+                                                    "identical start and end "
+                                                    "times, skipping")
+                                                    .arg(pginfo->title));
+            }
+            else if (pginfo->clumpidx.isEmpty())
+            {
+                keep = true;
+            }
+            else
+            {
+                /* append all titles/descriptions from one clump */
+                if (pginfo->clumpidx.toInt() == 0)
                 {
-                    LOG(VB_GENERAL, LOG_WARNING, QString("Invalid programme (%1), "
-                                                        "invalid start time, "
-                                                        "skipping")
-                                                        .arg(pginfo->title));
+                    aggregatedTitle.clear();
+                    aggregatedDesc.clear();
                 }
-                else if (pginfo->channel.isEmpty())
+
+                if (!pginfo->title.isEmpty())
                 {
-                    LOG(VB_GENERAL, LOG_WARNING, QString("Invalid programme (%1), "
-                                                        "missing channel, "
-                                                        "skipping")
-                                                        .arg(pginfo->title));
+                    if (!aggregatedTitle.isEmpty())
+                        aggregatedTitle.append(" | ");
+                    aggregatedTitle.append(pginfo->title);
                 }
-                else if (pginfo->startts == pginfo->endts)
+
+                if (!pginfo->description.isEmpty())
                 {
-                    LOG(VB_GENERAL, LOG_WARNING, QString("Invalid programme (%1), "
-                                                        "identical start and end "
-                                                        "times, skipping")
-                                                        .arg(pginfo->title));
+                    if (!aggregatedDesc.isEmpty())
+                        aggregatedDesc.append(" | ");
+                    aggregatedDesc.append(pginfo->description);
                 }
-                else
+                if (pginfo->clumpidx.toInt() ==
+                    pginfo->clumpmax.toInt() - 1)
+                {
+                    pginfo->title = aggregatedTitle;
+                    pginfo->description = aggregatedDesc;
+                    keep = true;
+                }
+            }
+
+            if (keep)
+            {
+                if (grouped && !lastChannel.isEmpty() &&
+                    pginfo->channel != lastChannel)
                 {
-                    if (pginfo->clumpidx.isEmpty())
-                        (*proglist)[pginfo->channel].push_back(*pginfo);
+                    if (handledChannels.contains(pginfo->channel))
+                    {
+                        LOG(VB_XMLTV, LOG_INFO,
+                            QString("Programmes for %1 are not grouped by "
+                                    "channel, holding the rest of the file")
+                                .arg(pginfo->channel));
+                        grouped = false;
+                    }
                     else
                     {
-                        /* append all titles/descriptions from one clump */
-                        if (pginfo->clumpidx.toInt() == 0)
-                        {
-                            aggregatedTitle.clear();
-                            aggregatedDesc.clear();
-                        }
-
-                        if (!pginfo->title.isEmpty())
-                        {
-                            if (!aggregatedTitle.isEmpty())
-                                aggregatedTitle.append(" | ");
-                            aggregatedTitle.append(pginfo->title);
-                        }
-
-                        if (!pginfo->description.isEmpty())
-                        {
-                            if (!aggregatedDesc.isEmpty())
-                                aggregatedDesc.append(" | ");
-                            aggregatedDesc.append(pginfo->description);
-                        }
-                        if (pginfo->clumpidx.toInt() ==
-                            pginfo->clumpmax.toInt() - 1)
-                        {
-                            pginfo->title = aggregatedTitle;
-                            pginfo->description = aggregatedDesc;
-                            (*proglist)[pginfo->channel].push_back(*pginfo);
-                        }
+                        QMap<QString, QList<ProgInfo> > channel;
+                        channel[lastChannel] = proglist.take(lastChannel);
+                        listener->HandlePrograms(channel);
+                        handledChannels.insert(lastChannel);
                     }
                 }
-                delete pginfo;
+                proglist[pginfo->channel].push_back(*pginfo);
+                lastChannel = pginfo->channel;
             }
+            delete pginfo;
         }
-        n = n.nextSibling();
     }
 
+    if (xml.hasError())
+    {
+        LOG(VB_GENERAL, LOG_ERR, QString("Error in %1:%2: %3")
+            .arg(xml.lineNumber()).arg(xml.columnNumber())
+            .arg(xml.errorString()));
+    }
+
+    f.close();
+
+    if (!channelsHandled)
+        listener->HandleChannels(chanlist);
+    if (!proglist.isEmpty())
+        listener->HandlePrograms(proglist);
+
     return true;
 }
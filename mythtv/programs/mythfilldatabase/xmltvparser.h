@@ -11,7 +11,20 @@
 
 class ProgInfo;
 class QUrl;
-class QDomElement;
+class QXmlStreamReader;
+
+/// Receives the data XMLTVParser::parseFile() reads, as it reads it.
+class XMLTVListener
+{
+  public:
+    /// Called once with all the channels, before any programmes.
+    virtual void HandleChannels(ChannelInfoList &chanlist) = 0;
+    /// Called with the programmes of one or more channels, keyed by xmltvid.
+    virtual void HandlePrograms(QMap<QString, QList<ProgInfo> > &proglist) = 0;
+
+  protected:
+    virtual ~XMLTVListener() {}
+};
 
 class XMLTVParser
 {
@@ -19,10 +32,9 @@ class XMLTVParser
     XMLTVParser();
     void lateInit();
 
-    ChannelInfo *parseChannel(QDomElement &element, QUrl &baseUrl);
-    ProgInfo *parseProgram(QDomElement &element);
-    bool parseFile(QString filename, ChannelInfoList *chanlist,
-                   QMap<QString, QList<ProgInfo> > *proglist);
+    ChannelInfo *parseChannel(QXmlStreamReader &xml, QUrl &baseUrl);
+    ProgInfo *parseProgram(QXmlStreamReader &xml);
+    bool parseFile(QString filename, XMLTVListener *listener);
 
   private:
     unsigned int current_year;
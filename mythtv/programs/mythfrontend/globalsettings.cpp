@@ -2699,6 +2699,26 @@ static GlobalComboBoxSetting *GRSchedOpenEnd()
     return bc;
 }
 
+static GlobalCheckBoxSetting *GRSchedIncremental()
+{
+    GlobalCheckBoxSetting *bc = new GlobalCheckBoxSetting("SchedIncremental");
+
+    bc->setLabel(GeneralRecPrioritiesSettings::tr("Incremental rescheduling"));
+
+    bc->setHelpText(
+        GeneralRecPrioritiesSettings::tr("If enabled, the scheduler keeps "
+                                         "the matching showings of every "
+                                         "rule in memory and only reads "
+                                         "those of changed rules from the "
+                                         "database. This speeds up "
+                                         "rescheduling with many rules at "
+                                         "the cost of backend memory."));
+
+    bc->setValue(false);
+
+    return bc;
+}
+
 static GlobalSpinBoxSetting *GRPrefInputRecPriority()
 {
     GlobalSpinBoxSetting *bs = new GlobalSpinBoxSetting("PrefInputPriority", 1, 99, 1);
@@ -4129,6 +4149,7 @@ GeneralRecPrioritiesSettings::GeneralRecPrioritiesSettings()
     sched->setLabel(tr("Scheduler Options"));
 
     sched->addChild(GRSchedOpenEnd());
+    sched->addChild(GRSchedIncremental());
     sched->addChild(GRPrefInputRecPriority());
     sched->addChild(GRHDTVRecPriority());
     sched->addChild(GRWSRecPriority());
@@ -284,6 +284,19 @@ static GlobalCheckBoxSetting *DeletesFollowLinks()
     return gc;
 };
 
+static GlobalCheckBoxSetting *RecordingDirectIO()
+{
+    GlobalCheckBoxSetting *gc = new GlobalCheckBoxSetting("RecordingDirectIO");
+    gc->setLabel(QObject::tr("Write recordings without caching"));
+    gc->setValue(false);
+    gc->setHelpText(QObject::tr("If enabled, recordings are written with "
+                    "direct I/O so they don't push other data out of the "
+                    "system's file cache. This can help backends with many "
+                    "simultaneous recordings. Filesystems that don't support "
+                    "direct I/O fall back to normal writes."));
+    return gc;
+};
+
 static GlobalSpinBoxSetting *HDRingbufferSize()
 {
     GlobalSpinBoxSetting *bs = new GlobalSpinBoxSetting(
@@ -565,6 +578,49 @@ static GlobalTextEditSetting *startupCommand()
     return gc;
 };
 
+static HostSpinBoxSetting *HTTPLiveStreamTranscoders()
+{
+    HostSpinBoxSetting *gc = new HostSpinBoxSetting("HTTPLiveStreamTranscoders", 0, 8, 1);
+    gc->setLabel(QObject::tr("Simultaneous HTTP Live Streams"));
+    gc->setHelpText(QObject::tr("If set above 0, HTTP Live Streams are "
+                    "transcoded inside the backend, at most this many at a "
+                    "time, and further streams wait for one of these to "
+                    "finish. A damaged recording can then crash the "
+                    "backend. If 0, mythtranscode is started for each "
+                    "stream. Changes take effect when the backend is "
+                    "restarted."));
+    gc->setValue(0);
+    return gc;
+};
+
+static HostSpinBoxSetting *HTTPLiveStreamRenditions()
+{
+    HostSpinBoxSetting *gc = new HostSpinBoxSetting("HTTPLiveStreamRenditions", 1, 5, 1);
+    gc->setLabel(QObject::tr("HTTP Live Stream renditions"));
+    gc->setHelpText(QObject::tr("Number of resolutions each HTTP Live Stream "
+                    "is encoded in, so that players can pick one to suit "
+                    "their connection. Each is about 2/3 the height and half "
+                    "the bitrate of the one before. Only applies to streams "
+                    "transcoded inside the backend."));
+    gc->setValue(3);
+    return gc;
+};
+
+static HostCheckBoxSetting *HTTPLiveStreamRemux()
+{
+    HostCheckBoxSetting *gc = new HostCheckBoxSetting("HTTPLiveStreamRemux");
+    gc->setLabel(QObject::tr("Stream compatible recordings without "
+                             "transcoding"));
+    gc->setHelpText(QObject::tr("HTTP Live Streams of finished recordings "
+                    "with progressive H.264 video and AAC, MP3 or AC-3 "
+                    "audio are cut at their key frames instead of being "
+                    "transcoded, when the player asked for at least the "
+                    "bitrate and resolution of the recording. Playback "
+                    "starts at once and uses hardly any CPU."));
+    gc->setValue(true);
+    return gc;
+};
+
 static HostSpinBoxSetting *JobQueueMaxSimultaneousJobs()
 {
     HostSpinBoxSetting *gc = new HostSpinBoxSetting("JobQueueMaxSimultaneousJobs", 1, 10, 1);
@@ -716,6 +772,22 @@ static HostCheckBoxSetting *JobAllowPreview()
     return gc;
 };
 
+static HostCheckBoxSetting *PreviewGeneratorInProcess()
+{
+    HostCheckBoxSetting *gc = new HostCheckBoxSetting("PreviewGeneratorInProcess");
+    gc->setLabel(QObject::tr("Make previews in the backend"));
+    gc->setValue(false);
+    gc->setHelpText(QObject::tr("If enabled, preview images are made by "
+                                "a pool of threads in the backend, which "
+                                "opens each recording once for all of its "
+                                "previews. If disabled, a separate "
+                                "mythpreviewgen process is run for each "
+                                "preview, at a lower priority and with a "
+                                "time limit, so that a damaged recording "
+                                "cannot hang or crash the backend."));
+    return gc;
+};
+
 static GlobalTextEditSetting *JobQueueTranscodeCommand()
 {
     GlobalTextEditSetting *gc = new GlobalTextEditSetting("JobQueueTranscodeCommand");
@@ -934,6 +1006,7 @@ BackendSettings::BackendSettings() :
     fm->addChild(MasterBackendOverride());
     fm->addChild(DeletesFollowLinks());
     fm->addChild(TruncateDeletes());
+    fm->addChild(RecordingDirectIO());
     fm->addChild(HDRingbufferSize());
     fm->addChild(StorageScheduler());
     group2->addChild(fm);
@@ -942,6 +1015,12 @@ BackendSettings::BackendSettings() :
     //upnp->addChild(UPNPShowRecordingUnderVideos());
     upnp->addChild(UPNPWmpSource());
     group2->addChild(upnp);
+    GroupSetting* hls = new GroupSetting();
+    hls->setLabel(QObject::tr("HTTP Live Streaming Settings"));
+    hls->addChild(HTTPLiveStreamRemux());
+    hls->addChild(HTTPLiveStreamTranscoders());
+    hls->addChild(HTTPLiveStreamRenditions());
+    group2->addChild(hls);
     group2->addChild(MiscStatusScript());
     group2->addChild(DisableAutomaticBackup());
     group2->addChild(DisableFirewireReset());
@@ -1000,6 +1079,7 @@ BackendSettings::BackendSettings() :
     group5->addChild(JobAllowCommFlag());
     group5->addChild(JobAllowTranscode());
     group5->addChild(JobAllowPreview());
+    group5->addChild(PreviewGeneratorInProcess());
     group5->addChild(JobAllowUserJob(1));
     group5->addChild(JobAllowUserJob(2));
     group5->addChild(JobAllowUserJob(3));